@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/config/config.h>
+#include <osquery/utils/json/json.h>
+#include <osquery/utils/system/time.h>
+
+namespace osquery {
+
+/// The number of queries in each benchmark pack.
+const size_t kBenchmarkPackSize{10};
+
+/// Replace the schedule with packs holding a total of count queries.
+static void setBenchmarkSchedule(size_t count) {
+  Config::get().reset();
+  for (size_t pack = 0; pack * kBenchmarkPackSize < count; ++pack) {
+    std::string queries;
+    for (size_t i = 0; i < kBenchmarkPackSize; ++i) {
+      if (!queries.empty()) {
+        queries += ",";
+      }
+      // Spread the intervals between a minute and an hour.
+      auto interval = 60 + (pack * kBenchmarkPackSize + i) % 3540;
+      queries += "\"query_" + std::to_string(i) +
+                 "\": {\"query\": \"select 1\", \"interval\": " +
+                 std::to_string(interval) + "}";
+    }
+
+    auto doc = JSON::newObject();
+    doc.fromString("{\"queries\": {" + queries + "}}");
+    Config::get().addPack("pack_" + std::to_string(pack), "", doc.doc());
+  }
+}
+
+/// The previous scheduler tick, a scan of every scheduled query.
+static void CONFIG_schedule_tick_scan(benchmark::State& state) {
+  setBenchmarkSchedule(static_cast<size_t>(state.range(0)));
+
+  size_t launched = 0;
+  auto step = getUnixTime();
+  while (state.KeepRunning()) {
+    Config::get().scheduledQueries(
+        ([&launched, step](const std::string&, const ScheduledQuery& query) {
+          if (query.splayed_interval > 0 &&
+              step % query.splayed_interval == 0) {
+            launched++;
+          }
+        }));
+    step++;
+  }
+  benchmark::DoNotOptimize(launched);
+  Config::get().reset();
+}
+
+BENCHMARK(CONFIG_schedule_tick_scan)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void CONFIG_schedule_tick_due(benchmark::State& state) {
+  setBenchmarkSchedule(static_cast<size_t>(state.range(0)));
+
+  size_t launched = 0;
+  auto step = getUnixTime();
+  while (state.KeepRunning()) {
+    Config::get().dueQueries(
+        step, ([&launched](const std::string&, const ScheduledQuery&) {
+          launched++;
+        }));
+    step++;
+  }
+  benchmark::DoNotOptimize(launched);
+  Config::get().reset();
+}
+
+BENCHMARK(CONFIG_schedule_tick_due)->Arg(100)->Arg(1000)->Arg(10000);
+
+} // namespace osquery
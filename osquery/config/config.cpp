@@ -12,7 +12,10 @@
 #include <functional>
 #include <map>
 #include <queue>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -31,6 +34,7 @@
 #include <osquery/events/events.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/registry/registry.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/utils/conversions/trim.h>
@@ -52,6 +56,27 @@ const int kMaxConfigSize = 1024 * 1024;
 using ConfigMap = std::map<std::string, std::string>;
 
 std::atomic<bool> is_first_time_refresh(true);
+
+/// Report the duration of each phase of a config update.
+class ReloadTimer {
+ public:
+  void phase(const std::string& name) {
+    auto now = std::chrono::steady_clock::now();
+    auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - start_)
+            .count();
+    start_ = now;
+
+    VLOG(1) << "Config update " << name << " took " << micros << "us";
+    monitoring::record("config.reload." + name + ".time.micros",
+                       micros,
+                       monitoring::PreAggregationType::Sum);
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_{
+      std::chrono::steady_clock::now()};
+};
 }; // namespace
 
 /**
@@ -187,10 +212,73 @@ class Schedule : private boost::noncopyable {
   std::map<std::string, std::map<std::string, std::string>>
   getSqlQueriesForSource(const std::string& source);
 
+  /// A scheduled query within the due-time index.
+  struct IndexEntry {
+    /// The pack owning the query.
+    Pack* pack{nullptr};
+
+    /// The query name within the pack.
+    const std::string* name{nullptr};
+
+    /// The query, owned by the pack.
+    ScheduledQuery* query{nullptr};
+
+    /// The next step the query is due at.
+    uint64_t due{0};
+  };
+
+  /**
+   * @brief Find the queries due at a schedule step.
+   *
+   * Steps are expected to be consecutive, any other step reindexes the
+   * schedule. The returned IDs are in schedule order, and every returned
+   * query is moved to the next step it is due at.
+   */
+  std::vector<uint64_t> due(uint64_t step);
+
+  /// Lookup an index entry, nullptr if its pack was removed.
+  IndexEntry* entry(uint64_t id);
+
+  /**
+   * @brief Check if a query is denylisted.
+   *
+   * Expired denylistings are removed and saved. The query's denylisted
+   * member is updated.
+   */
+  bool isDenylisted(const std::string& name, ScheduledQuery& query);
+
+ private:
+  /// Add the queries of a pack to the due-time index.
+  void indexPack(Pack& pack);
+
+  /// Remove the queries of a pack from the due-time index.
+  void unindexPack(const Pack& pack);
+
+  /// Recompute every due step relative to step.
+  void reindex(uint64_t step);
+
  private:
   /// Underlying storage for the packs
   container packs_;
 
+  /// Index entries by ID, IDs increase in schedule order.
+  std::unordered_map<uint64_t, IndexEntry> index_;
+
+  /// The index entry IDs of each pack.
+  std::unordered_map<const Pack*, std::vector<uint64_t>> pack_index_;
+
+  /// Index entry IDs ordered by the step they are next due at.
+  std::priority_queue<std::pair<uint64_t, uint64_t>,
+                      std::vector<std::pair<uint64_t, uint64_t>>,
+                      std::greater<std::pair<uint64_t, uint64_t>>>
+      due_;
+
+  /// The ID of the next index entry.
+  uint64_t next_id_{0};
+
+  /// The last step queries were found for.
+  uint64_t last_step_{0};
+
   /**
    * @brief The schedule will check and record previously executing queries.
    *
@@ -218,6 +306,7 @@ bool Schedule::Step::operator()(const PackRef& pack) const {
 
 void Schedule::add(PackRef pack) {
   remove(pack->getName(), pack->getSource());
+  indexPack(*pack);
   packs_.push_back(std::move(pack));
 }
 
@@ -227,11 +316,12 @@ void Schedule::remove(const std::string& pack) {
 
 void Schedule::remove(const std::string& pack, const std::string& source) {
   auto new_end = std::remove_if(
-      packs_.begin(), packs_.end(), [pack, source](const PackRef& p) {
+      packs_.begin(), packs_.end(), [this, pack, source](const PackRef& p) {
         if (p->getName() == pack &&
             (p->getSource() == source || source == "")) {
           Config::get().removeFiles(source + FLAGS_pack_delimiter +
                                     p->getName());
+          unindexPack(*p);
           return true;
         }
         return false;
@@ -261,11 +351,12 @@ Schedule::getSqlQueriesForSource(const std::string& source) {
 }
 
 void Schedule::removeAll(const std::string& source) {
-  auto new_end =
-      std::remove_if(packs_.begin(), packs_.end(), [source](const PackRef& p) {
+  auto new_end = std::remove_if(
+      packs_.begin(), packs_.end(), [this, source](const PackRef& p) {
         if (p->getSource() == source) {
           Config::get().removeFiles(source + FLAGS_pack_delimiter +
                                     p->getName());
+          unindexPack(*p);
           return true;
         }
         return false;
@@ -273,6 +364,94 @@ void Schedule::removeAll(const std::string& source) {
   packs_.erase(new_end, packs_.end());
 }
 
+/// The first step at or after step that is a multiple of interval.
+static inline uint64_t getNextDueStep(uint64_t step, uint64_t interval) {
+  return ((step + interval - 1) / interval) * interval;
+}
+
+void Schedule::indexPack(Pack& pack) {
+  auto& ids = pack_index_[&pack];
+  for (auto& it : pack.getSchedule()) {
+    if (it.second.splayed_interval == 0) {
+      // Queries without an interval never run.
+      continue;
+    }
+
+    IndexEntry entry;
+    entry.pack = &pack;
+    entry.name = &it.first;
+    entry.query = &it.second;
+    entry.due = getNextDueStep(last_step_ + 1, it.second.splayed_interval);
+
+    auto id = next_id_++;
+    index_[id] = entry;
+    ids.push_back(id);
+    due_.push(std::make_pair(entry.due, id));
+  }
+}
+
+void Schedule::unindexPack(const Pack& pack) {
+  auto ids = pack_index_.find(&pack);
+  if (ids == pack_index_.end()) {
+    return;
+  }
+
+  // Removed entries are skipped once they reach the top of the queue.
+  for (auto id : ids->second) {
+    index_.erase(id);
+  }
+  pack_index_.erase(ids);
+
+  // Rebuild the queue if most of it refers to removed entries.
+  if (due_.size() > 2 * index_.size() + 64) {
+    reindex(last_step_ + 1);
+  }
+}
+
+void Schedule::reindex(uint64_t step) {
+  std::vector<std::pair<uint64_t, uint64_t>> due;
+  due.reserve(index_.size());
+  for (auto& it : index_) {
+    auto& entry = it.second;
+    entry.due = getNextDueStep(step, entry.query->splayed_interval);
+    due.push_back(std::make_pair(entry.due, it.first));
+  }
+  due_ = decltype(due_)(std::greater<std::pair<uint64_t, uint64_t>>(),
+                        std::move(due));
+}
+
+std::vector<uint64_t> Schedule::due(uint64_t step) {
+  if (step != last_step_ + 1) {
+    reindex(step);
+  }
+  last_step_ = step;
+
+  // Entries due at the same step are ordered by ID, the schedule order.
+  std::vector<uint64_t> ids;
+  while (!due_.empty() && due_.top().first <= step) {
+    auto top = due_.top();
+    due_.pop();
+
+    auto it = index_.find(top.second);
+    if (it == index_.end() || it->second.due != top.first) {
+      continue;
+    }
+
+    auto& entry = it->second;
+    if (entry.due == step) {
+      ids.push_back(top.second);
+    }
+    entry.due = getNextDueStep(step + 1, entry.query->splayed_interval);
+    due_.push(std::make_pair(entry.due, top.second));
+  }
+  return ids;
+}
+
+Schedule::IndexEntry* Schedule::entry(uint64_t id) {
+  auto it = index_.find(id);
+  return (it == index_.end()) ? nullptr : &it->second;
+}
+
 Schedule::iterator Schedule::begin() {
   return Schedule::iterator(packs_.begin(), packs_.end());
 }
@@ -383,7 +562,10 @@ void Config::addPack(const std::string& name,
       bool should_pack_execute = true;
 #endif
       if (should_pack_execute) {
-        applyParsers(source + FLAGS_pack_delimiter + pack_name, pack_obj, true);
+        // Like a source, only the parsers of changed pack keys are applied.
+        auto pack_source = source + FLAGS_pack_delimiter + pack_name;
+        auto changed_keys = hashSourceKeys(pack_source, pack_obj);
+        applyParsers(pack_source, pack_obj, true, &changed_keys);
       }
     } catch (const std::exception& e) {
       LOG(WARNING) << "Error adding pack: " << pack_name << ": " << e.what();
@@ -465,6 +647,26 @@ std::string getQueryName(const std::string& packName, const std::string& name) {
   return name;
 }
 
+bool Schedule::isDenylisted(const std::string& name, ScheduledQuery& query) {
+  // They query may have failed and been added to the schedule's denylist.
+  auto denylisted_query = denylist_.find(name);
+  if (denylisted_query == denylist_.end()) {
+    return false;
+  }
+
+  if (denylistExpired(denylisted_query->second, query)) {
+    // The denylisted query passed the expiration time (remove).
+    denylist_.erase(denylisted_query);
+    saveScheduleDenylist(denylist_);
+    query.denylisted = false;
+    return false;
+  }
+
+  // The query is still denylisted.
+  query.denylisted = true;
+  return true;
+}
+
 void Config::scheduledQueries(
     std::function<void(std::string name, const ScheduledQuery& query)>
         predicate,
@@ -473,22 +675,9 @@ void Config::scheduledQueries(
   for (PackRef& pack : *schedule_) {
     for (auto& it : pack->getSchedule()) {
       std::string name = getQueryName(pack->getName(), it.first);
-      // They query may have failed and been added to the schedule's denylist.
-      auto denylisted_query = schedule_->denylist_.find(name);
-      if (denylisted_query != schedule_->denylist_.end()) {
-        if (denylistExpired(denylisted_query->second, it.second)) {
-          // The denylisted query passed the expiration time (remove).
-          schedule_->denylist_.erase(denylisted_query);
-          saveScheduleDenylist(schedule_->denylist_);
-          it.second.denylisted = false;
-        } else {
-          // The query is still denylisted.
-          it.second.denylisted = true;
-          if (!denylisted) {
-            // The caller does not want denylisted queries.
-            continue;
-          }
-        }
+      if (schedule_->isDenylisted(name, it.second) && !denylisted) {
+        // The caller does not want denylisted queries.
+        continue;
       }
 
       // Call the predicate.
@@ -501,6 +690,44 @@ void Config::scheduledQueries(
   }
 }
 
+void Config::dueQueries(
+    uint64_t step,
+    std::function<void(std::string name, const ScheduledQuery& query)>
+        predicate) const {
+  RecursiveLock lock(config_schedule_mutex_);
+
+  // Discovery is checked once per pack with a due query.
+  std::unordered_map<const Pack*, bool> executing;
+  for (auto id : schedule_->due(step)) {
+    // A predicate may have updated the schedule.
+    auto entry = schedule_->entry(id);
+    if (entry == nullptr) {
+      continue;
+    }
+
+    auto execute = executing.find(entry->pack);
+    if (execute == executing.end()) {
+      execute = executing
+                    .emplace(entry->pack, entry->pack->shouldPackExecute())
+                    .first;
+    }
+    if (!execute->second) {
+      continue;
+    }
+
+    std::string name = getQueryName(entry->pack->getName(), *entry->name);
+    if (schedule_->isDenylisted(name, *entry->query)) {
+      continue;
+    }
+
+    predicate(std::move(name), *entry->query);
+
+    if (shutdownRequested()) {
+      break;
+    }
+  }
+}
+
 void Config::packs(std::function<void(const Pack& pack)> predicate) const {
   RecursiveLock lock(config_schedule_mutex_);
   for (PackRef& pack : schedule_->packs_) {
@@ -709,15 +936,23 @@ Status Config::updateSource(const std::string& source,
     return Status(2);
   }
 
-  // Get the queries so that we can check which ones updated the SQL.
-  auto queries = schedule_->getSqlQueriesForSource(source);
-  {
+  // Content that cannot be used removes all packs and files of this source.
+  auto removeSource = [this, &source]() {
     RecursiveLock lock(config_schedule_mutex_);
-    // Remove all packs from this source.
     schedule_->removeAll(source);
-    // Remove all files from this source.
     removeFiles(source);
-  }
+
+    // Forget the key hashes of the source and of its packs.
+    WriteLock wlock(config_hash_mutex_);
+    auto pack_prefix = source + FLAGS_pack_delimiter;
+    for (auto it = key_hashes_.begin(); it != key_hashes_.end();) {
+      if (it->first == source || it->first.find(pack_prefix) == 0) {
+        it = key_hashes_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  };
 
   // load the config (source.second) into a JSON object.
   auto doc = JSON::newObject();
@@ -727,6 +962,7 @@ Status Config::updateSource(const std::string& source,
   // Since we use iterative parsing, we limit the size of the JSON
   // string to a sane value to avoid memory exhaustion.
   if (clone.size() > kMaxConfigSize) {
+    removeSource();
     return Status::failure(
         "Error parsing the config JSON: the config size exceeds the limit "
         "of " +
@@ -735,19 +971,54 @@ Status Config::updateSource(const std::string& source,
 
   if (!doc.fromString(clone, JSON::ParseMode::Iterative) ||
       !doc.doc().IsObject()) {
+    removeSource();
     return Status::failure("Error parsing the config JSON");
   }
 
   auto status = validateConfig(doc);
   if (!status.ok()) {
+    removeSource();
     return Status::failure("Error validating the config JSON: " +
                            status.getMessage());
   }
 
+  // Only the top-level keys that changed since the last update are applied.
+  auto changed_keys = hashSourceKeys(source, doc.doc());
+
+  // Packs are rebuilt if their content or the options they depend on changed.
+  // Packs given as resources are generated by the config plugin, their content
+  // cannot be compared before it is requested.
+  bool update_packs = changed_keys.count("schedule") > 0 ||
+                      changed_keys.count("packs") > 0 ||
+                      changed_keys.count("options") > 0;
+  if (doc.doc().HasMember("packs") && doc.doc()["packs"].IsObject()) {
+    for (const auto& pack : doc.doc()["packs"].GetObject()) {
+      update_packs = update_packs || pack.value.IsString();
+    }
+  }
+
+  if (update_packs) {
+    updatePacks(source, doc.doc());
+  }
+
+  applyParsers(source, doc.doc(), false, &changed_keys);
+  return Status::success();
+}
+
+void Config::updatePacks(const std::string& source, const rj::Value& obj) {
+  // Get the queries so that we can check which ones updated the SQL.
+  auto queries = schedule_->getSqlQueriesForSource(source);
+  {
+    RecursiveLock lock(config_schedule_mutex_);
+    // Remove all packs from this source.
+    schedule_->removeAll(source);
+    schedule_updated_ = true;
+  }
+
   // extract the "schedule" key and store it as the main pack
   auto& rf = RegistryFactory::get();
-  if (doc.doc().HasMember("schedule") && !rf.external()) {
-    auto& schedule = doc.doc()["schedule"];
+  if (obj.HasMember("schedule") && !rf.external()) {
+    const auto& schedule = obj["schedule"];
     if (schedule.IsObject()) {
       auto main_doc = JSON::newObject();
       auto queries_obj = main_doc.getObject();
@@ -758,8 +1029,8 @@ Status Config::updateSource(const std::string& source,
   }
 
   // extract the "packs" key into additional pack objects
-  if (doc.doc().HasMember("packs") && !rf.external()) {
-    auto& packs = doc.doc()["packs"];
+  if (obj.HasMember("packs") && !rf.external()) {
+    const auto& packs = obj["packs"];
     if (packs.IsObject()) {
       for (const auto& pack : packs.GetObject()) {
         std::string pack_name = pack.name.GetString();
@@ -773,8 +1044,6 @@ Status Config::updateSource(const std::string& source,
     }
   }
 
-  applyParsers(source, doc.doc(), false);
-
   // Get the updated queries so that we can compare them to old queries.
   auto newQueries = schedule_->getSqlQueriesForSource(source);
   // Clear the performance stats on updated queries.
@@ -806,8 +1075,6 @@ Status Config::updateSource(const std::string& source,
       }
     }
   }
-
-  return Status::success();
 }
 
 Status Config::genPack(const std::string& name,
@@ -844,14 +1111,31 @@ Status Config::genPack(const std::string& name,
 void Config::applyParsers(const std::string& source,
                           const rj::Value& obj,
                           bool pack) {
+  applyParsers(source, obj, pack, nullptr);
+}
+
+void Config::applyParsers(const std::string& source,
+                          const rj::Value& obj,
+                          bool pack,
+                          const std::set<std::string>* changed_keys) {
   assert(obj.IsObject());
 
   auto applyParser = [=](const std::shared_ptr<ConfigParserPlugin>& parser,
+                         const std::string& name,
                          const std::string& source,
                          const rj::Value& obj) {
+    const auto keys = parser->keys();
+    if (changed_keys != nullptr &&
+        std::none_of(keys.begin(), keys.end(), [=](const std::string& key) {
+          return changed_keys->count(key) > 0;
+        })) {
+      // The content read by this parser did not change.
+      return;
+    }
+
     // For each key requested by the parser, add a property tree reference.
     std::map<std::string, JSON> parser_config;
-    for (const auto& key : parser->keys()) {
+    for (const auto& key : keys) {
       if (obj.HasMember(key) && !obj[key].IsNull()) {
         if (!obj[key].IsArray() && !obj[key].IsObject()) {
           LOG(WARNING) << "Error config " << key
@@ -867,6 +1151,7 @@ void Config::applyParsers(const std::string& source,
     // each top-level-config key. The parser may choose to update the config's
     // internal state
     parser->update(source, parser_config);
+    updated_parsers_.insert(name);
   };
 
   auto getParser = [=](const PluginRef& plugin, const std::string& name) {
@@ -887,7 +1172,7 @@ void Config::applyParsers(const std::string& source,
   if (options_plugin != plugins.end()) {
     auto parser = getParser(options_plugin->second, options_plugin->first);
     if (parser != nullptr && parser.get() != nullptr) {
-      applyParser(parser, source, obj);
+      applyParser(parser, options_plugin->first, source, obj);
     }
   }
 
@@ -898,7 +1183,7 @@ void Config::applyParsers(const std::string& source,
     }
     auto parser = getParser(plugin.second, plugin.first);
     if (parser != nullptr && parser.get() != nullptr) {
-      applyParser(parser, source, obj);
+      applyParser(parser, plugin.first, source, obj);
     }
   }
 }
@@ -929,8 +1214,12 @@ Status Config::update(const ConfigMap& config) {
   // This will add/overwrite pack data, append to the schedule, change watched
   // files, set options, etc.
   // Before this occurs, take an opportunity to purge stale state.
+  ReloadTimer timer;
   purge();
+  timer.phase("purge");
 
+  updated_parsers_.clear();
+  schedule_updated_ = false;
   bool needs_reconfigure = false;
   for (const auto& source : config) {
     auto status = updateSource(source.first, source.second);
@@ -948,6 +1237,7 @@ Status Config::update(const ConfigMap& config) {
     // should be reconfigured. File watches may have changed, etc.
     needs_reconfigure = true;
   }
+  timer.phase("sources");
 
   if (loaded_ && needs_reconfigure) {
     // The config has since been loaded.
@@ -960,8 +1250,12 @@ Status Config::update(const ConfigMap& config) {
       }
       registry.second->configure();
     }
+    timer.phase("registries");
 
-    EventFactory::configUpdate();
+    // Only the subscribers and publishers reading updated parsers are
+    // reconfigured.
+    EventFactory::configUpdate(updated_parsers_, schedule_updated_);
+    timer.phase("events");
   }
 
   // This cannot be under the previous if block because on extensions loaded_
@@ -976,6 +1270,7 @@ Status Config::update(const ConfigMap& config) {
         plugin->configure();
       }
     }
+    timer.phase("loggers");
   }
 
   if (FLAGS_config_enable_backup) {
@@ -1046,6 +1341,7 @@ void Config::reset() {
   schedule_ = std::make_unique<Schedule>();
   std::map<std::string, FileCategories>().swap(files_);
   std::map<std::string, std::string>().swap(hash_);
+  key_hashes_.clear();
   valid_ = false;
   loaded_ = false;
   is_first_time_refresh = true;
@@ -1082,10 +1378,8 @@ void ConfigParserPlugin::reset() {
 }
 
 void Config::recordQueryPerformance(const std::string& name,
-                                    uint64_t delay_ms,
                                     uint64_t size,
-                                    const Row& r0,
-                                    const Row& r1) {
+                                    const QueryResourceUsage& usage) {
   RecursiveLock lock(config_performance_mutex_);
   std::string csv;
   QueryPerformance query;
@@ -1094,41 +1388,24 @@ void Config::recordQueryPerformance(const std::string& name,
     query = QueryPerformance(csv);
   }
 
-  if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
-    auto ut1 = tryTo<long long>(r1.at("user_time"));
-    auto ut0 = tryTo<long long>(r0.at("user_time"));
-    auto diff = (ut1 && ut0) ? ut1.take() - ut0.take() : 0;
-    if (diff > 0) {
-      query.user_time += diff;
-      query.last_user_time = diff;
-    }
-  }
+  query.user_time += usage.user_time_ms;
+  query.last_user_time = usage.user_time_ms;
+  query.system_time += usage.system_time_ms;
+  query.last_system_time = usage.system_time_ms;
 
-  if (!r1.at("system_time").empty() && !r0.at("system_time").empty()) {
-    auto st1 = tryTo<long long>(r1.at("system_time"));
-    auto st0 = tryTo<long long>(r0.at("system_time"));
-    auto diff = (st1 && st0) ? st1.take() - st0.take() : 0;
-    if (diff > 0) {
-      query.system_time += diff;
-      query.last_system_time = diff;
-    }
-  }
+  // Memory is stored as an average of heap growth between query executions.
+  query.average_memory =
+      (query.average_memory * query.executions) + usage.memory;
+  query.average_memory = (query.average_memory / (query.executions + 1));
+  query.last_memory = usage.memory;
 
-  if (!r1.at("resident_size").empty() && !r0.at("resident_size").empty()) {
-    auto rs1 = tryTo<long long>(r1.at("resident_size"));
-    auto rs0 = tryTo<long long>(r0.at("resident_size"));
-    auto diff = (rs1 && rs0) ? rs1.take() - rs0.take() : 0;
-    if (diff > 0) {
-      // Memory is stored as an average of RSS changes between query executions.
-      query.average_memory = (query.average_memory * query.executions) + diff;
-      query.average_memory = (query.average_memory / (query.executions + 1));
-      query.last_memory = diff;
-    }
-  }
+  auto generate_time_ms = usage.getGenerateTimeMs();
+  query.generate_time_ms += generate_time_ms;
+  query.last_generate_time_ms = generate_time_ms;
 
-  query.last_wall_time_ms = delay_ms;
-  query.wall_time_ms += delay_ms;
-  query.wall_time += (delay_ms / 1000);
+  query.last_wall_time_ms = usage.wall_time_ms;
+  query.wall_time_ms += usage.wall_time_ms;
+  query.wall_time += (usage.wall_time_ms / 1000);
   query.output_size += size;
   query.executions += 1;
   query.last_executed = getUnixTime();
@@ -1181,6 +1458,36 @@ bool Config::hashSource(const std::string& source, const std::string& content) {
   return true;
 }
 
+std::set<std::string> Config::hashSourceKeys(const std::string& source,
+                                             const rj::Value& obj) {
+  std::map<std::string, std::string> new_hashes;
+  for (const auto& member : obj.GetObject()) {
+    rj::StringBuffer sb;
+    rj::Writer<rj::StringBuffer> writer(sb);
+    member.value.Accept(writer);
+    new_hashes[member.name.GetString()] =
+        hashFromBuffer(HASH_TYPE_SHA1, sb.GetString(), sb.GetSize());
+  }
+
+  WriteLock wlock(config_hash_mutex_);
+  auto& old_hashes = key_hashes_[source];
+  std::set<std::string> changed_keys;
+  for (const auto& key : new_hashes) {
+    auto old_hash = old_hashes.find(key.first);
+    if (old_hash == old_hashes.end() || old_hash->second != key.second) {
+      changed_keys.insert(key.first);
+    }
+  }
+  for (const auto& key : old_hashes) {
+    if (new_hashes.count(key.first) == 0) {
+      changed_keys.insert(key.first);
+    }
+  }
+
+  old_hashes = std::move(new_hashes);
+  return changed_keys;
+}
+
 Status Config::genHash(std::string& hash) const {
   WriteLock lock(config_hash_mutex_);
   if (!valid_) {
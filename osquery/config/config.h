@@ -12,10 +12,13 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/core/query.h>
+#include <osquery/core/query_resources.h>
 #include <osquery/core/sql/query_performance.h>
 #include <osquery/utils/expected/expected.h>
 #include <osquery/utils/json/json.h>
@@ -85,16 +88,12 @@ class Config : private boost::noncopyable {
    * to the updates/changes reflected in the schedule, from the config.
    *
    * @param name The unique name of the scheduled item
-   * @param delay_ms Number of milliseconds (wall time) taken by the query
    * @param size Number of characters generated by query
-   * @param r0 the process row before the query
-   * @param r1 the process row after the query
+   * @param usage The resources used by the query's thread
    */
   static void recordQueryPerformance(const std::string& name,
-                                     uint64_t delay_ms,
                                      uint64_t size,
-                                     const Row& r0,
-                                     const Row& r1);
+                                     const QueryResourceUsage& usage);
 
   /**
    * @brief Record a query 'initialization', meaning the query will run.
@@ -128,6 +127,16 @@ class Config : private boost::noncopyable {
    */
   bool hashSource(const std::string& source, const std::string& content);
 
+  /**
+   * @brief Hash each top-level key of a source's parsed config data
+   *
+   * @param source is the place where the config content came from
+   * @param obj is the parsed config data for a given source
+   * @return the keys that were added, removed, or changed
+   */
+  std::set<std::string> hashSourceKeys(const std::string& source,
+                                       const rapidjson::Value& obj);
+
   /// Whether or not the last loaded config was valid.
   bool isValid() const {
     return valid_;
@@ -186,6 +195,23 @@ class Config : private boost::noncopyable {
           predicate,
       bool denylisted = false) const;
 
+  /**
+   * @brief Map a function across the scheduled queries due at a step.
+   *
+   * A query is due when the step is a multiple of its splayed interval, this
+   * is the subset of scheduledQueries the scheduler runs each second. The
+   * schedule maintains an index of the next step each query is due at, so
+   * only the due queries are visited. Denylisted queries are skipped.
+   *
+   * @param step The schedule step, in seconds. Steps are expected to increase
+   * by one between calls, other steps are supported but rebuild the index.
+   * @param predicate Called with the name and content of each due query.
+   */
+  void dueQueries(
+      uint64_t step,
+      std::function<void(std::string name, const ScheduledQuery& query)>
+          predicate) const;
+
   /**
    * @brief Map a function across the set of configured files
    *
@@ -327,6 +353,24 @@ class Config : private boost::noncopyable {
    */
   void reset();
 
+ private:
+  /// Replace the packs of a source, a step method for Config::updateSource.
+  void updatePacks(const std::string& source, const rapidjson::Value& obj);
+
+  /**
+   * @brief Apply the ConfigParsers reading any of a set of top-level keys.
+   *
+   * Parsers that do not read a changed key keep their state for the source.
+   * A removed key is a changed key, its parsers receive no content.
+   *
+   * @param changed_keys The keys changed since the last update, or nullptr
+   * to apply every parser.
+   */
+  void applyParsers(const std::string& source,
+                    const rapidjson::Value& obj,
+                    bool pack,
+                    const std::set<std::string>* changed_keys);
+
  private:
   /// Schedule of packs and their queries.
   std::unique_ptr<Schedule> schedule_;
@@ -338,6 +382,15 @@ class Config : private boost::noncopyable {
   /// A set of hashes for each source of the config.
   std::map<std::string, std::string> hash_;
 
+  /// A hash of each top-level key's content, for each source of the config.
+  std::map<std::string, std::map<std::string, std::string>> key_hashes_;
+
+  /// The config parsers applied during the current update.
+  std::set<std::string> updated_parsers_;
+
+  /// Set if the current update changed the schedule or packs.
+  bool schedule_updated_{false};
+
   /// Check if the config received valid/parsable content from a config plugin.
   bool valid_{false};
 
@@ -374,6 +427,7 @@ class Config : private boost::noncopyable {
   FRIEND_TEST(ConfigTests, test_nondenylist_query);
   FRIEND_TEST(ConfigTests, test_config_cli_flags);
   FRIEND_TEST(ConfigTests, test_pack_stats);
+  FRIEND_TEST(ConfigTests, test_incremental_update);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option_first);
   FRIEND_TEST(ViewsConfigParserPluginTests, test_add_view);
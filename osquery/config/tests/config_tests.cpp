@@ -44,6 +44,7 @@ namespace osquery {
 DECLARE_uint64(config_refresh);
 DECLARE_uint64(config_accelerated_refresh);
 DECLARE_bool(config_enable_backup);
+DECLARE_string(pack_delimiter);
 
 namespace fs = boost::filesystem;
 
@@ -413,15 +414,21 @@ TEST_F(ConfigTests, test_pack_stats) {
 
   // Add performance stats for a query.
   auto fullName = "pack_unrestricted_pack_process_events";
-  Row row;
-  row["user_time"] = "";
-  row["system_time"] = "";
-  row["resident_size"] = "";
-  get().recordQueryPerformance(fullName, 10, 10, row, row);
+  QueryResourceUsage usage;
+  usage.wall_time_ms = 10;
+  usage.user_time_ms = 4;
+  usage.memory = 1024;
+  usage.table_time_us["processes"] = 3000;
+  usage.table_time_us["file"] = 1500;
+  get().recordQueryPerformance(fullName, 10, usage);
   bool statFound = false;
   Config::get().getPerformanceStats(fullName,
                                     [&statFound](const QueryPerformance& perf) {
                                       ASSERT_EQ(perf.executions, 1U);
+                                      ASSERT_EQ(perf.wall_time_ms, 10U);
+                                      ASSERT_EQ(perf.last_user_time, 4U);
+                                      ASSERT_EQ(perf.last_memory, 1024U);
+                                      ASSERT_EQ(perf.last_generate_time_ms, 4U);
                                       statFound = true;
                                     });
   ASSERT_TRUE(statFound);
@@ -535,6 +542,100 @@ TEST_F(ConfigTests, test_get_scheduled_queries) {
   EXPECT_TRUE(denylisted);
 }
 
+TEST_F(ConfigTests, test_due_queries) {
+  auto pack = JSON::newObject();
+  pack.fromString(R"({"queries": {
+    "q2": {"query": "select 2", "interval": 2},
+    "q3": {"query": "select 3", "interval": 3},
+    "q5": {"query": "select 5", "interval": 5},
+    "q7": {"query": "select 7", "interval": 7}
+  }})");
+  get().addPack("due_pack", "", pack.doc());
+  get().addPack("unrestricted_pack", "", getUnrestrictedPack().doc());
+
+  // The queries the scheduler would have launched by scanning the schedule.
+  auto scanned = [this](uint64_t step) {
+    std::vector<std::string> names;
+    get().scheduledQueries(
+        ([&names, step](std::string name, const ScheduledQuery& query) {
+          if (query.splayed_interval > 0 &&
+              step % query.splayed_interval == 0) {
+            names.push_back(std::move(name));
+          }
+        }));
+    return names;
+  };
+
+  auto due = [this](uint64_t step) {
+    std::vector<std::string> names;
+    get().dueQueries(step,
+                     ([&names](std::string name, const ScheduledQuery&) {
+                       names.push_back(std::move(name));
+                     }));
+    return names;
+  };
+
+  size_t launched = 0;
+  uint64_t start = getUnixTime();
+  for (auto step = start; step < start + 120; ++step) {
+    auto expected = scanned(step);
+    EXPECT_EQ(due(step), expected) << "step " << step;
+    launched += expected.size();
+  }
+  EXPECT_GT(launched, 0U);
+
+  // Steps that are not consecutive rebuild the index.
+  for (auto step : {start + 1000, start + 10, start + 10000}) {
+    EXPECT_EQ(due(step), scanned(step)) << "step " << step;
+  }
+
+  // Removing a pack removes its queries from the index.
+  get().removePack("due_pack");
+  for (auto step = start + 10001; step < start + 10020; ++step) {
+    auto names = due(step);
+    EXPECT_EQ(names, scanned(step));
+    for (const auto& name : names) {
+      EXPECT_EQ(name.find("due_pack"), std::string::npos);
+    }
+  }
+
+  // Added packs are indexed relative to the current step.
+  get().addPack("due_pack", "", pack.doc());
+  for (auto step = start + 10020; step < start + 10040; ++step) {
+    EXPECT_EQ(due(step), scanned(step)) << "step " << step;
+  }
+}
+
+TEST_F(ConfigTests, test_due_queries_denylist) {
+  auto pack = JSON::newObject();
+  pack.fromString(R"({"queries": {
+    "denied": {"query": "select 1", "interval": 1},
+    "allowed": {"query": "select 1", "interval": 1}
+  }})");
+
+  std::map<std::string, uint64_t> denylist;
+  denylist["pack" + FLAGS_pack_delimiter + "due_pack" + FLAGS_pack_delimiter +
+           "denied"] = getUnixTime() * 2;
+  saveScheduleDenylist(denylist);
+
+  // The denylist is read when the schedule is created.
+  get().reset();
+  get().addPack("due_pack", "", pack.doc());
+
+  std::vector<std::string> names;
+  get().dueQueries(getUnixTime(),
+                   ([&names](std::string name, const ScheduledQuery&) {
+                     names.push_back(std::move(name));
+                   }));
+  ASSERT_EQ(names.size(), 1U);
+  EXPECT_EQ(names[0],
+            "pack" + FLAGS_pack_delimiter + "due_pack" + FLAGS_pack_delimiter +
+                "allowed");
+
+  denylist.clear();
+  saveScheduleDenylist(denylist);
+}
+
 TEST_F(ConfigTests, test_nondenylist_query) {
   std::map<std::string, uint64_t> denylist;
 
@@ -670,6 +771,88 @@ TEST_F(ConfigTests, test_plugin_reconfigure) {
   rf.registry("config_parser")->remove("placebo");
 }
 
+class CountingConfigParserPlugin : public ConfigParserPlugin {
+ public:
+  std::vector<std::string> keys() const override {
+    return {"counted"};
+  }
+
+  Status update(const std::string&, const ParserConfig&) override {
+    updates++;
+    return Status::success();
+  }
+
+  size_t updates{0};
+};
+
+TEST_F(ConfigTests, test_incremental_update) {
+  auto& rf = RegistryFactory::get();
+  auto parser = std::make_shared<CountingConfigParserPlugin>();
+  rf.registry("config_parser")->add("counting", parser);
+
+  size_t count = 0;
+  auto packCounter = [&count](const Pack& pack) { count++; };
+
+  get().update({{"data",
+                 R"({"counted": {"a": 1}, "other": {},
+                     "schedule": {"q": {"query": "select 1", "interval": 60}}
+                    })"}});
+  EXPECT_EQ(parser->updates, 1U);
+  EXPECT_EQ(get().updated_parsers_.count("counting"), 1U);
+  EXPECT_TRUE(get().schedule_updated_);
+  get().packs(packCounter);
+  EXPECT_EQ(count, 1U);
+
+  // Changing another key does not reapply the parser or rebuild the packs.
+  get().update({{"data",
+                 R"({"counted": {"a": 1}, "other": {"b": 2},
+                     "schedule": {"q": {"query": "select 1", "interval": 60}}
+                    })"}});
+  EXPECT_EQ(parser->updates, 1U);
+  EXPECT_EQ(get().updated_parsers_.count("counting"), 0U);
+  EXPECT_FALSE(get().schedule_updated_);
+  count = 0;
+  get().packs(packCounter);
+  EXPECT_EQ(count, 1U);
+
+  // Reordering or reformatting top-level keys does not change their content.
+  get().update({{"data",
+                 R"({"schedule": {"q": {"query": "select 1", "interval": 60}},
+                     "other": {"b": 2},   "counted": {"a": 1}})"}});
+  EXPECT_EQ(parser->updates, 1U);
+  EXPECT_FALSE(get().schedule_updated_);
+
+  // Changing or removing a key reapplies the parser.
+  get().update({{"data", R"({"counted": {"a": 2}, "other": {"b": 2}})"}});
+  EXPECT_EQ(parser->updates, 2U);
+  EXPECT_TRUE(get().schedule_updated_);
+  count = 0;
+  get().packs(packCounter);
+  EXPECT_EQ(count, 0U);
+
+  get().update({{"data", R"({"other": {"b": 2}})"}});
+  EXPECT_EQ(parser->updates, 3U);
+  EXPECT_EQ(get().updated_parsers_.count("counting"), 1U);
+
+  // Pack keys are compared per pack, a pack only reapplies changed keys.
+  get().update({{"data", R"({"other": {"b": 2}, "packs": {"p": {
+                     "counted": {"a": 1},
+                     "queries": {"q": {"query": "select 1", "interval": 60}}
+                    }}})"}});
+  EXPECT_EQ(parser->updates, 4U);
+  EXPECT_EQ(get().updated_parsers_.count("counting"), 1U);
+
+  get().update({{"data", R"({"other": {"b": 2}, "packs": {"p": {
+                     "counted": {"a": 1},
+                     "queries": {"q": {"query": "select 1", "interval": 30}}
+                    }}})"}});
+  EXPECT_EQ(parser->updates, 4U);
+  EXPECT_EQ(get().updated_parsers_.count("counting"), 0U);
+  EXPECT_TRUE(get().schedule_updated_);
+
+  rf.registry("config_parser")->remove("counting");
+}
+
 TEST_F(ConfigTests, test_pack_file_paths) {
   size_t count = 0;
   auto fileCounter = [&count](const std::string& c,
@@ -8,6 +8,7 @@
  */
 
 #include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,7 @@
 #include <osquery/core/query.h>
 #include <osquery/database/database.h>
 #include <osquery/logger/logger.h>
+#include <osquery/utils/conversions/castvariant.h>
 
 #include <osquery/utils/json/json.h>
 
@@ -356,7 +358,211 @@ Status serializeQueryLogItemAsEvents(const QueryLogItem& item, JSON& doc) {
   return Status::success();
 }
 
-Status serializeQueryLogItemJSON(const QueryLogItem& item, std::string& json) {
+namespace {
+
+/// Writes JSON text directly, the same handler a DOM uses in toString.
+using LogWriter = rj::Writer<rj::StringBuffer>;
+
+/// Top-level members written by the log item and event serializers.
+const std::set<std::string> kLogItemMembers = {
+    "name",
+    "hostIdentifier",
+    "calendarTime",
+    "unixTime",
+    "epoch",
+    "counter",
+    "numerics",
+    "decorations",
+    "diffResults",
+    "snapshot",
+    "action",
+    "columns",
+};
+
+/**
+ * @brief Check if the streaming writer can reproduce the DOM output.
+ *
+ * The DOM replaces (and reorders) members added twice. That only happens if a
+ * top-level decoration shares a name with another top-level member, in which
+ * case the DOM serializer is used.
+ */
+bool canStreamLogItem(const QueryLogItem& item) {
+  if (!FLAGS_decorations_top_level) {
+    return true;
+  }
+
+  for (const auto& decoration : item.decorations) {
+    if (kLogItemMembers.count(decoration.first) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Buffers grown beyond this size by a large item are released after use.
+const size_t kLogBufferRetainSize{1024 * 1024};
+
+/// A reusable per-thread output buffer, its capacity is kept between items.
+rj::StringBuffer& getLogBuffer() {
+  thread_local rj::StringBuffer buffer;
+  auto size = buffer.GetSize();
+  buffer.Clear();
+  if (size > kLogBufferRetainSize) {
+    buffer.ShrinkToFit();
+  }
+  return buffer;
+}
+
+/// Write a value added to a DOM with JSON::addRef, copied as a C string.
+void writeStringRef(LogWriter& writer, const std::string& value) {
+  writer.String(value.c_str());
+}
+
+/// Write a value added to a DOM with JSON::addCopy, copied with its size.
+void writeStringCopy(LogWriter& writer, const std::string& value) {
+  writer.String(value.c_str(), static_cast<rj::SizeType>(value.size()));
+}
+
+/// Write a member name, member names are always copied as a C string.
+void writeKey(LogWriter& writer, const std::string& key) {
+  writer.Key(key.c_str());
+}
+
+class NumericValueWriter : public boost::static_visitor<bool> {
+ public:
+  explicit NumericValueWriter(LogWriter& writer) : writer_(writer) {}
+
+  bool operator()(const long long& i) const {
+    return writer_.Int64(i);
+  }
+
+  bool operator()(const double& d) const {
+    // The writer rejects NaN and infinity, as it does for a DOM.
+    return writer_.Double(d);
+  }
+
+  bool operator()(const std::string& str) const {
+    writeStringCopy(writer_, str);
+    return true;
+  }
+
+ private:
+  LogWriter& writer_;
+};
+
+/**
+ * @brief Streaming equivalent of serializeRow for a RowTyped.
+ *
+ * @return false if a value cannot be written, the output is then incomplete.
+ */
+bool writeRow(LogWriter& writer, const RowTyped& row) {
+  NumericValueWriter numeric(writer);
+  writer.StartObject();
+  for (const auto& column : row) {
+    writeKey(writer, column.first);
+    if (FLAGS_logger_numerics) {
+      if (!boost::apply_visitor(numeric, column.second)) {
+        return false;
+      }
+    } else {
+      writeStringRef(writer, castVariant(column.second));
+    }
+  }
+  writer.EndObject();
+  return true;
+}
+
+bool writeQueryData(LogWriter& writer, const QueryDataTyped& rows) {
+  writer.StartArray();
+  for (const auto& row : rows) {
+    if (!writeRow(writer, row)) {
+      return false;
+    }
+  }
+  writer.EndArray();
+  return true;
+}
+
+/// Streaming equivalent of addLegacyFieldsAndDecorations.
+void writeLegacyFieldsAndDecorations(LogWriter& writer,
+                                     const QueryLogItem& item) {
+  writer.Key("name");
+  writeStringRef(writer, item.name);
+  writer.Key("hostIdentifier");
+  writeStringRef(writer, item.identifier);
+  writer.Key("calendarTime");
+  writeStringRef(writer, item.calendar_time);
+  writer.Key("unixTime");
+  writer.Uint64(item.time);
+  writer.Key("epoch");
+  writer.Uint64(item.epoch);
+  writer.Key("counter");
+  writer.Uint64(item.counter);
+  writer.Key("numerics");
+  writer.Bool(FLAGS_logger_numerics);
+
+  if (item.decorations.empty()) {
+    return;
+  }
+
+  if (!FLAGS_decorations_top_level) {
+    writer.Key("decorations");
+    writer.StartObject();
+  }
+  for (const auto& decoration : item.decorations) {
+    writeKey(writer, decoration.first);
+    writeStringRef(writer, decoration.second);
+  }
+  if (!FLAGS_decorations_top_level) {
+    writer.EndObject();
+  }
+}
+
+bool writeEvent(LogWriter& writer,
+                const QueryLogItem& item,
+                const RowTyped& row,
+                const char* action) {
+  writer.StartObject();
+  writeLegacyFieldsAndDecorations(writer, item);
+  writer.Key("columns");
+  if (!writeRow(writer, row)) {
+    return false;
+  }
+  writer.Key("action");
+  writer.String(action);
+  writer.EndObject();
+  return true;
+}
+
+bool writeQueryLogItem(LogWriter& writer, const QueryLogItem& item) {
+  writer.StartObject();
+  if (!item.isSnapshot) {
+    writer.Key("diffResults");
+    writer.StartObject();
+    writer.Key("removed");
+    if (!writeQueryData(writer, item.results.removed)) {
+      return false;
+    }
+    writer.Key("added");
+    if (!writeQueryData(writer, item.results.added)) {
+      return false;
+    }
+    writer.EndObject();
+  } else {
+    writer.Key("snapshot");
+    if (!writeQueryData(writer, item.snapshot_results)) {
+      return false;
+    }
+    writer.Key("action");
+    writer.String("snapshot");
+  }
+  writeLegacyFieldsAndDecorations(writer, item);
+  writer.EndObject();
+  return true;
+}
+
+Status serializeQueryLogItemDocumentJSON(const QueryLogItem& item,
+                                         std::string& json) {
   auto doc = JSON::newObject();
   auto status = serializeQueryLogItem(item, doc);
   if (!status.ok()) {
@@ -366,15 +572,14 @@ Status serializeQueryLogItemJSON(const QueryLogItem& item, std::string& json) {
   return doc.toString(json);
 }
 
-Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& item,
-                                         std::vector<std::string>& items) {
+Status serializeQueryLogItemAsEventsDocumentJSON(
+    const QueryLogItem& item, std::vector<std::string>& items) {
   auto doc = JSON::newArray();
   auto status = serializeQueryLogItemAsEvents(item, doc);
   if (!status.ok()) {
     return status;
   }
 
-  // return doc.toString()
   for (auto& event : doc.doc().GetArray()) {
     rj::StringBuffer sb;
     rj::Writer<rj::StringBuffer> writer(sb);
@@ -384,4 +589,57 @@ Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& item,
   return Status::success();
 }
 
+} // namespace
+
+Status serializeQueryLogItemJSON(const QueryLogItem& item, std::string& json) {
+  if (!canStreamLogItem(item)) {
+    return serializeQueryLogItemDocumentJSON(item, json);
+  }
+
+  // Write straight from the item, without building a JSON document.
+  auto& buffer = getLogBuffer();
+  LogWriter writer(buffer);
+  if (!writeQueryLogItem(writer, item)) {
+    return serializeQueryLogItemDocumentJSON(item, json);
+  }
+
+  json.assign(buffer.GetString(), buffer.GetSize());
+  return Status::success();
+}
+
+Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& item,
+                                         std::vector<std::string>& items) {
+  if (!canStreamLogItem(item)) {
+    return serializeQueryLogItemAsEventsDocumentJSON(item, items);
+  }
+
+  auto first_event = items.size();
+  auto& buffer = getLogBuffer();
+  auto write_events = [&](const QueryDataTyped& rows, const char* action) {
+    for (const auto& row : rows) {
+      buffer.Clear();
+      LogWriter writer(buffer);
+      if (!writeEvent(writer, item, row, action)) {
+        return false;
+      }
+      items.emplace_back(buffer.GetString(), buffer.GetSize());
+    }
+    return true;
+  };
+
+  bool written = false;
+  if (!item.isSnapshot) {
+    written = write_events(item.results.removed, "removed") &&
+              write_events(item.results.added, "added");
+  } else {
+    written = write_events(item.snapshot_results, "snapshot");
+  }
+
+  if (!written) {
+    items.resize(first_event);
+    return serializeQueryLogItemAsEventsDocumentJSON(item, items);
+  }
+  return Status::success();
+}
+
 } // namespace osquery
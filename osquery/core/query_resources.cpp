@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// Needed for RUSAGE_THREAD, before including anything else.
+#define _GNU_SOURCE
+#endif
+
+#ifdef OSQUERY_WINDOWS
+#include <osquery/utils/system/system.h>
+
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <osquery/core/query_resources.h>
+
+namespace osquery {
+
+namespace {
+
+/// The innermost active accounting of the calling thread.
+thread_local QueryResourceAccounting* kActiveAccounting{nullptr};
+
+/// Microseconds spent in completed tables nested in the current table.
+thread_local std::uint64_t kNestedTableTime{0};
+
+std::uint64_t getElapsedUs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+std::uint64_t getDifference(std::uint64_t start, std::uint64_t end) {
+  return (end > start) ? end - start : 0;
+}
+
+#ifdef OSQUERY_WINDOWS
+std::uint64_t fileTimeToUs(const FILETIME& time) {
+  ULARGE_INTEGER value;
+  value.LowPart = time.dwLowDateTime;
+  value.HighPart = time.dwHighDateTime;
+  // FILETIME durations are expressed in 100-nanosecond intervals.
+  return value.QuadPart / 10;
+}
+#elif !defined(__APPLE__)
+std::uint64_t timevalToUs(const struct timeval& time) {
+  return static_cast<std::uint64_t>(time.tv_sec) * 1000000 + time.tv_usec;
+}
+#endif
+
+void sampleThreadTimes(ThreadResourceSample& sample) {
+#if defined(OSQUERY_WINDOWS)
+  FILETIME creation, exit, kernel, user;
+  if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+    sample.user_time_us = fileTimeToUs(user);
+    sample.system_time_us = fileTimeToUs(kernel);
+  }
+#elif defined(__APPLE__)
+  thread_basic_info_data_t info;
+  mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+  auto thread = mach_thread_self();
+  if (thread_info(thread,
+                  THREAD_BASIC_INFO,
+                  reinterpret_cast<thread_info_t>(&info),
+                  &count) == KERN_SUCCESS) {
+    sample.user_time_us =
+        static_cast<std::uint64_t>(info.user_time.seconds) * 1000000 +
+        info.user_time.microseconds;
+    sample.system_time_us =
+        static_cast<std::uint64_t>(info.system_time.seconds) * 1000000 +
+        info.system_time.microseconds;
+  }
+  mach_port_deallocate(mach_task_self(), thread);
+#else
+  struct rusage usage;
+#ifdef RUSAGE_THREAD
+  auto who = RUSAGE_THREAD;
+#else
+  auto who = RUSAGE_SELF;
+#endif
+  if (getrusage(who, &usage) == 0) {
+    sample.user_time_us = timevalToUs(usage.ru_utime);
+    sample.system_time_us = timevalToUs(usage.ru_stime);
+  }
+#endif
+}
+
+void sampleHeap(ThreadResourceSample& sample) {
+#if defined(OSQUERY_WINDOWS)
+  PROCESS_MEMORY_COUNTERS_EX counters;
+  if (GetProcessMemoryInfo(
+          GetCurrentProcess(),
+          reinterpret_cast<PPROCESS_MEMORY_COUNTERS>(&counters),
+          sizeof(counters))) {
+    sample.heap_in_use = counters.PrivateUsage;
+  }
+#elif defined(__APPLE__)
+  malloc_statistics_t stats;
+  malloc_zone_statistics(nullptr, &stats);
+  sample.heap_in_use = stats.size_in_use;
+#elif defined(__GLIBC__)
+  // Chunks in use, both within arenas and individually mapped.
+#if __GLIBC_PREREQ(2, 33)
+  auto info = mallinfo2();
+  sample.heap_in_use = info.uordblks + info.hblkhd;
+#else
+  auto info = mallinfo();
+  sample.heap_in_use = static_cast<unsigned int>(info.uordblks) +
+                       static_cast<unsigned int>(info.hblkhd);
+#endif
+#else
+  (void)sample;
+#endif
+}
+
+} // namespace
+
+ThreadResourceSample getThreadResourceSample() {
+  ThreadResourceSample sample;
+  sampleThreadTimes(sample);
+  sampleHeap(sample);
+  return sample;
+}
+
+std::uint64_t QueryResourceUsage::getGenerateTimeMs() const {
+  std::uint64_t total = 0;
+  for (const auto& table : table_time_us) {
+    total += table.second;
+  }
+  return total / 1000;
+}
+
+QueryResourceAccounting::QueryResourceAccounting()
+    : start_(getThreadResourceSample()),
+      start_time_(std::chrono::steady_clock::now()),
+      previous_(kActiveAccounting) {
+  kActiveAccounting = this;
+}
+
+QueryResourceAccounting::~QueryResourceAccounting() {
+  stop();
+}
+
+const QueryResourceUsage& QueryResourceAccounting::stop() {
+  if (stopped_) {
+    return usage_;
+  }
+
+  auto end = getThreadResourceSample();
+  usage_.wall_time_ms = getElapsedUs(start_time_) / 1000;
+  usage_.user_time_ms =
+      getDifference(start_.user_time_us, end.user_time_us) / 1000;
+  usage_.system_time_ms =
+      getDifference(start_.system_time_us, end.system_time_us) / 1000;
+  usage_.memory = getDifference(start_.heap_in_use, end.heap_in_use);
+
+  // Accounting is scoped, restore the outer instance.
+  if (kActiveAccounting == this) {
+    kActiveAccounting = previous_;
+  }
+  stopped_ = true;
+  return usage_;
+}
+
+bool QueryResourceAccounting::isActive() {
+  return kActiveAccounting != nullptr;
+}
+
+void QueryResourceAccounting::recordTable(const std::string& table,
+                                          std::uint64_t time_us) {
+  if (kActiveAccounting != nullptr && !kActiveAccounting->stopped_) {
+    kActiveAccounting->usage_.table_time_us[table] += time_us;
+  }
+}
+
+TableResourceScope::TableResourceScope(const std::string& table) {
+  if (!QueryResourceAccounting::isActive()) {
+    return;
+  }
+
+  active_ = true;
+  table_ = table;
+  start_time_ = std::chrono::steady_clock::now();
+  outer_nested_us_ = kNestedTableTime;
+  kNestedTableTime = 0;
+}
+
+TableResourceScope::~TableResourceScope() {
+  if (!active_) {
+    return;
+  }
+
+  auto elapsed = getElapsedUs(start_time_);
+  QueryResourceAccounting::recordTable(
+      table_, getDifference(kNestedTableTime, elapsed));
+  kNestedTableTime = outer_nested_us_ + elapsed;
+}
+
+} // namespace osquery
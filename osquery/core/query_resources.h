@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+namespace osquery {
+
+/**
+ * @brief A point-in-time sample of the resources used by the calling thread.
+ *
+ * CPU times are for the calling thread only. The allocator counter is the
+ * number of bytes the process heap currently has in use, threads share a
+ * heap, so growth of this counter is only an estimate of a query's memory.
+ */
+struct ThreadResourceSample {
+  /// Thread user time in microseconds.
+  std::uint64_t user_time_us{0};
+
+  /// Thread system time in microseconds.
+  std::uint64_t system_time_us{0};
+
+  /// Bytes of heap memory in use, 0 if the allocator cannot be inspected.
+  std::uint64_t heap_in_use{0};
+};
+
+/// Sample the calling thread's CPU times and the allocator's counters.
+ThreadResourceSample getThreadResourceSample();
+
+/**
+ * @brief The resources used by a query, the difference of two samples.
+ *
+ * Table generate time is exclusive: time a table spends running a nested
+ * query is attributed to the tables of the nested query.
+ */
+struct QueryResourceUsage {
+  /// Wall time in milliseconds.
+  std::uint64_t wall_time_ms{0};
+
+  /// User time in milliseconds.
+  std::uint64_t user_time_ms{0};
+
+  /// System time in milliseconds.
+  std::uint64_t system_time_ms{0};
+
+  /// Growth in bytes of heap memory in use, 0 if the heap shrank.
+  std::uint64_t memory{0};
+
+  /// Microseconds spent in each table's xFilter/generate, by table name.
+  std::map<std::string, std::uint64_t> table_time_us;
+
+  /// The sum of the time spent in every table, in milliseconds.
+  std::uint64_t getGenerateTimeMs() const;
+};
+
+/**
+ * @brief Account for the resources used while running a query on this thread.
+ *
+ * Construct this before executing a query and call stop once it completes.
+ * While an instance is active, the virtual table implementation attributes
+ * the time spent generating rows to each table through TableResourceScope.
+ *
+ * Instances may be nested, for example a distributed query run while a
+ * scheduled query is being accounted. Tables only report to the innermost
+ * active instance.
+ *
+ * Example:
+ *   @code{.cpp}
+ *     QueryResourceAccounting accounting;
+ *     SQL sql(query);
+ *     auto usage = accounting.stop();
+ *   @endcode
+ */
+class QueryResourceAccounting : private boost::noncopyable {
+ public:
+  QueryResourceAccounting();
+  ~QueryResourceAccounting();
+
+  /// Stop accounting and return the resources used since construction.
+  const QueryResourceUsage& stop();
+
+  /// Check if the calling thread is accounting for a query.
+  static bool isActive();
+
+  /// Attribute generate time to a table of the innermost active query.
+  static void recordTable(const std::string& table, std::uint64_t time_us);
+
+ private:
+  /// The sample taken at construction.
+  ThreadResourceSample start_;
+
+  /// The wall time at construction.
+  std::chrono::steady_clock::time_point start_time_;
+
+  /// The resources used, completed by stop.
+  QueryResourceUsage usage_;
+
+  /// The instance active on this thread before this one.
+  QueryResourceAccounting* previous_{nullptr};
+
+  /// Set once stop has been called.
+  bool stopped_{false};
+};
+
+/**
+ * @brief Time a table's row generation for the active query accounting.
+ *
+ * This does nothing, not even read a clock, unless the calling thread has an
+ * active QueryResourceAccounting.
+ */
+class TableResourceScope : private boost::noncopyable {
+ public:
+  explicit TableResourceScope(const std::string& table);
+  ~TableResourceScope();
+
+ private:
+  /// Set if the calling thread has an active accounting.
+  bool active_{false};
+
+  /// The table being generated.
+  std::string table_;
+
+  /// The wall time when the table started generating.
+  std::chrono::steady_clock::time_point start_time_;
+
+  /// Time already spent in nested tables when this scope started.
+  std::uint64_t outer_nested_us_{0};
+};
+
+} // namespace osquery
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osquery {
+
+/**
+ * @brief A least-recently-used cache bounded by the memory of its values.
+ *
+ * Each value is inserted with its estimated size in bytes. Inserting evicts
+ * the least recently used values until the total fits within the maximum,
+ * values larger than the maximum are not cached.
+ *
+ * The cache is not synchronized, callers hold their own lock. Only the const
+ * methods may be called concurrently.
+ */
+template <typename Value>
+class SizedLRUCache {
+ public:
+  explicit SizedLRUCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /// Find a value without changing its position.
+  const Value* peek(const std::string& key) const {
+    auto it = index_.find(key);
+    return (it == index_.end()) ? nullptr : &it->second->value;
+  }
+
+  /// Find a value and mark it as the most recently used.
+  Value* get(const std::string& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
+
+  /**
+   * @brief Insert or replace a value, evicting the least recently used.
+   *
+   * @return False if the value is larger than the maximum, it is not cached
+   * and an existing value for the key is left unchanged.
+   */
+  bool insert(const std::string& key, Value value, size_t bytes) {
+    if (bytes > max_bytes_) {
+      return false;
+    }
+
+    erase(key);
+    while (!entries_.empty() && bytes_ + bytes > max_bytes_) {
+      erase(std::prev(entries_.end()));
+    }
+
+    entries_.push_front({key, std::move(value), bytes});
+    index_[key] = entries_.begin();
+    bytes_ += bytes;
+    return true;
+  }
+
+  /// Remove a value, returns false if the key is not cached.
+  bool erase(const std::string& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+
+    erase(it->second);
+    return true;
+  }
+
+  /// Remove every value.
+  void clear() {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  /// The number of cached values.
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /// The estimated memory of all cached values.
+  size_t bytes() const {
+    return bytes_;
+  }
+
+  /// The maximum estimated memory of all cached values.
+  size_t capacity() const {
+    return max_bytes_;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    Value value;
+    size_t bytes{0};
+  };
+
+  using EntryList = std::list<Entry>;
+
+  void erase(typename EntryList::iterator entry) {
+    bytes_ -= entry->bytes;
+    index_.erase(entry->key);
+    entries_.erase(entry);
+  }
+
+ private:
+  /// Entries ordered from most to least recently used.
+  EntryList entries_;
+
+  /// Lookup of entries by key.
+  std::unordered_map<std::string, typename EntryList::iterator> index_;
+
+  /// Maximum estimated memory of all cached values.
+  size_t max_bytes_{0};
+
+  /// Current estimated memory of all cached values.
+  size_t bytes_{0};
+};
+
+} // namespace osquery
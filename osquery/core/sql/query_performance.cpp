@@ -45,6 +45,12 @@ QueryPerformance::QueryPerformance(const std::string& csv) {
   average_memory = convert<std::uint64_t>(parts[9]);
   last_memory = convert<std::uint64_t>(parts[10]);
   output_size = convert<std::uint64_t>(parts[11]);
+
+  // Statistics recorded before table generate time was tracked have 12 parts.
+  if (parts.size() >= 14) {
+    generate_time_ms = convert<std::uint64_t>(parts[12]);
+    last_generate_time_ms = convert<std::uint64_t>(parts[13]);
+  }
 }
 
 std::string QueryPerformance::toCSV() const {
@@ -55,7 +61,9 @@ std::string QueryPerformance::toCSV() const {
          "," + std::to_string(system_time) + "," +
          std::to_string(last_system_time) + "," +
          std::to_string(average_memory) + "," + std::to_string(last_memory) +
-         "," + std::to_string(output_size);
+         "," + std::to_string(output_size) + "," +
+         std::to_string(generate_time_ms) + "," +
+         std::to_string(last_generate_time_ms);
 }
 
 bool operator==(const QueryPerformance& l, const QueryPerformance& r) {
@@ -70,7 +78,9 @@ bool operator==(const QueryPerformance& l, const QueryPerformance& r) {
                   l.last_system_time,
                   l.average_memory,
                   l.last_memory,
-                  l.output_size) == std::tie(r.executions,
+                  l.output_size,
+                  l.generate_time_ms,
+                  l.last_generate_time_ms) == std::tie(r.executions,
                                              r.last_executed,
                                              r.wall_time,
                                              r.wall_time_ms,
@@ -81,7 +91,9 @@ bool operator==(const QueryPerformance& l, const QueryPerformance& r) {
                                              r.last_system_time,
                                              r.average_memory,
                                              r.last_memory,
-                                             r.output_size);
+                                             r.output_size,
+                                             r.generate_time_ms,
+                                             r.last_generate_time_ms);
 }
 
 } // namespace osquery
@@ -46,17 +46,23 @@ struct QueryPerformance {
   /// System time in milliseconds of the latest execution
   std::uint64_t last_system_time{0};
 
-  /// Average of the bytes of resident memory left allocated
+  /// Average of the bytes of heap memory left allocated
   /// after collecting results
   std::uint64_t average_memory{0};
 
-  /// Resident memory in bytes left allocated after collecting results
+  /// Heap memory in bytes left allocated after collecting results
   /// of the latest execution
   std::uint64_t last_memory{0};
 
   /// Total bytes for the query
   std::uint64_t output_size{0};
 
+  /// Total time in milliseconds spent generating table rows
+  std::uint64_t generate_time_ms{0};
+
+  /// Time in milliseconds spent generating table rows of the latest execution
+  std::uint64_t last_generate_time_ms{0};
+
   // Default constructor
   QueryPerformance() = default;
 
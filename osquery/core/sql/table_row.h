@@ -56,6 +56,13 @@ class TableRow {
    */
   virtual operator Row() const = 0;
 
+  /**
+   * Estimate the memory owned by this row, used to bound result caches.
+   */
+  virtual size_t getMemorySize() const {
+    return sizeof(*this);
+  }
+
  protected:
   TableRow(const TableRow&) = default;
   TableRow& operator=(const TableRow&) = default;
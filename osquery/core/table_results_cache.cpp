@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/core/flags.h>
+#include <osquery/core/table_results_cache.h>
+
+namespace osquery {
+
+FLAG(uint32,
+     table_cache_max_size,
+     64,
+     "Maximum memory in MB used to share cacheable table results");
+
+namespace {
+
+std::string cacheKey(const std::string& table, const std::string& fingerprint) {
+  std::string key;
+  key.reserve(table.size() + fingerprint.size() + 1);
+  key += table;
+  key += '\0';
+  key += fingerprint;
+  return key;
+}
+
+bool isFresh(uint64_t step, uint64_t cached_step, uint64_t interval) {
+  return step < cached_step + interval;
+}
+
+} // namespace
+
+int SharedTableRow::get_rowid(sqlite_int64 default_value,
+                              sqlite_int64* pRowid) const {
+  return row().get_rowid(default_value, pRowid);
+}
+
+int SharedTableRow::get_column(sqlite3_context* ctx,
+                               sqlite3_vtab* pVtab,
+                               int col) {
+  return row().get_column(ctx, pVtab, col);
+}
+
+Status SharedTableRow::serialize(JSON& doc, rapidjson::Value& obj) const {
+  return row().serialize(doc, obj);
+}
+
+TableRowHolder SharedTableRow::clone() const {
+  return TableRowHolder(new SharedTableRow(rows_, index_));
+}
+
+SharedTableRow::operator Row() const {
+  return static_cast<Row>(row());
+}
+
+TableResultsCache& TableResultsCache::get() {
+  static TableResultsCache cache(static_cast<size_t>(FLAGS_table_cache_max_size)
+                                 << 20);
+  return cache;
+}
+
+TableResultsCache::TableResultsCache(size_t max_bytes)
+    : entries_(max_bytes) {}
+
+bool TableResultsCache::lookup(const std::string& table,
+                               const std::string& fingerprint,
+                               uint64_t step,
+                               TableRows& results) {
+  SharedTableRows rows;
+  {
+    auto key = cacheKey(table, fingerprint);
+    WriteLock lock(mutex_);
+    auto entry = entries_.get(key);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    if (!isFresh(step, entry->step, entry->interval)) {
+      entries_.erase(key);
+      return false;
+    }
+
+    rows = entry->rows;
+  }
+
+  // Build the references outside of the lock, the rows are immutable.
+  results.clear();
+  results.reserve(rows->size());
+  for (size_t i = 0; i < rows->size(); ++i) {
+    results.push_back(TableRowHolder(new SharedTableRow(rows, i)));
+  }
+  return true;
+}
+
+bool TableResultsCache::contains(const std::string& table,
+                                 const std::string& fingerprint,
+                                 uint64_t step) const {
+  auto key = cacheKey(table, fingerprint);
+  ReadLock lock(mutex_);
+  auto entry = entries_.peek(key);
+  return (entry != nullptr && isFresh(step, entry->step, entry->interval));
+}
+
+void TableResultsCache::insert(const std::string& table,
+                               const std::string& fingerprint,
+                               uint64_t step,
+                               uint64_t interval,
+                               TableRows& results) {
+  size_t bytes = 0;
+  for (const auto& row : results) {
+    bytes += row->getMemorySize();
+  }
+
+  if (bytes > entries_.capacity()) {
+    return;
+  }
+
+  auto rows = std::make_shared<TableRows>(std::move(results));
+  results.clear();
+  results.reserve(rows->size());
+  for (size_t i = 0; i < rows->size(); ++i) {
+    results.push_back(TableRowHolder(new SharedTableRow(rows, i)));
+  }
+
+  Entry entry;
+  entry.rows = std::move(rows);
+  entry.step = step;
+  entry.interval = interval;
+
+  auto key = cacheKey(table, fingerprint);
+  WriteLock lock(mutex_);
+  entries_.insert(key, std::move(entry), bytes);
+}
+
+void TableResultsCache::clear() {
+  WriteLock lock(mutex_);
+  entries_.clear();
+}
+
+size_t TableResultsCache::size() const {
+  ReadLock lock(mutex_);
+  return entries_.size();
+}
+
+size_t TableResultsCache::bytes() const {
+  ReadLock lock(mutex_);
+  return entries_.bytes();
+}
+
+} // namespace osquery
@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/core/sized_lru_cache.h>
+#include <osquery/core/sql/table_rows.h>
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+
+/**
+ * @brief Generated results owned by the table results cache.
+ *
+ * The rows are never modified once they are cached, every reader of the cache
+ * references them through SharedTableRow.
+ */
+using SharedTableRows = std::shared_ptr<TableRows>;
+
+/**
+ * @brief A TableRow referencing a single row of shared, cached results.
+ *
+ * Holding a SharedTableRow keeps all of the cached results alive, even after
+ * they are evicted from the cache. Cloning only copies the reference.
+ */
+class SharedTableRow : public TableRow {
+ public:
+  SharedTableRow(SharedTableRows rows, size_t index)
+      : rows_(std::move(rows)), index_(index) {}
+
+  int get_rowid(sqlite_int64 default_value,
+                sqlite_int64* pRowid) const override;
+  int get_column(sqlite3_context* ctx, sqlite3_vtab* pVtab, int col) override;
+  Status serialize(JSON& doc, rapidjson::Value& obj) const override;
+  TableRowHolder clone() const override;
+  operator Row() const override;
+
+ private:
+  TableRow& row() const {
+    return *(*rows_)[index_];
+  }
+
+ private:
+  /// The cached results this row belongs to.
+  SharedTableRows rows_;
+
+  /// The position of this row within the cached results.
+  size_t index_{0};
+};
+
+/**
+ * @brief An in-memory cache of results generated by CACHEABLE tables.
+ *
+ * Scheduled queries executing within the same interval share the results of
+ * cacheable tables. Entries are keyed by the table name and a fingerprint of
+ * the constraints passed to the table's generate method. An entry is fresh
+ * until the schedule step passes the step it was cached at plus its interval.
+ *
+ * Entries are evicted least-recently-used first when the estimated memory of
+ * all cached rows exceeds the configured maximum.
+ */
+class TableResultsCache : private boost::noncopyable {
+ public:
+  /// The process-wide cache, sized using --table_cache_max_size.
+  static TableResultsCache& get();
+
+  /// Create a cache holding at most max_bytes of estimated row memory.
+  explicit TableResultsCache(size_t max_bytes);
+
+  /**
+   * @brief Retrieve fresh results for a table.
+   *
+   * @param table The table name.
+   * @param fingerprint The constraint fingerprint of the request.
+   * @param step The current schedule step.
+   * @param results The output, SharedTableRow%s referencing the cached rows.
+   *
+   * @return True if fresh results were found, otherwise false.
+   */
+  bool lookup(const std::string& table,
+              const std::string& fingerprint,
+              uint64_t step,
+              TableRows& results);
+
+  /// Check if fresh results exist, without retrieving them.
+  bool contains(const std::string& table,
+                const std::string& fingerprint,
+                uint64_t step) const;
+
+  /**
+   * @brief Take ownership of a table's generated results.
+   *
+   * On success results is replaced with SharedTableRow%s referencing the
+   * cached rows, so the caller may continue to use them. Results larger than
+   * the cache are left unchanged and are not cached.
+   */
+  void insert(const std::string& table,
+              const std::string& fingerprint,
+              uint64_t step,
+              uint64_t interval,
+              TableRows& results);
+
+  /// Remove every entry.
+  void clear();
+
+  /// The number of cached results.
+  size_t size() const;
+
+  /// The estimated memory used by all cached rows.
+  size_t bytes() const;
+
+ private:
+  struct Entry {
+    SharedTableRows rows;
+    uint64_t step{0};
+    uint64_t interval{0};
+  };
+
+ private:
+  /// Entries by table and fingerprint, bounded by their rows' memory.
+  SizedLRUCache<Entry> entries_;
+
+  mutable Mutex mutex_;
+};
+
+} // namespace osquery
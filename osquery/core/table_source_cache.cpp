@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/core/table_source_cache.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+FLAG(uint32,
+     table_source_cache_max_size,
+     32,
+     "Maximum memory in MB used to reuse rows parsed from unchanged files");
+
+namespace {
+
+std::string cacheKey(const std::string& table, const std::string& key) {
+  std::string cache_key;
+  cache_key.reserve(table.size() + key.size() + 1);
+  cache_key += table;
+  cache_key += '\0';
+  cache_key += key;
+  return cache_key;
+}
+
+} // namespace
+
+SourceFingerprint::SourceFingerprint(const std::vector<std::string>& paths) {
+  for (const auto& path : paths) {
+    add(path);
+  }
+}
+
+bool SourceFingerprint::FileState::operator==(const FileState& other) const {
+  return exists == other.exists && inode == other.inode &&
+         size == other.size && mtime == other.mtime && path == other.path;
+}
+
+SourceFingerprint::FileState SourceFingerprint::getFileState(
+    const std::string& path) {
+  FileState state;
+  state.path = path;
+
+  struct stat file;
+  if (::stat(path.c_str(), &file) != 0) {
+    return state;
+  }
+
+  state.exists = true;
+  state.inode = static_cast<uint64_t>(file.st_ino);
+  state.size = static_cast<uint64_t>(file.st_size);
+#if defined(__linux__)
+  state.mtime = static_cast<int64_t>(file.st_mtim.tv_sec) * 1000000000 +
+                file.st_mtim.tv_nsec;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+  state.mtime = static_cast<int64_t>(file.st_mtimespec.tv_sec) * 1000000000 +
+                file.st_mtimespec.tv_nsec;
+#else
+  state.mtime = static_cast<int64_t>(file.st_mtime) * 1000000000;
+#endif
+  return state;
+}
+
+void SourceFingerprint::addPath(const std::string& path,
+                                std::vector<FileState>& files) {
+  files.push_back(getFileState(path));
+
+  boost::system::error_code ec;
+  if (!files.back().exists || !fs::is_directory(path, ec)) {
+    return;
+  }
+
+  // Files rewritten in place do not change their directory's mtime.
+  std::vector<std::string> entries;
+  for (fs::directory_iterator it(path, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    entries.push_back(it->path().string());
+  }
+  std::sort(entries.begin(), entries.end());
+  for (const auto& entry : entries) {
+    files.push_back(getFileState(entry));
+  }
+}
+
+void SourceFingerprint::add(const std::string& path) {
+  paths_.push_back(path);
+  addPath(path, files_);
+}
+
+bool SourceFingerprint::changed() const {
+  std::vector<FileState> files;
+  files.reserve(files_.size());
+  for (const auto& path : paths_) {
+    addPath(path, files);
+  }
+  return files != files_;
+}
+
+bool SourceFingerprint::operator==(const SourceFingerprint& other) const {
+  return paths_ == other.paths_ && files_ == other.files_;
+}
+
+TableSourceCache& TableSourceCache::get() {
+  static TableSourceCache cache(
+      static_cast<size_t>(FLAGS_table_source_cache_max_size) << 20);
+  return cache;
+}
+
+TableSourceCache::TableSourceCache(size_t max_bytes) : entries_(max_bytes) {}
+
+size_t TableSourceCache::getMemorySize(const Row& row) {
+  size_t bytes = sizeof(Row);
+  for (const auto& column : row) {
+    bytes += column.first.size() + column.second.size() +
+             2 * sizeof(std::string);
+  }
+  return bytes;
+}
+
+QueryData TableSourceCache::generate(const std::string& table,
+                                     const std::string& key,
+                                     const std::vector<std::string>& sources,
+                                     const Generator& generator) {
+  QueryData results;
+  SourceFingerprint fingerprint;
+  if (entries_.capacity() == 0) {
+    generator(fingerprint, results);
+    return results;
+  }
+
+  if (lookup(table, key, results)) {
+    return results;
+  }
+
+  for (const auto& source : sources) {
+    fingerprint.add(source);
+  }
+  if (generator(fingerprint, results).ok()) {
+    insert(table, key, std::move(fingerprint), results);
+  }
+  return results;
+}
+
+bool TableSourceCache::lookup(const std::string& table,
+                              const std::string& key,
+                              QueryData& results) {
+  auto cache_key = cacheKey(table, key);
+  std::shared_ptr<const QueryData> rows;
+  SourceFingerprint sources;
+  {
+    ReadLock lock(mutex_);
+    auto entry = entries_.peek(cache_key);
+    if (entry == nullptr) {
+      return false;
+    }
+    rows = entry->rows;
+    sources = entry->sources;
+  }
+
+  // Stat the sources outside of the lock.
+  auto changed = sources.changed();
+
+  {
+    WriteLock lock(mutex_);
+    auto entry = entries_.get(cache_key);
+    // The entry may have been replaced while the sources were checked.
+    if (entry != nullptr && entry->rows == rows && changed) {
+      entries_.erase(cache_key);
+    }
+  }
+
+  if (changed) {
+    return false;
+  }
+
+  results = *rows;
+  return true;
+}
+
+void TableSourceCache::insert(const std::string& table,
+                              const std::string& key,
+                              SourceFingerprint sources,
+                              QueryData rows) {
+  size_t bytes = 0;
+  for (const auto& row : rows) {
+    bytes += getMemorySize(row);
+  }
+
+  if (entries_.capacity() == 0 || bytes > entries_.capacity()) {
+    return;
+  }
+
+  Entry entry;
+  entry.rows = std::make_shared<const QueryData>(std::move(rows));
+  entry.sources = std::move(sources);
+
+  auto cache_key = cacheKey(table, key);
+  WriteLock lock(mutex_);
+  entries_.insert(cache_key, std::move(entry), bytes);
+}
+
+void TableSourceCache::clear() {
+  WriteLock lock(mutex_);
+  entries_.clear();
+}
+
+size_t TableSourceCache::size() const {
+  ReadLock lock(mutex_);
+  return entries_.size();
+}
+
+size_t TableSourceCache::bytes() const {
+  ReadLock lock(mutex_);
+  return entries_.bytes();
+}
+
+} // namespace osquery
@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/core/sized_lru_cache.h>
+#include <osquery/core/sql/query_data.h>
+#include <osquery/utils/mutex.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/**
+ * @brief The state of the files a table's results are parsed from.
+ *
+ * Each source path is recorded with its inode, size and modification time.
+ * A directory also records every file it directly contains, so adding,
+ * removing or rewriting a file within it changes the fingerprint.
+ * A missing path is recorded as missing, creating it changes the fingerprint.
+ */
+class SourceFingerprint {
+ public:
+  SourceFingerprint() = default;
+  explicit SourceFingerprint(const std::vector<std::string>& paths);
+
+  /// Record the current state of a path, before it is read.
+  void add(const std::string& path);
+
+  /// Check if any recorded path differs from its current state.
+  bool changed() const;
+
+  bool operator==(const SourceFingerprint& other) const;
+  bool operator!=(const SourceFingerprint& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  struct FileState {
+    std::string path;
+    bool exists{false};
+    uint64_t inode{0};
+    uint64_t size{0};
+    int64_t mtime{0};
+
+    bool operator==(const FileState& other) const;
+  };
+
+  /// Stat a single path.
+  static FileState getFileState(const std::string& path);
+
+  /// Append the state of a path, and of the files within a directory.
+  static void addPath(const std::string& path, std::vector<FileState>& files);
+
+ private:
+  /// The paths passed to add, in order.
+  std::vector<std::string> paths_;
+
+  /// The state of each path, followed by the files within directories.
+  std::vector<FileState> files_;
+};
+
+/**
+ * @brief An in-memory cache of rows parsed from rarely changing files.
+ *
+ * Package inventory tables parse databases such as the rpmdb or the dpkg
+ * status file, which only change when packages are installed or removed.
+ * Such tables declare the files their rows are parsed from, and reuse the
+ * rows parsed by a previous query until one of those files changes.
+ *
+ * Entries are keyed by the table name and a key describing the constraints
+ * used to generate the rows. Entries are evicted least-recently-used first
+ * when the estimated memory of all cached rows exceeds the configured
+ * maximum, rows larger than the maximum are not cached. A maximum of 0
+ * disables the cache.
+ *
+ * Example:
+ *   @code{.cpp}
+ *     return TableSourceCache::get().generate(
+ *         "yum_sources", "", {"/etc/yum.conf"},
+ *         ([&](SourceFingerprint& sources, QueryData& results) {
+ *           auto repos_dir = parseConf("/etc/yum.conf", results);
+ *           // Discovered sources are added before they are read.
+ *           sources.add(repos_dir);
+ *           return parseRepos(repos_dir, results);
+ *         }));
+ *   @endcode
+ */
+class TableSourceCache : private boost::noncopyable {
+ public:
+  /**
+   * @brief Generate a table's rows.
+   *
+   * The generator may add the sources it discovers while generating, before
+   * reading them. Rows are only cached if the generator succeeds.
+   */
+  using Generator =
+      std::function<Status(SourceFingerprint& sources, QueryData& results)>;
+
+ public:
+  /// The process-wide cache, sized using --table_source_cache_max_size.
+  static TableSourceCache& get();
+
+  /// Create a cache holding at most max_bytes of estimated row memory.
+  explicit TableSourceCache(size_t max_bytes);
+
+  /**
+   * @brief Reuse cached rows, or generate and cache them.
+   *
+   * @param table The table name.
+   * @param key The constraints used by the generator.
+   * @param sources The files and directories the rows are parsed from.
+   * @param generator Parses the rows, called when the sources changed.
+   *
+   * @return A copy of the cached rows, or the generated rows.
+   */
+  QueryData generate(const std::string& table,
+                     const std::string& key,
+                     const std::vector<std::string>& sources,
+                     const Generator& generator);
+
+  /**
+   * @brief Retrieve rows if none of their sources changed.
+   *
+   * Rows with changed sources are evicted.
+   */
+  bool lookup(const std::string& table,
+              const std::string& key,
+              QueryData& results);
+
+  /**
+   * @brief Cache rows parsed from the sources.
+   *
+   * The fingerprint must be taken before the sources were read, a source
+   * changing while it is read then invalidates the rows on the next lookup.
+   */
+  void insert(const std::string& table,
+              const std::string& key,
+              SourceFingerprint sources,
+              QueryData rows);
+
+  /// Remove every entry.
+  void clear();
+
+  /// The number of cached entries.
+  size_t size() const;
+
+  /// The estimated memory used by all cached rows.
+  size_t bytes() const;
+
+  /// The maximum estimated memory of all cached rows.
+  size_t capacity() const {
+    return entries_.capacity();
+  }
+
+  /// The estimated memory used by a row.
+  static size_t getMemorySize(const Row& row);
+
+ private:
+  struct Entry {
+    std::shared_ptr<const QueryData> rows;
+    SourceFingerprint sources;
+  };
+
+ private:
+  /// Entries by table and key, bounded by their rows' memory.
+  SizedLRUCache<Entry> entries_;
+
+  mutable Mutex mutex_;
+};
+
+} // namespace osquery
@@ -10,8 +10,8 @@
 #include <osquery/utils/json/json.h>
 
 #include <osquery/core/flags.h>
+#include <osquery/core/table_results_cache.h>
 #include <osquery/core/tables.h>
-#include <osquery/database/database.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/utils/conversions/tryto.h>
@@ -37,6 +37,24 @@ static constexpr R bitmask(unsigned int const onecount) {
          (static_cast<R>(-1) >> ((sizeof(R) * CHAR_BIT) - onecount));
 }
 
+/// Serialize the pushed down row limit and order of a context.
+static void serializeLimit(const QueryContext& context, JSON& doc) {
+  if (context.limit) {
+    doc.add("limit", static_cast<unsigned long long>(*context.limit));
+  }
+
+  if (!context.orderBy.empty()) {
+    auto order_by = doc.getArray();
+    for (const auto& order : context.orderBy) {
+      auto child = doc.getObject();
+      doc.addRef("column", order.column, child);
+      doc.add("descending", order.descending, child);
+      doc.push(child, order_by);
+    }
+    doc.add("orderBy", order_by);
+  }
+}
+
 Status TablePlugin::addExternal(const std::string& name,
                                 const PluginResponse& response) {
   // Attach the table.
@@ -85,6 +103,8 @@ void TablePlugin::setRequestFromContext(const QueryContext& context,
     doc.add("colsUsedBitset", context.colsUsedBitset->to_ullong());
   }
 
+  serializeLimit(context, doc);
+
   doc.toString(request["context"]);
 }
 
@@ -192,60 +212,102 @@ PluginResponse TablePlugin::routeInfo() const {
   response.push_back(
       {{"id", "attributes"},
        {"attributes", INTEGER(static_cast<size_t>(attributes()))}});
+
+  // Cost hints are optional, tables without hints keep the default costs.
+  auto table_cost = cost();
+  if (table_cost.rows > 0 || table_cost.row_cost > 0) {
+    response.push_back({{"id", "cost"},
+                        {"rows", std::to_string(table_cost.rows)},
+                        {"row_cost", std::to_string(table_cost.row_cost)}});
+  }
+  for (const auto& column : table_cost.columns) {
+    response.push_back({{"id", "columnCost"},
+                        {"name", column.first},
+                        {"cost", std::to_string(column.second)}});
+  }
   return response;
 }
 
-static bool cacheAllowed(const TableColumns& cols, const QueryContext& ctx) {
+/// Columns whose constraints are passed to the table's generate method.
+static const ColumnOptions kGenerateOptions =
+    ColumnOptions::INDEX | ColumnOptions::REQUIRED | ColumnOptions::ADDITIONAL |
+    ColumnOptions::OPTIMIZED;
+
+static bool cacheAllowed(const QueryContext& ctx) {
   if (!ctx.useCache() || !ctx.defaultColumnsUsed()) {
     // The query execution did not request use of the warm cache.
     return false;
   }
+  return true;
+}
 
-  auto uncachable = ColumnOptions::INDEX | ColumnOptions::REQUIRED |
-                    ColumnOptions::ADDITIONAL | ColumnOptions::OPTIMIZED;
+/**
+ * @brief Fingerprint the constraints that may change generated results.
+ *
+ * Constraints on other columns are applied by SQLite after generate, so
+ * results are shared between queries that only differ in those constraints.
+ */
+static std::string cacheFingerprint(const TableColumns& cols,
+                                    const QueryContext& ctx) {
+  std::string fingerprint;
   for (const auto& column : cols) {
-    auto opts = std::get<2>(column) & uncachable;
-    if (opts && ctx.constraints.at(std::get<0>(column)).exists()) {
-      return false;
+    if (!(std::get<2>(column) & kGenerateOptions)) {
+      continue;
+    }
+
+    auto constraints = ctx.constraints.find(std::get<0>(column));
+    if (constraints == ctx.constraints.end() ||
+        !constraints->second.exists()) {
+      continue;
+    }
+
+    fingerprint += std::get<0>(column);
+    for (const auto& constraint : constraints->second.getAll()) {
+      fingerprint += '\0';
+      fingerprint += std::to_string(constraint.op);
+      fingerprint += ':';
+      fingerprint += constraint.expr;
     }
+    fingerprint += '\n';
   }
-  return true;
+  return fingerprint;
 }
 
 bool TablePlugin::isCached(uint64_t step, const QueryContext& ctx) const {
-  if (FLAGS_disable_caching) {
+  if (FLAGS_disable_caching || !cacheAllowed(ctx)) {
     return false;
   }
 
-  // Perform the step comparison first, because it's easy.
-  return (step < last_cached_ + last_interval_ && cacheAllowed(columns(), ctx));
+  return TableResultsCache::get().contains(
+      getName(), cacheFingerprint(columns(), ctx), step);
 }
 
-TableRows TablePlugin::getCache() const {
+bool TablePlugin::getCache(uint64_t step,
+                           const QueryContext& ctx,
+                           TableRows& results) const {
+  if (FLAGS_disable_caching || !cacheAllowed(ctx)) {
+    return false;
+  }
+
+  if (!TableResultsCache::get().lookup(
+          getName(), cacheFingerprint(columns(), ctx), step, results)) {
+    return false;
+  }
+
   VLOG(1) << "Retrieving results from cache for table: " << getName();
-  // Lookup results from database and deserialize.
-  std::string content;
-  getDatabaseValue(kQueries, "cache." + getName(), content);
-  TableRows results;
-  deserializeTableRowsJSON(content, results);
-  return results;
+  return true;
 }
 
 void TablePlugin::setCache(uint64_t step,
                            uint64_t interval,
                            const QueryContext& ctx,
-                           const TableRows& results) {
-  if (FLAGS_disable_caching || !cacheAllowed(columns(), ctx)) {
+                           TableRows& results) {
+  if (FLAGS_disable_caching || !cacheAllowed(ctx)) {
     return;
   }
 
-  // Serialize QueryData and save to database.
-  std::string content;
-  if (serializeTableRowsJSON(results, content)) {
-    last_cached_ = step;
-    last_interval_ = interval;
-    setDatabaseValue(kQueries, "cache." + getName(), content);
-  }
+  TableResultsCache::get().insert(
+      getName(), cacheFingerprint(columns(), ctx), step, interval, results);
 }
 
 std::string columnDefinition(const TableColumns& columns, bool is_extension) {
@@ -419,23 +481,34 @@ bool ConstraintList::matches(const std::string& expr) const {
 
 template <typename T>
 bool ConstraintList::literal_matches(const T& base_expr) const {
-  bool aggregate = true;
+  // Several EQUALS constraints are the values of an IN() list, the
+  // expression must equal one of them.
+  bool has_equals = false;
+  bool equals = false;
   for (size_t i = 0; i < constraints_.size(); ++i) {
     auto constraint_expr = tryTo<T>(constraints_[i].expr);
+    if (constraints_[i].op == EQUALS) {
+      has_equals = true;
+      // A value that cannot be cast to the column type never matches.
+      equals = equals ||
+               (constraint_expr && base_expr == constraint_expr.take());
+      continue;
+    }
+
     if (!constraint_expr) {
       // Cannot cast input constraint to column type.
       return false;
     }
-    if (constraints_[i].op == EQUALS) {
-      aggregate = aggregate && (base_expr == constraint_expr.take());
-    } else if (constraints_[i].op == GREATER_THAN) {
-      aggregate = aggregate && (base_expr > constraint_expr.take());
+
+    bool aggregate = true;
+    if (constraints_[i].op == GREATER_THAN) {
+      aggregate = (base_expr > constraint_expr.take());
     } else if (constraints_[i].op == LESS_THAN) {
-      aggregate = aggregate && (base_expr < constraint_expr.take());
+      aggregate = (base_expr < constraint_expr.take());
     } else if (constraints_[i].op == GREATER_THAN_OR_EQUALS) {
-      aggregate = aggregate && (base_expr >= constraint_expr.take());
+      aggregate = (base_expr >= constraint_expr.take());
     } else if (constraints_[i].op == LESS_THAN_OR_EQUALS) {
-      aggregate = aggregate && (base_expr <= constraint_expr.take());
+      aggregate = (base_expr <= constraint_expr.take());
     } else {
       // Unsupported constraint. Should match every thing.
       return true;
@@ -445,7 +518,7 @@ bool ConstraintList::literal_matches(const T& base_expr) const {
       return false;
     }
   }
-  return true;
+  return !has_equals || equals;
 }
 
 std::set<std::string> ConstraintList::getAll(ConstraintOperator op) const {
@@ -534,6 +607,11 @@ bool QueryContext::isAnyColumnUsed(
   return false;
 }
 
+bool QueryContext::isColumnGroupUsed(const std::string& group) const {
+  auto columns = columnGroups.find(group);
+  return columns == columnGroups.end() || isAnyColumnUsed(columns->second);
+}
+
 bool QueryContext::defaultColumnsUsed() const {
   auto mask = bitmask<uint64_t>(table_->columns.size());
   return !colsUsedBitset || *colsUsedBitset == mask;
@@ -605,6 +683,27 @@ Status deserializeQueryContextJSON(const JSON& json_helper,
     context.colsUsedBitset = rapidjson_doc["colsUsedBitset"].GetUint64();
   }
 
+  if (rapidjson_doc.HasMember("limit") && rapidjson_doc["limit"].IsUint64()) {
+    context.limit = static_cast<size_t>(rapidjson_doc["limit"].GetUint64());
+  }
+
+  if (rapidjson_doc.HasMember("orderBy") &&
+      rapidjson_doc["orderBy"].IsArray()) {
+    for (const auto& order : rapidjson_doc["orderBy"].GetArray()) {
+      if (!order.IsObject() || !order.HasMember("column") ||
+          !order["column"].IsString()) {
+        continue;
+      }
+
+      ColumnOrder column_order;
+      column_order.column = order["column"].GetString();
+      column_order.descending =
+          order.HasMember("descending") && order["descending"].IsBool() &&
+          order["descending"].GetBool();
+      context.orderBy.push_back(std::move(column_order));
+    }
+  }
+
   if (!rapidjson_doc.HasMember("constraints")) {
     return Status::failure(1, "Missing contraints field in JSON");
   }
@@ -649,6 +748,8 @@ void serializeQueryContextJSON(const QueryContext& context, JSON& json_helper) {
   if (context.colsUsedBitset) {
     json_helper.add("colsUsedBitset", context.colsUsedBitset->to_ullong());
   }
+
+  serializeLimit(context, json_helper);
 }
 
 } // namespace osquery
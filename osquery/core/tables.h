@@ -192,6 +192,9 @@ enum class TableAttributes {
 
   /// (Deprecated) This table's data requires an osquery kernel module.
   KERNEL_REQUIRED = 16,
+
+  /// The generator honors a row limit and order, see QueryContext::limit.
+  LIMIT_PUSHDOWN = 32,
 };
 
 /// Treat table attributes as a set of flags.
@@ -209,6 +212,24 @@ inline size_t operator&(TableAttributes a, TableAttributes b) {
 using TableColumns =
     std::vector<std::tuple<std::string, ColumnType, ColumnOptions>>;
 
+/**
+ * @brief Planner hints about the cost of generating a table's rows.
+ *
+ * Costs are relative to generating a row from memory. The planner uses them
+ * to prefer driving JOINs from cheap tables. A table without an expected row
+ * count keeps the planner's default costs.
+ */
+struct TableCost {
+  /// The expected number of rows generated by a scan, 0 if unknown.
+  uint64_t rows{0};
+
+  /// The additional cost of generating each row.
+  uint64_t row_cost{0};
+
+  /// The additional cost of each expensive column, when it is used.
+  std::map<std::string, uint64_t> columns;
+};
+
 /// Alias for map of column alias sets.
 using ColumnAliasSet = std::map<std::string, std::set<std::string>>;
 
@@ -242,6 +263,9 @@ struct ConstraintList : private boost::noncopyable {
    * If there are no predicate constraints in this list, all expression will
    * match. Constraints are limitations.
    *
+   * Several EQUALS constraints are the values of an IN() list, the expression
+   * must equal one of them and match every other constraint.
+   *
    * @param expr a SQL type expression of the column literal type to check.
    * @return If the expression matched all constraints.
    */
@@ -378,6 +402,37 @@ using UsedColumns = std::unordered_set<std::string>;
 using UsedColumnsBitset = std::bitset<
     std::numeric_limits<decltype(sqlite3_index_info().colUsed)>::digits>;
 
+/**
+ * @brief Named groups of columns that share an expensive lookup.
+ *
+ * Groups are declared in table specs with the column's group option, the
+ * generated table plugin provides them to the QueryContext.
+ */
+using ColumnGroups = std::map<std::string, UsedColumnsBitset>;
+
+/// A column rows are ordered by, from a query's ORDER BY clause.
+struct ColumnOrder {
+  /// The name of a column within the table.
+  std::string column;
+
+  /// Rows are ordered from the largest to the smallest value.
+  bool descending{false};
+};
+
+/**
+ * @brief A LIMIT and ORDER BY consumed by a table scan.
+ *
+ * These are only consumed for tables with the LIMIT_PUSHDOWN attribute.
+ */
+struct LimitPushdown {
+  /// The xFilter argument positions of the LIMIT and OFFSET, 0 if missing.
+  size_t limit_argument{0};
+  size_t offset_argument{0};
+
+  /// The order rows must be generated in, empty if unordered.
+  std::vector<ColumnOrder> order;
+};
+
 /**
  * @brief osquery table content descriptor.
  *
@@ -403,6 +458,9 @@ struct VirtualTableContent {
   /// passed to the SQL and optional Query for inspection.
   TableAttributes attributes{TableAttributes::NONE};
 
+  /// Cost hints are copied into the content for the planner.
+  TableCost cost;
+
   /**
    * @brief Table column aliases structure.
    *
@@ -421,6 +479,15 @@ struct VirtualTableContent {
   /// Transient set of virtual table used columns (as bitmasks)
   std::unordered_map<size_t, UsedColumnsBitset> colsUsedBitsets;
 
+  /// Transient set of virtual table limits and orders
+  std::unordered_map<size_t, LimitPushdown> limits;
+
+  /// Transient set of constraints receiving every IN value at once
+  std::unordered_map<size_t, std::set<size_t>> inLists;
+
+  /// Transient results of the table for each set of constraint values
+  std::unordered_map<std::string, TableRows> probes;
+
   /*
    * @brief A table implementation specific query result cache.
    *
@@ -469,6 +536,10 @@ struct QueryContext {
   QueryContext(QueryContext&& other)
       : constraints(std::move(other.constraints)),
         colsUsed(std::move(other.colsUsed)),
+        colsUsedBitset(std::move(other.colsUsedBitset)),
+        columnGroups(std::move(other.columnGroups)),
+        limit(std::move(other.limit)),
+        orderBy(std::move(other.orderBy)),
         enable_cache_(other.enable_cache_),
         use_cache_(other.use_cache_),
         table_(other.table_) {
@@ -480,6 +551,10 @@ struct QueryContext {
   QueryContext& operator=(QueryContext&& other) {
     std::swap(constraints, other.constraints);
     std::swap(colsUsed, other.colsUsed);
+    std::swap(colsUsedBitset, other.colsUsedBitset);
+    std::swap(columnGroups, other.columnGroups);
+    std::swap(limit, other.limit);
+    std::swap(orderBy, other.orderBy);
     std::swap(enable_cache_, other.enable_cache_);
     std::swap(use_cache_, other.use_cache_);
     std::swap(table_, other.table_);
@@ -582,6 +657,15 @@ struct QueryContext {
     return !colsUsedBitset || (*colsUsedBitset & desiredBitset).any();
   }
 
+  /**
+   * @brief Check if any column of a spec-declared column group is used.
+   *
+   * Tables skip the lookup shared by a group's columns if none is used.
+   * Unknown groups are considered used, as are all groups when the table
+   * did not provide them, e.g. when generating within a container.
+   */
+  bool isColumnGroupUsed(const std::string& group) const;
+
   template <typename Type>
   inline void setTextColumnIfUsed(Row& r,
                                   const std::string& colName,
@@ -638,6 +722,27 @@ struct QueryContext {
   boost::optional<UsedColumns> colsUsed;
   boost::optional<UsedColumnsBitset> colsUsedBitset;
 
+  /// The table's column groups, see isColumnGroupUsed.
+  ColumnGroups columnGroups;
+
+  /**
+   * @brief The number of rows the query needs, including its OFFSET.
+   *
+   * Only tables with the LIMIT_PUSHDOWN attribute receive a limit. SQLite
+   * still applies the LIMIT, but the table may stop generating rows once it
+   * is reached. The limit is only set if the table filters every constraint
+   * it receives, so that SQLite does not discard any of the rows.
+   */
+  boost::optional<size_t> limit;
+
+  /**
+   * @brief The order rows must be generated in, empty if unordered.
+   *
+   * Only tables with the LIMIT_PUSHDOWN attribute are asked to order rows,
+   * SQLite then skips sorting them.
+   */
+  std::vector<ColumnOrder> orderBy;
+
  private:
   /// If false then the context is maintaining an ephemeral cache.
   bool enable_cache_{false};
@@ -705,6 +810,16 @@ class TablePlugin : public Plugin {
     return TableAttributes::NONE;
   }
 
+  /// Return hints about the cost of generating rows, see TableCost.
+  virtual TableCost cost() const {
+    return TableCost();
+  }
+
+  /// Return the column groups declared by the table spec, see ColumnGroups.
+  virtual ColumnGroups columnGroups() const {
+    return ColumnGroups();
+  }
+
   /**
    * @brief Generate a complete table representation.
    *
@@ -801,14 +916,13 @@ class TablePlugin : public Plugin {
    * table "processes" at the interval 60. The first executed will cache results
    * and the second will use the cached results.
    *
-   * Table results are not cached if a QueryContext contains constraints or
-   * provides HOB (hand-off blocks) to additional tables within a query.
+   * Results are cached in memory, see TableResultsCache, per set of constraints
+   * on required/indexed/optimized or additional columns. Table results are not
+   * cached if the query does not use the default columns.
    * Currently, the query scheduler cannot communicate to table implementations.
    * An interval is set globally by the scheduler and passed to the table
    * implementation as a future-proof API. There is no "shortcut" for caching
-   * when used in external tables. A cache lookup within an extension means
-   * a database call API and re-serialization to the virtual table APIs. In
-   * practice this does not perform well and is explicitly disabled.
+   * when used in external tables, the cache lives within each process.
    *
    * @param interval The interval this query expects the tables results.
    * @param ctx The query context.
@@ -817,34 +931,31 @@ class TablePlugin : public Plugin {
   bool isCached(uint64_t interval, const QueryContext& ctx) const;
 
   /**
-   * @brief Perform a database lookup of cached results and deserialize.
+   * @brief Retrieve fresh cached results.
    *
-   * If a query determined the table's cached results are fresh, it may ask the
-   * table to retrieve results from the database and deserialized them into
-   * table row data.
+   * The returned rows reference the cached results, nothing is copied or
+   * deserialized.
    *
-   * @return The deserialized row data of cached results.
+   * @param step The current schedule step.
+   * @param ctx The query context.
+   * @param results The output parameter, set only if fresh results exist.
+   * @return True if the cache contained fresh results, otherwise false.
    */
-  TableRows getCache() const;
+  bool getCache(uint64_t step,
+                const QueryContext& ctx,
+                TableRows& results) const;
 
   /**
    * @brief Similar to getCache, stores the results from generate.
    *
-   * Set will serialize and save the results as JSON to be retrieved later.
-   * It will inspect the query context, if any required/indexed/optimized or
-   * additional columns are used then the cache will not be saved.
+   * The results are moved into the cache and replaced with rows referencing
+   * the cached data, they remain usable by the caller. If the query does not
+   * use the default columns then the cache will not be saved.
    */
   void setCache(uint64_t step,
                 uint64_t interval,
                 const QueryContext& ctx,
-                const TableRows& results);
-
- private:
-  /// The last time in seconds the table data results were saved to cache.
-  uint64_t last_cached_{0};
-
-  /// The last interval in seconds when the table data was cached.
-  uint64_t last_interval_{0};
+                TableRows& results);
 
  public:
   /**
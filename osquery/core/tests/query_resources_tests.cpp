@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/core/query_resources.h>
+
+namespace osquery {
+
+class QueryResourcesTests : public testing::Test {};
+
+namespace {
+
+void sleepMs(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+} // namespace
+
+TEST_F(QueryResourcesTests, test_thread_cpu_time) {
+  QueryResourceAccounting accounting;
+
+  // Spin for a while, the accounted CPU time is this thread's.
+  auto start = std::chrono::steady_clock::now();
+  volatile std::uint64_t counter = 0;
+  while (std::chrono::steady_clock::now() - start <
+         std::chrono::milliseconds(50)) {
+    counter = counter + 1;
+  }
+
+  // Another thread burning CPU is not attributed to this query.
+  std::thread other([]() {
+    auto other_start = std::chrono::steady_clock::now();
+    volatile std::uint64_t other_counter = 0;
+    while (std::chrono::steady_clock::now() - other_start <
+           std::chrono::milliseconds(200)) {
+      other_counter = other_counter + 1;
+    }
+  });
+  other.join();
+
+  const auto& usage = accounting.stop();
+  EXPECT_GE(usage.wall_time_ms, 250U);
+  EXPECT_GE(usage.user_time_ms + usage.system_time_ms, 25U);
+  EXPECT_LT(usage.user_time_ms + usage.system_time_ms, 200U);
+  EXPECT_TRUE(usage.table_time_us.empty());
+}
+
+TEST_F(QueryResourcesTests, test_table_scope_inactive) {
+  ASSERT_FALSE(QueryResourceAccounting::isActive());
+
+  // Without an active accounting scopes are no-ops.
+  {
+    TableResourceScope scope("inactive");
+  }
+  QueryResourceAccounting::recordTable("inactive", 1000);
+
+  QueryResourceAccounting accounting;
+  EXPECT_TRUE(QueryResourceAccounting::isActive());
+  EXPECT_TRUE(accounting.stop().table_time_us.empty());
+  EXPECT_FALSE(QueryResourceAccounting::isActive());
+}
+
+TEST_F(QueryResourcesTests, test_table_scope_exclusive_time) {
+  QueryResourceAccounting accounting;
+  {
+    TableResourceScope outer("outer");
+    sleepMs(10);
+    {
+      // A table running a nested query, e.g. through SQL::selectAllFrom.
+      TableResourceScope inner("inner");
+      sleepMs(30);
+    }
+  }
+  {
+    TableResourceScope outer("outer");
+  }
+
+  const auto& usage = accounting.stop();
+  ASSERT_EQ(usage.table_time_us.size(), 2U);
+  EXPECT_GE(usage.table_time_us.at("inner"), 30000U);
+  EXPECT_GE(usage.table_time_us.at("outer"), 10000U);
+
+  // The nested time is only attributed to the inner table.
+  EXPECT_LT(usage.table_time_us.at("outer"), 30000U);
+  EXPECT_GE(usage.getGenerateTimeMs(), 40U);
+}
+
+TEST_F(QueryResourcesTests, test_nested_accounting) {
+  QueryResourceAccounting outer;
+  {
+    QueryResourceAccounting inner;
+    {
+      TableResourceScope scope("inner_table");
+    }
+    EXPECT_EQ(inner.stop().table_time_us.count("inner_table"), 1U);
+  }
+
+  // The outer accounting is restored once the inner stops.
+  EXPECT_TRUE(QueryResourceAccounting::isActive());
+  {
+    TableResourceScope scope("outer_table");
+  }
+
+  const auto& usage = outer.stop();
+  EXPECT_EQ(usage.table_time_us.count("inner_table"), 0U);
+  EXPECT_EQ(usage.table_time_us.count("outer_table"), 1U);
+  EXPECT_FALSE(QueryResourceAccounting::isActive());
+}
+
+TEST_F(QueryResourcesTests, test_heap_growth) {
+  auto before = getThreadResourceSample();
+  if (before.heap_in_use == 0) {
+    // The allocator on this platform cannot be inspected.
+    return;
+  }
+
+  QueryResourceAccounting accounting;
+  std::vector<std::string> retained;
+  for (size_t i = 0; i < 64; ++i) {
+    retained.emplace_back(64 * 1024, 'A');
+  }
+
+  EXPECT_GE(accounting.stop().memory, 64U * 64 * 1024);
+}
+
+} // namespace osquery
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <osquery/core/sized_lru_cache.h>
+
+namespace osquery {
+
+class SizedLRUCacheTests : public testing::Test {};
+
+TEST_F(SizedLRUCacheTests, test_insert_and_lookup) {
+  SizedLRUCache<std::string> cache(100);
+  EXPECT_TRUE(cache.insert("a", "first", 10));
+  EXPECT_TRUE(cache.insert("b", "second", 20));
+  EXPECT_EQ(cache.size(), 2U);
+  EXPECT_EQ(cache.bytes(), 30U);
+
+  ASSERT_NE(cache.peek("a"), nullptr);
+  EXPECT_EQ(*cache.peek("a"), "first");
+  ASSERT_NE(cache.get("b"), nullptr);
+  EXPECT_EQ(*cache.get("b"), "second");
+  EXPECT_EQ(cache.peek("c"), nullptr);
+
+  // Replacing a value replaces its size.
+  EXPECT_TRUE(cache.insert("a", "replaced", 5));
+  EXPECT_EQ(*cache.peek("a"), "replaced");
+  EXPECT_EQ(cache.size(), 2U);
+  EXPECT_EQ(cache.bytes(), 25U);
+
+  EXPECT_TRUE(cache.erase("a"));
+  EXPECT_FALSE(cache.erase("a"));
+  EXPECT_EQ(cache.bytes(), 20U);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0U);
+  EXPECT_EQ(cache.bytes(), 0U);
+}
+
+TEST_F(SizedLRUCacheTests, test_eviction) {
+  SizedLRUCache<int> cache(100);
+  cache.insert("a", 1, 40);
+  cache.insert("b", 2, 40);
+
+  // Using a makes b the least recently used, peeking does not.
+  cache.get("a");
+  cache.peek("b");
+  cache.insert("c", 3, 40);
+  EXPECT_NE(cache.peek("a"), nullptr);
+  EXPECT_EQ(cache.peek("b"), nullptr);
+  EXPECT_NE(cache.peek("c"), nullptr);
+  EXPECT_EQ(cache.bytes(), 80U);
+
+  // A value larger than the cache is not cached, and evicts nothing.
+  EXPECT_FALSE(cache.insert("a", 4, 101));
+  EXPECT_EQ(*cache.peek("a"), 1);
+  EXPECT_EQ(cache.size(), 2U);
+
+  // A value as large as the cache evicts everything else.
+  EXPECT_TRUE(cache.insert("d", 5, 100));
+  EXPECT_EQ(cache.size(), 1U);
+  EXPECT_EQ(cache.bytes(), 100U);
+}
+
+} // namespace osquery
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <osquery/core/table_source_cache.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+class TableSourceCacheTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = fs::temp_directory_path() /
+            fs::unique_path("osquery.table_source_cache_tests.%%%%.%%%%");
+    fs::create_directories(root_ / "repos");
+    writeFile("status", "package: a\n");
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+  }
+
+  std::string path(const std::string& name) const {
+    return (root_ / name).string();
+  }
+
+  void writeFile(const std::string& name, const std::string& content) const {
+    std::ofstream stream(path(name), std::ios::trunc);
+    stream << content;
+  }
+
+  /// Count the generator calls, producing one row per call.
+  TableSourceCache::Generator countingGenerator(size_t& calls) {
+    return ([&calls](SourceFingerprint&, QueryData& results) {
+      calls++;
+      results.push_back({{"calls", std::to_string(calls)}});
+      return Status::success();
+    });
+  }
+
+ protected:
+  fs::path root_;
+};
+
+TEST_F(TableSourceCacheTests, test_fingerprint_changes) {
+  SourceFingerprint fingerprint({path("status"), path("missing")});
+  EXPECT_FALSE(fingerprint.changed());
+  EXPECT_EQ(fingerprint, SourceFingerprint({path("status"), path("missing")}));
+
+  // A rewrite changes the size.
+  writeFile("status", "package: a\npackage: b\n");
+  EXPECT_TRUE(fingerprint.changed());
+
+  // Creating a missing file changes the fingerprint.
+  fingerprint = SourceFingerprint({path("status"), path("missing")});
+  writeFile("missing", "");
+  EXPECT_TRUE(fingerprint.changed());
+}
+
+TEST_F(TableSourceCacheTests, test_fingerprint_directory) {
+  writeFile("repos/a.repo", "[a]\n");
+  SourceFingerprint fingerprint({path("repos")});
+  EXPECT_FALSE(fingerprint.changed());
+
+  // Adding a file to a directory changes the fingerprint.
+  writeFile("repos/b.repo", "[b]\n");
+  EXPECT_TRUE(fingerprint.changed());
+
+  // So does rewriting a file within the directory.
+  fingerprint = SourceFingerprint({path("repos")});
+  writeFile("repos/a.repo", "[a]\nenabled=1\n");
+  EXPECT_TRUE(fingerprint.changed());
+}
+
+TEST_F(TableSourceCacheTests, test_generate_reuses_rows) {
+  TableSourceCache cache(1 << 20);
+  size_t calls = 0;
+  auto generator = countingGenerator(calls);
+
+  auto results = cache.generate("test", "", {path("status")}, generator);
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["calls"], "1");
+
+  // The source did not change, the rows are reused.
+  results = cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 1U);
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["calls"], "1");
+
+  // Each key is cached independently.
+  cache.generate("test", "name=a", {path("status")}, generator);
+  EXPECT_EQ(calls, 2U);
+  EXPECT_EQ(cache.size(), 2U);
+
+  // A changed source invalidates the rows.
+  writeFile("status", "package: a\npackage: b\n");
+  results = cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 3U);
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["calls"], "3");
+}
+
+TEST_F(TableSourceCacheTests, test_generate_discovered_sources) {
+  TableSourceCache cache(1 << 20);
+  size_t calls = 0;
+  auto generator = [this, &calls](SourceFingerprint& sources, QueryData&) {
+    calls++;
+    sources.add(path("repos"));
+    return Status::success();
+  };
+
+  cache.generate("test", "", {path("status")}, generator);
+  cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 1U);
+
+  writeFile("repos/a.repo", "[a]\n");
+  cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 2U);
+}
+
+TEST_F(TableSourceCacheTests, test_generate_failure_not_cached) {
+  TableSourceCache cache(1 << 20);
+  size_t calls = 0;
+  auto generator = [&calls](SourceFingerprint&, QueryData& results) {
+    calls++;
+    results.push_back({{"partial", "1"}});
+    return Status::failure("Cannot read the database");
+  };
+
+  auto results = cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(results.size(), 1U);
+  cache.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 2U);
+  EXPECT_EQ(cache.size(), 0U);
+}
+
+TEST_F(TableSourceCacheTests, test_eviction) {
+  Row row = {{"calls", "1"}};
+  auto row_size = TableSourceCache::getMemorySize(row);
+
+  TableSourceCache cache(row_size * 2);
+  size_t calls = 0;
+  auto generator = countingGenerator(calls);
+  cache.generate("test", "a", {path("status")}, generator);
+  cache.generate("test", "b", {path("status")}, generator);
+  EXPECT_EQ(cache.size(), 2U);
+  EXPECT_EQ(cache.bytes(), row_size * 2);
+
+  // Reusing a makes b the least recently used entry.
+  QueryData results;
+  EXPECT_TRUE(cache.lookup("test", "a", results));
+  cache.generate("test", "c", {path("status")}, generator);
+  EXPECT_EQ(cache.size(), 2U);
+  EXPECT_TRUE(cache.lookup("test", "a", results));
+  EXPECT_FALSE(cache.lookup("test", "b", results));
+
+  // Rows larger than the cache are not cached.
+  TableSourceCache small(row_size / 2);
+  small.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(small.size(), 0U);
+
+  // A disabled cache always generates.
+  TableSourceCache disabled(0);
+  calls = 0;
+  disabled.generate("test", "", {path("status")}, generator);
+  disabled.generate("test", "", {path("status")}, generator);
+  EXPECT_EQ(calls, 2U);
+}
+
+} // namespace osquery
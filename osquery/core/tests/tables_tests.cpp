@@ -116,6 +116,25 @@ TEST_F(TablesTests, test_constraint_matching) {
   EXPECT_TRUE(cl3.matches(1));
 }
 
+TEST_F(TablesTests, test_constraint_matching_in_list) {
+  // The values of an IN() list are several EQUALS constraints.
+  struct ConstraintList cl;
+  cl.affinity = INTEGER_TYPE;
+  cl.add(Constraint(EQUALS, "1"));
+  cl.add(Constraint(EQUALS, "5"));
+  cl.add(Constraint(EQUALS, "not_an_integer"));
+
+  EXPECT_TRUE(cl.matches(1));
+  EXPECT_TRUE(cl.notExistsOrMatches(5));
+  EXPECT_FALSE(cl.matches(2));
+  EXPECT_FALSE(cl.notExistsOrMatches(2));
+
+  // Every other constraint must still match.
+  cl.add(Constraint(GREATER_THAN, "2"));
+  EXPECT_FALSE(cl.matches(1));
+  EXPECT_TRUE(cl.matches(5));
+}
+
 TEST_F(TablesTests, test_constraint_map) {
   ConstraintMap cm;
 
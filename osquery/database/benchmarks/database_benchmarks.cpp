@@ -94,6 +94,96 @@ BENCHMARK(DATABASE_serialize_json)
     ->ArgPair(10, 10)
     ->ArgPair(10, 100);
 
+QueryLogItem getExampleQueryLogItem(size_t x, size_t y, bool snapshot) {
+  RowTyped r;
+  for (size_t i = 0; i < x; i++) {
+    r["key" + std::to_string(i)] = std::to_string(i) + "content";
+  }
+
+  QueryLogItem item;
+  item.isSnapshot = snapshot;
+  for (size_t i = 0; i < y; i++) {
+    if (snapshot) {
+      item.snapshot_results.push_back(r);
+    } else {
+      item.results.added.push_back(r);
+    }
+  }
+  item.name = "example_query";
+  item.identifier = "example_host";
+  item.calendar_time = "Mon Aug 25 12:10:57 2014 UTC";
+  item.time = 1408993857;
+  item.decorations["host_uuid"] = "00000000-0000-0000-0000-000000000000";
+  return item;
+}
+
+static void DATABASE_serialize_log_item_json(benchmark::State& state) {
+  auto item = getExampleQueryLogItem(state.range(0), state.range(1), true);
+  while (state.KeepRunning()) {
+    std::string content;
+    serializeQueryLogItemJSON(item, content);
+    benchmark::DoNotOptimize(content);
+  }
+}
+
+BENCHMARK(DATABASE_serialize_log_item_json)
+    ->ArgPair(10, 10)
+    ->ArgPair(10, 1000)
+    ->ArgPair(50, 10000);
+
+/// The document serializer, the previous implementation of the above.
+static void DATABASE_serialize_log_item_document(benchmark::State& state) {
+  auto item = getExampleQueryLogItem(state.range(0), state.range(1), true);
+  while (state.KeepRunning()) {
+    auto doc = JSON::newObject();
+    serializeQueryLogItem(item, doc);
+    std::string content;
+    doc.toString(content);
+    benchmark::DoNotOptimize(content);
+  }
+}
+
+BENCHMARK(DATABASE_serialize_log_item_document)
+    ->ArgPair(10, 10)
+    ->ArgPair(10, 1000)
+    ->ArgPair(50, 10000);
+
+static void DATABASE_serialize_log_item_events_json(benchmark::State& state) {
+  auto item = getExampleQueryLogItem(state.range(0), state.range(1), false);
+  while (state.KeepRunning()) {
+    std::vector<std::string> events;
+    serializeQueryLogItemAsEventsJSON(item, events);
+    benchmark::DoNotOptimize(events);
+  }
+}
+
+BENCHMARK(DATABASE_serialize_log_item_events_json)
+    ->ArgPair(10, 10)
+    ->ArgPair(10, 1000)
+    ->ArgPair(50, 10000);
+
+static void DATABASE_serialize_log_item_events_document(
+    benchmark::State& state) {
+  auto item = getExampleQueryLogItem(state.range(0), state.range(1), false);
+  while (state.KeepRunning()) {
+    auto doc = JSON::newArray();
+    serializeQueryLogItemAsEvents(item, doc);
+    std::vector<std::string> events;
+    for (auto& event : doc.doc().GetArray()) {
+      rapidjson::StringBuffer sb;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+      event.Accept(writer);
+      events.push_back(sb.GetString());
+    }
+    benchmark::DoNotOptimize(events);
+  }
+}
+
+BENCHMARK(DATABASE_serialize_log_item_events_document)
+    ->ArgPair(10, 10)
+    ->ArgPair(10, 1000)
+    ->ArgPair(50, 10000);
+
 static void DATABASE_diff(benchmark::State& state) {
   QueryData qd = getExampleQueryData(state.range(0), state.range(1));
   QueryDataSet qds = getExampleQueryDataSet(state.range(0), state.range(1));
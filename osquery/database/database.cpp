@@ -48,6 +48,7 @@ const std::string kLogs = "logs";
 const std::string kDistributedQueries = "distributed";
 const std::string kDistributedRunningQueries = "distributed_running";
 const std::string kQueryPerformance = "query_performance";
+const std::string kFileHashes = "file_hashes";
 
 const std::string kDbEpochSuffix = "epoch";
 const std::string kDbCounterSuffix = "counter";
@@ -61,7 +62,8 @@ const std::vector<std::string> kDomains = {kPersistentSettings,
                                            kCarves,
                                            kDistributedQueries,
                                            kDistributedRunningQueries,
-                                           kQueryPerformance};
+                                           kQueryPerformance,
+                                           kFileHashes};
 
 std::atomic<bool> kDBAllowOpen(false);
 std::atomic<bool> kDBInitialized(false);
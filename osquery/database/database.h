@@ -61,6 +61,9 @@ extern const std::string kDistributedRunningQueries;
 /// The "domain" where query performance stats are stored.
 extern const std::string kQueryPerformance;
 
+/// The "domain" where persisted file content hashes are stored.
+extern const std::string kFileHashes;
+
 /// The running version of our database schema
 const int kDbCurrentVersion = 2;
 
@@ -9,6 +9,7 @@
 
 #include <osquery/database/database.h>
 
+#include <osquery/core/flags.h>
 #include <osquery/core/query.h>
 #include <osquery/core/sql/diff_results.h>
 #include <osquery/core/sql/query_data.h>
@@ -16,12 +17,83 @@
 
 #include <gtest/gtest.h>
 
+#include <limits>
 #include <string>
 
 namespace osquery {
 
+DECLARE_bool(logger_numerics);
+DECLARE_bool(decorations_top_level);
+
 class ResultsTests : public testing::Test {};
 
+namespace {
+
+/// A log item exercising escaping, numeric types and decorations.
+QueryLogItem getStreamingLogItem(bool snapshot) {
+  RowTyped r1;
+  r1["text"] = std::string("quote\" backslash\\ tab\t \x01 utf8 \xc3\xa9");
+  r1["integer"] = 42LL;
+  r1["negative"] = -7LL;
+  r1["real"] = 3.25;
+
+  RowTyped r2;
+  r2["text"] = std::string("nul\0suffix", 10);
+  r2["empty"] = "";
+
+  QueryLogItem item;
+  item.isSnapshot = snapshot;
+  if (snapshot) {
+    item.snapshot_results = {r1, r2};
+  } else {
+    item.results.added = {r1};
+    item.results.removed = {r2};
+  }
+  item.name = "pack_streaming_query";
+  item.identifier = "host\"name";
+  item.calendar_time = "Mon Aug 25 12:10:57 2014 UTC";
+  item.time = 1408993857;
+  item.epoch = 3;
+  item.counter = 12;
+  item.decorations = {{"host_uuid", "uuid"}, {"user", "root/\n"}};
+  return item;
+}
+
+/// The reference output, serialized through a JSON document.
+std::string getDocumentJSON(const QueryLogItem& item) {
+  auto doc = JSON::newObject();
+  EXPECT_TRUE(serializeQueryLogItem(item, doc).ok());
+  std::string json;
+  doc.toString(json);
+  return json;
+}
+
+std::vector<std::string> getDocumentEventsJSON(const QueryLogItem& item) {
+  auto doc = JSON::newArray();
+  EXPECT_TRUE(serializeQueryLogItemAsEvents(item, doc).ok());
+
+  std::vector<std::string> events;
+  for (auto& event : doc.doc().GetArray()) {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    event.Accept(writer);
+    events.push_back(sb.GetString());
+  }
+  return events;
+}
+
+void expectDocumentEquivalent(const QueryLogItem& item) {
+  std::string json;
+  ASSERT_TRUE(serializeQueryLogItemJSON(item, json).ok());
+  EXPECT_EQ(getDocumentJSON(item), json);
+
+  std::vector<std::string> events;
+  ASSERT_TRUE(serializeQueryLogItemAsEventsJSON(item, events).ok());
+  EXPECT_EQ(getDocumentEventsJSON(item), events);
+}
+
+} // namespace
+
 TEST_F(ResultsTests, test_simple_diff) {
   QueryDataSet os;
   QueryDataTyped o;
@@ -152,4 +224,48 @@ TEST_F(ResultsTests, test_adding_duplicate_rows_to_query_data) {
   EXPECT_FALSE(s);
   EXPECT_EQ(q.size(), 2U);
 }
+
+TEST_F(ResultsTests, test_streaming_log_item_matches_document) {
+  auto numerics = FLAGS_logger_numerics;
+  auto top_level = FLAGS_decorations_top_level;
+
+  for (bool numeric : {false, true}) {
+    for (bool decorations_top_level : {false, true}) {
+      FLAGS_logger_numerics = numeric;
+      FLAGS_decorations_top_level = decorations_top_level;
+      expectDocumentEquivalent(getStreamingLogItem(false));
+      expectDocumentEquivalent(getStreamingLogItem(true));
+
+      // Items without results or decorations.
+      QueryLogItem empty;
+      empty.isSnapshot = false;
+      expectDocumentEquivalent(empty);
+      empty.isSnapshot = true;
+      expectDocumentEquivalent(empty);
+    }
+  }
+
+  FLAGS_logger_numerics = numerics;
+  FLAGS_decorations_top_level = top_level;
+}
+
+TEST_F(ResultsTests, test_streaming_log_item_document_fallbacks) {
+  auto numerics = FLAGS_logger_numerics;
+  auto top_level = FLAGS_decorations_top_level;
+
+  // A top-level decoration replacing a member is ordered like the document.
+  FLAGS_decorations_top_level = true;
+  auto item = getStreamingLogItem(false);
+  item.decorations["name"] = "decorated";
+  expectDocumentEquivalent(item);
+
+  // Non-finite numbers cannot be written, the output matches the document.
+  FLAGS_logger_numerics = true;
+  item = getStreamingLogItem(true);
+  item.snapshot_results[0]["real"] = std::numeric_limits<double>::infinity();
+  expectDocumentEquivalent(item);
+
+  FLAGS_logger_numerics = numerics;
+  FLAGS_decorations_top_level = top_level;
+}
 }
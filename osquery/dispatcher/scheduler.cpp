@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <ctime>
+#include <memory>
 
 #include <boost/format.hpp>
 #include <boost/io/quoted.hpp>
@@ -20,6 +21,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/flags.h>
 #include <osquery/core/query.h>
+#include <osquery/core/query_resources.h>
 #include <osquery/core/shutdown.h>
 #include <osquery/database/database.h>
 #include <osquery/logger/data_logger.h>
@@ -64,54 +66,44 @@ DECLARE_bool(enable_numeric_monitoring);
 DECLARE_bool(verbose);
 
 SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
+  Config::get().recordQueryStart(name);
+
+  // Account for the resources this thread uses while running the query.
+  QueryResourceAccounting accounting;
+  std::unique_ptr<CodeProfiler> profiler;
   if (FLAGS_enable_numeric_monitoring) {
-    CodeProfiler profiler(
-        {(boost::format("scheduler.pack.%s") % query.pack_name).str(),
-         (boost::format("scheduler.global.query.%s.%s") % query.pack_name %
-          query.name)
-             .str(),
-         (boost::format("scheduler.assigned.query.%s.%s.%s") % query.oncall %
-          query.pack_name % query.name)
-             .str(),
-         (boost::format("scheduler.owners.%s") % query.oncall).str(),
-         (boost::format("scheduler.query.%s.%s.%s") %
-          monitoring::hostIdentifierKeys().scheme % query.pack_name %
-          query.name)
-             .str()});
-    return SQLInternal(query.query, true);
-  } else {
-    // Snapshot the performance and times for the worker before running.
-    auto pid = std::to_string(PlatformProcess::getCurrentPid());
-    auto r0 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                              "processes",
-                              "pid",
-                              EQUALS,
-                              pid);
-
-    using namespace std::chrono;
-    auto t0 = steady_clock::now();
-    Config::get().recordQueryStart(name);
-    SQLInternal sql(query.query, true);
-
-    // Snapshot the performance after, and compare.
-    auto t1 = steady_clock::now();
-    auto r1 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                              "processes",
-                              "pid",
-                              EQUALS,
-                              pid);
-    if (r0.size() > 0 && r1.size() > 0) {
-      // Always called while processes table is working.
-      uint64_t size = sql.getSize();
-      Config::get().recordQueryPerformance(
-          name,
-          duration_cast<milliseconds>(t1 - t0).count(),
-          size,
-          r0[0],
-          r1[0]);
+    profiler = std::make_unique<CodeProfiler>(
+        std::initializer_list<std::string>{
+            (boost::format("scheduler.pack.%s") % query.pack_name).str(),
+            (boost::format("scheduler.global.query.%s.%s") % query.pack_name %
+             query.name)
+                .str(),
+            (boost::format("scheduler.assigned.query.%s.%s.%s") %
+             query.oncall % query.pack_name % query.name)
+                .str(),
+            (boost::format("scheduler.owners.%s") % query.oncall).str(),
+            (boost::format("scheduler.query.%s.%s.%s") %
+             monitoring::hostIdentifierKeys().scheme % query.pack_name %
+             query.name)
+                .str()});
+  }
+
+  SQLInternal sql(query.query, true);
+  profiler.reset();
+  const auto& usage = accounting.stop();
+  Config::get().recordQueryPerformance(name, sql.getSize(), usage);
+
+  if (FLAGS_enable_numeric_monitoring) {
+    for (const auto& table : usage.table_time_us) {
+      monitoring::record("scheduler.global.query." + query.pack_name + "." +
+                             query.name + ".table." + table.first +
+                             ".time.micros",
+                         table.second,
+                         monitoring::PreAggregationType::Sum,
+                         true);
     }
-    return sql;
   }
+  return sql;
 }
 
 Status launchQuery(const std::string& name, const ScheduledQuery& query) {
@@ -279,26 +271,26 @@ void SchedulerRunner::start() {
 
   for (; (end == 0) || (i <= end); ++i) {
     auto start_time_point = std::chrono::steady_clock::now();
-    Config::get().scheduledQueries(([&i](const std::string& name,
-                                         const ScheduledQuery& query) {
-      if (query.splayed_interval > 0 && i % query.splayed_interval == 0) {
-        TablePlugin::kCacheInterval = query.splayed_interval;
-        TablePlugin::kCacheStep = i;
-        const auto status = launchQuery(name, query);
-        monitoring::record((boost::format("scheduler.query.%s.%s.status.%s") %
-                            query.pack_name % query.name %
-                            (status.ok() ? "success" : "failure"))
-                               .str(),
-                           1,
-                           monitoring::PreAggregationType::Sum,
-                           true);
+    Config::get().dueQueries(
+        i, ([&i](const std::string& name, const ScheduledQuery& query) {
+          TablePlugin::kCacheInterval = query.splayed_interval;
+          TablePlugin::kCacheStep = i;
+          const auto status = launchQuery(name, query);
+          if (FLAGS_enable_numeric_monitoring) {
+            monitoring::record("scheduler.query." + query.pack_name + "." +
+                                   query.name + ".status." +
+                                   (status.ok() ? "success" : "failure"),
+                               1,
+                               monitoring::PreAggregationType::Sum,
+                               true);
+          }
 
 #ifdef OSQUERY_LINUX
-        // Attempt to release some unused memory kept by malloc internal caching
-        releaseRetainedMemory();
+          // Attempt to release some unused memory kept by malloc internal
+          // caching
+          releaseRetainedMemory();
 #endif
-      }
-    }));
+        }));
 
     maybeRunDecorators(i);
     maybeReloadSchedule(i);
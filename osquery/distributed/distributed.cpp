@@ -17,7 +17,6 @@
 #include <osquery/distributed/distributed.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
-#include <osquery/process/process.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/sql/sql.h>
 #include <osquery/utils/conversions/tryto.h>
@@ -135,6 +134,9 @@ Status Distributed::serializeResults(std::string& json) {
       obj.AddMember("memory",
                     static_cast<uint64_t>(perf.last_memory),
                     obj.GetAllocator());
+      obj.AddMember("generate_time_ms",
+                    static_cast<uint64_t>(perf.last_generate_time_ms),
+                    obj.GetAllocator());
     };
 
     doc.add(result.request.id, obj, stats_obj);
@@ -380,70 +382,29 @@ void Distributed::setCurrentRequestId(const std::string& cReqId) {
 
 SQL Distributed::monitorNonnumeric(const std::string& name,
                                    const std::string& query) {
-  // Snapshot the performance and times for the worker before running.
-  auto pid = std::to_string(PlatformProcess::getCurrentPid());
-  auto r0 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                            "processes",
-                            "pid",
-                            EQUALS,
-                            pid);
-
-  using namespace std::chrono;
-  auto t0 = steady_clock::now();
+  // Account for the resources this thread uses while running the query.
+  QueryResourceAccounting accounting;
   SQL sql(query, true);
-
-  // Snapshot the performance after, and compare.
-  auto t1 = steady_clock::now();
-  auto r1 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                            "processes",
-                            "pid",
-                            EQUALS,
-                            pid);
-  if (r0.size() > 0 && r1.size() > 0) {
-    // Always called while processes table is working.
-    uint64_t size = sql.rows().size();
-    recordQueryPerformance(
-        name, duration_cast<milliseconds>(t1 - t0).count(), size, r0[0], r1[0]);
-  }
+  recordQueryPerformance(name, sql.rows().size(), accounting.stop());
   return sql;
 }
 
 void Distributed::recordQueryPerformance(const std::string& name,
-                                         uint64_t delay_ms,
                                          uint64_t size,
-                                         const Row& r0,
-                                         const Row& r1) {
-  performance_[name] = QueryPerformance();
-
-  auto& query = performance_.at(name);
-  if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
-    auto ut1 = tryTo<long long>(r1.at("user_time"));
-    auto ut0 = tryTo<long long>(r0.at("user_time"));
-    auto diff = (ut1 && ut0) ? ut1.take() - ut0.take() : 0;
-    if (diff > 0) {
-      query.user_time = diff;
-    }
-  }
-
-  if (!r1.at("system_time").empty() && !r0.at("system_time").empty()) {
-    auto st1 = tryTo<long long>(r1.at("system_time"));
-    auto st0 = tryTo<long long>(r0.at("system_time"));
-    auto diff = (st1 && st0) ? st1.take() - st0.take() : 0;
-    if (diff > 0) {
-      query.system_time = diff;
-    }
-  }
-
-  if (!r1.at("resident_size").empty() && !r0.at("resident_size").empty()) {
-    auto rs1 = tryTo<long long>(r1.at("resident_size"));
-    auto rs0 = tryTo<long long>(r0.at("resident_size"));
-    auto diff = (rs1 && rs0) ? rs1.take() - rs0.take() : 0;
-    if (diff > 0) {
-      query.last_memory = diff;
-    }
-  }
-
-  query.wall_time_ms = delay_ms;
+                                         const QueryResourceUsage& usage) {
+  auto& query = performance_[name];
+  query = QueryPerformance();
+  query.executions = 1;
+  query.user_time = usage.user_time_ms;
+  query.last_user_time = usage.user_time_ms;
+  query.system_time = usage.system_time_ms;
+  query.last_system_time = usage.system_time_ms;
+  query.last_memory = usage.memory;
+  query.generate_time_ms = usage.getGenerateTimeMs();
+  query.last_generate_time_ms = query.generate_time_ms;
+  query.wall_time_ms = usage.wall_time_ms;
+  query.last_wall_time_ms = usage.wall_time_ms;
+  query.output_size = size;
 }
 
 Status serializeDistributedQueryRequest(const DistributedQueryRequest& r,
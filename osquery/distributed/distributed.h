@@ -14,6 +14,7 @@
 
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/core/query.h>
+#include <osquery/core/query_resources.h>
 #include <osquery/core/sql/query_performance.h>
 #include <osquery/sql/sql.h>
 #include <osquery/utils/status/status.h>
@@ -344,20 +345,15 @@ class Distributed {
   SQL monitorNonnumeric(const std::string& name, const std::string& query);
 
   /**
-   * @brief Calculate query performance and record it into the performance_
-   * object
+   * @brief Record a query's performance into the performance_ object
    *
    * @param name Query name, as sent by the server
-   * @param delay_ms Time taken for query to run
    * @param size number of rows output
-   * @param r0 Row generated from first call to the processes table
-   * @param r1 Row generated from second call to the processes table
+   * @param usage The resources used by the query's thread
    */
   void recordQueryPerformance(const std::string& name,
-                              uint64_t delay_ms,
                               uint64_t size,
-                              const Row& r0,
-                              const Row& r1);
+                              const QueryResourceUsage& usage);
 
   std::vector<DistributedQueryResult> results_;
 
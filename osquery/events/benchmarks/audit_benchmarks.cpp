@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/events/linux/auditdnetlink.h>
+
+namespace osquery {
+
+/// Audit records of a single execve, as received from the audit netlink.
+static const std::vector<std::pair<int, std::string>> kRecordedMessages = {
+    {AUDIT_SYSCALL,
+     "audit(1588703361.452:26860): arch=c000003e syscall=59 success=yes "
+     "exit=0 a0=55a3b7e9c2a0 a1=55a3b7e9c6f0 a2=55a3b7ea1e20 a3=8 items=2 "
+     "ppid=3264 pid=3378 auid=1000 uid=1000 gid=1000 euid=1000 suid=1000 "
+     "fsuid=1000 egid=1000 sgid=1000 fsgid=1000 tty=pts0 ses=3 comm=\"ls\" "
+     "exe=\"/usr/bin/ls\" key=(null)"},
+    {AUDIT_EXECVE,
+     "audit(1588703361.452:26860): argc=3 a0=\"ls\" a1=\"--color=auto\" "
+     "a2=\"-la\""},
+    {AUDIT_CWD, "audit(1588703361.452:26860): cwd=\"/home/user\""},
+    {AUDIT_PATH,
+     "audit(1588703361.452:26860): item=0 name=\"/usr/bin/ls\" inode=2883641 "
+     "dev=08:01 mode=0100755 ouid=0 ogid=0 rdev=00:00 nametype=NORMAL "
+     "cap_fp=0 cap_fi=0 cap_fe=0 cap_fver=0"},
+    {AUDIT_PROCTITLE,
+     "audit(1588703361.452:26860): proctitle=6C73002D2D636F6C6F723D6175746F"},
+    {AUDIT_EOE, "audit(1588703361.452:26860): "},
+};
+
+/// Replay the recorded messages through a socketpair, like the kernel does.
+static bool replayMessages(int handle, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& message = kRecordedMessages[i % kRecordedMessages.size()];
+
+    audit_message packet = {};
+    packet.nlh.nlmsg_type = static_cast<__u16>(message.first);
+    packet.nlh.nlmsg_len = static_cast<__u32>(message.second.size());
+    std::memcpy(packet.data, message.second.data(), message.second.size());
+
+    auto size = NLMSG_HDRLEN + message.second.size();
+    if (send(handle, &packet, size, 0) != static_cast<ssize_t>(size)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Receive a message per poll and recvfrom, as the reader used to.
+static std::size_t receiveMessages(int handle,
+                                   std::vector<audit_reply>& read_buffer) {
+  pollfd fds[] = {{handle, POLLIN, 0}};
+
+  std::size_t events_received = 0;
+  for (; events_received < read_buffer.size(); ++events_received) {
+    if (::poll(fds, 1, 0) <= 0 || (fds[0].revents & POLLIN) == 0) {
+      break;
+    }
+
+    audit_reply reply = {};
+    if (recv(handle, &reply.msg, sizeof(reply.msg), 0) < 0) {
+      break;
+    }
+
+    read_buffer[events_received] = reply;
+  }
+
+  return events_received;
+}
+
+static void AUDIT_receive_per_message(benchmark::State& state) {
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) != 0) {
+    state.SkipWithError("Could not create the socketpair");
+    return;
+  }
+
+  auto count = static_cast<std::size_t>(state.range(0));
+  std::vector<audit_reply> read_buffer(1024U);
+  for (auto _ : state) {
+    if (!replayMessages(sockets[1], count)) {
+      state.SkipWithError("Could not replay the messages");
+      break;
+    }
+
+    // The records were copied again into the parser queue.
+    std::vector<audit_reply> queue;
+    auto received = receiveMessages(sockets[0], read_buffer);
+    queue.insert(queue.end(),
+                 read_buffer.begin(),
+                 std::next(read_buffer.begin(), received));
+
+    for (auto& reply : queue) {
+      AuditdNetlinkParser::AdjustAuditReply(reply);
+      AuditEventRecord audit_event_record = {};
+      AuditdNetlinkParser::ParseAuditReply(reply, audit_event_record);
+      benchmark::DoNotOptimize(audit_event_record);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  close(sockets[0]);
+  close(sockets[1]);
+}
+
+static void AUDIT_receive_batched(benchmark::State& state) {
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) != 0) {
+    state.SkipWithError("Could not create the socketpair");
+    return;
+  }
+
+  auto count = static_cast<std::size_t>(state.range(0));
+  AuditMessageReceiver receiver(false);
+  for (auto _ : state) {
+    if (!replayMessages(sockets[1], count)) {
+      state.SkipWithError("Could not replay the messages");
+      break;
+    }
+
+    // The batch is moved to the parser queue.
+    std::vector<AuditMessageBatch> queue;
+    AuditMessageBatch batch;
+    receiver.receive(sockets[0], batch, 1024U, 0);
+    queue.push_back(std::move(batch));
+
+    audit_reply reply;
+    for (auto& received : queue) {
+      for (std::size_t i = 0; i < received.size(); ++i) {
+        AuditdNetlinkParser::AdjustAuditReply(reply, received.header(i));
+        AuditEventRecord audit_event_record = {};
+        AuditdNetlinkParser::ParseAuditReply(reply, audit_event_record);
+        benchmark::DoNotOptimize(audit_event_record);
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  close(sockets[0]);
+  close(sockets[1]);
+}
+
+// The default socket buffer of a socketpair holds over a hundred messages.
+BENCHMARK(AUDIT_receive_per_message)->Arg(6)->Arg(30)->Arg(120);
+BENCHMARK(AUDIT_receive_batched)->Arg(6)->Arg(30)->Arg(120);
+
+} // namespace osquery
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/events/linux/bpf/systemstatetracker.h>
+
+#include <linux/fcntl.h>
+
+namespace osquery {
+
+namespace {
+
+/// Creates shell-like processes with the given amount of open files
+class BenchmarkProcessContextFactory final : public IProcessContextFactory {
+ public:
+  BenchmarkProcessContextFactory(std::size_t fd_count) : fd_count(fd_count) {}
+
+  bool captureSingleProcess(ProcessContext& process_context,
+                            pid_t process_id) const override {
+    process_context = {};
+    process_context.parent_process_id = 1;
+    process_context.binary_path = "/usr/bin/bash";
+    process_context.argv = std::vector<std::string>{"bash", "-i"};
+    process_context.cwd = "/home/osquery";
+
+    auto& fd_map = process_context.fd_map.edit();
+    for (std::size_t i = 0U; i < fd_count; ++i) {
+      ProcessContext::FileDescriptor fd_info;
+      fd_info.close_on_exec = (i % 2U) != 0U;
+
+      ProcessContext::FileDescriptor::FileData file_data;
+      file_data.path = "/usr/share/osquery/file" + std::to_string(i % 16U);
+      fd_info.data = std::move(file_data);
+
+      fd_map.insert({static_cast<int>(i), std::move(fd_info)});
+    }
+
+    return true;
+  }
+
+  bool captureAllProcesses(ProcessContextMap& process_map) const override {
+    process_map = {};
+    return captureSingleProcess(process_map[kShellProcessId], kShellProcessId);
+  }
+
+  static constexpr pid_t kShellProcessId{1000};
+
+ private:
+  std::size_t fd_count{};
+};
+
+const tob::ebpfpub::IFunctionTracer::Event::Header kBenchmarkEventHeader{};
+
+} // namespace
+
+/// A shell spawning short lived commands: fork, chdir, open and exec
+static void BPF_system_state_tracker_spawn(benchmark::State& state) {
+  BenchmarkProcessContextFactory process_context_factory(
+      static_cast<std::size_t>(state.range(0)));
+
+  SystemStateTracker::Context context;
+  process_context_factory.captureAllProcesses(context.process_map);
+
+  const auto parent_process_id =
+      BenchmarkProcessContextFactory::kShellProcessId;
+
+  const pid_t child_process_id{parent_process_id + 1};
+  const tob::ebpfpub::IFunctionTracer::Event::Field::Argv argv{"ls", "-l"};
+
+  for (auto _ : state) {
+    SystemStateTracker::createProcess(context,
+                                      process_context_factory,
+                                      kBenchmarkEventHeader,
+                                      parent_process_id,
+                                      child_process_id);
+
+    SystemStateTracker::setWorkingDirectory(
+        context, process_context_factory, child_process_id, "/tmp");
+
+    SystemStateTracker::openFile(context,
+                                 process_context_factory,
+                                 child_process_id,
+                                 AT_FDCWD,
+                                 10000,
+                                 "output.txt",
+                                 O_CLOEXEC);
+
+    SystemStateTracker::executeBinary(context,
+                                      process_context_factory,
+                                      kBenchmarkEventHeader,
+                                      child_process_id,
+                                      AT_FDCWD,
+                                      0,
+                                      "/usr/bin/ls",
+                                      argv);
+
+    SystemStateTracker::closeHandle(
+        context, process_context_factory, child_process_id, 0);
+
+    context.process_map.erase(child_process_id);
+    context.event_list.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BPF_system_state_tracker_spawn)->Arg(8)->Arg(64)->Arg(256);
+
+} // namespace osquery
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/events/linux/inotify.h>
+#include <osquery/events/pathset.h>
+#include <osquery/events/pathtrie.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_bool(enable_file_events);
+
+/// Create a tree of directories, 100 directories wide at the top.
+static fs::path createDirectoryTree(size_t directories) {
+  auto root = fs::temp_directory_path() /
+              fs::unique_path("osquery.inotify_benchmarks.%%%%.%%%%");
+  for (size_t i = 0; i < directories; ++i) {
+    fs::create_directories(root / std::to_string(i % 100) / std::to_string(i));
+  }
+  return root;
+}
+
+static void INOTIFY_configure_recursive(benchmark::State& state) {
+  FLAGS_enable_file_events = true;
+  auto root = createDirectoryTree(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    auto pub = std::make_shared<INotifyEventPublisher>();
+    if (!pub->setUp().ok()) {
+      state.SkipWithError("Could not start inotify");
+      break;
+    }
+
+    auto sc = pub->createSubscriptionContext();
+    sc->path = root.string() + "/**";
+    pub->addSubscription(Subscription::create("benchmark", sc));
+    pub->configure();
+    pub->tearDown();
+  }
+
+  fs::remove_all(root);
+}
+
+BENCHMARK(INOTIFY_configure_recursive)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+static const std::vector<std::string> kExcludePatterns = {
+    "/etc/ssh/%%",
+    "/etc/ssl/openssl.cnf",
+    "/var/log/%",
+    "/home/%/.cache/%%",
+    "/usr/lib/%%",
+    "/tmp/",
+};
+
+static void INOTIFY_exclude_path_set(benchmark::State& state) {
+  PathSet<patternedPath> exclude_paths;
+  for (const auto& pattern : kExcludePatterns) {
+    exclude_paths.insert(pattern);
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(exclude_paths.find("/home/user/documents/file"));
+    benchmark::DoNotOptimize(exclude_paths.find("/var/log/syslog"));
+  }
+}
+
+BENCHMARK(INOTIFY_exclude_path_set);
+
+static void INOTIFY_exclude_path_trie(benchmark::State& state) {
+  PathTrie exclude_paths;
+  for (const auto& pattern : kExcludePatterns) {
+    exclude_paths.insert(pattern);
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(exclude_paths.find("/home/user/documents/file"));
+    benchmark::DoNotOptimize(exclude_paths.find("/var/log/syslog"));
+  }
+}
+
+BENCHMARK(INOTIFY_exclude_path_trie);
+
+} // namespace osquery
@@ -221,6 +221,12 @@ class ESProcessFileEventSubscriber
   }
 
   Status init() override API_AVAILABLE(macos(10.15));
+
+  /// The publisher reads the "file_paths" parser when configured.
+  std::set<std::string> configParsers() const override {
+    return {"file_paths"};
+  }
+
   Status Callback(const EndpointSecurityFileEventContextRef& ec,
                   const EndpointSecurityFileSubscriptionContextRef& sc)
       API_AVAILABLE(macos(10.15));
@@ -303,7 +303,7 @@ void EventFactory::forwardEvent(const std::string& event) {
   }
 }
 
-void EventFactory::configUpdate() {
+void EventFactory::updateMinExpiry() {
   // Scan the schedule for queries that touch "_events" tables.
   // We will count the queries
   std::map<std::string, SubscriberExpirationDetails> subscriber_details;
@@ -355,6 +355,10 @@ void EventFactory::configUpdate() {
     }
     subscriber->resetQueryCount(details.second.query_count);
   }
+}
+
+void EventFactory::configUpdate() {
+  updateMinExpiry();
 
   // If events are enabled configure the subscribers before publishers.
   if (!FLAGS_disable_events) {
@@ -363,6 +367,52 @@ void EventFactory::configUpdate() {
   }
 }
 
+void EventFactory::configUpdate(const std::set<std::string>& parsers,
+                                bool schedule_changed) {
+  if (schedule_changed) {
+    updateMinExpiry();
+  }
+
+  if (FLAGS_disable_events) {
+    return;
+  }
+
+  // Select the subscribers reading an updated parser, and their publishers.
+  bool options_changed = (parsers.count("options") > 0);
+  std::vector<EventSubscriberRef> subscribers;
+  std::map<std::string, EventPublisherRef> publishers;
+  {
+    auto& ef = EventFactory::getInstance();
+    RecursiveLock lock(ef.factory_lock_);
+    for (const auto& subscriber : ef.event_subs_) {
+      bool reads_parser = options_changed;
+      for (const auto& parser : subscriber.second->configParsers()) {
+        reads_parser = reads_parser || (parsers.count(parser) > 0);
+      }
+      if (!reads_parser) {
+        continue;
+      }
+
+      subscribers.push_back(subscriber.second);
+      auto publisher = ef.event_pubs_.find(subscriber.second->getType());
+      if (publisher != ef.event_pubs_.end()) {
+        publishers.insert(*publisher);
+      }
+    }
+  }
+
+  // Configure the subscribers before publishers.
+  for (const auto& subscriber : subscribers) {
+    VLOG(1) << "Reconfiguring event subscriber: " << subscriber->getName();
+    subscriber->configure();
+  }
+
+  for (const auto& publisher : publishers) {
+    VLOG(1) << "Reconfiguring event publisher: " << publisher.first;
+    publisher.second->configure();
+  }
+}
+
 Status EventFactory::run(const std::string& type_id) {
   if (FLAGS_disable_events) {
     return Status::success();
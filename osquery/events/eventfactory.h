@@ -11,6 +11,8 @@
 
 #include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <osquery/events/eventer.h>
@@ -159,6 +161,20 @@ class EventFactory : private boost::noncopyable {
    */
   static void configUpdate();
 
+  /**
+   * @brief Respond to an incremental configuration update.
+   *
+   * Only the subscribers reading one of the updated config parsers, see
+   * EventSubscriberPlugin::configParsers, and the publishers they subscribe
+   * to are reconfigured. Every subscriber reads flags, so an update of the
+   * "options" parser reconfigures all of them.
+   *
+   * @param parsers The names of the config parsers that were updated.
+   * @param schedule_changed True if the schedule or packs may have changed.
+   */
+  static void configUpdate(const std::set<std::string>& parsers,
+                           bool schedule_changed);
+
  public:
   /// The dispatched event thread's entry-point (if needed).
   static Status run(const std::string& type_id);
@@ -211,6 +227,9 @@ class EventFactory : private boost::noncopyable {
   EventFactory() = default;
   ~EventFactory() = default;
 
+  /// Set the minimum events expiry of subscribers used by the schedule.
+  static void updateMinExpiry();
+
  private:
   /// Set of registered EventPublisher instances.
   std::map<std::string, EventPublisherRef> event_pubs_;
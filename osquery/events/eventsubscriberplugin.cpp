@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <iterator>
+
 #include <osquery/config/config.h>
 #include <osquery/core/flags.h>
 #include <osquery/database/database.h>
@@ -218,6 +220,10 @@ bool EventSubscriberPlugin::shouldOptimize() const {
   return isDaemon() && FLAGS_events_optimize;
 }
 
+std::set<std::string> EventSubscriberPlugin::configParsers() const {
+  return {};
+}
+
 void EventSubscriberPlugin::resetQueryCount(size_t count) {
   WriteLock subscriber_lock(event_query_record_);
   queries_.clear();
@@ -258,7 +264,9 @@ uint64_t EventSubscriberPlugin::getExpireTime() {
 void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
                                          bool can_optimize,
                                          EventTime start_time,
-                                         EventTime stop_time) {
+                                         EventTime stop_time,
+                                         size_t max_rows,
+                                         bool newest_first) {
   EventTime optimize_time{0U};
   EventID optimize_eid{0U};
   if (can_optimize && shouldOptimize()) {
@@ -278,7 +286,9 @@ void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
                                callback,
                                start_time,
                                stop_time,
-                               optimize_eid);
+                               optimize_eid,
+                               max_rows,
+                               newest_first);
 
     if (can_optimize && shouldOptimize() && !result.isEnd) {
       setOptimizeData(getDatabase(), result.last_time, result.last_id);
@@ -315,11 +325,25 @@ void EventSubscriberPlugin::genTable(RowYield& yield, QueryContext& context) {
     }
   }
 
+  // The event index is ordered by time, a query ordering by time and using a
+  // LIMIT only reads the events it needs.
+  size_t max_rows = 0;
+  if (context.limit) {
+    if (*context.limit == 0) {
+      return;
+    }
+    max_rows = *context.limit;
+  }
+
+  bool newest_first =
+      !context.orderBy.empty() && context.orderBy.front().descending;
+
   auto generateRowsCallback = [&yield](Row row) {
     yield(TableRowHolder(new DynamicTableRow(std::move(row))));
   };
 
-  generateRows(generateRowsCallback, can_optimize, start, stop);
+  generateRows(
+      generateRowsCallback, can_optimize, start, stop, max_rows, newest_first);
 }
 
 size_t EventSubscriberPlugin::numSubscriptions() const {
@@ -642,12 +666,13 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
     std::function<void(Row)> callback,
     EventTime start_time,
     EventTime end_time,
-    EventID last_eid) {
+    EventID last_eid,
+    size_t max_rows,
+    bool newest_first) {
   EventSubscriberPlugin::GenerateRowsResult ret{true, 0, 0};
   std::vector<EventID> collected_event_id_list;
   {
     ReadLock lock(context.event_index_mutex);
-    auto last = context.event_index.end();
     if (end_time != 0 && start_time > end_time) {
       return ret;
     }
@@ -667,20 +692,57 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
                               ? context.event_index.end()
                               : context.event_index.upper_bound(end_time);
 
-    for (auto it = lower_bound_it; it != upper_bound_it; ++it) {
-      const auto& event_id_list = it->second;
+    // Set when the limit stops the scan before every event was visited.
+    bool truncated = false;
+    EventTime last_collected_time = 0;
 
-      for (const auto& event_identifier : event_id_list) {
-        if (last_eid >= event_identifier) {
-          // A previous optimized query has already visited this event.
-          continue;
+    auto collect_event = [&](EventTime event_time, EventID event_identifier) {
+      if (last_eid >= event_identifier) {
+        // A previous optimized query has already visited this event.
+        return;
+      }
+      if (max_rows != 0 && collected_event_id_list.size() >= max_rows) {
+        truncated = true;
+        return;
+      }
+      collected_event_id_list.push_back(event_identifier);
+      last_collected_time = event_time;
+    };
+
+    if (newest_first) {
+      auto it = upper_bound_it;
+      while (it != lower_bound_it && !truncated) {
+        --it;
+        const auto& event_id_list = it->second;
+        for (auto id_it = event_id_list.rbegin();
+             id_it != event_id_list.rend() && !truncated;
+             ++id_it) {
+          collect_event(it->first, *id_it);
+        }
+      }
+
+    } else {
+      for (auto it = lower_bound_it; it != upper_bound_it && !truncated;
+           ++it) {
+        for (const auto& event_identifier : it->second) {
+          collect_event(it->first, event_identifier);
+          if (truncated) {
+            break;
+          }
         }
-        collected_event_id_list.push_back(event_identifier);
       }
-      last = it;
     }
 
-    if (last != context.event_index.end()) {
+    if (truncated) {
+      // Only the oldest events are visited when generating in time order,
+      // the next optimized query continues after the last one. The newest
+      // events are generated first otherwise, nothing is marked as visited.
+      if (!newest_first) {
+        ret = EventSubscriberPlugin::GenerateRowsResult{
+            false, last_collected_time, collected_event_id_list.back()};
+      }
+    } else if (lower_bound_it != upper_bound_it) {
+      auto last = std::prev(upper_bound_it);
       ret = EventSubscriberPlugin::GenerateRowsResult{
           false, last->first, last->second.empty() ? 0 : last->second.back()};
     }
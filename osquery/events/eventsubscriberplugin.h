@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <set>
+#include <string>
+
 #include <gtest/gtest_prod.h>
 
 #include <osquery/core/plugins/plugin.h>
@@ -115,6 +118,14 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   /// Determine if the subscriber should attempt optmization.
   virtual bool shouldOptimize() const;
 
+  /**
+   * @brief The config parsers read when the subscriber is configured.
+   *
+   * An incremental config update only reconfigures a subscriber, and its
+   * publisher, if one of these parsers or the options were updated.
+   */
+  virtual std::set<std::string> configParsers() const;
+
   /**
    * @brief Return all events added by this EventSubscriber within start, stop.
    *
@@ -124,12 +135,16 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    * @param can_optimize If true then optimization can be considered.
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
+   * @param max_rows The maximum number of rows, 0 if unlimited.
+   * @param newest_first Generate the most recent events first.
    * @return Set of event rows matching time limits.
    */
   void generateRows(std::function<void(Row)> callback,
                     bool can_optimize,
                     EventTime start_time,
-                    EventTime stop_stop);
+                    EventTime stop_stop,
+                    size_t max_rows = 0,
+                    bool newest_first = false);
 
   /// Track a query execution.
   virtual void setExecutedQuery(const std::string& query_name,
@@ -241,14 +256,21 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
    * @param last_eid (optional) The last visited event id.
+   * @param max_rows (optional) The maximum number of rows, 0 if unlimited.
+   * @param newest_first (optional) Generate the most recent events first.
    * @return The upper bound time or 0 if there were no events in the range.
+   *
+   * When max_rows stops the scan early, the last visited event is the last
+   * generated one. Nothing is visited if the newest events were generated.
    */
   static GenerateRowsResult generateRows(Context& context,
                                          IDatabaseInterface& db_interface,
                                          std::function<void(Row)> callback,
                                          EventTime start_time,
                                          EventTime end_time,
-                                         EventID last_eid = 0);
+                                         EventID last_eid = 0,
+                                         size_t max_rows = 0,
+                                         bool newest_first = false);
 
   explicit EventSubscriberPlugin(EventSubscriberPlugin const&) = delete;
   EventSubscriberPlugin& operator=(EventSubscriberPlugin const&) = delete;
@@ -337,6 +359,7 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   FRIEND_TEST(EventSubscriberPluginTests, getEventsExpiry);
   FRIEND_TEST(EventSubscriberPluginTests, generateRowsWithExpiry);
   FRIEND_TEST(EventSubscriberPluginTests, generateRowsWithOptimize);
+  FRIEND_TEST(EventSubscriberPluginTests, generateRowsWithOptimizeAndLimit);
 
   friend class DBFakeEventSubscriber;
   friend class BenchmarkEventSubscriber;
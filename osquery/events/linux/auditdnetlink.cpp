@@ -10,11 +10,15 @@
 #include <libaudit.h>
 #include <linux/audit.h>
 #include <poll.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 
 #include <boost/utility/string_ref.hpp>
 
@@ -56,6 +60,12 @@ FLAG(int32, audit_backlog_wait_time, 0, "The audit backlog wait time");
 /// This value is passed directly to the audit API.
 FLAG(int32, audit_backlog_limit, 4096, "The audit backlog limit");
 
+/// Records are sharded by audit event, so that each event stays ordered.
+FLAG(uint32,
+     audit_parser_threads,
+     1,
+     "Number of threads parsing audit records (default 1, max 16)");
+
 // External flags; they are used to determine which rules need to be installed
 DECLARE_bool(audit_allow_config);
 DECLARE_bool(audit_allow_fim_events);
@@ -72,6 +82,18 @@ namespace {
 
 const std::string kAppArmorRecordMarker{"apparmor="};
 constexpr std::uint64_t kUnprocessedRecordsThreshold{4096};
+// How many messages are received before they are handed to the parser
+constexpr std::size_t kMaxBatchMessages{1024};
+// How many messages a single recvmmsg call can receive
+constexpr std::size_t kReceiveSlots{64};
+// How long to wait for the first message of a batch, in milliseconds
+constexpr int kReceiveTimeout{2000};
+// The initial size of a batch buffer, most audit messages are small
+constexpr std::size_t kBatchBufferSize{64 * 1024};
+// The maximum number of parser services
+constexpr std::uint32_t kMaxParserThreads{16};
+// The audit event serial is found within the start of each record
+constexpr std::size_t kAuditPreambleMaxLength{64};
 // How often in seconds a message should be displayed if throttling happened
 constexpr std::uint64_t kThrottlingMessageInterval{60};
 // How much to wait for each throttling loop in millseconds
@@ -133,15 +155,25 @@ enum AuditStatus {
   AUDIT_IMMUTABLE = 2,
 };
 
+AuditdContext::AuditdContext(std::size_t parser_count) {
+  for (std::size_t i = 0; i < parser_count; ++i) {
+    parser_shards.push_back(std::make_unique<AuditParserShard>());
+  }
+}
+
 AuditdNetlink::AuditdNetlink() {
   try {
-    auditd_context_ = std::make_shared<AuditdContext>();
+    auto parser_count = std::max(
+        1U, std::min(FLAGS_audit_parser_threads, kMaxParserThreads));
+    auditd_context_ = std::make_shared<AuditdContext>(parser_count);
 
     Dispatcher::addService(
         std::make_shared<AuditdNetlinkReader>(auditd_context_));
 
-    Dispatcher::addService(
-        std::make_shared<AuditdNetlinkParser>(auditd_context_));
+    for (std::size_t shard = 0; shard < parser_count; ++shard) {
+      Dispatcher::addService(
+          std::make_shared<AuditdNetlinkParser>(auditd_context_, shard));
+    }
 
   } catch (const std::bad_alloc&) {
     VLOG(1) << "Failed to initialize the AuditdNetlink services due to a "
@@ -174,10 +206,160 @@ std::vector<AuditEventRecord> AuditdNetlink::getEvents() noexcept {
   return record_list;
 }
 
+void AuditMessageBatch::append(const void* message, std::size_t size) {
+  if (buffer_.empty()) {
+    buffer_.reserve(kBatchBufferSize);
+  }
+
+  // The zeroed padding terminates the message text. It also covers records
+  // whose length includes the netlink header, as the kernel does not set the
+  // header length consistently
+  auto offset = buffer_.size();
+  buffer_.resize(offset + NLMSG_ALIGN(size + NLMSG_HDRLEN + 1), 0);
+  std::memcpy(buffer_.data() + offset, message, size);
+  offsets_.push_back(offset);
+}
+
+struct nlmsghdr* AuditMessageBatch::header(std::size_t index) noexcept {
+  return reinterpret_cast<struct nlmsghdr*>(buffer_.data() + offsets_[index]);
+}
+
+std::size_t AuditMessageBatch::size() const noexcept {
+  return offsets_.size();
+}
+
+bool AuditMessageBatch::empty() const noexcept {
+  return offsets_.empty();
+}
+
+AuditMessageReceiver::AuditMessageReceiver(bool verify_sender)
+    : verify_sender_(verify_sender),
+      slots_(kReceiveSlots),
+      addresses_(kReceiveSlots),
+      iovecs_(kReceiveSlots),
+      headers_(kReceiveSlots) {
+  for (std::size_t i = 0; i < kReceiveSlots; ++i) {
+    iovecs_[i].iov_base = &slots_[i];
+    iovecs_[i].iov_len = sizeof(audit_message);
+
+    headers_[i] = {};
+    headers_[i].msg_hdr.msg_name = &addresses_[i];
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+Status AuditMessageReceiver::receive(int handle,
+                                     AuditMessageBatch& batch,
+                                     std::size_t max_messages,
+                                     int timeout) {
+  std::size_t received = 0;
+
+  while (received < max_messages) {
+    auto slot_count = std::min(slots_.size(), max_messages - received);
+    for (std::size_t i = 0; i < slot_count; ++i) {
+      headers_[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_nl);
+      headers_[i].msg_hdr.msg_flags = 0;
+    }
+
+    errno = 0;
+    int message_count = ::recvmmsg(handle,
+                                   headers_.data(),
+                                   static_cast<unsigned int>(slot_count),
+                                   MSG_DONTWAIT,
+                                   nullptr);
+
+    if (message_count < 0) {
+      if (errno == EINTR) {
+        break;
+      }
+
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return Status::failure(
+            "Failed to receive data from the audit netlink");
+      }
+
+      // Hand off what was received instead of waiting for more messages
+      if (received != 0) {
+        break;
+      }
+
+      pollfd fds[] = {{handle, POLLIN, 0}};
+
+      errno = 0;
+      int poll_status = ::poll(fds, 1, timeout);
+      if (poll_status == 0) {
+        break;
+      }
+
+      if (poll_status < 0) {
+        if (errno != EINTR) {
+          return Status::failure("poll() failed with error " +
+                                 std::to_string(errno));
+        }
+
+        break;
+      }
+
+      if ((fds[0].revents & POLLIN) == 0) {
+        break;
+      }
+
+      continue;
+    }
+
+    for (int i = 0; i < message_count; ++i) {
+      auto status = appendMessage(static_cast<std::size_t>(i), batch);
+      if (!status.ok()) {
+        return status;
+      }
+
+      ++received;
+    }
+
+    // The socket queue was drained, avoid a receive that would only fail
+    if (static_cast<std::size_t>(message_count) < slot_count) {
+      break;
+    }
+  }
+
+  return Status::success();
+}
+
+Status AuditMessageReceiver::appendMessage(std::size_t slot,
+                                           AuditMessageBatch& batch) {
+  const auto& header = headers_[slot];
+
+  if (verify_sender_) {
+    if (header.msg_hdr.msg_namelen != sizeof(struct sockaddr_nl)) {
+      return Status::failure("Protocol error");
+    }
+
+    if (addresses_[slot].nl_pid) {
+      return Status::failure("Invalid netlink endpoint");
+    }
+  }
+
+  if ((header.msg_hdr.msg_flags & MSG_TRUNC) != 0 ||
+      header.msg_len == sizeof(audit_message)) {
+    return Status::failure("Netlink event too big (EFBIG)");
+  }
+
+  if (!NLMSG_OK(&slots_[slot].nlh, header.msg_len)) {
+    return Status::failure("Broken netlink event (EBADE)");
+  }
+
+  batch.append(&slots_[slot], header.msg_len);
+  return Status::success();
+}
+
 AuditdNetlinkReader::AuditdNetlinkReader(AuditdContextRef context)
     : InternalRunnable("AuditdNetlinkReader"),
       auditd_context_(std::move(context)),
-      read_buffer_(1024U) {}
+      received_metric_("audit.netlink.records",
+                       monitoring::PreAggregationType::Sum),
+      throttled_metric_("audit.netlink.throttled.millis",
+                        monitoring::PreAggregationType::Sum) {}
 
 void AuditdNetlinkReader::start() {
   int counter_to_next_status_request = 0;
@@ -235,7 +417,9 @@ void AuditdNetlinkReader::stop() {
 
   VLOG(1) << "Releasing the audit handle...";
 
-  auditd_context_->unprocessed_records_cv.notify_all();
+  for (auto& shard : auditd_context_->parser_shards) {
+    shard->unprocessed_records_cv.notify_all();
+  }
 
   if (FLAGS_audit_allow_config) {
     restoreAuditServiceConfiguration();
@@ -246,101 +430,27 @@ void AuditdNetlinkReader::stop() {
 }
 
 bool AuditdNetlinkReader::acquireMessages() noexcept {
-  pollfd fds[] = {{audit_netlink_handle_, POLLIN, 0}};
-
-  struct sockaddr_nl nladdr = {};
-  socklen_t nladdrlen = sizeof(nladdr);
-
-  bool reset_handle = false;
-  size_t events_received = 0;
-
-  // Attempt to read as many messages as possible before we exit, and terminate
-  // early if we have been asked to terminate
-  for (events_received = 0;
-       !interrupted() && events_received < read_buffer_.size();
-       events_received++) {
-    errno = 0;
-    int poll_status = ::poll(fds, 1, 2000);
-    if (poll_status == 0) {
-      break;
-    }
-
-    if (poll_status < 0) {
-      if (errno != EINTR) {
-        reset_handle = true;
-        VLOG(1) << "poll() failed with error " << errno;
-      }
-
-      break;
-    }
-
-    if ((fds[0].revents & POLLIN) == 0) {
-      break;
-    }
-
-    audit_reply reply = {};
-    ssize_t len = recvfrom(audit_netlink_handle_,
-                           &reply.msg,
-                           sizeof(reply.msg),
-                           0,
-                           reinterpret_cast<struct sockaddr*>(&nladdr),
-                           &nladdrlen);
-
-    if (len < 0) {
-      VLOG(1) << "Failed to receive data from the audit netlink";
-      reset_handle = true;
-      break;
-    }
-
-    if (nladdrlen != sizeof(nladdr)) {
-      VLOG(1) << "Protocol error";
-      reset_handle = true;
-      break;
-    }
-
-    if (nladdr.nl_pid) {
-      VLOG(1) << "Invalid netlink endpoint";
-      reset_handle = true;
-      break;
-    }
-
-    if (!NLMSG_OK(&reply.msg.nlh, static_cast<unsigned int>(len))) {
-      if (len == sizeof(reply.msg)) {
-        VLOG(1) << "Netlink event too big (EFBIG)";
-      } else {
-        VLOG(1) << "Broken netlink event (EBADE)";
-      }
-
-      reset_handle = true;
-      break;
-    }
-
-    read_buffer_[events_received] = reply;
+  // Attempt to read as many messages as possible before we exit; the
+  // messages are received in batches instead of one syscall each
+  AuditMessageBatch batch;
+  auto status = receiver_.receive(
+      audit_netlink_handle_, batch, kMaxBatchMessages, kReceiveTimeout);
+
+  if (!status.ok()) {
+    VLOG(1) << status.getMessage();
   }
 
-  if (events_received != 0) {
-    std::unique_lock<std::mutex> lock(
-        auditd_context_->unprocessed_records_mutex);
-
-    auditd_context_->unprocessed_records.reserve(
-        auditd_context_->unprocessed_records.size() + events_received);
-
-    auditd_context_->unprocessed_records.insert(
-        auditd_context_->unprocessed_records.end(),
-        read_buffer_.begin(),
-        std::next(read_buffer_.begin(), events_received));
-
-    auditd_context_->unprocessed_records_amount += events_received;
-
-    auditd_context_->unprocessed_records_cv.notify_all();
+  if (!batch.empty()) {
+    queueMessages(std::move(batch));
   }
 
-  /* Throttle reading if the processing thread cannot keep up,
+  /* Throttle reading if the processing threads cannot keep up,
    we don't want to use too much memory */
   while (auditd_context_->unprocessed_records_amount >
              kUnprocessedRecordsThreshold &&
          !interrupted()) {
     ++auditd_context_->netlink_throttling_count;
+    throttled_metric_.record(kThrottlingDuration);
     std::this_thread::sleep_for(std::chrono::milliseconds(kThrottlingDuration));
   }
 
@@ -360,13 +470,78 @@ bool AuditdNetlinkReader::acquireMessages() noexcept {
     }
   }
 
-  if (reset_handle) {
+  if (!status.ok()) {
     VLOG(1) << "Requesting audit handle reset";
     return false;
   }
 
   return true;
-} // namespace osquery
+}
+
+void AuditdNetlinkReader::queueMessages(AuditMessageBatch batch) {
+  auto message_count = batch.size();
+  auto& parser_shards = auditd_context_->parser_shards;
+
+  std::vector<AuditParserWork> work_list(parser_shards.size());
+  auto shared_batch = std::make_shared<AuditMessageBatch>(std::move(batch));
+  for (std::size_t i = 0; i < message_count; ++i) {
+    auto nlh = shared_batch->header(i);
+    work_list[GetParserShard(nlh, work_list.size())].messages.push_back(nlh);
+  }
+
+  auditd_context_->unprocessed_records_amount += message_count;
+  received_metric_.record(static_cast<monitoring::ValueType>(message_count));
+
+  for (std::size_t shard = 0; shard < work_list.size(); ++shard) {
+    auto& work = work_list[shard];
+    if (work.messages.empty()) {
+      continue;
+    }
+
+    work.batch = shared_batch;
+
+    auto& parser_shard = *parser_shards[shard];
+    std::unique_lock<std::mutex> lock(parser_shard.unprocessed_records_mutex);
+    parser_shard.unprocessed_records.push_back(std::move(work));
+    parser_shard.unprocessed_records_cv.notify_all();
+  }
+}
+
+std::size_t AuditdNetlinkReader::GetParserShard(
+    const struct nlmsghdr* nlh, std::size_t shard_count) noexcept {
+  if (shard_count <= 1) {
+    return 0;
+  }
+
+  // Records start with "audit(<seconds>.<milliseconds>:<serial>): ", other
+  // messages are sent to the first shard. The batch padding ensures that
+  // nlmsg_len bytes can be read
+  boost::string_ref preamble(
+      static_cast<const char*>(NLMSG_DATA(nlh)),
+      std::min<std::size_t>(nlh->nlmsg_len, kAuditPreambleMaxLength));
+
+  if (!preamble.starts_with("audit(")) {
+    return 0;
+  }
+
+  auto serial_start = preamble.find(':');
+  auto serial_end = preamble.find(')');
+  if (serial_start == boost::string_ref::npos ||
+      serial_end == boost::string_ref::npos || serial_end < serial_start) {
+    return 0;
+  }
+
+  std::uint64_t serial = 0;
+  for (auto i = serial_start + 1; i < serial_end; ++i) {
+    if (preamble[i] < '0' || preamble[i] > '9') {
+      return 0;
+    }
+
+    serial = serial * 10 + static_cast<std::uint64_t>(preamble[i] - '0');
+  }
+
+  return static_cast<std::size_t>(serial % shard_count);
+}
 
 bool AuditdNetlinkReader::configureAuditService() noexcept {
   VLOG(1) << "Attempting to configure the audit service";
@@ -722,73 +897,89 @@ NetlinkStatus AuditdNetlinkReader::acquireHandle() noexcept {
   return NetlinkStatus::ActiveMutable;
 }
 
-AuditdNetlinkParser::AuditdNetlinkParser(AuditdContextRef context)
+AuditdNetlinkParser::AuditdNetlinkParser(AuditdContextRef context,
+                                         std::size_t shard)
     : InternalRunnable("AuditdNetlinkParser"),
-      auditd_context_(std::move(context)) {}
+      auditd_context_(std::move(context)),
+      shard_(shard),
+      parsed_metric_("audit.parser.records",
+                     monitoring::PreAggregationType::Sum),
+      malformed_metric_("audit.parser.malformed",
+                        monitoring::PreAggregationType::Sum),
+      lost_metric_("audit.kernel.lost", monitoring::PreAggregationType::Max),
+      backlog_metric_("audit.kernel.backlog",
+                      monitoring::PreAggregationType::Max) {}
 
 void AuditdNetlinkParser::start() {
+  auto& parser_shard = *auditd_context_->parser_shards.at(shard_);
+
   while (!interrupted()) {
-    std::vector<audit_reply> queue;
+    std::vector<AuditParserWork> queue;
 
     {
       std::unique_lock<std::mutex> lock(
-          auditd_context_->unprocessed_records_mutex);
+          parser_shard.unprocessed_records_mutex);
 
-      while (auditd_context_->unprocessed_records.empty()) {
+      while (parser_shard.unprocessed_records.empty()) {
         if (interrupted()) {
           return;
         }
 
-        auditd_context_->unprocessed_records_cv.wait_for(
-            lock, std::chrono::seconds(1));
+        parser_shard.unprocessed_records_cv.wait_for(lock,
+                                                     std::chrono::seconds(1));
       }
 
-      queue = std::move(auditd_context_->unprocessed_records);
-      auditd_context_->unprocessed_records.clear();
+      queue = std::move(parser_shard.unprocessed_records);
+      parser_shard.unprocessed_records.clear();
     }
 
-    std::vector<AuditEventRecord> audit_event_record_queue;
-    audit_event_record_queue.reserve(queue.size());
-
-    for (auto& reply : queue) {
-      if (interrupted()) {
-        break;
-      }
-
-      AdjustAuditReply(reply);
-
-      // This record carries the process id of the controlling daemon; in case
-      // we lost control of the audit service, we are going to request a reset
-      // as soon as we finish processing the pending queue
-      if (reply.type == AUDIT_GET) {
-        reply.status = static_cast<struct audit_status*>(NLMSG_DATA(reply.nlh));
-        auto new_pid = static_cast<pid_t>(reply.status->pid);
-
-        if (new_pid != getpid()) {
-          VLOG(1) << "Audit control lost to pid: " << new_pid;
+    std::size_t message_count = 0;
+    for (const auto& work : queue) {
+      message_count += work.messages.size();
+    }
 
-          if (FLAGS_audit_persist) {
-            VLOG(1) << "Attempting to reacquire control of the audit service";
-            auditd_context_->acquire_handle = true;
-          }
+    std::vector<AuditEventRecord> audit_event_record_queue;
+    audit_event_record_queue.reserve(message_count);
+
+    std::size_t malformed_count = 0;
+    audit_reply reply;
+    for (const auto& work : queue) {
+      for (std::size_t i = 0; i < work.messages.size() && !interrupted(); ++i) {
+        // The reply points to the message within the batch, not to a copy
+        AdjustAuditReply(reply, work.messages[i]);
+
+        // This record carries the process id of the controlling daemon; in
+        // case we lost control of the audit service, we are going to request
+        // a reset as soon as we finish processing the pending queue
+        if (reply.type == AUDIT_GET) {
+          reply.status =
+              static_cast<struct audit_status*>(NLMSG_DATA(reply.nlh));
+          handleAuditStatus(*reply.status);
+          continue;
         }
 
-        continue;
-      }
+        // We are not interested in all messages; only get the ones related to
+        // user events, seccomp, syscalls, SELinux events and AppArmor events
+        if (!ShouldHandle(reply)) {
+          continue;
+        }
 
-      // We are not interested in all messages; only get the ones related to
-      // user events, seccomp, syscalls, SELinux events and AppArmor events
-      if (!ShouldHandle(reply)) {
-        continue;
-      }
+        AuditEventRecord audit_event_record = {};
+        if (!ParseAuditReply(reply, audit_event_record)) {
+          VLOG(1) << "Malformed audit record received";
+          ++malformed_count;
+          continue;
+        }
 
-      AuditEventRecord audit_event_record = {};
-      if (!ParseAuditReply(reply, audit_event_record)) {
-        VLOG(1) << "Malformed audit record received";
-        continue;
+        audit_event_record_queue.push_back(std::move(audit_event_record));
       }
+    }
 
-      audit_event_record_queue.push_back(audit_event_record);
+    parsed_metric_.record(
+        static_cast<monitoring::ValueType>(audit_event_record_queue.size()));
+    if (malformed_count != 0) {
+      malformed_metric_.record(
+          static_cast<monitoring::ValueType>(malformed_count));
     }
 
     // Save the new records and notify the reader
@@ -796,14 +987,18 @@ void AuditdNetlinkParser::start() {
       std::lock_guard<std::mutex> queue_lock(
           auditd_context_->processed_events_mutex);
 
-      auditd_context_->processed_events.reserve(
-          auditd_context_->processed_events.size() +
-          audit_event_record_queue.size());
+      auto& processed_events = auditd_context_->processed_events;
+      if (processed_events.empty()) {
+        processed_events = std::move(audit_event_record_queue);
+      } else {
+        processed_events.reserve(processed_events.size() +
+                                 audit_event_record_queue.size());
 
-      auditd_context_->processed_events.insert(
-          auditd_context_->processed_events.end(),
-          audit_event_record_queue.begin(),
-          audit_event_record_queue.end());
+        processed_events.insert(
+            processed_events.end(),
+            std::make_move_iterator(audit_event_record_queue.begin()),
+            std::make_move_iterator(audit_event_record_queue.end()));
+      }
 
       auditd_context_->processed_records_backlog =
           auditd_context_->processed_events.size();
@@ -811,7 +1006,7 @@ void AuditdNetlinkParser::start() {
       auditd_context_->processed_records_cv.notify_all();
     }
 
-    auditd_context_->unprocessed_records_amount -= queue.size();
+    auditd_context_->unprocessed_records_amount -= message_count;
     queue.clear();
     audit_event_record_queue.clear();
 
@@ -847,6 +1042,23 @@ void AuditdNetlinkParser::start() {
   }
 }
 
+void AuditdNetlinkParser::handleAuditStatus(
+    const struct audit_status& status) {
+  // The kernel drops records when its backlog is full
+  lost_metric_.record(static_cast<monitoring::ValueType>(status.lost));
+  backlog_metric_.record(static_cast<monitoring::ValueType>(status.backlog));
+
+  auto new_pid = static_cast<pid_t>(status.pid);
+  if (new_pid != getpid()) {
+    VLOG(1) << "Audit control lost to pid: " << new_pid;
+
+    if (FLAGS_audit_persist) {
+      VLOG(1) << "Attempting to reacquire control of the audit service";
+      auditd_context_->acquire_handle = true;
+    }
+  }
+}
+
 bool AuditdNetlinkParser::ParseAuditReply(
     const audit_reply& reply, AuditEventRecord& event_record) noexcept {
   event_record = {};
@@ -944,9 +1156,14 @@ bool AuditdNetlinkParser::ParseAuditReply(
 }
 
 void AuditdNetlinkParser::AdjustAuditReply(audit_reply& reply) noexcept {
-  reply.type = reply.msg.nlh.nlmsg_type;
-  reply.len = reply.msg.nlh.nlmsg_len;
-  reply.nlh = &reply.msg.nlh;
+  AdjustAuditReply(reply, &reply.msg.nlh);
+}
+
+void AuditdNetlinkParser::AdjustAuditReply(audit_reply& reply,
+                                           struct nlmsghdr* nlh) noexcept {
+  reply.type = nlh->nlmsg_type;
+  reply.len = nlh->nlmsg_len;
+  reply.nlh = nlh;
 
   reply.status = nullptr;
   reply.ruledata = nullptr;
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <libaudit.h>
+#include <sys/socket.h>
 
 #include <atomic>
 #include <condition_variable>
@@ -21,8 +22,11 @@
 #include <vector>
 
 #include <boost/algorithm/hex.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <osquery/dispatcher/dispatcher.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+#include <osquery/utils/status/status.h>
 
 namespace osquery {
 
@@ -55,11 +59,86 @@ struct AuditEventRecord final {
 static_assert(std::is_move_constructible<AuditEventRecord>::value,
               "not move constructible");
 
-// This structure is used to share data between the reading and processing
-// services
-struct AuditdContext final {
+/**
+ * @brief Raw audit netlink messages, stored back to back in one buffer.
+ *
+ * A message only takes the bytes that were received, followed by zeroed
+ * padding so that its text is always NUL terminated. Batches are moved from
+ * the reader to the parser, the messages are never copied again.
+ */
+class AuditMessageBatch final {
+ public:
+  /// Copy a received message, starting with its netlink header.
+  void append(const void* message, std::size_t size);
+
+  /// The netlink header of a message.
+  struct nlmsghdr* header(std::size_t index) noexcept;
+
+  /// The number of messages.
+  std::size_t size() const noexcept;
+
+  /// Check if there are no messages.
+  bool empty() const noexcept;
+
+ private:
+  /// The messages, each one starting on a netlink alignment boundary.
+  std::vector<char> buffer_;
+
+  /// The offset of each message within the buffer.
+  std::vector<std::size_t> offsets_;
+};
+
+/// Receives audit netlink messages in batches, using recvmmsg.
+class AuditMessageReceiver final : private boost::noncopyable {
+ public:
+  /**
+   * @brief Allocate the receive slots.
+   *
+   * Messages must be sent by the kernel unless verify_sender is false, which
+   * is only used to replay recorded messages through a socketpair.
+   */
+  explicit AuditMessageReceiver(bool verify_sender = true);
+
+  /**
+   * @brief Receive up to max_messages messages into a batch.
+   *
+   * Waits up to timeout milliseconds for the first message, then only takes
+   * the messages that are already queued. A failure means the handle must be
+   * reset, messages received before the error are kept in the batch.
+   */
+  Status receive(int handle,
+                 AuditMessageBatch& batch,
+                 std::size_t max_messages,
+                 int timeout);
+
+ private:
+  /// Validate a received message, and copy it into the batch.
+  Status appendMessage(std::size_t slot, AuditMessageBatch& batch);
+
+ private:
+  /// Check that messages come from the kernel.
+  bool verify_sender_{true};
+
+  /// Buffers, sender addresses and headers of each receive slot.
+  std::vector<audit_message> slots_;
+  std::vector<struct sockaddr_nl> addresses_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<struct mmsghdr> headers_;
+};
+
+/// Messages of the audit events owned by a parser shard.
+struct AuditParserWork final {
+  /// Keeps the messages alive, the batch is shared by every shard.
+  std::shared_ptr<AuditMessageBatch> batch;
+
+  /// The messages owned by the shard, in the order they were received.
+  std::vector<struct nlmsghdr*> messages;
+};
+
+/// The queue of a parser service. Records of an event share the same shard.
+struct AuditParserShard final {
   /// Unprocessed audit records
-  std::vector<audit_reply> unprocessed_records;
+  std::vector<AuditParserWork> unprocessed_records;
   static_assert(
       std::is_move_constructible<decltype(unprocessed_records)>::value,
       "not move constructible");
@@ -67,8 +146,17 @@ struct AuditdContext final {
   /// Mutex for the list of unprocessed records
   std::mutex unprocessed_records_mutex;
 
-  /// Processed events condition variable
+  /// Unprocessed records condition variable
   std::condition_variable unprocessed_records_cv;
+};
+
+// This structure is used to share data between the reading and processing
+// services
+struct AuditdContext final {
+  explicit AuditdContext(std::size_t parser_count = 1);
+
+  /// Unprocessed audit records, each shard is parsed by its own service
+  std::vector<std::unique_ptr<AuditParserShard>> parser_shards;
 
   /// This queue contains processed events
   std::vector<AuditEventRecord> processed_events;
@@ -95,13 +183,14 @@ struct AuditdContext final {
   std::uint64_t last_netlink_throttling_message_time{};
 
   /// Timestamp of the last records processing throttling message
-  std::uint64_t last_processing_throttling_message_time{};
+  std::atomic<std::uint64_t> last_processing_throttling_message_time{};
 
   /// Count of loops done during Netlink records reading throttling
   std::uint32_t netlink_throttling_count{};
 
-  /// Count of loops done during records processing throttling
-  std::uint32_t processing_throttling_count{};
+  /// Count of loops done during records processing throttling, by every
+  /// parser service
+  std::atomic<std::uint32_t> processing_throttling_count{};
 };
 
 using AuditdContextRef = std::shared_ptr<AuditdContext>;
@@ -115,10 +204,17 @@ class AuditdNetlinkReader final : public InternalRunnable {
   virtual void start() override;
   virtual void stop() override;
 
+  /// Selects the parser shard of a message, using its audit event serial.
+  static std::size_t GetParserShard(const struct nlmsghdr* nlh,
+                                    std::size_t shard_count) noexcept;
+
  private:
   /// Reads as many audit event records as possible before returning.
   bool acquireMessages() noexcept;
 
+  /// Queues the messages of a batch for the parser shards.
+  void queueMessages(AuditMessageBatch batch);
+
   /// Configures the audit service and applies required rules
   bool configureAuditService() noexcept;
 
@@ -138,8 +234,14 @@ class AuditdNetlinkReader final : public InternalRunnable {
   /// Shared data
   AuditdContextRef auditd_context_;
 
-  /// Read buffer used when receiving events from the netlink
-  std::vector<audit_reply> read_buffer_;
+  /// Receives the batches of events from the netlink
+  AuditMessageReceiver receiver_;
+
+  /// The count of records received from the netlink
+  monitoring::Metric received_metric_;
+
+  /// The time spent throttling the netlink reader
+  monitoring::Metric throttled_metric_;
 
   /// The set of rules we applied (and that we'll uninstall when exiting)
   std::vector<audit_rule_data> installed_rule_list_;
@@ -154,7 +256,7 @@ class AuditdNetlinkReader final : public InternalRunnable {
 /// This service parses the raw audit records
 class AuditdNetlinkParser final : public InternalRunnable {
  public:
-  explicit AuditdNetlinkParser(AuditdContextRef context);
+  AuditdNetlinkParser(AuditdContextRef context, std::size_t shard);
   virtual void start() override;
 
   /// Parses an audit_reply structure into an AuditEventRecord object
@@ -164,9 +266,28 @@ class AuditdNetlinkParser final : public InternalRunnable {
   /// Adjusts the internal pointers of the audit_reply object
   static void AdjustAuditReply(audit_reply& reply) noexcept;
 
+  /// Points the audit_reply object to a message stored elsewhere
+  static void AdjustAuditReply(audit_reply& reply,
+                               struct nlmsghdr* nlh) noexcept;
+
+ private:
+  /// Reports the status of the audit service, including the lost records.
+  void handleAuditStatus(const struct audit_status& status);
+
  private:
   /// Shared data
   AuditdContextRef auditd_context_;
+
+  /// The shard parsed by this service
+  std::size_t shard_{0};
+
+  /// The count of records parsed, and of malformed records
+  monitoring::Metric parsed_metric_;
+  monitoring::Metric malformed_metric_;
+
+  /// The kernel counters of lost records and of the backlog size
+  monitoring::Metric lost_metric_;
+  monitoring::Metric backlog_metric_;
 };
 
 /// This class provides access to the audit netlink data
@@ -25,7 +25,19 @@ namespace osquery {
 HIDDEN_FLAG(uint32,
             bpf_state_tracker_reset_time,
             10,
-            "Number of minutes between BPF system state tracker resets");
+            "Number of minutes between BPF system state tracker resyncs");
+
+HIDDEN_FLAG(uint32,
+            bpf_state_tracker_resync_batch,
+            64,
+            "Number of processes checked by the BPF system state tracker "
+            "each second during a resync");
+
+HIDDEN_FLAG(uint32,
+            bpf_state_tracker_capture_age,
+            6,
+            "Number of resyncs after which the BPF system state tracker "
+            "captures a process from procfs again (0 = only when diverged)");
 
 namespace ebpfpub = tob::ebpfpub;
 namespace ebpf = tob::ebpf;
@@ -315,23 +327,36 @@ Status BPFEventPublisher::run() {
   BPFErrorState bpf_error_state;
 
   auto last_error_report = getUnixTime();
-  auto last_tracker_restart = getUnixTime();
+  auto last_tracker_resync = getUnixTime();
+  auto last_tracker_resync_batch = getUnixTime();
 
   while (!isEnding()) {
+    // Rather than taking a new snapshot of the whole system, compare the
+    // tracked processes against procfs a few at a time
     auto current_time = getUnixTime();
-    if (last_tracker_restart + (FLAGS_bpf_state_tracker_reset_time * 60) <
+    if (last_tracker_resync + (FLAGS_bpf_state_tracker_reset_time * 60) <
         current_time) {
-      auto status = d->system_state_tracker->restart();
+      auto status = d->system_state_tracker->beginResync();
       if (!status.ok()) {
-        LOG(ERROR) << "The BPF system state tracker could not be successfully "
-                      "restarted: "
+        LOG(ERROR) << "The BPF system state tracker could not start a new "
+                      "resync: "
+                   << status.getMessage();
+      }
+
+      last_tracker_resync = current_time;
+    }
+
+    if (last_tracker_resync_batch != current_time) {
+      auto status = d->system_state_tracker->resync(
+          FLAGS_bpf_state_tracker_resync_batch,
+          FLAGS_bpf_state_tracker_capture_age);
+
+      if (!status.ok()) {
+        LOG(ERROR) << "The BPF system state tracker could not be resynced: "
                    << status.getMessage();
-      } else {
-        VLOG(1)
-            << "The BPF system state tracker has been successfully restarted";
       }
 
-      last_tracker_restart = current_time;
+      last_tracker_resync_batch = current_time;
     }
 
     d->perf_event_reader->exec(
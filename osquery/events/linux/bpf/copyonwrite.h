@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osquery {
+
+class StringInterner;
+
+/// \brief A value shared by all its copies until one of them is modified
+/// Copying a CopyOnWrite object only copies a reference to the value,
+/// which is cloned the first time a shared copy is changed through
+/// edit(). The reference counts are not meant to be accessed from
+/// multiple threads at the same time
+template <typename T>
+class CopyOnWrite final {
+ public:
+  /// Creates an empty value, shared by all the empty objects
+  CopyOnWrite() : value(emptyValue()) {}
+
+  /// Takes ownership of the given value
+  CopyOnWrite(T new_value)
+      : value(std::make_shared<T>(std::move(new_value))) {}
+
+  /// Replaces the value, without affecting the other copies
+  CopyOnWrite& operator=(T new_value) {
+    value = std::make_shared<T>(std::move(new_value));
+    return *this;
+  }
+
+  CopyOnWrite(const CopyOnWrite&) = default;
+  CopyOnWrite& operator=(const CopyOnWrite&) = default;
+  CopyOnWrite(CopyOnWrite&&) = default;
+  CopyOnWrite& operator=(CopyOnWrite&&) = default;
+
+  const T& operator*() const {
+    return *value;
+  }
+
+  const T* operator->() const {
+    return value.get();
+  }
+
+  operator const T&() const {
+    return *value;
+  }
+
+  /// Returns a modifiable value, cloning it first if it is shared
+  T& edit() {
+    if (value.use_count() != 1) {
+      value = std::make_shared<T>(*value);
+    }
+
+    return *value;
+  }
+
+  /// Returns true if other objects reference the same value
+  bool shared() const {
+    return value.use_count() != 1;
+  }
+
+  friend bool operator==(const CopyOnWrite& lhs, const CopyOnWrite& rhs) {
+    return lhs.value == rhs.value || *lhs.value == *rhs.value;
+  }
+
+  friend bool operator==(const CopyOnWrite& lhs, const T& rhs) {
+    return *lhs.value == rhs;
+  }
+
+  friend bool operator==(const T& lhs, const CopyOnWrite& rhs) {
+    return lhs == *rhs.value;
+  }
+
+  friend bool operator!=(const CopyOnWrite& lhs, const CopyOnWrite& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator!=(const CopyOnWrite& lhs, const T& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator!=(const T& lhs, const CopyOnWrite& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  explicit CopyOnWrite(std::shared_ptr<T> shared_value)
+      : value(std::move(shared_value)) {}
+
+  static const std::shared_ptr<T>& emptyValue() {
+    static const auto empty_value = std::make_shared<T>();
+    return empty_value;
+  }
+
+  std::shared_ptr<T> value;
+
+  friend class StringInterner;
+};
+
+/// An immutable string, shared by all its copies
+using SharedString = CopyOnWrite<std::string>;
+
+} // namespace osquery
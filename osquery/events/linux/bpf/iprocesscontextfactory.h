@@ -9,22 +9,28 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
+#include <osquery/events/linux/bpf/copyonwrite.h>
 #include <osquery/events/linux/bpf/ifilesystem.h>
 
 namespace osquery {
 
-/// A structure collecting process data
+/// \brief A structure collecting process data
+/// Process contexts are copied every time a process forks. The
+/// strings, the argument list and the file descriptor map are shared
+/// with the parent process until either one of them changes them
 struct ProcessContext final {
   /// An object describing a file descriptor
   struct FileDescriptor final {
     /// Path data for files
     struct FileData final {
       /// File or directory path
-      std::string path;
+      SharedString path;
     };
 
     /// Network information for sockets
@@ -64,16 +70,16 @@ struct ProcessContext final {
   pid_t parent_process_id{};
 
   /// Current binary path
-  std::string binary_path;
+  SharedString binary_path;
 
   /// Program argument list
-  std::vector<std::string> argv;
+  CopyOnWrite<std::vector<std::string>> argv;
 
   /// Current working directory
-  std::string cwd;
+  SharedString cwd;
 
   /// File descriptor map, automatically inherited when forking
-  FileDescriptorMap fd_map;
+  CopyOnWrite<FileDescriptorMap> fd_map;
 };
 
 using ProcessContextMap = std::unordered_map<pid_t, ProcessContext>;
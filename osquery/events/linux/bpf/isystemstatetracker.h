@@ -98,6 +98,19 @@ class ISystemStateTracker {
   /// \brief Resets the internal state, taking a new /proc snapshot
   virtual Status restart() = 0;
 
+  /// \brief Starts a new incremental resynchronization round
+  /// Lists the processes in /proc and drops the ones that no longer
+  /// exist. The live processes are then checked by resync(). A round
+  /// that is still running is completed first
+  virtual Status beginResync() = 0;
+
+  /// \brief Checks up to max_process_count processes against procfs
+  /// Only the process contexts that have diverged from procfs, or that
+  /// have not been captured for max_capture_age rounds (0 = never), are
+  /// captured again; this is a no-op once the round is complete
+  virtual Status resync(std::size_t max_process_count,
+                        std::size_t max_capture_age) = 0;
+
   /// \brief Creates a new process, in response to an fork, vfork or clone
   /// syscall Once the method has updated the internal state, it will also emit
   /// a new event
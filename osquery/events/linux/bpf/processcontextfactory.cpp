@@ -71,6 +71,7 @@ bool ProcessContextFactory::captureSingleProcess(
   }
 
   ProcessContext output;
+  auto& fd_map = output.fd_map.edit();
 
   // clang-format off
   auto succeeded = fs.enumFiles(
@@ -121,7 +122,7 @@ bool ProcessContextFactory::captureSingleProcess(
       file_data.path = std::move(destination);
       fd_info.data = std::move(file_data);
 
-      output.fd_map.insert({int_fd_value, fd_info});
+      fd_map.insert({int_fd_value, fd_info});
     }
   );
   // clang-format on
@@ -130,22 +131,29 @@ bool ProcessContextFactory::captureSingleProcess(
     return false;
   }
 
-  succeeded = fs.readLinkAt(output.binary_path, process_root.get(), "exe");
+  std::string binary_path;
+  succeeded = fs.readLinkAt(binary_path, process_root.get(), "exe");
   static_cast<void>(succeeded);
 
-  succeeded = getArgvFromCmdlineFile(fs, output.argv, process_cmdline.get());
+  std::vector<std::string> argv;
+  succeeded = getArgvFromCmdlineFile(fs, argv, process_cmdline.get());
   static_cast<void>(succeeded);
 
   // If we failed to capture both fields, assume it's a special process
   // such as a kworker instance
-  if (output.binary_path.empty() != output.argv.empty()) {
+  if (binary_path.empty() != argv.empty()) {
     return false;
   }
 
-  if (!fs.readLinkAt(output.cwd, process_root.get(), "cwd")) {
+  std::string cwd;
+  if (!fs.readLinkAt(cwd, process_root.get(), "cwd")) {
     return false;
   }
 
+  output.binary_path = std::move(binary_path);
+  output.argv = std::move(argv);
+  output.cwd = std::move(cwd);
+
   if (!getParentPidFromStatFile(
           fs, output.parent_process_id, process_stat.get())) {
     return false;
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/events/linux/bpf/stringinterner.h>
+
+namespace osquery {
+
+SharedString StringInterner::intern(std::string value) {
+  auto string_it = string_map.find(value);
+  if (string_it != string_map.end()) {
+    return SharedString(string_it->second);
+  }
+
+  auto shared_value = std::make_shared<std::string>(std::move(value));
+  string_map.insert({*shared_value, shared_value});
+
+  return SharedString(std::move(shared_value));
+}
+
+void StringInterner::intern(SharedString& value) {
+  auto string_it = string_map.find(*value);
+  if (string_it != string_map.end()) {
+    if (string_it->second != value.value) {
+      value = SharedString(string_it->second);
+    }
+
+    return;
+  }
+
+  string_map.insert({*value.value, value.value});
+}
+
+void StringInterner::collect() {
+  for (auto string_it = string_map.begin(); string_it != string_map.end();) {
+    if (string_it->second.use_count() == 1) {
+      string_it = string_map.erase(string_it);
+    } else {
+      ++string_it;
+    }
+  }
+}
+
+std::size_t StringInterner::size() const {
+  return string_map.size();
+}
+
+} // namespace osquery
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <osquery/events/linux/bpf/copyonwrite.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace osquery {
+
+/// \brief Deduplicates the strings referenced by the process contexts
+/// Most processes share the same binary paths, working directories
+/// and open files. Interning them lets all the process contexts
+/// reference a single copy of each string
+class StringInterner final {
+ public:
+  /// Returns the shared copy of the given string
+  SharedString intern(std::string value);
+
+  /// Replaces the given string with its shared copy
+  void intern(SharedString& value);
+
+  /// Releases the strings that are only referenced by the interner
+  void collect();
+
+  /// Returns the number of strings currently interned
+  std::size_t size() const;
+
+ private:
+  /// The keys reference the strings owned by the values
+  std::unordered_map<std::string_view, std::shared_ptr<std::string>>
+      string_map;
+};
+
+} // namespace osquery
@@ -7,12 +7,14 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
 #include <osquery/events/linux/bpf/systemstatetracker.h>
 #include <osquery/logger/logger.h>
+#include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/status/status.h>
 #include <osquery/utils/system/time.h>
 
@@ -71,9 +73,50 @@ Status SystemStateTracker::restart() {
     return Status::failure("Failed to scan the procfs folder");
   }
 
+  // The snapshot is the procfs baseline of the next resync round
+  d->context.resync_state_map.clear();
+
+  for (auto& process : d->context.process_map) {
+    internProcessContext(d->context, process.second);
+    setResyncState(d->context, process.first, process.second);
+  }
+
+  d->context.string_interner.collect();
+  d->context.resync_queue = {};
+
   return Status::success();
 }
 
+Status SystemStateTracker::beginResync() {
+  IFilesystem::Ref fs;
+  auto status = IFilesystem::create(fs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  return beginResync(d->context, *fs.get());
+}
+
+Status SystemStateTracker::resync(std::size_t max_process_count,
+                                  std::size_t max_capture_age) {
+  // Avoid creating a filesystem object when there is nothing to do
+  if (d->context.resync_queue.empty()) {
+    return Status::success();
+  }
+
+  IFilesystem::Ref fs;
+  auto status = IFilesystem::create(fs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  return resync(d->context,
+                *d->process_context_factory.get(),
+                *fs.get(),
+                max_process_count,
+                max_capture_age);
+}
+
 bool SystemStateTracker::createProcess(
     const tob::ebpfpub::IFunctionTracer::Event::Header& event_header,
     pid_t process_id,
@@ -278,6 +321,28 @@ SystemStateTracker::SystemStateTracker(
   }
 }
 
+void SystemStateTracker::internProcessContext(
+    Context& context, ProcessContext& process_context) {
+  auto& string_interner = context.string_interner;
+  string_interner.intern(process_context.binary_path);
+  string_interner.intern(process_context.cwd);
+
+  if (process_context.fd_map->empty()) {
+    return;
+  }
+
+  for (auto& fd : process_context.fd_map.edit()) {
+    auto& fd_info = fd.second;
+    if (std::holds_alternative<ProcessContext::FileDescriptor::FileData>(
+            fd_info.data)) {
+      auto& file_data =
+          std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
+
+      string_interner.intern(file_data.path);
+    }
+  }
+}
+
 ProcessContext& SystemStateTracker::getProcessContext(
     Context& context,
     IProcessContextFactory& process_context_factory,
@@ -287,6 +352,8 @@ ProcessContext& SystemStateTracker::getProcessContext(
     ProcessContext process_context;
     if (process_context_factory.captureSingleProcess(process_context,
                                                      process_id)) {
+      internProcessContext(context, process_context);
+
       VLOG(1) << "Created new process context from procfs for pid "
               << process_id << " some fields may be not accurate";
     } else {
@@ -328,6 +395,9 @@ Status SystemStateTracker::expireProcessContexts(Context& context,
     }
   }
 
+  // Release the paths that were only used by the expired processes
+  context.string_interner.collect();
+
   if (return_error) {
     return Status::failure(
         "Failed to access one or more entries in the procfs directory");
@@ -336,12 +406,184 @@ Status SystemStateTracker::expireProcessContexts(Context& context,
   return Status::success();
 }
 
+void SystemStateTracker::setResyncState(Context& context,
+                                        pid_t process_id,
+                                        const ProcessContext& process_context) {
+  auto& resync_state = context.resync_state_map[process_id];
+  resync_state.binary_path = process_context.binary_path;
+  resync_state.cwd = process_context.cwd;
+  resync_state.capture_round = context.resync_round;
+}
+
+Status SystemStateTracker::beginResync(Context& context, IFilesystem& fs) {
+  // Starting over would never reach the processes at the front of the
+  // queue on hosts with more processes than a round can check
+  if (!context.resync_queue.empty()) {
+    VLOG(1) << "The previous BPF system state tracker resync has "
+            << context.resync_queue.size() << " processes left";
+    return Status::success();
+  }
+
+  tob::utils::UniqueFd procfs_root;
+  if (!fs.open(procfs_root, "/proc", O_DIRECTORY)) {
+    return Status::failure("Failed to open the procfs root: /proc");
+  }
+
+  std::vector<pid_t> resync_queue;
+
+  // clang-format off
+  auto succeeded = fs.enumFiles(
+    procfs_root.get(),
+
+    [&](const std::string &name, bool directory) {
+      if (!directory) {
+        return;
+      }
+
+      auto process_id_exp = tryTo<unsigned long long>(name, 10);
+      if (process_id_exp.isError()) {
+        return;
+      }
+
+      resync_queue.push_back(static_cast<pid_t>(process_id_exp.take()));
+    }
+  );
+  // clang-format on
+
+  if (!succeeded) {
+    return Status::failure("Failed to enumerate the procfs root: /proc");
+  }
+
+  // Processes we are tracking that are no longer in the listing have
+  // terminated without us seeing it; drop them right away
+  std::sort(resync_queue.begin(), resync_queue.end());
+
+  for (auto process_map_it = context.process_map.begin();
+       process_map_it != context.process_map.end();) {
+    if (!std::binary_search(resync_queue.begin(),
+                            resync_queue.end(),
+                            process_map_it->first)) {
+      process_map_it = context.process_map.erase(process_map_it);
+    } else {
+      ++process_map_it;
+    }
+  }
+
+  for (auto resync_state_it = context.resync_state_map.begin();
+       resync_state_it != context.resync_state_map.end();) {
+    if (context.process_map.count(resync_state_it->first) == 0U) {
+      resync_state_it = context.resync_state_map.erase(resync_state_it);
+    } else {
+      ++resync_state_it;
+    }
+  }
+
+  context.string_interner.collect();
+  ++context.resync_round;
+
+  VLOG(1) << "The BPF system state tracker has started a new resync of "
+          << resync_queue.size() << " processes";
+
+  // The queue is consumed from the back, so check the lowest (and
+  // usually longest lived) process identifiers first
+  std::reverse(resync_queue.begin(), resync_queue.end());
+  context.resync_queue = std::move(resync_queue);
+
+  return Status::success();
+}
+
+Status SystemStateTracker::resync(
+    Context& context,
+    IProcessContextFactory& process_context_factory,
+    IFilesystem& fs,
+    std::size_t max_process_count,
+    std::size_t max_capture_age) {
+  if (context.resync_queue.empty()) {
+    return Status::success();
+  }
+
+  tob::utils::UniqueFd procfs_root;
+  if (!fs.open(procfs_root, "/proc", O_DIRECTORY)) {
+    return Status::failure("Failed to open the procfs root: /proc");
+  }
+
+  for (std::size_t i = 0U;
+       i < max_process_count && !context.resync_queue.empty();
+       ++i) {
+    auto process_id = context.resync_queue.back();
+    context.resync_queue.pop_back();
+
+    tob::utils::UniqueFd process_root;
+    if (!fs.openAt(process_root,
+                   procfs_root.get(),
+                   std::to_string(process_id),
+                   O_DIRECTORY)) {
+      context.process_map.erase(process_id);
+      context.resync_state_map.erase(process_id);
+      continue;
+    }
+
+    // Compare the cheap fields first; the full capture reads the whole
+    // fd directory, so only pay for it when the context has diverged.
+    // Paths derived from events are not canonical, so the links are
+    // compared with what procfs reported the last time instead.
+    // Processes without such a baseline, or that have not been captured
+    // for too long (the fd map and argv are not compared), are captured
+    // again. Kernel threads have no exe link
+    auto resync_state_it = context.resync_state_map.find(process_id);
+    if (context.process_map.count(process_id) != 0U &&
+        resync_state_it != context.resync_state_map.end() &&
+        (max_capture_age == 0U ||
+         context.resync_round - resync_state_it->second.capture_round <
+             max_capture_age)) {
+      const auto& resync_state = resync_state_it->second;
+
+      std::string binary_path;
+      if (!fs.readLinkAt(binary_path, process_root.get(), "exe")) {
+        binary_path.clear();
+      }
+
+      std::string cwd;
+      if (!fs.readLinkAt(cwd, process_root.get(), "cwd")) {
+        cwd.clear();
+      }
+
+      if (resync_state.binary_path == binary_path &&
+          resync_state.cwd == cwd) {
+        continue;
+      }
+    }
+
+    ProcessContext process_context;
+    if (!process_context_factory.captureSingleProcess(process_context,
+                                                      process_id)) {
+      continue;
+    }
+
+    internProcessContext(context, process_context);
+    setResyncState(context, process_id, process_context);
+
+    VLOG(1) << "Resynchronized the process context for pid " << process_id
+            << " from procfs";
+
+    context.process_map[process_id] = std::move(process_context);
+  }
+
+  if (context.resync_queue.empty()) {
+    context.string_interner.collect();
+  }
+
+  return Status::success();
+}
+
 bool SystemStateTracker::createProcess(
     Context& context,
     IProcessContextFactory& process_context_factory,
     const tob::ebpfpub::IFunctionTracer::Event::Header& event_header,
     pid_t process_id,
     pid_t child_process_id) {
+  // The child shares the strings, argv and file descriptors of the
+  // parent until one of the two processes changes them
   ProcessContext child_process_context =
       getProcessContext(context, process_context_factory, process_id);
 
@@ -350,8 +592,8 @@ bool SystemStateTracker::createProcess(
   Event event;
   event.type = Event::Type::Fork;
   event.parent_process_id = child_process_context.parent_process_id;
-  event.binary_path = child_process_context.binary_path;
-  event.cwd = child_process_context.cwd;
+  event.binary_path = *child_process_context.binary_path;
+  event.cwd = *child_process_context.cwd;
 
   // The BPF header is emitted from the parent process; save it
   // and update it with the child process identifier
@@ -389,12 +631,12 @@ bool SystemStateTracker::executeBinary(
   if (binary_path.empty()) {
     std::string root_path;
 
-    auto fd_info_it = process_context.fd_map.find(dirfd);
-    if (fd_info_it == process_context.fd_map.end()) {
+    auto fd_info_it = process_context.fd_map->find(dirfd);
+    if (fd_info_it == process_context.fd_map->end()) {
       return false;
     }
 
-    auto fd_info = fd_info_it->second;
+    const auto& fd_info = fd_info_it->second;
     if (!std::holds_alternative<ProcessContext::FileDescriptor::FileData>(
             fd_info.data)) {
       return false;
@@ -406,20 +648,22 @@ bool SystemStateTracker::executeBinary(
     process_context.binary_path = file_data.path;
 
   } else if (binary_path.front() == '/') {
-    process_context.binary_path = binary_path;
+    process_context.binary_path =
+        context.string_interner.intern(binary_path);
 
   } else if (dirfd == AT_FDCWD) {
-    process_context.binary_path = process_context.cwd + '/' + binary_path;
+    process_context.binary_path = context.string_interner.intern(
+        *process_context.cwd + '/' + binary_path);
 
   } else {
     std::string root_path;
 
-    auto fd_info_it = process_context.fd_map.find(dirfd);
-    if (fd_info_it == process_context.fd_map.end()) {
+    auto fd_info_it = process_context.fd_map->find(dirfd);
+    if (fd_info_it == process_context.fd_map->end()) {
       return false;
     }
 
-    auto fd_info = fd_info_it->second;
+    const auto& fd_info = fd_info_it->second;
     if (!std::holds_alternative<ProcessContext::FileDescriptor::FileData>(
             fd_info.data)) {
       return false;
@@ -427,28 +671,40 @@ bool SystemStateTracker::executeBinary(
 
     const auto& file_data =
         std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
-    root_path = file_data.path;
+    root_path = *file_data.path;
 
-    process_context.binary_path = root_path + '/' + binary_path;
+    process_context.binary_path =
+        context.string_interner.intern(root_path + '/' + binary_path);
   }
 
   process_context.argv = argv;
 
-  for (auto fd_it = process_context.fd_map.begin();
-       fd_it != process_context.fd_map.end();) {
-    const auto& fd_info = fd_it->second;
-    if (fd_info.close_on_exec) {
-      fd_it = process_context.fd_map.erase(fd_it);
-    } else {
-      ++fd_it;
+  // Only detach the file descriptor map from the parent process if
+  // there is something to close
+  const auto& fd_map = *process_context.fd_map;
+  auto close_on_exec = std::any_of(
+      fd_map.begin(), fd_map.end(), [](const auto& fd) {
+        return fd.second.close_on_exec;
+      });
+
+  if (close_on_exec) {
+    auto& new_fd_map = process_context.fd_map.edit();
+
+    for (auto fd_it = new_fd_map.begin(); fd_it != new_fd_map.end();) {
+      const auto& fd_info = fd_it->second;
+      if (fd_info.close_on_exec) {
+        fd_it = new_fd_map.erase(fd_it);
+      } else {
+        ++fd_it;
+      }
     }
   }
 
   Event event;
   event.type = Event::Type::Exec;
   event.parent_process_id = process_context.parent_process_id;
-  event.binary_path = process_context.binary_path;
-  event.cwd = process_context.cwd;
+  event.binary_path = *process_context.binary_path;
+  event.cwd = *process_context.cwd;
   event.bpf_header = event_header;
 
   Event::ExecData data;
@@ -467,12 +723,12 @@ bool SystemStateTracker::setWorkingDirectory(
   auto& process_context =
       getProcessContext(context, process_context_factory, process_id);
 
-  auto fd_info_it = process_context.fd_map.find(dirfd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  auto fd_info_it = process_context.fd_map->find(dirfd);
+  if (fd_info_it == process_context.fd_map->end()) {
     return false;
   }
 
-  auto fd_info = fd_info_it->second;
+  const auto& fd_info = fd_info_it->second;
   if (!std::holds_alternative<ProcessContext::FileDescriptor::FileData>(
           fd_info.data)) {
     return false;
@@ -494,14 +750,16 @@ bool SystemStateTracker::setWorkingDirectory(
       getProcessContext(context, process_context_factory, process_id);
 
   if (path.front() == '/') {
-    process_context.cwd = path;
+    process_context.cwd = context.string_interner.intern(path);
 
   } else {
-    if (process_context.cwd.back() != '/') {
-      process_context.cwd += '/';
+    auto cwd = *process_context.cwd;
+    if (cwd.back() != '/') {
+      cwd += '/';
     }
 
-    process_context.cwd += path;
+    cwd += path;
+    process_context.cwd = context.string_interner.intern(std::move(cwd));
   }
 
   return true;
@@ -528,7 +786,7 @@ bool SystemStateTracker::openFile(
       return false;
     }
 
-    absolute_path = process_context.cwd;
+    absolute_path = *process_context.cwd;
     if (absolute_path.back() != '/') {
       absolute_path += '/';
     }
@@ -536,12 +794,12 @@ bool SystemStateTracker::openFile(
     absolute_path += path;
 
   } else {
-    auto fd_info_it = process_context.fd_map.find(dirfd);
-    if (fd_info_it == process_context.fd_map.end()) {
+    auto fd_info_it = process_context.fd_map->find(dirfd);
+    if (fd_info_it == process_context.fd_map->end()) {
       return false;
     }
 
-    auto fd_info = fd_info_it->second;
+    const auto& fd_info = fd_info_it->second;
     if (!std::holds_alternative<ProcessContext::FileDescriptor::FileData>(
             fd_info.data)) {
       return false;
@@ -550,7 +808,7 @@ bool SystemStateTracker::openFile(
     const auto& file_data =
         std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
 
-    absolute_path = file_data.path;
+    absolute_path = *file_data.path;
 
     if ((flags & AT_EMPTY_PATH) == 0) {
       if (absolute_path.back() != '/') {
@@ -565,10 +823,10 @@ bool SystemStateTracker::openFile(
   fd_info.close_on_exec = ((flags & O_CLOEXEC) != 0);
 
   ProcessContext::FileDescriptor::FileData file_data;
-  file_data.path = std::move(absolute_path);
+  file_data.path = context.string_interner.intern(std::move(absolute_path));
   fd_info.data = std::move(file_data);
 
-  process_context.fd_map.insert({newfd, std::move(fd_info)});
+  process_context.fd_map.edit().insert({newfd, std::move(fd_info)});
   return true;
 }
 
@@ -583,14 +841,14 @@ bool SystemStateTracker::duplicateHandle(Context& context,
   }
 
   auto& process_context = process_context_it->second;
-  auto fd_info_it = process_context.fd_map.find(oldfd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  auto fd_info_it = process_context.fd_map->find(oldfd);
+  if (fd_info_it == process_context.fd_map->end()) {
     return false;
   }
 
   auto new_fd_info = fd_info_it->second;
   new_fd_info.close_on_exec = close_on_exec;
-  process_context.fd_map.insert({newfd, std::move(new_fd_info)});
+  process_context.fd_map.edit().insert({newfd, std::move(new_fd_info)});
 
   return true;
 }
@@ -607,12 +865,11 @@ bool SystemStateTracker::closeHandle(
   auto& process_context =
       getProcessContext(context, process_context_factory, process_id);
 
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  if (process_context.fd_map->count(fd) == 0) {
     return false;
   }
 
-  process_context.fd_map.erase(fd_info_it);
+  process_context.fd_map.edit().erase(fd);
   return true;
 }
 
@@ -636,7 +893,7 @@ bool SystemStateTracker::createSocket(
   socket_data.opt_protocol = protocol;
   fd_info.data = std::move(socket_data);
 
-  process_context.fd_map.insert({fd, std::move(fd_info)});
+  process_context.fd_map.edit().insert({fd, std::move(fd_info)});
   return true;
 }
 
@@ -652,15 +909,15 @@ bool SystemStateTracker::bind(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  auto& fd_map = process_context.fd_map.edit();
+
+  auto fd_info_it = fd_map.find(fd);
+  if (fd_info_it == fd_map.end()) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
+    auto insert_status = fd_map.insert({fd, std::move(fd_info)});
     fd_info_it = insert_status.first;
   }
 
@@ -681,8 +938,8 @@ bool SystemStateTracker::bind(
   Event event;
   event.type = Event::Type::Bind;
   event.parent_process_id = process_context.parent_process_id;
-  event.binary_path = process_context.binary_path;
-  event.cwd = process_context.cwd;
+  event.binary_path = *process_context.binary_path;
+  event.cwd = *process_context.cwd;
   event.bpf_header = event_header;
 
   Event::SocketData data;
@@ -733,13 +990,13 @@ bool SystemStateTracker::listen(
   auto& process_context =
       getProcessContext(context, process_context_factory, process_id);
 
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it != process_context.fd_map.end()) {
-    auto& fd_info = fd_info_it->second;
+  auto fd_info_it = process_context.fd_map->find(fd);
+  if (fd_info_it != process_context.fd_map->end()) {
+    const auto& fd_info = fd_info_it->second;
 
     if (std::holds_alternative<ProcessContext::FileDescriptor::SocketData>(
             fd_info.data)) {
-      auto& socket_address =
+      const auto& socket_address =
           std::get<ProcessContext::FileDescriptor::SocketData>(fd_info.data);
 
       if (socket_address.opt_domain.has_value()) {
@@ -775,8 +1032,8 @@ bool SystemStateTracker::listen(
   Event event;
   event.type = Event::Type::Listen;
   event.parent_process_id = process_context.parent_process_id;
-  event.binary_path = process_context.binary_path;
-  event.cwd = process_context.cwd;
+  event.binary_path = *process_context.binary_path;
+  event.cwd = *process_context.cwd;
   event.bpf_header = event_header;
   event.data = std::move(data);
 
@@ -796,15 +1053,15 @@ bool SystemStateTracker::connect(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  auto& fd_map = process_context.fd_map.edit();
+
+  auto fd_info_it = fd_map.find(fd);
+  if (fd_info_it == fd_map.end()) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
+    auto insert_status = fd_map.insert({fd, std::move(fd_info)});
     fd_info_it = insert_status.first;
   }
 
@@ -825,8 +1082,8 @@ bool SystemStateTracker::connect(
   Event event;
   event.type = Event::Type::Connect;
   event.parent_process_id = process_context.parent_process_id;
-  event.binary_path = process_context.binary_path;
-  event.cwd = process_context.cwd;
+  event.binary_path = *process_context.binary_path;
+  event.cwd = *process_context.cwd;
   event.bpf_header = event_header;
 
   Event::SocketData data;
@@ -879,15 +1136,15 @@ bool SystemStateTracker::accept(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto parent_fd_info_it = process_context.fd_map.find(fd);
-  if (parent_fd_info_it == process_context.fd_map.end()) {
+  auto& fd_map = process_context.fd_map.edit();
+
+  auto parent_fd_info_it = fd_map.find(fd);
+  if (parent_fd_info_it == fd_map.end()) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
+    auto insert_status = fd_map.insert({fd, std::move(fd_info)});
     parent_fd_info_it = insert_status.first;
   }
 
@@ -912,13 +1169,13 @@ bool SystemStateTracker::accept(
     return false;
   }
 
-  process_context.fd_map.insert({newfd, new_fd_info});
+  fd_map.insert({newfd, new_fd_info});
 
   Event event;
   event.type = Event::Type::Accept;
   event.parent_process_id = process_context.parent_process_id;
-  event.binary_path = process_context.binary_path;
-  event.cwd = process_context.cwd;
+  event.binary_path = *process_context.binary_path;
+  event.cwd = *process_context.cwd;
   event.bpf_header = event_header;
 
   Event::SocketData data;
@@ -989,11 +1246,11 @@ bool SystemStateTracker::openByHandleAt(
       std::string base_path;
 
       if (file_handle.dfd == AT_FDCWD) {
-        base_path = process_context.cwd;
+        base_path = *process_context.cwd;
 
       } else {
-        auto fd_info_it = process_context.fd_map.find(file_handle.dfd);
-        if (fd_info_it == process_context.fd_map.end()) {
+        auto fd_info_it = process_context.fd_map->find(file_handle.dfd);
+        if (fd_info_it == process_context.fd_map->end()) {
           return false;
         }
 
@@ -1006,15 +1263,15 @@ bool SystemStateTracker::openByHandleAt(
         const auto& file_data =
             std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
 
-        base_path = file_data.path;
+        base_path = *file_data.path;
       }
 
       absolute_path = base_path + '/' + file_handle.name;
     }
 
   } else if ((file_handle.flags & AT_EMPTY_PATH) != 0) {
-    auto fd_info_it = process_context.fd_map.find(file_handle.dfd);
-    if (fd_info_it == process_context.fd_map.end()) {
+    auto fd_info_it = process_context.fd_map->find(file_handle.dfd);
+    if (fd_info_it == process_context.fd_map->end()) {
       return false;
     }
 
@@ -1027,7 +1284,7 @@ bool SystemStateTracker::openByHandleAt(
     const auto& file_data =
         std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
 
-    absolute_path = file_data.path;
+    absolute_path = *file_data.path;
 
   } else {
     return false;
@@ -1035,10 +1292,10 @@ bool SystemStateTracker::openByHandleAt(
 
   ProcessContext::FileDescriptor fd_info{};
   ProcessContext::FileDescriptor::FileData file_data{};
-  file_data.path = std::move(absolute_path);
+  file_data.path = context.string_interner.intern(std::move(absolute_path));
   fd_info.data = std::move(file_data);
 
-  process_context.fd_map.insert({newfd, std::move(fd_info)});
+  process_context.fd_map.edit().insert({newfd, std::move(fd_info)});
   return true;
 }
 
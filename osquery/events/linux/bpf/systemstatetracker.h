@@ -11,6 +11,7 @@
 
 #include <osquery/events/linux/bpf/iprocesscontextfactory.h>
 #include <osquery/events/linux/bpf/isystemstatetracker.h>
+#include <osquery/events/linux/bpf/stringinterner.h>
 
 #include <functional>
 #include <memory>
@@ -28,6 +29,9 @@ class SystemStateTracker final : public ISystemStateTracker {
   virtual ~SystemStateTracker() override;
 
   virtual Status restart() override;
+  virtual Status beginResync() override;
+  virtual Status resync(std::size_t max_process_count,
+                        std::size_t max_capture_age) override;
 
   virtual bool createProcess(
       const tob::ebpfpub::IFunctionTracer::Event::Header& event_header,
@@ -127,8 +131,34 @@ class SystemStateTracker final : public ISystemStateTracker {
 
     std::vector<std::string> file_handle_struct_index;
     FileHandleStructMap file_handle_struct_map;
+
+    /// Paths referenced by the process contexts
+    StringInterner string_interner;
+
+    /// Processes waiting to be checked by the current resync round
+    std::vector<pid_t> resync_queue;
+
+    /// The number of resync rounds started
+    std::uint64_t resync_round{0};
+
+    /// What procfs reported for a process when it was last checked
+    struct ResyncState final {
+      /// The exe link, as read from procfs
+      SharedString binary_path;
+
+      /// The cwd link, as read from procfs
+      SharedString cwd;
+
+      /// The round in which the process was last captured
+      std::uint64_t capture_round{0};
+    };
+
+    std::unordered_map<pid_t, ResyncState> resync_state_map;
   };
 
+  static void internProcessContext(Context& context,
+                                   ProcessContext& process_context);
+
   static ProcessContext& getProcessContext(
       Context& context,
       IProcessContextFactory& process_context_factory,
@@ -136,6 +166,18 @@ class SystemStateTracker final : public ISystemStateTracker {
 
   static Status expireProcessContexts(Context& context, IFilesystem& fs);
 
+  static void setResyncState(Context& context,
+                             pid_t process_id,
+                             const ProcessContext& process_context);
+
+  static Status beginResync(Context& context, IFilesystem& fs);
+
+  static Status resync(Context& context,
+                       IProcessContextFactory& process_context_factory,
+                       IFilesystem& fs,
+                       std::size_t max_process_count,
+                       std::size_t max_capture_age);
+
   static bool createProcess(
       Context& context,
       IProcessContextFactory& process_context_factory,
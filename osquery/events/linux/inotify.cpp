@@ -7,8 +7,11 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
 #include <sstream>
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <fnmatch.h>
 #include <linux/limits.h>
 #include <poll.h>
@@ -53,8 +56,76 @@ const uint32_t kFileDefaultMasks = IN_MOVED_TO | IN_MOVED_FROM | IN_MODIFY |
                                    IN_ATTRIB;
 const uint32_t kFileAccessMasks = IN_OPEN | IN_ACCESS;
 
+/// Recursive watches are added in batches, releasing the path lock.
+static const size_t kWatchBatchSize = 1024;
+
 REGISTER(INotifyEventPublisher, "event_publisher", "inotify");
 
+namespace {
+
+/**
+ * @brief Append the canonical path of each directory below a directory.
+ *
+ * Entry types are read from the directory entries, only entries of unknown
+ * type and symbolic links are inspected. Symbolic links to directories are
+ * listed, but not followed.
+ */
+void listSubdirectories(const std::string& path,
+                        std::vector<std::string>& results) {
+  char resolved[PATH_MAX];
+  if (::realpath(path.c_str(), resolved) == nullptr) {
+    return;
+  }
+
+  std::vector<std::string> pending = {resolved};
+  if (pending.back().back() != '/') {
+    pending.back() += '/';
+  }
+
+  while (!pending.empty()) {
+    auto directory = std::move(pending.back());
+    pending.pop_back();
+
+    auto* handle = ::opendir(directory.c_str());
+    if (handle == nullptr) {
+      continue;
+    }
+
+    while (auto* entry = ::readdir(handle)) {
+      std::string name = entry->d_name;
+      if (name == "." || name == "..") {
+        continue;
+      }
+
+      auto type = entry->d_type;
+      struct stat entry_stat;
+      if (type == DT_UNKNOWN &&
+          ::fstatat(::dirfd(handle),
+                    entry->d_name,
+                    &entry_stat,
+                    AT_SYMLINK_NOFOLLOW) == 0) {
+        type = S_ISDIR(entry_stat.st_mode)
+                   ? DT_DIR
+                   : (S_ISLNK(entry_stat.st_mode) ? DT_LNK : DT_REG);
+      }
+
+      auto child = directory + name;
+      if (type == DT_DIR) {
+        child += '/';
+        results.push_back(child);
+        pending.push_back(std::move(child));
+      } else if (type == DT_LNK &&
+                 ::realpath(child.c_str(), resolved) != nullptr &&
+                 isDirectory(resolved).ok()) {
+        results.push_back(std::string(resolved) + '/');
+      }
+    }
+    ::closedir(handle);
+  }
+}
+
+} // namespace
+
 Status INotifyEventPublisher::setUp() {
   if (!FLAGS_enable_file_events) {
     return Status(1, "Publisher disabled via configuration");
@@ -139,6 +210,9 @@ void INotifyEventPublisher::buildExcludePathsSet() {
 
   WriteLock lock(subscription_lock_);
   exclude_paths_.clear();
+  if (parser == nullptr) {
+    return;
+  }
 
   const auto& doc = parser->getData();
   if (!doc.doc().HasMember("exclude_paths")) {
@@ -358,6 +432,36 @@ bool INotifyEventPublisher::shouldFire(const INotifySubscriptionContextRef& sc,
   return true;
 }
 
+Status INotifyEventPublisher::addWatch(const std::string& path,
+                                       INotifySubscriptionContextRef& isc,
+                                       uint32_t mask,
+                                       bool add_watch) {
+  int watch = ::inotify_add_watch(
+      getHandle(), path.c_str(), ((mask == 0) ? kFileDefaultMasks : mask));
+  if (add_watch && watch == -1) {
+    return Status(errno, "Could not add inotify watch on: " + path);
+  }
+
+  if (descriptor_inosubctx_.find(watch) != descriptor_inosubctx_.end()) {
+    auto ino_sc = descriptor_inosubctx_.at(watch);
+    if (inotify_sanity_check) {
+      std::string watched_path = ino_sc->descriptor_paths_[watch];
+      path_descriptors_.erase(watched_path);
+    }
+    ino_sc->descriptor_paths_.erase(watch);
+    descriptor_inosubctx_.erase(watch);
+  }
+
+  // Keep a map of (descriptor -> path)
+  isc->descriptor_paths_[watch] = path;
+  descriptor_inosubctx_[watch] = isc;
+  if (inotify_sanity_check) {
+    // Keep a map of the path -> watch descriptor
+    path_descriptors_[path] = watch;
+  }
+  return Status::success();
+}
+
 bool INotifyEventPublisher::addMonitor(const std::string& path,
                                        INotifySubscriptionContextRef& isc,
                                        uint32_t mask,
@@ -365,41 +469,38 @@ bool INotifyEventPublisher::addMonitor(const std::string& path,
                                        bool add_watch) {
   {
     WriteLock lock(path_mutex_);
-    int watch = ::inotify_add_watch(
-        getHandle(), path.c_str(), ((mask == 0) ? kFileDefaultMasks : mask));
-    if (add_watch && watch == -1) {
-      LOG(WARNING) << "Could not add inotify watch on: " << path;
+    auto status = addWatch(path, isc, mask, add_watch);
+    if (!status.ok()) {
+      LOG(WARNING) << status.getMessage();
       return false;
     }
+  }
 
-    if (descriptor_inosubctx_.find(watch) != descriptor_inosubctx_.end()) {
-      auto ino_sc = descriptor_inosubctx_.at(watch);
-      if (inotify_sanity_check) {
-        std::string watched_path = ino_sc->descriptor_paths_[watch];
-        path_descriptors_.erase(watched_path);
-      }
-      ino_sc->descriptor_paths_.erase(watch);
-      descriptor_inosubctx_.erase(watch);
-    }
-
-    // Keep a map of (descriptor -> path)
-    isc->descriptor_paths_[watch] = path;
-    descriptor_inosubctx_[watch] = isc;
-    if (inotify_sanity_check) {
-      // Keep a map of the path -> watch descriptor
-      path_descriptors_[path] = watch;
-    }
+  if (!recursive || !isDirectory(path).ok()) {
+    return true;
   }
 
-  if (recursive && isDirectory(path).ok()) {
-    std::vector<std::string> children;
-    // Get a list of children of this directory (requested recursive watches).
-    listDirectoriesInDirectory(path, children, true);
+  // Get a list of children of this directory (requested recursive watches).
+  std::vector<std::string> children;
+  listSubdirectories(path, children);
 
-    boost::system::error_code ec;
-    for (const auto& child : children) {
-      auto canonicalized = fs::canonical(child, ec).string() + '/';
-      addMonitor(canonicalized, isc, mask, false);
+  // Excluded directories are still watched, their events are filtered in
+  // shouldFire. Directories created below them must be watched as well.
+  // The path lock is released between batches, to let events be read.
+  for (size_t batch = 0; batch < children.size(); batch += kWatchBatchSize) {
+    WriteLock lock(path_mutex_);
+    auto batch_end = std::min(batch + kWatchBatchSize, children.size());
+    for (auto child = batch; child < batch_end; ++child) {
+      auto status = addWatch(children[child], isc, mask, add_watch);
+      if (status.getCode() == ENOSPC) {
+        // Every following watch would fail.
+        LOG(WARNING) << "The inotify watch limit was reached, "
+                     << children.size() - child << " directories below "
+                     << path << " are not monitored";
+        return true;
+      } else if (!status.ok()) {
+        LOG(WARNING) << status.getMessage();
+      }
     }
   }
 
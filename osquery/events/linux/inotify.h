@@ -16,7 +16,7 @@
 #include <sys/stat.h>
 
 #include <osquery/events/eventpublisher.h>
-#include <osquery/events/pathset.h>
+#include <osquery/events/pathtrie.h>
 #include <osquery/events/subscription.h>
 
 namespace osquery {
@@ -124,7 +124,7 @@ using INotifyEventContextRef = std::shared_ptr<INotifyEventContext>;
 // Publisher container
 using DescriptorINotifySubCtxMap = std::map<int, INotifySubscriptionContextRef>;
 
-using ExcludePathSet = PathSet<patternedPath>;
+using ExcludePathSet = PathTrie;
 
 /**
  * @brief A Linux `inotify` EventPublisher.
@@ -191,7 +191,9 @@ class INotifyEventPublisher
    * file descriptor is stored for lookup when events fire.
    *
    * A recursive flag will tell addMonitor to enumerate all subdirectories
-   * recursively and add monitors to them.
+   * recursively and add monitors to them. The subdirectories are walked
+   * before any is monitored, then monitored in batches. Excluded
+   * subdirectories are monitored too, their events are filtered when fired.
    *
    * @param path complete (non-glob) canonical path to monitor.
    * @param subscription context tracking the path.
@@ -205,6 +207,16 @@ class INotifyEventPublisher
                   bool recursive,
                   bool add_watch = true);
 
+  /**
+   * @brief Add a single INotify watch, the caller holds path_mutex_.
+   *
+   * @return success if the watch was created, or the watch creation errno.
+   */
+  Status addWatch(const std::string& path,
+                  INotifySubscriptionContextRef& isc,
+                  uint32_t mask,
+                  bool add_watch);
+
   /**
    * Some decision making code refactored in needMonitoring before calling
    * addMonitor in the context of monitorSubscription.
@@ -291,5 +303,6 @@ class INotifyEventPublisher
   FRIEND_TEST(INotifyTests, DISABLED_test_inotify_recursion);
   FRIEND_TEST(INotifyTests, test_inotify_match_subscription);
   FRIEND_TEST(INotifyTests, test_inotify_embedded_wildcards);
+  FRIEND_TEST(INotifyTests, test_inotify_excluded_directories);
 };
 }
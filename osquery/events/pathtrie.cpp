@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/events/pathtrie.h>
+#include <osquery/filesystem/filesystem.h>
+
+namespace osquery {
+
+PathTrie::PathTrie() : root_(std::make_unique<Node>()) {}
+
+PathTrie::~PathTrie() = default;
+
+std::string_view PathTrie::nextComponent(std::string_view& path) {
+  auto start = path.find_first_not_of('/');
+  if (start == std::string_view::npos) {
+    path = std::string_view();
+    return path;
+  }
+
+  auto end = path.find('/', start);
+  if (end == std::string_view::npos) {
+    end = path.size();
+  }
+
+  auto component = path.substr(start, end - start);
+  path.remove_prefix(end);
+  return component;
+}
+
+void PathTrie::insert(const std::string& pattern) {
+  auto expanded = pattern;
+  replaceGlobWildcards(expanded);
+
+  WriteLock lock(mutex_);
+  auto* node = root_.get();
+  std::string_view path(expanded);
+  if (path == "/") {
+    // The root path is a single empty component.
+    auto& child = node->children[std::string()];
+    if (child == nullptr) {
+      child = std::make_unique<Node>();
+    }
+    node = child.get();
+    path = std::string_view();
+  }
+
+  for (auto component = nextComponent(path); !component.empty();
+       component = nextComponent(path)) {
+    if (component == "**") {
+      // The path before the wildcard also matches, see patternedPath.
+      node->terminal = true;
+      node->any_suffix = true;
+      patterns_++;
+      return;
+    }
+
+    auto& child = (component == "*")
+                      ? node->any
+                      : node->children[std::string(component)];
+    if (child == nullptr) {
+      child = std::make_unique<Node>();
+    }
+    node = child.get();
+  }
+
+  node->terminal = true;
+  patterns_++;
+}
+
+bool PathTrie::match(const Node& node, std::string_view path) {
+  auto component = nextComponent(path);
+  if (component.empty()) {
+    return node.terminal;
+  }
+
+  if (node.any_suffix) {
+    return true;
+  }
+
+  auto child = node.children.find(component);
+  if (child != node.children.end() && match(*child->second, path)) {
+    return true;
+  }
+
+  // A trailing '*' also matches deeper paths.
+  return node.any != nullptr && (node.any->terminal || match(*node.any, path));
+}
+
+bool PathTrie::find(const std::string& path) const {
+  ReadLock lock(mutex_);
+  if (path == "/") {
+    // The root path is a single empty component.
+    auto child = root_->children.find(std::string_view());
+    return root_->any_suffix ||
+           (child != root_->children.end() && child->second->terminal) ||
+           (root_->any != nullptr && root_->any->terminal);
+  }
+  return match(*root_, path);
+}
+
+void PathTrie::clear() {
+  WriteLock lock(mutex_);
+  root_ = std::make_unique<Node>();
+  patterns_ = 0;
+}
+
+bool PathTrie::empty() const {
+  ReadLock lock(mutex_);
+  return patterns_ == 0;
+}
+
+} // namespace osquery
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+
+/**
+ * @brief A trie of path patterns, matched one path component at a time.
+ *
+ * Patterns follow the rules of PathSet<patternedPath>. A component made of
+ * '%' (or '*') matches any single component, and also any deeper path when
+ * it is the last component. A component made of '%%' (or '**') matches the
+ * path before it and everything below it, components after it are ignored.
+ *
+ * A lookup walks the path components once, without tokenizing the path or
+ * allocating, so its cost does not grow with the number of patterns.
+ *
+ * The trie is protected by a lock. It is threadsafe.
+ */
+class PathTrie : private boost::noncopyable {
+ public:
+  PathTrie();
+  ~PathTrie();
+
+  /// Add a path pattern.
+  void insert(const std::string& pattern);
+
+  /// Check if a path matches any pattern.
+  bool find(const std::string& path) const;
+
+  /// Remove every pattern.
+  void clear();
+
+  /// Check if there are no patterns.
+  bool empty() const;
+
+ private:
+  struct Node {
+    /// Children for literal components.
+    std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+
+    /// The child for a '*' component.
+    std::unique_ptr<Node> any;
+
+    /// A '**' component follows this node.
+    bool any_suffix{false};
+
+    /// A pattern ends at this node.
+    bool terminal{false};
+  };
+
+  /// Remove the next component from a path, empty if there are none.
+  static std::string_view nextComponent(std::string_view& path);
+
+  /// Match the remaining components of a path, starting at a node.
+  static bool match(const Node& node, std::string_view path);
+
+ private:
+  std::unique_ptr<Node> root_;
+
+  /// The number of inserted patterns.
+  size_t patterns_{0};
+
+  mutable Mutex mutex_;
+};
+
+} // namespace osquery
@@ -12,6 +12,7 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -239,6 +240,49 @@ TEST_F(EventSubscriberPluginTests, generateRows) {
   EXPECT_EQ(result.isEnd, true);
 }
 
+TEST_F(EventSubscriberPluginTests, generateRowsWithLimit) {
+  MockedOsqueryDatabase mocked_database;
+  mocked_database.generateEvents("type", "name");
+
+  EventSubscriberPlugin::Context context;
+  EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+
+  auto status =
+      EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
+  ASSERT_TRUE(status.ok());
+
+  std::vector<std::string> times;
+  auto callback = [&times](Row row) { times.push_back(row["time"]); };
+
+  // The oldest events are generated first.
+  auto result = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 0, 0, 0, 3);
+  EXPECT_EQ(times, std::vector<std::string>({"0", "1", "2"}));
+
+  // Only the generated events are visited.
+  EXPECT_EQ(result.isEnd, false);
+  EXPECT_EQ(result.last_time, 2U);
+
+  // Nothing is visited when the limit skips older events.
+  times.clear();
+  result = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 0, 0, 0, 3, true);
+  EXPECT_EQ(times, std::vector<std::string>({"9", "8", "7"}));
+  EXPECT_EQ(result.isEnd, true);
+
+  times.clear();
+  result = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 2, 5, 0, 10, true);
+  EXPECT_EQ(times, std::vector<std::string>({"5", "4", "3", "2"}));
+  EXPECT_EQ(result.last_time, 5U);
+
+  // Events visited by a previous optimized query are not counted.
+  times.clear();
+  result = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 0, 0, result.last_id, 2);
+  EXPECT_EQ(times, std::vector<std::string>({"6", "7"}));
+}
+
 class FakeEventSubscriberPlugin : public EventSubscriberPlugin {
  public:
   FakeEventSubscriberPlugin(IDatabaseInterface& db)
@@ -393,4 +437,31 @@ TEST_F(EventSubscriberPluginTests, generateRowsWithOptimize) {
   ASSERT_FALSE(subscriber.executedAllQueries());
   EXPECT_EQ(0U, callback_count);
 }
+
+TEST_F(EventSubscriberPluginTests, generateRowsWithOptimizeAndLimit) {
+  MockedOsqueryDatabase mocked_database;
+  FakeEventSubscriberPlugin subscriber(mocked_database);
+  mocked_database.generateEvents(subscriber.getType(), subscriber.getName());
+
+  subscriber.setDatabaseNamespace();
+  subscriber.generateEventDataIndex();
+  subscriber.resetQueryCount(2);
+  subscriber.setOptimizeData(mocked_database, 0, 0);
+  subscriber.setShouldOptimize(true);
+
+  std::vector<std::string> times;
+  auto callback = [&times](Row row) { times.push_back(row["time"]); };
+
+  // A limited query continues after the last event it generated.
+  subscriber.generateRows(callback, true, 0, 0, 6);
+  EXPECT_EQ(times, std::vector<std::string>({"0", "1", "2", "3", "4", "5"}));
+
+  times.clear();
+  subscriber.generateRows(callback, true, 0, 0, 6);
+  EXPECT_EQ(times, std::vector<std::string>({"6", "7", "8", "9"}));
+
+  times.clear();
+  subscriber.generateRows(callback, true, 0, 0, 6);
+  EXPECT_TRUE(times.empty());
+}
 } // namespace osquery
@@ -8,6 +8,8 @@
  */
 
 #include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
@@ -76,6 +78,95 @@ TEST_F(AuditTests, test_handle_reply) {
   EXPECT_EQ(audit_event_record.fields["a2"], "c");
 }
 
+TEST_F(AuditTests, test_receive_message_batch) {
+  // Messages are replayed through a socketpair instead of the audit netlink.
+  int sockets[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets), 0);
+
+  std::vector<std::string> messages = {
+      "audit(1440542781.644:403030): argc=3 a0=\"H=1 \" a1=\"/bin/sh\" a2=c",
+      "audit(1440542781.644:403030): cwd=\"/root\"",
+      "audit(1440542781.644:403030): proctitle=2F62696E2F7368",
+  };
+
+  for (const auto& message : messages) {
+    // The kernel does not include the header in the length of audit records.
+    audit_message packet = {};
+    packet.nlh.nlmsg_type = AUDIT_EXECVE;
+    packet.nlh.nlmsg_len = static_cast<__u32>(message.size());
+    memcpy(packet.data, message.data(), message.size());
+
+    auto size = NLMSG_HDRLEN + message.size();
+    ASSERT_EQ(send(sockets[1], &packet, size, 0), static_cast<ssize_t>(size));
+  }
+
+  // The batch stops at the requested number of messages.
+  AuditMessageReceiver receiver(false);
+  AuditMessageBatch batch;
+  EXPECT_TRUE(receiver.receive(sockets[0], batch, 2, 0).ok());
+  EXPECT_EQ(batch.size(), 2U);
+
+  // The remaining messages are appended without waiting.
+  EXPECT_TRUE(receiver.receive(sockets[0], batch, 1024, 0).ok());
+  ASSERT_EQ(batch.size(), messages.size());
+
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    audit_reply reply;
+    AuditdNetlinkParser::AdjustAuditReply(reply, batch.header(i));
+    EXPECT_EQ(reply.type, AUDIT_EXECVE);
+    EXPECT_EQ(std::string(reply.message), messages[i]);
+
+    AuditEventRecord audit_event_record = {};
+    EXPECT_TRUE(
+        AuditdNetlinkParser::ParseAuditReply(reply, audit_event_record));
+    EXPECT_EQ("1440542781.644:403030", audit_event_record.audit_id);
+  }
+
+  // Messages filling the whole receive buffer may have been truncated.
+  std::vector<char> oversized(sizeof(audit_message), 'A');
+  auto oversized_header = reinterpret_cast<struct nlmsghdr*>(oversized.data());
+  *oversized_header = {};
+  oversized_header->nlmsg_len = sizeof(audit_message);
+  ASSERT_EQ(send(sockets[1], oversized.data(), oversized.size(), 0),
+            static_cast<ssize_t>(oversized.size()));
+  EXPECT_FALSE(receiver.receive(sockets[0], batch, 1024, 0).ok());
+  EXPECT_EQ(batch.size(), messages.size());
+
+  close(sockets[0]);
+  close(sockets[1]);
+}
+
+TEST_F(AuditTests, test_parser_shard) {
+  auto make_message = [](const std::string& message) {
+    std::vector<char> packet(NLMSG_HDRLEN + message.size() + NLMSG_HDRLEN + 1);
+    auto nlh = reinterpret_cast<struct nlmsghdr*>(packet.data());
+    nlh->nlmsg_type = AUDIT_SYSCALL;
+    nlh->nlmsg_len = static_cast<__u32>(message.size());
+    memcpy(packet.data() + NLMSG_HDRLEN, message.data(), message.size());
+    return packet;
+  };
+
+  // Records are sharded by the serial of their audit event.
+  auto syscall = make_message("audit(1440542781.644:403030): arch=c000003e");
+  auto cwd = make_message("audit(1440542781.644:403030): cwd=\"/root\"");
+  auto next = make_message("audit(1440542781.644:403031): arch=c000003e");
+
+  auto header = [](std::vector<char>& packet) {
+    return reinterpret_cast<struct nlmsghdr*>(packet.data());
+  };
+
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(syscall), 4), 2U);
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(cwd), 4), 2U);
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(next), 4), 3U);
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(next), 1), 0U);
+
+  // Messages without an event serial go to the first shard.
+  auto other = make_message("op=add_rule key=(null) list=4 res=1");
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(other), 4), 0U);
+  auto broken = make_message("audit(1440542781.644:40x): arch=c000003e");
+  EXPECT_EQ(AuditdNetlinkReader::GetParserShard(header(broken), 4), 0U);
+}
+
 TEST_F(AuditTests, test_audit_value_decode) {
   // In the normal case the decoding only removes '"' characters from the ends.
   auto decoded_normal = DecodeAuditPathValues("\"/bin/ls\"");
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "mockedprocfilesystem.h"
+
+#include <osquery/utils/conversions/tryto.h>
+
+namespace osquery {
+
+namespace {
+
+const int kProcFsRootFd{0xFFFFFF0};
+const int kProcessRootFdBase{0x1000000};
+
+} // namespace
+
+void MockedProcFilesystem::setProcess(pid_t process_id,
+                                      const std::string& binary_path,
+                                      const std::string& cwd) {
+  process_map[process_id] = {binary_path, cwd};
+}
+
+void MockedProcFilesystem::removeProcess(pid_t process_id) {
+  process_map.erase(process_id);
+}
+
+std::size_t MockedProcFilesystem::operationCount() const {
+  return operation_count;
+}
+
+void MockedProcFilesystem::resetOperationCount() {
+  operation_count = 0U;
+}
+
+bool MockedProcFilesystem::open(tob::utils::UniqueFd& fd,
+                                const std::string& path,
+                                int flags) const {
+  ++operation_count;
+
+  if (path != "/proc" && path != "/proc/") {
+    throw std::logic_error(
+        "Invalid path specified in MockedProcFilesystem::open");
+  }
+
+  fd.reset(kProcFsRootFd);
+  return true;
+}
+
+bool MockedProcFilesystem::openAt(tob::utils::UniqueFd& fd,
+                                  int dirfd,
+                                  const std::string& path,
+                                  int flags) const {
+  ++operation_count;
+
+  if (dirfd != kProcFsRootFd) {
+    throw std::logic_error(
+        "Invalid dirfd specified in MockedProcFilesystem::openAt");
+  }
+
+  auto process_id_exp = tryTo<int>(path, 10);
+  if (process_id_exp.isError()) {
+    return false;
+  }
+
+  auto process_id = process_id_exp.take();
+  if (process_map.count(process_id) == 0U) {
+    return false;
+  }
+
+  fd.reset(kProcessRootFdBase + process_id);
+  return true;
+}
+
+bool MockedProcFilesystem::readLinkAt(std::string& destination,
+                                      int dirfd,
+                                      const std::string& path) const {
+  ++operation_count;
+
+  auto process_it = process_map.find(dirfd - kProcessRootFdBase);
+  if (process_it == process_map.end()) {
+    throw std::logic_error(
+        "Invalid dirfd specified in MockedProcFilesystem::readLinkAt");
+  }
+
+  const auto& process = process_it->second;
+
+  if (path == "exe") {
+    destination = process.binary_path;
+
+  } else if (path == "cwd") {
+    destination = process.cwd;
+
+  } else {
+    throw std::logic_error(
+        "Invalid path specified in MockedProcFilesystem::readLinkAt");
+  }
+
+  return !destination.empty();
+}
+
+bool MockedProcFilesystem::read(std::vector<char>& buffer,
+                                int fd,
+                                std::size_t max_size) const {
+  throw std::logic_error("MockedProcFilesystem::read is not implemented");
+}
+
+bool MockedProcFilesystem::enumFiles(int dirfd,
+                                     EnumFilesCallback callback) const {
+  ++operation_count;
+
+  if (dirfd != kProcFsRootFd) {
+    throw std::logic_error(
+        "Invalid dirfd specified in MockedProcFilesystem::enumFiles");
+  }
+
+  callback("self", true);
+  callback("uptime", false);
+
+  for (const auto& process : process_map) {
+    callback(std::to_string(process.first), true);
+  }
+
+  return true;
+}
+
+bool MockedProcFilesystem::fileExists(bool& exists,
+                                      int dirfd,
+                                      const std::string& name) const {
+  ++operation_count;
+
+  auto process_id_exp = tryTo<int>(name, 10);
+  exists = dirfd == kProcFsRootFd && !process_id_exp.isError() &&
+           process_map.count(process_id_exp.take()) != 0U;
+
+  return true;
+}
+
+} // namespace osquery
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <osquery/events/linux/bpf/ifilesystem.h>
+
+#include <map>
+
+#include <unistd.h>
+
+namespace osquery {
+
+/// A procfs mock that counts how many operations have been performed
+class MockedProcFilesystem final : public IFilesystem {
+ public:
+  MockedProcFilesystem() = default;
+  virtual ~MockedProcFilesystem() override = default;
+
+  void setProcess(pid_t process_id,
+                  const std::string& binary_path,
+                  const std::string& cwd);
+
+  void removeProcess(pid_t process_id);
+
+  std::size_t operationCount() const;
+  void resetOperationCount();
+
+  virtual bool open(tob::utils::UniqueFd& fd,
+                    const std::string& path,
+                    int flags) const override;
+
+  virtual bool openAt(tob::utils::UniqueFd& fd,
+                      int dirfd,
+                      const std::string& path,
+                      int flags) const override;
+
+  virtual bool readLinkAt(std::string& destination,
+                          int dirfd,
+                          const std::string& path) const override;
+
+  virtual bool read(std::vector<char>& buffer,
+                    int fd,
+                    std::size_t max_size) const override;
+
+  virtual bool enumFiles(int dirfd, EnumFilesCallback callback) const override;
+
+  virtual bool fileExists(bool& exists,
+                          int dirfd,
+                          const std::string& name) const override;
+
+ private:
+  struct Process final {
+    std::string binary_path;
+    std::string cwd;
+  };
+
+  std::map<pid_t, Process> process_map;
+  mutable std::size_t operation_count{0U};
+};
+
+} // namespace osquery
@@ -9,6 +9,7 @@
 
 #include "bpftestsmain.h"
 #include "mockedfilesystem.h"
+#include "mockedprocfilesystem.h"
 #include "mockedprocesscontextfactory.h"
 #include "utils.h"
 
@@ -119,7 +120,7 @@ TEST_F(SystemStateTrackerTests, getProcessContext) {
   EXPECT_TRUE(process_context_factory->invocationCount() == 1U);
   EXPECT_EQ(context.process_map.size(), 2U);
   EXPECT_EQ(context.process_map.count(1001), 1U);
-  EXPECT_TRUE(context.process_map.at(1001).binary_path.empty());
+  EXPECT_TRUE(context.process_map.at(1001).binary_path->empty());
   EXPECT_EQ(&context.process_map.at(1001), &process_context2);
 }
 
@@ -163,7 +164,7 @@ TEST_F(SystemStateTrackerTests, create_process) {
   EXPECT_EQ(child_process1.binary_path, parent_process1.binary_path);
   EXPECT_EQ(child_process1.argv, parent_process1.argv);
   EXPECT_EQ(child_process1.cwd, parent_process1.cwd);
-  EXPECT_EQ(child_process1.fd_map.size(), parent_process1.fd_map.size());
+  EXPECT_EQ(child_process1.fd_map->size(), parent_process1.fd_map->size());
 
   // Make sure that the fork event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -204,7 +205,7 @@ TEST_F(SystemStateTrackerTests, create_process) {
   EXPECT_EQ(child_process2.binary_path, parent_process2.binary_path);
   EXPECT_EQ(child_process2.argv, parent_process2.argv);
   EXPECT_EQ(child_process2.cwd, parent_process2.cwd);
-  EXPECT_EQ(child_process2.fd_map.size(), parent_process2.fd_map.size());
+  EXPECT_EQ(child_process2.fd_map->size(), parent_process2.fd_map->size());
 
   // Make sure that the fork event was generated
   ASSERT_EQ(context.event_list.size(), 2U);
@@ -217,6 +218,81 @@ TEST_F(SystemStateTrackerTests, create_process) {
   EXPECT_TRUE(std::holds_alternative<std::monostate>(fork_event2.data));
 }
 
+TEST_F(SystemStateTrackerTests, shared_process_context) {
+  auto process_context_factory =
+      std::make_unique<MockedProcessContextFactory>();
+
+  auto bpf_event_header = kBaseBPFEventHeader;
+  bpf_event_header.process_id = 1001;
+
+  SystemStateTracker::Context context;
+  auto succeeded = SystemStateTracker::createProcess(
+      context,
+      *process_context_factory.get(),
+      bpf_event_header,
+      1000, // parent pid
+      bpf_event_header.process_id); // child pid
+
+  ASSERT_TRUE(succeeded);
+
+  // The child process should reference the same data as its parent
+  const auto& parent_process = context.process_map.at(1000);
+  const auto& child_process = context.process_map.at(1001);
+
+  EXPECT_TRUE(child_process.fd_map.shared());
+  EXPECT_TRUE(child_process.argv.shared());
+  EXPECT_EQ(&(*child_process.binary_path), &(*parent_process.binary_path));
+  EXPECT_EQ(&(*child_process.cwd), &(*parent_process.cwd));
+
+  // Paths captured from procfs are interned, so the three standard
+  // file descriptors should all reference the same string
+  const auto& stdin_data = std::get<ProcessContext::FileDescriptor::FileData>(
+      parent_process.fd_map->at(0).data);
+
+  const auto& stderr_data = std::get<ProcessContext::FileDescriptor::FileData>(
+      parent_process.fd_map->at(2).data);
+
+  EXPECT_EQ(&(*stdin_data.path), &(*stderr_data.path));
+
+  // Opening a file in the child process should not affect the parent
+  succeeded = SystemStateTracker::openFile(context,
+                                           *process_context_factory.get(),
+                                           1001,
+                                           AT_FDCWD,
+                                           16,
+                                           "test_file",
+                                           0);
+
+  EXPECT_TRUE(succeeded);
+  EXPECT_FALSE(child_process.fd_map.shared());
+  EXPECT_TRUE(child_process.argv.shared());
+  EXPECT_EQ(child_process.fd_map->size(), 9U);
+  EXPECT_EQ(parent_process.fd_map->size(), 8U);
+
+  EXPECT_TRUE(validateFileDescriptor(
+      child_process, 16, false, "/home/alessandro/test_file"));
+
+  // Both processes moving to the same folder should end up sharing the
+  // same string again
+  succeeded = SystemStateTracker::setWorkingDirectory(
+      context, *process_context_factory.get(), 1000, "/tmp");
+  EXPECT_TRUE(succeeded);
+
+  succeeded = SystemStateTracker::setWorkingDirectory(
+      context, *process_context_factory.get(), 1001, "/tmp");
+  EXPECT_TRUE(succeeded);
+
+  EXPECT_EQ(parent_process.cwd, "/tmp");
+  EXPECT_EQ(&(*child_process.cwd), &(*parent_process.cwd));
+
+  // Once the processes are gone, the interned strings can be released
+  EXPECT_NE(context.string_interner.size(), 0U);
+
+  context.process_map.clear();
+  context.string_interner.collect();
+  EXPECT_EQ(context.string_interner.size(), 0U);
+}
+
 TEST_F(SystemStateTrackerTests, execute_binary_with_absolute_path) {
   auto bpf_event_header = kBaseBPFEventHeader;
   bpf_event_header.process_id = 1001;
@@ -259,7 +335,7 @@ TEST_F(SystemStateTrackerTests, execute_binary_with_absolute_path) {
 
   EXPECT_EQ(process_context.binary_path, "/usr/bin/date");
   EXPECT_EQ(process_context.argv, kExecArgumentList);
-  EXPECT_EQ(process_context.fd_map.size(), 5U);
+  EXPECT_EQ(process_context.fd_map->size(), 5U);
 
   // Make sure that the exec event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -323,7 +399,7 @@ TEST_F(SystemStateTrackerTests, execute_binary_at_cwd) {
 
   EXPECT_EQ(process_context.binary_path, "/usr/bin/date");
   EXPECT_EQ(process_context.argv, kExecArgumentList);
-  EXPECT_EQ(process_context.fd_map.size(), 5U);
+  EXPECT_EQ(process_context.fd_map->size(), 5U);
 
   // Make sure that the exec event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -402,7 +478,7 @@ TEST_F(SystemStateTrackerTests, execute_binary_with_fd) {
 
   EXPECT_EQ(process_context.binary_path, "/usr/bin/date");
   EXPECT_EQ(process_context.argv, kExecArgumentList);
-  EXPECT_EQ(process_context.fd_map.size(), 5U);
+  EXPECT_EQ(process_context.fd_map->size(), 5U);
 
   // Make sure that the exec event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -478,11 +554,11 @@ TEST_F(SystemStateTrackerTests, execute_binary_at_dirfd) {
 
   const auto& process_context = context.process_map.at(1001);
 
-  // The path we are expecting is: (process_context.fd_map.at(15).path) +
+  // The path we are expecting is: (process_context.fd_map->at(15).path) +
   // "/date"
   EXPECT_EQ(process_context.binary_path, "/usr/bin/date");
   EXPECT_EQ(process_context.argv, kExecArgumentList);
-  EXPECT_EQ(process_context.fd_map.size(), 5U);
+  EXPECT_EQ(process_context.fd_map->size(), 5U);
 
   // Make sure that the exec event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -585,7 +661,7 @@ TEST_F(SystemStateTrackerTests, close_handle) {
         {kBaseBPFEventHeader.process_id, process_context});
   }
 
-  EXPECT_EQ(context.process_map[kBaseBPFEventHeader.process_id].fd_map.size(),
+  EXPECT_EQ(context.process_map[kBaseBPFEventHeader.process_id].fd_map->size(),
             9U);
 
   auto succeeded =
@@ -601,8 +677,8 @@ TEST_F(SystemStateTrackerTests, close_handle) {
   const auto& process_context =
       context.process_map.at(kBaseBPFEventHeader.process_id);
 
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
-  EXPECT_EQ(process_context.fd_map.count(2000), 0U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
+  EXPECT_EQ(process_context.fd_map->count(2000), 0U);
 
   EXPECT_TRUE(context.event_list.empty());
 }
@@ -636,7 +712,7 @@ TEST_F(SystemStateTrackerTests, duplicate_handle) {
       context, kBaseBPFEventHeader.process_id, 1000, 3000, true);
 
   EXPECT_FALSE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
 
   succeeded = SystemStateTracker::duplicateHandle(
       context, kBaseBPFEventHeader.process_id, 15, 16, true);
@@ -644,7 +720,7 @@ TEST_F(SystemStateTrackerTests, duplicate_handle) {
   EXPECT_TRUE(succeeded);
   ASSERT_EQ(context.process_map.count(kBaseBPFEventHeader.process_id), 1U);
   EXPECT_EQ(context.process_map.size(), 1U);
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
 
   EXPECT_TRUE(validateFileDescriptor(
       process_context, 15, false, "/usr/share/zsh/functions/Misc.zwc"));
@@ -674,7 +750,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
   auto& process_context =
       context.process_map.at(kBaseBPFEventHeader.process_id);
 
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
 
   // Empty file path
   auto succeeded = SystemStateTracker::openFile(context,
@@ -686,7 +762,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                                 0);
 
   EXPECT_FALSE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
   // Invalid dirfd
@@ -699,7 +775,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            0);
 
   EXPECT_FALSE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
   // Absolute paths, without close on exec
@@ -714,7 +790,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            0);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
   EXPECT_TRUE(
       validateFileDescriptor(process_context, 16, false, absolute_test_path));
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
@@ -729,7 +805,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            O_CLOEXEC);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 10U);
+  EXPECT_EQ(process_context.fd_map->size(), 10U);
   EXPECT_TRUE(
       validateFileDescriptor(process_context, 17, true, absolute_test_path));
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
@@ -746,12 +822,12 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            0);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 11U);
+  EXPECT_EQ(process_context.fd_map->size(), 11U);
   EXPECT_TRUE(
       validateFileDescriptor(process_context,
                              18,
                              false,
-                             process_context.cwd + "/" + relative_test_path));
+                             *process_context.cwd + "/" + relative_test_path));
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
@@ -765,11 +841,11 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            O_CLOEXEC);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 12U);
+  EXPECT_EQ(process_context.fd_map->size(), 12U);
   validateFileDescriptor(process_context,
                          19,
                          true,
-                         process_context.cwd + "/" + relative_test_path);
+                         *process_context.cwd + "/" + relative_test_path);
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
@@ -788,7 +864,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            0);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 14U);
+  EXPECT_EQ(process_context.fd_map->size(), 14U);
   EXPECT_TRUE(
       validateFileDescriptor(process_context,
                              21,
@@ -807,7 +883,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
                                            O_CLOEXEC);
 
   EXPECT_TRUE(succeeded);
-  EXPECT_EQ(process_context.fd_map.size(), 15U);
+  EXPECT_EQ(process_context.fd_map->size(), 15U);
   EXPECT_TRUE(
       validateFileDescriptor(process_context,
                              22,
@@ -837,7 +913,7 @@ TEST_F(SystemStateTrackerTests, create_socket) {
   auto& process_context =
       context.process_map.at(kBaseBPFEventHeader.process_id);
 
-  EXPECT_EQ(process_context.fd_map.size(), 8U);
+  EXPECT_EQ(process_context.fd_map->size(), 8U);
 
   auto succeeded =
       SystemStateTracker::createSocket(context,
@@ -852,10 +928,10 @@ TEST_F(SystemStateTrackerTests, create_socket) {
 
   ASSERT_TRUE(succeeded);
 
-  ASSERT_EQ(process_context.fd_map.size(), 9U);
-  ASSERT_EQ(process_context.fd_map.count(99), 1U);
+  ASSERT_EQ(process_context.fd_map->size(), 9U);
+  ASSERT_EQ(process_context.fd_map->count(99), 1U);
 
-  const auto& fd = process_context.fd_map.at(99);
+  const auto& fd = process_context.fd_map->at(99);
   EXPECT_EQ(fd.close_on_exec, false);
 
   ASSERT_TRUE(
@@ -897,7 +973,7 @@ TEST_F(SystemStateTrackerTests, bind_socket) {
   setSocketDescriptor(
       process_context, 99, true, AF_UNIX, SOCK_STREAM, 0, "", 1, "", 1);
 
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
 
   auto succeeded = SystemStateTracker::bind(context,
                                             *process_context_factory.get(),
@@ -909,10 +985,10 @@ TEST_F(SystemStateTrackerTests, bind_socket) {
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
   ASSERT_TRUE(succeeded);
 
-  ASSERT_EQ(process_context.fd_map.size(), 9U);
-  ASSERT_EQ(process_context.fd_map.count(99), 1U);
+  ASSERT_EQ(process_context.fd_map->size(), 9U);
+  ASSERT_EQ(process_context.fd_map->count(99), 1U);
 
-  const auto& fd = process_context.fd_map.at(99);
+  const auto& fd = process_context.fd_map->at(99);
   EXPECT_EQ(fd.close_on_exec, true);
 
   ASSERT_TRUE(
@@ -980,7 +1056,7 @@ TEST_F(SystemStateTrackerTests, listen_socket) {
                       "",
                       0);
 
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
 
   auto succeeded = SystemStateTracker::listen(context,
                                               *process_context_factory.get(),
@@ -991,7 +1067,7 @@ TEST_F(SystemStateTrackerTests, listen_socket) {
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
   ASSERT_TRUE(succeeded);
 
-  ASSERT_EQ(process_context.fd_map.size(), 9U);
+  ASSERT_EQ(process_context.fd_map->size(), 9U);
 
   // Make sure that the bind event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -1045,7 +1121,7 @@ TEST_F(SystemStateTrackerTests, connect_socket) {
                       "",
                       0);
 
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
 
   auto succeeded = SystemStateTracker::connect(context,
                                                *process_context_factory.get(),
@@ -1057,7 +1133,7 @@ TEST_F(SystemStateTrackerTests, connect_socket) {
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
   ASSERT_TRUE(succeeded);
 
-  ASSERT_EQ(process_context.fd_map.size(), 9U);
+  ASSERT_EQ(process_context.fd_map->size(), 9U);
 
   // Make sure that the bind event was generated
   ASSERT_EQ(context.event_list.size(), 1U);
@@ -1111,7 +1187,7 @@ TEST_F(SystemStateTrackerTests, accept_socket) {
                       "",
                       0);
 
-  EXPECT_EQ(process_context.fd_map.size(), 9U);
+  EXPECT_EQ(process_context.fd_map->size(), 9U);
 
   // Accept two new connections; for one of them, try to use the
   // SOCK_CLOEXEC flag to automatically set the close_on_exec
@@ -1126,7 +1202,7 @@ TEST_F(SystemStateTrackerTests, accept_socket) {
                                               0);
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
-  EXPECT_EQ(process_context.fd_map.size(), 10U);
+  EXPECT_EQ(process_context.fd_map->size(), 10U);
   ASSERT_TRUE(succeeded);
 
   succeeded = SystemStateTracker::accept(context,
@@ -1139,14 +1215,14 @@ TEST_F(SystemStateTrackerTests, accept_socket) {
                                          SOCK_CLOEXEC);
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
-  EXPECT_EQ(process_context.fd_map.size(), 11U);
+  EXPECT_EQ(process_context.fd_map->size(), 11U);
   ASSERT_TRUE(succeeded);
 
   // There should be 2 new file descriptors
-  ASSERT_EQ(process_context.fd_map.count(100), 1U);
-  ASSERT_EQ(process_context.fd_map.count(101), 1U);
+  ASSERT_EQ(process_context.fd_map->count(100), 1U);
+  ASSERT_EQ(process_context.fd_map->count(101), 1U);
 
-  const auto& fd1 = process_context.fd_map.at(100);
+  const auto& fd1 = process_context.fd_map->at(100);
   EXPECT_FALSE(fd1.close_on_exec);
 
   ASSERT_TRUE(
@@ -1172,7 +1248,7 @@ TEST_F(SystemStateTrackerTests, accept_socket) {
   EXPECT_EQ(socket_data1.opt_remote_address.value(), "192.168.1.2");
   EXPECT_EQ(socket_data1.opt_remote_port.value(), 80);
 
-  const auto& fd2 = process_context.fd_map.at(101);
+  const auto& fd2 = process_context.fd_map->at(101);
   EXPECT_TRUE(fd2.close_on_exec);
 
   ASSERT_TRUE(
@@ -1455,6 +1531,121 @@ TEST_F(SystemStateTrackerTests, expireProcessContexts) {
   EXPECT_EQ(context.process_map.size(), 1U);
 }
 
+TEST_F(SystemStateTrackerTests, resync) {
+  auto process_context_factory =
+      std::make_unique<MockedProcessContextFactory>();
+
+  SystemStateTracker::Context context;
+
+  // Pid 2 is up to date, pid 1000 has changed its working directory,
+  // pid 1001 is not tracked yet and pid 1003 has already terminated.
+  // The snapshot is the procfs baseline of the tracked processes
+  for (pid_t process_id : {2, 1000}) {
+    ProcessContext process_context;
+    process_context_factory->captureSingleProcess(process_context,
+                                                  process_id);
+
+    SystemStateTracker::setResyncState(context, process_id, process_context);
+    context.process_map.insert({process_id, std::move(process_context)});
+  }
+
+  context.process_map.insert({1003, ProcessContext{}});
+  EXPECT_EQ(process_context_factory->invocationCount(), 2U);
+
+  // Paths derived from events are not canonical, and are not compared
+  context.process_map.at(2).binary_path = "zsh";
+
+  MockedProcFilesystem mocked_procfs;
+  mocked_procfs.setProcess(2, "/usr/bin/zsh", "/home/alessandro");
+  mocked_procfs.setProcess(1000, "/usr/bin/zsh", "/tmp");
+  mocked_procfs.setProcess(1001, "/usr/bin/zsh", "/home/alessandro");
+
+  // Starting a new round only lists the procfs root
+  auto status = SystemStateTracker::beginResync(context, mocked_procfs);
+  ASSERT_TRUE(status.ok());
+
+  EXPECT_EQ(mocked_procfs.operationCount(), 2U);
+  EXPECT_EQ(context.resync_queue.size(), 3U);
+  EXPECT_EQ(context.process_map.size(), 2U);
+  EXPECT_EQ(context.process_map.count(1003), 0U);
+  EXPECT_EQ(context.resync_round, 1U);
+
+  // An up to date process only costs the two link reads
+  mocked_procfs.resetOperationCount();
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 1U, 0U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(mocked_procfs.operationCount(), 4U);
+  EXPECT_EQ(process_context_factory->invocationCount(), 2U);
+  EXPECT_EQ(context.resync_queue.size(), 2U);
+
+  // A round that is still running is not started over
+  mocked_procfs.resetOperationCount();
+  status = SystemStateTracker::beginResync(context, mocked_procfs);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(mocked_procfs.operationCount(), 0U);
+  EXPECT_EQ(context.resync_queue.size(), 2U);
+  EXPECT_EQ(context.resync_round, 1U);
+
+  // A process that has diverged is captured again
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 1U, 0U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(mocked_procfs.operationCount(), 4U);
+  EXPECT_EQ(process_context_factory->invocationCount(), 3U);
+  EXPECT_EQ(context.resync_queue.size(), 1U);
+
+  // A process we have never seen is captured without comparing it; the
+  // slice size is larger than the remaining queue
+  mocked_procfs.resetOperationCount();
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 16U, 0U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(mocked_procfs.operationCount(), 2U);
+  EXPECT_EQ(process_context_factory->invocationCount(), 4U);
+  EXPECT_TRUE(context.resync_queue.empty());
+  EXPECT_EQ(context.process_map.size(), 3U);
+  EXPECT_EQ(context.process_map.at(1001).parent_process_id, 1000);
+
+  // Once the round is complete, no work is performed
+  mocked_procfs.resetOperationCount();
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 16U, 0U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(mocked_procfs.operationCount(), 0U);
+  EXPECT_EQ(process_context_factory->invocationCount(), 4U);
+
+  // Processes that have not been captured for too many rounds are
+  // captured again, even if their links are unchanged
+  mocked_procfs.setProcess(1000, "/usr/bin/zsh", "/home/alessandro");
+  status = SystemStateTracker::beginResync(context, mocked_procfs);
+  ASSERT_TRUE(status.ok());
+
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 16U, 2U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(process_context_factory->invocationCount(), 5U);
+  EXPECT_EQ(context.process_map.at(2).binary_path, "/usr/bin/zsh");
+
+  // Processes terminating during a round are dropped when reached
+  status = SystemStateTracker::beginResync(context, mocked_procfs);
+  ASSERT_TRUE(status.ok());
+
+  mocked_procfs.removeProcess(2);
+  status = SystemStateTracker::resync(
+      context, *process_context_factory.get(), mocked_procfs, 1U, 0U);
+
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(context.process_map.count(2), 0U);
+  EXPECT_EQ(context.resync_state_map.count(2), 0U);
+  EXPECT_EQ(process_context_factory->invocationCount(), 5U);
+}
+
 TEST_F(SystemStateTrackerTests, parseSocketAddress) {
   static const std::uint16_t kUnspecFamily{AF_UNSPEC};
 
@@ -17,7 +17,7 @@ void setFileDescriptor(ProcessContext& process_context,
                        int fd,
                        bool close_on_exec,
                        const std::string& path) {
-  process_context.fd_map.erase(fd);
+  process_context.fd_map.edit().erase(fd);
 
   ProcessContext::FileDescriptor fd_info;
   fd_info.close_on_exec = close_on_exec;
@@ -26,7 +26,7 @@ void setFileDescriptor(ProcessContext& process_context,
   file_data.path = path;
   fd_info.data = std::move(file_data);
 
-  process_context.fd_map.insert({fd, std::move(fd_info)});
+  process_context.fd_map.edit().insert({fd, std::move(fd_info)});
 }
 
 void setFileDescriptor(ProcessContextMap& process_context_map,
@@ -51,7 +51,7 @@ void setSocketDescriptor(ProcessContext& process_context,
                          std::uint16_t local_port,
                          const std::string& remote_address,
                          std::uint16_t remote_port) {
-  process_context.fd_map.erase(fd);
+  process_context.fd_map.edit().erase(fd);
 
   ProcessContext::FileDescriptor fd_info;
   fd_info.close_on_exec = close_on_exec;
@@ -68,7 +68,7 @@ void setSocketDescriptor(ProcessContext& process_context,
   socket_data.opt_remote_port = remote_port;
 
   fd_info.data = std::move(socket_data);
-  process_context.fd_map.insert({fd, std::move(fd_info)});
+  process_context.fd_map.edit().insert({fd, std::move(fd_info)});
 }
 
 void setSocketDescriptor(ProcessContextMap& process_context_map,
@@ -102,8 +102,8 @@ bool validateFileDescriptor(const ProcessContext& process_context,
                             int fd,
                             bool close_on_exec,
                             const std::string& path) {
-  auto fd_it = process_context.fd_map.find(fd);
-  if (fd_it == process_context.fd_map.end()) {
+  auto fd_it = process_context.fd_map->find(fd);
+  if (fd_it == process_context.fd_map->end()) {
     return false;
   }
 
@@ -150,8 +150,8 @@ bool validateSocketDescriptor(const ProcessContext& process_context,
                               std::uint16_t local_port,
                               const std::string& remote_address,
                               std::uint16_t remote_port) {
-  auto fd_it = process_context.fd_map.find(fd);
-  if (fd_it == process_context.fd_map.end()) {
+  auto fd_it = process_context.fd_map->find(fd);
+  if (fd_it == process_context.fd_map->end()) {
     return false;
   }
 
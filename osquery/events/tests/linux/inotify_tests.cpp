@@ -553,4 +553,20 @@ TEST_F(INotifyTests, test_inotify_embedded_wildcards) {
 
   EventFactory::deregisterEventPublisher("inotify");
 }
+
+TEST_F(INotifyTests, test_inotify_excluded_directories) {
+  event_pub_ = std::make_shared<INotifyEventPublisher>(true);
+  EventFactory::registerEventPublisher(event_pub_);
+
+  // Create ./inotify-triggers/2/1/ and exclude ./inotify-triggers/2/.
+  fs::create_directories(real_test_sub_dir + "/1");
+  event_pub_->exclude_paths_.insert(real_test_sub_dir + "/");
+
+  // An excluded directory is still monitored, to watch the directories that
+  // are created within it.
+  addMonitor(real_test_dir, 0, true, true);
+  EXPECT_EQ(event_pub_->numDescriptors(), 3U);
+
+  EventFactory::deregisterEventPublisher("inotify");
+}
 } // namespace osquery
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/events/pathset.h>
+#include <osquery/events/pathtrie.h>
+
+namespace osquery {
+
+GTEST_TEST(PathTrieTests, test_find) {
+  PathTrie trie;
+  EXPECT_TRUE(trie.empty());
+  EXPECT_FALSE(trie.find("/etc"));
+
+  for (const auto& pattern :
+       {"/etc/ssh/%%", "/etc/", "/etc/ssl/openssl.cnf", "/var/%", "/"}) {
+    trie.insert(pattern);
+  }
+  EXPECT_FALSE(trie.empty());
+
+  EXPECT_TRUE(trie.find("/"));
+  EXPECT_TRUE(trie.find("/etc"));
+  EXPECT_TRUE(trie.find("/etc/"));
+  EXPECT_FALSE(trie.find("/etc/passwd"));
+  EXPECT_TRUE(trie.find("/etc/ssh"));
+  EXPECT_TRUE(trie.find("/etc/ssh/sshd_config.d/custom.conf"));
+  EXPECT_TRUE(trie.find("/etc/ssl/openssl.cnf"));
+  EXPECT_FALSE(trie.find("/etc/ssl/certs"));
+  EXPECT_FALSE(trie.find("/var"));
+  EXPECT_TRUE(trie.find("/var/log"));
+  // A trailing wildcard also matches deeper paths.
+  EXPECT_TRUE(trie.find("/var/log/syslog"));
+  EXPECT_FALSE(trie.find("/usr"));
+
+  trie.clear();
+  EXPECT_TRUE(trie.empty());
+  EXPECT_FALSE(trie.find("/etc"));
+}
+
+GTEST_TEST(PathTrieTests, test_embedded_wildcards) {
+  PathTrie trie;
+  trie.insert("/home/%/.ssh/");
+  trie.insert("/home/%/.ssh/known_hosts");
+  trie.insert("/home/user/%%/cache");
+
+  EXPECT_TRUE(trie.find("/home/user/.ssh"));
+  EXPECT_TRUE(trie.find("/home/other/.ssh/known_hosts"));
+  EXPECT_FALSE(trie.find("/home/other/.ssh/authorized_keys"));
+  EXPECT_FALSE(trie.find("/home/other/.config"));
+  // Components after a recursive wildcard are ignored.
+  EXPECT_TRUE(trie.find("/home/user"));
+  EXPECT_TRUE(trie.find("/home/user/.config/app"));
+}
+
+GTEST_TEST(PathTrieTests, test_path_set_equivalence) {
+  std::vector<std::string> patterns = {
+      "/etc/", "/etc/%", "/etc/%%", "/etc/%/conf", "/", "/%"};
+  std::vector<std::string> paths = {"/",
+                                    "/etc",
+                                    "/etc/passwd",
+                                    "/etc/ssh/conf",
+                                    "/etc/ssh/sshd_config",
+                                    "/usr/bin"};
+
+  // A trie with a single pattern matches the paths its PathSet matches.
+  for (const auto& pattern : patterns) {
+    PathTrie trie;
+    PathSet<patternedPath> set;
+    trie.insert(pattern);
+    set.insert(pattern);
+    for (const auto& path : paths) {
+      EXPECT_EQ(trie.find(path), set.find(path))
+          << "pattern: " << pattern << " path: " << path;
+    }
+  }
+}
+
+} // namespace osquery
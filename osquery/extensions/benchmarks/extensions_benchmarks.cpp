@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/extensions/client_pool.h>
+#include <osquery/extensions/extensions.h>
+#include <osquery/extensions/interface.h>
+#include <osquery/filesystem/fileops.h>
+#include <osquery/process/process.h>
+#include <osquery/registry/registry_factory.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_uint32(thrift_server_threads);
+
+class BenchmarkExtensionPlugin : public Plugin {
+ public:
+  Status call(const PluginRequest& request, PluginResponse& response) {
+    response.push_back(request);
+    return Status::success();
+  }
+};
+
+CREATE_REGISTRY(BenchmarkExtensionPlugin, "extension_benchmark");
+
+/// Start a manager and an extension in this process, return its socket.
+static const std::string& getBenchmarkExtension() {
+  static std::string extension_path;
+  if (!extension_path.empty()) {
+    return extension_path;
+  }
+
+  auto manager_path =
+      (fs::temp_directory_path() /
+       fs::unique_path("osquery.extensions_benchmark.%%%%.%%%%"))
+          .string();
+  startExtensionManager(manager_path);
+  for (size_t i = 0; i < 100 && !socketExists(manager_path).ok(); ++i) {
+    sleepFor(20);
+  }
+
+  // The manager and the extension share a registry, as in the tests.
+  auto& rf = RegistryFactory::get();
+  rf.registry("extension_benchmark")
+      ->add("item", std::make_shared<BenchmarkExtensionPlugin>());
+  rf.addAlias("extension_benchmark", "item", "alias");
+  rf.allowDuplicates(true);
+
+  auto status =
+      startExtension(manager_path, "benchmark", "0.1", "0.0.0", "0.0.0");
+  auto uuid = (RouteUUID)std::stoul(status.getMessage());
+  extension_path = getExtensionSocket(uuid, manager_path);
+  for (size_t i = 0; i < 100 && !socketExists(extension_path).ok(); ++i) {
+    sleepFor(20);
+  }
+  return extension_path;
+}
+
+/// The previous call path, an active check and a new connection per call.
+static void EXTENSIONS_call_transient(benchmark::State& state) {
+  const auto& path = getBenchmarkExtension();
+
+  PluginRequest request = {{"action", "benchmark"}};
+  while (state.KeepRunning()) {
+    PluginResponse response;
+    {
+      ExtensionManagerClient check(path, 10);
+      check.ping();
+    }
+    ExtensionClient client(path);
+    client.call("extension_benchmark", "alias", request, response);
+    benchmark::DoNotOptimize(response);
+  }
+}
+
+BENCHMARK(EXTENSIONS_call_transient)->UseRealTime();
+BENCHMARK(EXTENSIONS_call_transient)->Threads(4)->UseRealTime();
+
+static void EXTENSIONS_call_pooled(benchmark::State& state) {
+  const auto& path = getBenchmarkExtension();
+
+  PluginRequest request = {{"action", "benchmark"}};
+  while (state.KeepRunning()) {
+    PluginResponse response;
+    callExtension(path, "extension_benchmark", "alias", request, response);
+    benchmark::DoNotOptimize(response);
+  }
+}
+
+BENCHMARK(EXTENSIONS_call_pooled)->UseRealTime();
+BENCHMARK(EXTENSIONS_call_pooled)->Threads(4)->UseRealTime();
+
+static void EXTENSIONS_ping_pooled(benchmark::State& state) {
+  const auto& path = getBenchmarkExtension();
+
+  while (state.KeepRunning()) {
+    auto status = pingExtension(path);
+    benchmark::DoNotOptimize(status);
+  }
+}
+
+BENCHMARK(EXTENSIONS_ping_pooled)->UseRealTime();
+
+/// Read a counter, such as Threads or VmRSS, from the process status.
+static double getProcessStatus(const std::string& name) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, name.size() + 1, name + ":") == 0) {
+      return std::stod(line.substr(name.size() + 1));
+    }
+  }
+  return 0;
+}
+
+/// Threads and RSS of a manager with persistent connections from extensions.
+static void EXTENSIONS_server_connections(benchmark::State& state) {
+  auto server_threads = FLAGS_thrift_server_threads;
+  FLAGS_thrift_server_threads = static_cast<uint32_t>(state.range(0));
+
+  auto path = (fs::temp_directory_path() /
+               fs::unique_path("osquery.extensions_benchmark.%%%%.%%%%"))
+                  .string();
+  auto threads = getProcessStatus("Threads");
+  auto rss = getProcessStatus("VmRSS");
+
+  auto runner = std::make_shared<ExtensionManagerRunner>(path);
+  std::thread server([runner]() { runner->start(); });
+  for (size_t i = 0; i < 100 && !socketExists(path).ok(); ++i) {
+    sleepFor(20);
+  }
+
+  // Each client stands in for an extension's connection to the manager.
+  std::vector<std::unique_ptr<ExtensionManagerClient>> clients;
+  for (int64_t i = 0; i < state.range(1); ++i) {
+    clients.push_back(std::make_unique<ExtensionManagerClient>(path));
+  }
+
+  while (state.KeepRunning()) {
+    for (auto& client : clients) {
+      client->ping();
+    }
+  }
+
+  state.counters["threads"] = getProcessStatus("Threads") - threads;
+  state.counters["rss_kb"] = getProcessStatus("VmRSS") - rss;
+
+  clients.clear();
+  runner->stop();
+  server.join();
+  FLAGS_thrift_server_threads = server_threads;
+}
+
+BENCHMARK(EXTENSIONS_server_connections)
+    ->ArgPair(0, 50)
+    ->ArgPair(4, 50)
+    ->UseRealTime();
+
+} // namespace osquery
@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <osquery/core/flags.h>
+#include <osquery/extensions/client_pool.h>
+#include <osquery/filesystem/fileops.h>
+#include <osquery/logger/logger.h>
+
+namespace osquery {
+
+namespace {
+
+/// Idle connections unused for longer than this are pinged before reuse.
+const std::chrono::seconds kExtensionClientCheckInterval{5};
+
+std::unique_ptr<ExtensionClient> connectThriftClient(const std::string& path,
+                                                     bool manager) {
+  if (manager) {
+    return std::make_unique<ExtensionManagerClient>(path);
+  }
+  return std::make_unique<ExtensionClient>(path);
+}
+
+} // namespace
+
+CLI_FLAG(uint32,
+         extensions_max_connections,
+         4,
+         "Maximum concurrent connections to each extension");
+
+DECLARE_uint32(thrift_timeout);
+
+ExtensionClientPool& ExtensionClientPool::get() {
+  static ExtensionClientPool instance;
+  return instance;
+}
+
+Status ExtensionClientPool::call(const std::string& path,
+                                 const ClientAction& action) {
+  return run(path, false, action);
+}
+
+Status ExtensionClientPool::callManager(const std::string& path,
+                                        const ManagerAction& action) {
+  return run(path, true, ([&action](ExtensionClient& client) {
+               // Manager endpoints only hold manager clients.
+               return action(static_cast<ExtensionManagerClient&>(client));
+             }));
+}
+
+Status ExtensionClientPool::run(const std::string& path,
+                                bool manager,
+                                const ClientAction& action) {
+  auto key = std::make_pair(path, manager);
+  std::shared_ptr<Endpoint> endpoint;
+  Connection connection;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& slot = endpoints_[key];
+    if (slot == nullptr) {
+      slot = std::make_shared<Endpoint>();
+    }
+    endpoint = slot;
+
+    // Every call is bounded by the Thrift timeout, so is the wait for one.
+    size_t limit = std::max(FLAGS_extensions_max_connections, 1U);
+    if (!endpoint->returned.wait_for(
+            lock, std::chrono::seconds(FLAGS_thrift_timeout), [&]() {
+              return endpoint->active < limit;
+            })) {
+      return Status(1, "Extension connection limit reached: " + path);
+    }
+
+    endpoint->active++;
+    if (!endpoint->idle.empty()) {
+      connection = std::move(endpoint->idle.back());
+      endpoint->idle.pop_back();
+    }
+  }
+
+  auto client = std::move(connection.client);
+  bool reused = (client != nullptr);
+  if (reused && std::chrono::steady_clock::now() - connection.last_used >
+                    kExtensionClientCheckInterval) {
+    try {
+      client->ping();
+    } catch (const std::exception& /* e */) {
+      // The extension closed the connection or went away.
+      client.reset();
+      reused = false;
+    }
+  }
+
+  Status status;
+  while (true) {
+    if (client == nullptr) {
+      status = connect(path, manager, client);
+      if (!status.ok()) {
+        break;
+      }
+    }
+
+    try {
+      status = action(*client);
+      break;
+    } catch (const ExtensionConnectionClosed& e) {
+      client.reset();
+      status = Status(1, "Extension call failed: " + std::string(e.what()));
+      if (!reused) {
+        break;
+      }
+      // The connection was closed while it was idle and the request was not
+      // sent, so it is safe to send it again, once.
+      VLOG(1) << "Reconnecting to extension socket: " << path;
+      reused = false;
+    } catch (const std::exception& e) {
+      // The extension may have handled the request, calls such as logger
+      // and distributed writes must not be repeated.
+      client.reset();
+      status = Status(1, "Extension call failed: " + std::string(e.what()));
+      break;
+    }
+  }
+
+  release(key, endpoint, std::move(client));
+  return status;
+}
+
+Status ExtensionClientPool::connect(const std::string& path,
+                                    bool manager,
+                                    std::unique_ptr<ExtensionClient>& client) {
+  // Make sure the extension path exists, and is writable.
+  if (!socketExists(path).ok()) {
+    return Status(1, "Extension socket not available: " + path);
+  }
+
+  ClientFactory factory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    factory = factory_;
+  }
+
+  try {
+    client = (factory) ? factory(path, manager)
+                       : connectThriftClient(path, manager);
+  } catch (const std::exception& e) {
+    return Status(1, "Extension call failed: " + std::string(e.what()));
+  }
+
+  if (client == nullptr) {
+    return Status(1, "Extension socket not available: " + path);
+  }
+  return Status::success();
+}
+
+void ExtensionClientPool::release(const EndpointKey& key,
+                                  const std::shared_ptr<Endpoint>& endpoint,
+                                  std::unique_ptr<ExtensionClient> client) {
+  std::unique_ptr<ExtensionClient> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoint->active--;
+
+    // The endpoint is replaced when the path is invalidated.
+    auto it = endpoints_.find(key);
+    if (client != nullptr && it != endpoints_.end() &&
+        it->second == endpoint) {
+      endpoint->idle.push_back({std::move(client),
+                                std::chrono::steady_clock::now()});
+    } else {
+      stale = std::move(client);
+    }
+  }
+  endpoint->returned.notify_one();
+
+  // Close a connection that is not kept outside of the lock.
+  stale.reset();
+}
+
+void ExtensionClientPool::invalidate(const std::string& path) {
+  std::vector<Connection> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto manager : {false, true}) {
+      auto it = endpoints_.find(std::make_pair(path, manager));
+      if (it == endpoints_.end()) {
+        continue;
+      }
+
+      // Waiting callers keep the endpoint, new callers create a new one.
+      std::move(it->second->idle.begin(),
+                it->second->idle.end(),
+                std::back_inserter(stale));
+      it->second->idle.clear();
+      endpoints_.erase(it);
+    }
+  }
+}
+
+void ExtensionClientPool::clear() {
+  std::vector<Connection> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& endpoint : endpoints_) {
+      std::move(endpoint.second->idle.begin(),
+                endpoint.second->idle.end(),
+                std::back_inserter(stale));
+      endpoint.second->idle.clear();
+    }
+    endpoints_.clear();
+  }
+}
+
+size_t ExtensionClientPool::idleConnections(const std::string& path,
+                                            bool manager) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = endpoints_.find(std::make_pair(path, manager));
+  return (it == endpoints_.end()) ? 0 : it->second->idle.size();
+}
+
+void ExtensionClientPool::setClientFactory(ClientFactory factory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  factory_ = std::move(factory);
+}
+
+} // namespace osquery
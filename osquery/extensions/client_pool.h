@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/extensions/interface.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/**
+ * @brief Persistent Thrift connections to extensions and extension managers.
+ *
+ * Connecting to an extension socket costs a connect and a Thrift server
+ * thread on the other side. Calls made through the pool reuse idle
+ * connections to the same socket path instead.
+ *
+ * The pool limits the number of concurrent connections to each path, callers
+ * wait for a connection to be returned when the limit is reached. Connections
+ * idle for more than a few seconds are pinged before they are reused. A call
+ * on a reused connection is retried once on a new one only when the request
+ * could not be sent because the connection was closed.
+ *
+ * Example:
+ *   @code{.cpp}
+ *     auto status = ExtensionClientPool::get().call(
+ *         path, ([](ExtensionClient& client) { return client.ping(); }));
+ *   @endcode
+ */
+class ExtensionClientPool : private boost::noncopyable {
+ public:
+  /// Create a connected client for a path, throws if it cannot connect.
+  using ClientFactory = std::function<std::unique_ptr<ExtensionClient>(
+      const std::string& path, bool manager)>;
+
+  /// An operation using an extension client.
+  using ClientAction = std::function<Status(ExtensionClient& client)>;
+
+  /// An operation using an extension manager client.
+  using ManagerAction = std::function<Status(ExtensionManagerClient& client)>;
+
+ public:
+  /// Access the process-wide pool.
+  static ExtensionClientPool& get();
+
+  /**
+   * @brief Run an action using a connection to an extension.
+   *
+   * Transport failures are returned as a failed Status. The action's own
+   * Status is returned as-is and leaves the connection in the pool.
+   */
+  Status call(const std::string& path, const ClientAction& action);
+
+  /// Run an action using a connection to an extension manager.
+  Status callManager(const std::string& path, const ManagerAction& action);
+
+  /// Close the idle connections to a path, for example a removed extension.
+  void invalidate(const std::string& path);
+
+  /// Close every idle connection.
+  void clear();
+
+  /// The number of idle connections to a path.
+  size_t idleConnections(const std::string& path, bool manager = false);
+
+  /// Replace how connections are created, an empty factory restores Thrift.
+  void setClientFactory(ClientFactory factory);
+
+ private:
+  ExtensionClientPool() = default;
+
+  /// An idle connection.
+  struct Connection {
+    std::unique_ptr<ExtensionClient> client;
+
+    /// When the connection was last returned to the pool.
+    std::chrono::steady_clock::time_point last_used;
+  };
+
+  /// The connections to a socket path.
+  struct Endpoint {
+    /// Idle connections, the most recently used is at the back.
+    std::vector<Connection> idle;
+
+    /// The number of connections checked out of the pool.
+    size_t active{0};
+
+    /// Signaled when a connection is returned to the pool.
+    std::condition_variable returned;
+  };
+
+  /// The key of an endpoint is the socket path and the manager flag.
+  using EndpointKey = std::pair<std::string, bool>;
+
+ private:
+  /// Check out a connection, run the action and return the connection.
+  Status run(const std::string& path, bool manager, const ClientAction& action);
+
+  /// Create a new connection to a path.
+  Status connect(const std::string& path,
+                 bool manager,
+                 std::unique_ptr<ExtensionClient>& client);
+
+  /// Return a checked out connection, a null client only releases the slot.
+  void release(const EndpointKey& key,
+               const std::shared_ptr<Endpoint>& endpoint,
+               std::unique_ptr<ExtensionClient> client);
+
+ private:
+  /// Connections by socket path.
+  std::map<EndpointKey, std::shared_ptr<Endpoint>> endpoints_;
+
+  /// Optional replacement for the Thrift client constructors.
+  ClientFactory factory_;
+
+  /// Protects the endpoints and the factory.
+  std::mutex mutex_;
+};
+
+} // namespace osquery
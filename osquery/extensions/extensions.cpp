@@ -20,6 +20,7 @@
 #include <osquery/core/flagalias.h>
 #include <osquery/core/shutdown.h>
 #include <osquery/core/system.h>
+#include <osquery/extensions/client_pool.h>
 #include <osquery/extensions/interface.h>
 #include <osquery/filesystem/fileops.h>
 #include <osquery/filesystem/filesystem.h>
@@ -224,6 +225,7 @@ void ExtensionWatcher::start() {
     watch();
     pause(std::chrono::milliseconds(interval_));
   }
+  ExtensionClientPool::get().invalidate(path_);
 }
 
 void ExtensionManagerWatcher::start() {
@@ -236,15 +238,16 @@ void ExtensionManagerWatcher::start() {
   // When interrupted, request each extension tear down.
   const auto uuids = RegistryFactory::get().routeUUIDs();
   for (const auto& uuid : uuids) {
-    try {
-      auto path = getExtensionSocket(uuid);
-      ExtensionClient client(path);
-      client.shutdown();
-    } catch (const std::exception& /* e */) {
+    auto status = ExtensionClientPool::get().call(
+        getExtensionSocket(uuid), ([](ExtensionClient& client) {
+          client.shutdown();
+          return Status::success();
+        }));
+    if (!status.ok()) {
       VLOG(1) << "Extension UUID " << uuid << " shutdown request failed";
-      continue;
     }
   }
+  ExtensionClientPool::get().clear();
 }
 
 void ExtensionWatcher::exitFatal(int return_code) {
@@ -277,9 +280,18 @@ void ExtensionWatcher::watch() {
         }
       } else {
         // Ping the extension manager to check it's still there
-        ExtensionManagerClient client(path_);
-        status = client.ping();
-        if (status.getCode() != (int)ExtensionCode::EXT_SUCCESS && fatal_) {
+        bool connected = false;
+        status = ExtensionClientPool::get().callManager(
+            path_, ([&connected](ExtensionManagerClient& client) {
+              // Not reached if the core cannot be connected, or throws.
+              auto ping_status = client.ping();
+              connected = true;
+              return ping_status;
+            }));
+        if (!connected) {
+          core_sane = false;
+        } else if (status.getCode() != (int)ExtensionCode::EXT_SUCCESS &&
+                   fatal_) {
           // The core may be healthy but return a failed ping status.
           LOG(ERROR) << "Extension watcher ping failed: "
                      << status.getMessage();
@@ -321,11 +333,15 @@ void ExtensionManagerWatcher::watch() {
     // If failures get to 2 then the extension will be removed.
     failures_[uuid] = 1;
     if (exists.ok()) {
-      try {
-        ExtensionClient client(path);
-        // Ping the extension until it goes down.
-        status = client.ping();
-      } catch (const std::exception& /* e */) {
+      // Ping the extension until it goes down.
+      bool connected = false;
+      status = ExtensionClientPool::get().call(
+          path, ([&connected](ExtensionClient& client) {
+            auto ping_status = client.ping();
+            connected = true;
+            return ping_status;
+          }));
+      if (!connected) {
         failures_[uuid] += 1;
         continue;
       }
@@ -347,6 +363,7 @@ void ExtensionManagerWatcher::watch() {
     if (uuid.second > 1) {
       LOG(INFO) << "Extension UUID " << uuid.first << " has gone away";
       RegistryFactory::get().removeBroadcast(uuid.first);
+      ExtensionClientPool::get().invalidate(getExtensionSocket(uuid.first));
       failures_[uuid.first] = 1;
     }
   }
@@ -569,37 +586,22 @@ Status ExternalSQLPlugin::query(const std::string& query,
                                 QueryData& results,
                                 bool use_cache) const {
   static_cast<void>(use_cache);
-  // Make sure the extension path exists, and is writable.
-  auto status = extensionPathActive(FLAGS_extensions_socket);
-  if (!status.ok()) {
-    return status;
-  }
-
-  try {
-    ExtensionManagerClient client(FLAGS_extensions_socket);
-    status = client.query(query, results);
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
-
-  return status;
+  auto offset = results.size();
+  return ExtensionClientPool::get().callManager(
+      FLAGS_extensions_socket, ([&](ExtensionManagerClient& client) {
+        results.resize(offset);
+        return client.query(query, results);
+      }));
 }
 
 Status ExternalSQLPlugin::getQueryColumns(const std::string& query,
                                           TableColumns& columns) const {
-  // Make sure the extension path exists, and is writable.
-  auto status = extensionPathActive(FLAGS_extensions_socket);
-  if (!status.ok()) {
-    return status;
-  }
-
   QueryData qd;
-  try {
-    ExtensionManagerClient client(FLAGS_extensions_socket);
-    status = client.getQueryColumns(query, qd);
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
+  auto status = ExtensionClientPool::get().callManager(
+      FLAGS_extensions_socket, ([&](ExtensionManagerClient& client) {
+        qd.clear();
+        return client.getQueryColumns(query, qd);
+      }));
 
   // Translate response map: {string: string} to a vector: pair(name, type).
   for (const auto& column : qd) {
@@ -617,20 +619,11 @@ Status pingExtension(const std::string& path) {
     return Status(1, "Extensions disabled");
   }
 
-  // Make sure the extension path exists, and is writable.
-  auto status = extensionPathActive(path);
-  if (!status.ok()) {
-    return status;
-  }
-
-  try {
-    ExtensionClient client(path);
-    status = client.ping();
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
-
-  return Status(0, status.getMessage());
+  // Connections are checked and reused by the pool. Only a failure to reach
+  // the extension fails the ping, not the status it answers with.
+  return ExtensionClientPool::get().call(path, ([](ExtensionClient& client) {
+    return Status(0, client.ping().getMessage());
+  }));
 }
 
 Status getExtensions(ExtensionList& extensions) {
@@ -642,20 +635,16 @@ Status getExtensions(ExtensionList& extensions) {
 
 Status getExtensions(const std::string& manager_path,
                      ExtensionList& extensions) {
-  // Make sure the extension path exists, and is writable.
-  auto status = extensionPathActive(manager_path);
+  ExtensionList ext_list;
+  auto status = ExtensionClientPool::get().callManager(
+      manager_path, ([&ext_list](ExtensionManagerClient& client) {
+        ext_list = client.extensions();
+        return Status::success();
+      }));
   if (!status.ok()) {
     return status;
   }
 
-  ExtensionList ext_list;
-  try {
-    ExtensionManagerClient client(manager_path);
-    ext_list = client.extensions();
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
-
   // Add the extension manager to the list called (core).
   extensions[0] = {"core", kVersion, "0.0.0", kSDKVersion};
 
@@ -687,20 +676,14 @@ Status callExtension(const std::string& extension_path,
                      const std::string& item,
                      const PluginRequest& request,
                      PluginResponse& response) {
-  // Make sure the extension manager path exists, and is writable.
-  auto status = extensionPathActive(extension_path);
-  if (!status.ok()) {
-    return status;
-  }
-
-  try {
-    ExtensionClient client(extension_path);
-    status = client.call(registry, item, request, response);
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
-
-  return status;
+  // Connections to the extension are reused across calls.
+  auto offset = response.size();
+  return ExtensionClientPool::get().call(
+      extension_path, ([&](ExtensionClient& client) {
+        // A retried call must not append to a partial response.
+        response.resize(offset);
+        return client.call(registry, item, request, response);
+      }));
 }
 
 Status startExtensionWatcher(const std::string& manager_path,
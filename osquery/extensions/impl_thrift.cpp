@@ -26,6 +26,8 @@
 #else
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TSocket.h>
+
+#include "osquery/extensions/thrift_server.h"
 #endif
 
 #include "Extension.h"
@@ -47,6 +49,15 @@ FLAG(int32,
      0,
      "Sets the maximum string size allowed in a thrift message, use 0 for "
      "unlimited");
+FLAG(uint32,
+     thrift_server_threads,
+     0,
+     "Worker threads for each thrift server, use 0 for a thread per "
+     "connection");
+FLAG(uint32,
+     thrift_server_pending,
+     256,
+     "Maximum thrift requests waiting for a server worker thread");
 
 using namespace apache::thrift;
 using namespace apache::thrift::protocol;
@@ -174,7 +185,7 @@ class ExtensionManagerHandler : virtual public extensions::ExtensionManagerIf,
 
 struct ImplExtensionRunner {
   std::shared_ptr<TServerTransport> transport;
-  std::shared_ptr<TThreadedServer> server;
+  std::shared_ptr<TServer> server;
   std::shared_ptr<TProcessor> processor;
   std::shared_ptr<ThriftServerEventHandler> server_event_handler;
 };
@@ -187,6 +198,31 @@ struct ImplExtensionClient {
   std::shared_ptr<TPlatformSocket> socket;
 };
 
+namespace {
+
+/**
+ * @brief Send a request and receive its response.
+ *
+ * Writing to a closed connection fails with NOT_OPEN (EPIPE, ECONNRESET or
+ * ENOTCONN), the server did not read the request so this is reported as
+ * ExtensionConnectionClosed and may be retried. Once the request is sent the
+ * server may have handled it, every later failure is thrown as is.
+ */
+template <typename Send, typename Receive>
+void sendRequest(Send send, Receive receive) {
+  try {
+    send();
+  } catch (const TTransportException& e) {
+    if (e.getType() == TTransportException::NOT_OPEN) {
+      throw ExtensionConnectionClosed(e.what());
+    }
+    throw;
+  }
+  receive();
+}
+
+} // namespace
+
 void ExtensionHandler::ping(extensions::ExtensionStatus& _return) {
   auto s = ExtensionInterface::ping();
   _return.code = (int)extensions::ExtensionCode::EXT_SUCCESS;
@@ -348,16 +384,35 @@ void ExtensionRunnerInterface::connect() {
   server_->transport = std::make_shared<TPlatformServerSocket>(
       path_, bufsize, TPIPE_SERVER_MAX_CONNS_DEFAULT, securityDescriptor);
 #else
-  server_->transport = std::make_shared<TPlatformServerSocket>(path_);
+  auto server_socket = std::make_shared<TPlatformServerSocket>(path_);
+  server_->transport = server_socket;
 #endif
 
   // Construct the service's transport, protocol, thread pool.
+  // Both servers use the buffered transport, existing clients are compatible.
   auto transport_fac = std::make_shared<TBufferedTransportFactory>();
   auto protocol_fac = std::make_shared<TBinaryProtocolFactory>();
   protocol_fac->setStringSizeLimit(FLAGS_thrift_string_size_limit);
 
-  server_->server = std::make_shared<TThreadedServer>(
-      server_->processor, server_->transport, transport_fac, protocol_fac);
+#ifndef WIN32
+  if (FLAGS_thrift_server_threads > 0) {
+    // Bound how long a worker waits for the rest of a request.
+    server_socket->setRecvTimeout(FLAGS_thrift_timeout * 1000);
+    server_->server = std::make_shared<ThriftPoolServer>(
+        server_->processor,
+        server_->transport,
+        transport_fac,
+        protocol_fac,
+        FLAGS_thrift_server_threads,
+        FLAGS_thrift_server_pending,
+        (manager_) ? "extensions.manager.server" : "extensions.server");
+  }
+#endif
+
+  if (server_->server == nullptr) {
+    server_->server = std::make_shared<TThreadedServer>(
+        server_->processor, server_->transport, transport_fac, protocol_fac);
+  }
 
   server_->server_event_handler = std::make_shared<ThriftServerEventHandler>();
   server_->server->setServerEventHandler(server_->server_event_handler);
@@ -420,6 +475,11 @@ void ExtensionClientCore::init(const std::string& path, bool manager) {
 }
 
 ExtensionClientCore::~ExtensionClientCore() {
+  if (client_ == nullptr) {
+    // Derived clients may not use a Thrift transport.
+    return;
+  }
+
   try {
     client_->transport->close();
   } catch (const std::exception& /* e */) {
@@ -453,7 +513,8 @@ ExtensionManagerClient::ExtensionManagerClient(const std::string& path,
 Status ExtensionClient::ping() {
   extensions::ExtensionStatus status;
   auto client = manager() ? client_->em : client_->e;
-  client->ping(status);
+  sendRequest([&]() { client->send_ping(); },
+              [&]() { client->recv_ping(status); });
   if (status.code != (int)extensions::ExtensionCode::EXT_FAILED) {
     return Status(0, status.message);
   }
@@ -466,7 +527,8 @@ Status ExtensionClient::call(const std::string& registry,
                              PluginResponse& response) {
   extensions::ExtensionResponse er;
   auto client = manager() ? client_->em : client_->e;
-  client->call(er, registry, item, request);
+  sendRequest([&]() { client->send_call(registry, item, request); },
+              [&]() { client->recv_call(er); });
   for (const auto& r : er.response) {
     response.push_back(r);
   }
@@ -476,13 +538,15 @@ Status ExtensionClient::call(const std::string& registry,
 
 void ExtensionClient::shutdown() {
   auto client = manager() ? client_->em : client_->e;
-  client->shutdown();
+  sendRequest([&]() { client->send_shutdown(); },
+              [&]() { client->recv_shutdown(); });
 }
 
 ExtensionList ExtensionManagerClient::extensions() {
   ExtensionList el;
   extensions::InternalExtensionList iel;
-  client_->em->extensions(iel);
+  sendRequest([&]() { client_->em->send_extensions(); },
+              [&]() { client_->em->recv_extensions(iel); });
   for (const auto& extension : iel) {
     auto& ext = el[extension.first];
     ext.min_sdk_version = extension.second.min_sdk_version;
@@ -496,7 +560,8 @@ ExtensionList ExtensionManagerClient::extensions() {
 OptionList ExtensionManagerClient::options() {
   OptionList ol;
   extensions::InternalOptionList iol;
-  client_->em->options(iol);
+  sendRequest([&]() { client_->em->send_options(); },
+              [&]() { client_->em->recv_options(iol); });
   for (const auto& option : iol) {
     auto& opt = option.second;
     ol[option.first] = {opt.value, opt.default_value, opt.type};
@@ -514,14 +579,16 @@ Status ExtensionManagerClient::registerExtension(
   iei.sdk_version = info.sdk_version;
   iei.min_sdk_version = info.min_sdk_version;
   extensions::ExtensionStatus status;
-  client_->em->registerExtension(status, iei, registry);
+  sendRequest([&]() { client_->em->send_registerExtension(iei, registry); },
+              [&]() { client_->em->recv_registerExtension(status); });
   uuid = status.uuid;
   return Status(status.code, status.message);
 }
 
 Status ExtensionManagerClient::query(const std::string& sql, QueryData& qd) {
   extensions::ExtensionResponse er;
-  client_->em->query(er, sql);
+  sendRequest([&]() { client_->em->send_query(sql); },
+              [&]() { client_->em->recv_query(er); });
   for (const auto& row : er.response) {
     qd.push_back(row);
   }
@@ -532,7 +599,8 @@ Status ExtensionManagerClient::query(const std::string& sql, QueryData& qd) {
 Status ExtensionManagerClient::getQueryColumns(const std::string& sql,
                                                QueryData& qd) {
   extensions::ExtensionResponse er;
-  client_->em->getQueryColumns(er, sql);
+  sendRequest([&]() { client_->em->send_getQueryColumns(sql); },
+              [&]() { client_->em->recv_getQueryColumns(er); });
   for (const auto& row : er.response) {
     qd.push_back(row);
   }
@@ -542,7 +610,8 @@ Status ExtensionManagerClient::getQueryColumns(const std::string& sql,
 
 Status ExtensionManagerClient::deregisterExtension(RouteUUID uuid) {
   extensions::ExtensionStatus status;
-  client_->em->deregisterExtension(status, uuid);
+  sendRequest([&]() { client_->em->send_deregisterExtension(uuid); },
+              [&]() { client_->em->recv_deregisterExtension(status); });
   return Status(status.code, status.message);
 }
 
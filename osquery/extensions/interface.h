@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <stdexcept>
+
 #include <osquery/core/query.h>
 #include <osquery/dispatcher/dispatcher.h>
 #include <osquery/extensions/extensions.h>
@@ -308,6 +310,18 @@ class ExtensionManagerRunner : public ExtensionRunnerCore {
   void start() override;
 };
 
+/**
+ * @brief The connection was closed before the server read the request.
+ *
+ * Thrown by extension clients when the request could not be sent because the
+ * connection was closed. Failures after the request was sent are thrown as
+ * is, the server may have handled the request.
+ */
+class ExtensionConnectionClosed : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
 /// Internal accessor for extension clients.
 class ExtensionClientCore : private boost::noncopyable {
  public:
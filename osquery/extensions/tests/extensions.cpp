@@ -12,10 +12,16 @@
 #define GTEST_HAS_TR1_TUPLE 0
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <osquery/extensions/client_pool.h>
 #include <osquery/extensions/extensions.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/registry/registry_factory.h>
@@ -34,6 +40,8 @@ namespace fs = boost::filesystem;
 namespace osquery {
 
 DECLARE_string(extensions_require);
+DECLARE_uint32(extensions_max_connections);
+DECLARE_uint32(thrift_server_threads);
 
 const int kDelay = 20;
 const int kTimeout = 3000;
@@ -63,6 +71,8 @@ class ExtensionsTest : public testing::Test {
   }
 
   void TearDown() override {
+    ExtensionClientPool::get().setClientFactory(nullptr);
+    ExtensionClientPool::get().clear();
     resetDispatcher();
 
     if (!isPlatform(PlatformType::TYPE_WINDOWS)) {
@@ -287,4 +297,223 @@ TEST_F(ExtensionsTest, test_extension_broadcast) {
   rf.allowDuplicates(false);
 }
 
+/// A client that does not connect, it fails once its connection is closed.
+class FakeExtensionClient : public ExtensionClient {
+ public:
+  explicit FakeExtensionClient(std::shared_ptr<std::atomic<bool>> open,
+                               std::shared_ptr<std::atomic<bool>> reset = {})
+      : open_(std::move(open)), reset_(std::move(reset)) {}
+
+  Status ping() override {
+    check();
+    return Status(0, "pong");
+  }
+
+  Status call(const std::string& registry,
+              const std::string& item,
+              const PluginRequest& request,
+              PluginResponse& response) override {
+    check();
+    response.push_back({{"item", item}});
+    if (reset_ != nullptr && *reset_) {
+      // The extension handled the request but the response was lost.
+      throw std::runtime_error("Connection reset");
+    }
+    return Status::success();
+  }
+
+ private:
+  void check() {
+    if (!*open_) {
+      throw ExtensionConnectionClosed("Connection closed");
+    }
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> open_;
+  std::shared_ptr<std::atomic<bool>> reset_;
+};
+
+TEST_F(ExtensionsTest, test_client_pool_reuse) {
+  auto status = startExtensionManager(socket_path);
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(socketExistsLocal(socket_path));
+  ASSERT_TRUE(ping());
+
+  // Each ping uses the same connection to the extension manager.
+  auto& pool = ExtensionClientPool::get();
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(pingExtension(socket_path).ok());
+  }
+  EXPECT_EQ(pool.idleConnections(socket_path), 1U);
+
+  ExtensionList extensions;
+  EXPECT_TRUE(getExtensions(socket_path, extensions).ok());
+  EXPECT_EQ(pool.idleConnections(socket_path, true), 1U);
+
+  pool.invalidate(socket_path);
+  EXPECT_EQ(pool.idleConnections(socket_path), 0U);
+  EXPECT_EQ(pool.idleConnections(socket_path, true), 0U);
+  EXPECT_TRUE(pingExtension(socket_path).ok());
+}
+
+TEST_F(ExtensionsTest, test_client_pool_reconnect) {
+  auto status = startExtensionManager(socket_path);
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(socketExistsLocal(socket_path));
+
+  size_t connections = 0;
+  auto open = std::make_shared<std::atomic<bool>>(true);
+  auto& pool = ExtensionClientPool::get();
+  pool.setClientFactory(([&connections, &open](const std::string&, bool) {
+    connections++;
+    return std::make_unique<FakeExtensionClient>(open);
+  }));
+
+  PluginResponse response;
+  EXPECT_TRUE(callExtension(socket_path, "test", "first", {}, response).ok());
+  EXPECT_TRUE(callExtension(socket_path, "test", "second", {}, response).ok());
+  EXPECT_EQ(connections, 1U);
+
+  // Close the idle connection, the next call reconnects once.
+  *open = false;
+  open = std::make_shared<std::atomic<bool>>(true);
+  EXPECT_TRUE(callExtension(socket_path, "test", "third", {}, response).ok());
+  EXPECT_EQ(connections, 2U);
+  EXPECT_EQ(pool.idleConnections(socket_path), 1U);
+
+  // A retried call does not duplicate the response rows.
+  ASSERT_EQ(response.size(), 3U);
+  EXPECT_EQ(response[2]["item"], "third");
+
+  // A new connection that fails is not retried.
+  *open = false;
+  pool.invalidate(socket_path);
+  EXPECT_FALSE(callExtension(socket_path, "test", "fourth", {}, response).ok());
+  EXPECT_EQ(connections, 3U);
+  EXPECT_EQ(pool.idleConnections(socket_path), 0U);
+
+  // Missing sockets fail before connecting.
+  status = pingExtension(socket_path + ".missing");
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(connections, 3U);
+}
+
+TEST_F(ExtensionsTest, test_client_pool_no_retry_after_send) {
+  auto status = startExtensionManager(socket_path);
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(socketExistsLocal(socket_path));
+
+  size_t connections = 0;
+  auto open = std::make_shared<std::atomic<bool>>(true);
+  auto reset = std::make_shared<std::atomic<bool>>(false);
+  auto& pool = ExtensionClientPool::get();
+  pool.setClientFactory(([&](const std::string&, bool) {
+    connections++;
+    return std::make_unique<FakeExtensionClient>(open, reset);
+  }));
+
+  PluginResponse response;
+  EXPECT_TRUE(callExtension(socket_path, "test", "first", {}, response).ok());
+  EXPECT_EQ(connections, 1U);
+
+  // The reused connection fails after the extension handled the request,
+  // sending it again could deliver it twice.
+  *reset = true;
+  response.clear();
+  EXPECT_FALSE(callExtension(socket_path, "test", "second", {}, response).ok());
+  EXPECT_EQ(connections, 1U);
+  EXPECT_EQ(response.size(), 1U);
+  EXPECT_EQ(pool.idleConnections(socket_path), 0U);
+}
+
+TEST_F(ExtensionsTest, test_client_pool_limit) {
+  auto status = startExtensionManager(socket_path);
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(socketExistsLocal(socket_path));
+
+  auto max_connections = FLAGS_extensions_max_connections;
+  FLAGS_extensions_max_connections = 2;
+
+  std::atomic<size_t> connections{0};
+  auto open = std::make_shared<std::atomic<bool>>(true);
+  auto& pool = ExtensionClientPool::get();
+  pool.setClientFactory(([&connections, &open](const std::string&, bool) {
+    connections++;
+    return std::make_unique<FakeExtensionClient>(open);
+  }));
+
+  std::atomic<size_t> active{0};
+  std::atomic<size_t> peak{0};
+  std::vector<std::thread> callers;
+  for (size_t i = 0; i < 6; ++i) {
+    callers.emplace_back([&]() {
+      pool.call(socket_path, ([&](ExtensionClient& client) {
+                  auto current = ++active;
+                  auto previous = peak.load();
+                  while (current > previous &&
+                         !peak.compare_exchange_weak(previous, current)) {
+                  }
+                  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                  active--;
+                  return client.ping();
+                }));
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  EXPECT_LE(peak.load(), 2U);
+  EXPECT_LE(connections.load(), 2U);
+  EXPECT_LE(pool.idleConnections(socket_path), 2U);
+  FLAGS_extensions_max_connections = max_connections;
+}
+
+TEST_F(ExtensionsTest, test_pool_server) {
+  if (isPlatform(PlatformType::TYPE_WINDOWS)) {
+    // Named pipes always use a thread per connection.
+    return;
+  }
+
+  auto server_threads = FLAGS_thrift_server_threads;
+  FLAGS_thrift_server_threads = 2;
+  auto status = startExtensionManager(socket_path);
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(socketExistsLocal(socket_path));
+  FLAGS_thrift_server_threads = server_threads;
+
+  // More persistent connections than workers are all served.
+  std::vector<std::unique_ptr<ExtensionManagerClient>> clients;
+  for (size_t i = 0; i < 8; ++i) {
+    clients.push_back(std::make_unique<ExtensionManagerClient>(socket_path));
+  }
+  for (size_t round = 0; round < 3; ++round) {
+    for (auto& client : clients) {
+      EXPECT_EQ(client->ping().getCode(), (int)ExtensionCode::EXT_SUCCESS);
+    }
+  }
+
+  std::vector<std::thread> callers;
+  std::atomic<size_t> successes{0};
+  for (auto& client : clients) {
+    callers.emplace_back([&client, &successes]() {
+      for (size_t i = 0; i < 20; ++i) {
+        if (client->ping().getCode() == (int)ExtensionCode::EXT_SUCCESS) {
+          successes++;
+        }
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(successes.load(), clients.size() * 20);
+
+  // A closed connection does not affect the others.
+  clients.pop_back();
+  EXPECT_EQ(clients.front()->ping().getCode(),
+            (int)ExtensionCode::EXT_SUCCESS);
+}
+
 } // namespace osquery
@@ -0,0 +1,342 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+#include <thrift/concurrency/ThreadFactory.h>
+#include <thrift/transport/TSocket.h>
+
+#include <osquery/logger/logger.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+
+#include "osquery/extensions/thrift_server.h"
+
+namespace osquery {
+
+using namespace apache::thrift;
+using namespace apache::thrift::concurrency;
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::server;
+using namespace apache::thrift::transport;
+
+namespace {
+
+std::uint64_t getElapsedUs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+struct ThriftPoolServer::Connection {
+  /// The accepted socket.
+  std::shared_ptr<TSocket> client;
+
+  std::shared_ptr<TTransport> input;
+  std::shared_ptr<TTransport> output;
+  std::shared_ptr<TProtocol> input_protocol;
+  std::shared_ptr<TProtocol> output_protocol;
+  std::shared_ptr<TProcessor> processor;
+
+  /// The server event handler's context.
+  void* context{nullptr};
+
+  /// The socket descriptor, the key in the connection maps.
+  int fd{-1};
+};
+
+class ThriftPoolServer::Task : public Runnable {
+ public:
+  Task(ThriftPoolServer& server, std::shared_ptr<Connection> connection)
+      : server_(server),
+        connection_(std::move(connection)),
+        queued_(std::chrono::steady_clock::now()) {}
+
+  void run() override {
+    server_.process(connection_, queued_);
+  }
+
+ private:
+  ThriftPoolServer& server_;
+  std::shared_ptr<Connection> connection_;
+  std::chrono::steady_clock::time_point queued_;
+};
+
+ThriftPoolServer::ThriftPoolServer(
+    const std::shared_ptr<TProcessor>& processor,
+    const std::shared_ptr<TServerTransport>& server_transport,
+    const std::shared_ptr<TTransportFactory>& transport_factory,
+    const std::shared_ptr<TProtocolFactory>& protocol_factory,
+    size_t workers,
+    size_t pending,
+    const std::string& metrics_prefix)
+    : TServer(processor, server_transport, transport_factory, protocol_factory),
+      connections_metric_(metrics_prefix + ".connections",
+                          monitoring::PreAggregationType::Max),
+      pending_metric_(metrics_prefix + ".pending",
+                      monitoring::PreAggregationType::Max),
+      wait_metric_(metrics_prefix + ".wait.micros",
+                   monitoring::PreAggregationType::Avg),
+      blocked_metric_(metrics_prefix + ".blocked.micros",
+                      monitoring::PreAggregationType::Sum) {
+  workers_ = ThreadManager::newSimpleThreadManager(workers, pending);
+  workers_->threadFactory(std::make_shared<ThreadFactory>(false));
+
+  if (::pipe(wake_) != 0) {
+    throw TTransportException(TTransportException::NOT_OPEN,
+                              "Cannot create the server wake pipe",
+                              errno);
+  }
+  // The pipe must not leak into extensions or other children of the worker.
+  for (auto fd : wake_) {
+    auto flags = ::fcntl(fd, F_GETFL);
+    if (flags == -1 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 ||
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+      auto error = errno;
+      for (auto& wake_fd : wake_) {
+        ::close(wake_fd);
+        wake_fd = -1;
+      }
+      throw TTransportException(TTransportException::NOT_OPEN,
+                                "Cannot configure the server wake pipe",
+                                error);
+    }
+  }
+}
+
+ThriftPoolServer::~ThriftPoolServer() {
+  for (auto fd : wake_) {
+    if (fd != -1) {
+      ::close(fd);
+    }
+  }
+}
+
+void ThriftPoolServer::serve() {
+  serverTransport_->listen();
+  workers_->start();
+  if (eventHandler_ != nullptr) {
+    eventHandler_->preServe();
+  }
+
+  std::thread poller([this]() { poll(); });
+  while (!stopping_) {
+    std::shared_ptr<TSocket> client;
+    try {
+      client = std::dynamic_pointer_cast<TSocket>(serverTransport_->accept());
+    } catch (const TTransportException& e) {
+      if (e.getType() == TTransportException::TIMED_OUT ||
+          e.getType() == TTransportException::CLIENT_DISCONNECT) {
+        continue;
+      }
+      if (e.getType() != TTransportException::INTERRUPTED) {
+        VLOG(1) << "Thrift server cannot accept: " << e.what();
+      }
+      break;
+    }
+
+    if (client == nullptr) {
+      continue;
+    }
+
+    auto connection = std::make_shared<Connection>();
+    connection->client = client;
+    connection->fd = static_cast<int>(client->getSocketFD());
+    try {
+      connection->input = inputTransportFactory_->getTransport(client);
+      connection->output = outputTransportFactory_->getTransport(client);
+      connection->input_protocol =
+          inputProtocolFactory_->getProtocol(connection->input);
+      connection->output_protocol =
+          outputProtocolFactory_->getProtocol(connection->output);
+      connection->processor = getProcessor(
+          connection->input_protocol, connection->output_protocol, client);
+    } catch (const std::exception& e) {
+      VLOG(1) << "Thrift server cannot set up a connection: " << e.what();
+      client->close();
+      continue;
+    }
+
+    if (eventHandler_ != nullptr) {
+      connection->context = eventHandler_->createContext(
+          connection->input_protocol, connection->output_protocol);
+    }
+
+    size_t count = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      connections_[connection->fd] = connection;
+      idle_[connection->fd] = connection;
+      count = connections_.size();
+    }
+    connections_metric_.record(count);
+    wake();
+  }
+
+  // Stop polling, then wait for the workers to finish their requests.
+  stopping_ = true;
+  wake();
+  poller.join();
+  workers_->stop();
+
+  std::map<int, std::shared_ptr<Connection>> connections;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections = connections_;
+  }
+  for (const auto& connection : connections) {
+    close(connection.second);
+  }
+  serverTransport_->close();
+}
+
+void ThriftPoolServer::stop() {
+  stopping_ = true;
+  serverTransport_->interrupt();
+  wake();
+}
+
+size_t ThriftPoolServer::connections() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.size();
+}
+
+void ThriftPoolServer::poll() {
+  std::vector<struct pollfd> fds;
+  std::vector<std::shared_ptr<Connection>> polled;
+  while (!stopping_) {
+    fds.clear();
+    polled.clear();
+    fds.push_back({wake_[0], POLLIN, 0});
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& connection : idle_) {
+        fds.push_back({connection.first, POLLIN, 0});
+        polled.push_back(connection.second);
+      }
+    }
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      VLOG(1) << "Thrift server cannot poll connections: " << errno;
+      break;
+    }
+
+    if (fds[0].revents != 0) {
+      char buffer[64];
+      while (::read(wake_[0], buffer, sizeof(buffer)) > 0) {
+      }
+    }
+
+    for (size_t i = 1; i < fds.size() && !stopping_; ++i) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+
+      // The connection is owned by a worker until its request is processed.
+      const auto& connection = polled[i - 1];
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.erase(connection->fd);
+      }
+
+      // Adding to a full queue blocks until a worker takes a request.
+      auto start = std::chrono::steady_clock::now();
+      try {
+        workers_->add(std::make_shared<Task>(*this, connection));
+      } catch (const std::exception& e) {
+        VLOG(1) << "Thrift server cannot queue a request: " << e.what();
+        close(connection);
+        continue;
+      }
+      blocked_metric_.record(getElapsedUs(start));
+      pending_metric_.record(workers_->pendingTaskCount());
+    }
+  }
+}
+
+void ThriftPoolServer::process(const std::shared_ptr<Connection>& connection,
+                               std::chrono::steady_clock::time_point queued) {
+  wait_metric_.record(getElapsedUs(queued));
+
+  bool keep = false;
+  try {
+    if (eventHandler_ != nullptr) {
+      eventHandler_->processContext(connection->context, connection->client);
+    }
+    keep = connection->processor->process(connection->input_protocol,
+                                          connection->output_protocol,
+                                          connection->context);
+  } catch (const TTransportException& e) {
+    // The client closed the connection, or it timed out mid-request.
+    if (e.getType() != TTransportException::END_OF_FILE) {
+      VLOG(1) << "Thrift server connection failed: " << e.what();
+    }
+  } catch (const std::exception& e) {
+    VLOG(1) << "Thrift server request failed: " << e.what();
+  }
+
+  if (keep && !stopping_) {
+    release(connection);
+  } else {
+    close(connection);
+  }
+}
+
+void ThriftPoolServer::release(const std::shared_ptr<Connection>& connection) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_[connection->fd] = connection;
+  }
+  wake();
+}
+
+void ThriftPoolServer::close(const std::shared_ptr<Connection>& connection) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(connection->fd);
+    if (it == connections_.end() || it->second != connection) {
+      return;
+    }
+    connections_.erase(it);
+    idle_.erase(connection->fd);
+  }
+
+  if (eventHandler_ != nullptr) {
+    eventHandler_->deleteContext(connection->context,
+                                 connection->input_protocol,
+                                 connection->output_protocol);
+  }
+
+  try {
+    connection->input->close();
+    connection->output->close();
+    connection->client->close();
+  } catch (const std::exception& /* e */) {
+    // The client may have already closed the socket.
+  }
+}
+
+void ThriftPoolServer::wake() {
+  char signal = 0;
+  // A full pipe already wakes the poll loop.
+  auto written = ::write(wake_[1], &signal, sizeof(signal));
+  static_cast<void>(written);
+}
+
+} // namespace osquery
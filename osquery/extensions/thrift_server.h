@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <thrift/concurrency/ThreadManager.h>
+#include <thrift/server/TServer.h>
+
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+
+namespace osquery {
+
+/**
+ * @brief A Thrift server dispatching requests to a fixed pool of workers.
+ *
+ * TThreadedServer dedicates a thread to each connection for its lifetime.
+ * This server polls the idle connections and queues a connection to the
+ * workers only when a request is readable. Persistent connections from many
+ * extensions share a bounded number of threads, and the poll thread stops
+ * reading requests while the queue is full.
+ *
+ * Connections use the transport and protocol factories of the server, with
+ * the buffered transport clients cannot tell this server from the threaded
+ * server. This server requires a pollable socket, it is not used for
+ * Windows named pipes.
+ *
+ * When numeric monitoring is enabled the server records, under the metrics
+ * prefix:
+ *  - connections: the number of connected clients (Max).
+ *  - pending: the number of requests waiting for a worker (Max).
+ *  - wait.micros: the time a request waited for a worker (Avg).
+ *  - blocked.micros: the time spent not polling, waiting for the queue (Sum).
+ */
+class ThriftPoolServer : public apache::thrift::server::TServer {
+ public:
+  ThriftPoolServer(
+      const std::shared_ptr<apache::thrift::TProcessor>& processor,
+      const std::shared_ptr<apache::thrift::transport::TServerTransport>&
+          server_transport,
+      const std::shared_ptr<apache::thrift::transport::TTransportFactory>&
+          transport_factory,
+      const std::shared_ptr<apache::thrift::protocol::TProtocolFactory>&
+          protocol_factory,
+      size_t workers,
+      size_t pending,
+      const std::string& metrics_prefix);
+  ~ThriftPoolServer() override;
+
+  /// Accept connections until stopped.
+  void serve() override;
+
+  /// Interrupt the accept and poll loops, serve then closes connections.
+  void stop() override;
+
+  /// The number of connected clients.
+  size_t connections();
+
+ private:
+  struct Connection;
+  class Task;
+
+  /// Wait for readable idle connections and queue them to the workers.
+  void poll();
+
+  /// Process a single request of a connection, on a worker.
+  void process(const std::shared_ptr<Connection>& connection,
+               std::chrono::steady_clock::time_point queued);
+
+  /// Return a connection to the poll loop.
+  void release(const std::shared_ptr<Connection>& connection);
+
+  /// Close a connection and forget it.
+  void close(const std::shared_ptr<Connection>& connection);
+
+  /// Interrupt the poll loop to poll a different set of connections.
+  void wake();
+
+ private:
+  /// The workers and their queue of readable connections.
+  std::shared_ptr<apache::thrift::concurrency::ThreadManager> workers_;
+
+  /// Every connected client, by socket descriptor.
+  std::map<int, std::shared_ptr<Connection>> connections_;
+
+  /// Connected clients waiting for a request, by socket descriptor.
+  std::map<int, std::shared_ptr<Connection>> idle_;
+
+  /// Protects the connection maps.
+  std::mutex mutex_;
+
+  /// A pipe written to interrupt the poll loop.
+  int wake_[2]{-1, -1};
+
+  /// Set by stop.
+  std::atomic<bool> stopping_{false};
+
+  /// Numeric monitoring metrics, registered with the metrics prefix.
+  monitoring::Metric connections_metric_;
+  monitoring::Metric pending_metric_;
+  monitoring::Metric wait_metric_;
+  monitoring::Metric blocked_metric_;
+};
+
+} // namespace osquery
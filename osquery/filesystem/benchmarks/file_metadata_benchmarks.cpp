@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/filesystem/posix/file_metadata.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+/// The number of files in each directory of a synthetic tree.
+const size_t kBenchmarkFilesPerDirectory{1000};
+
+/**
+ * @brief Create (once per size) a tree of empty files.
+ *
+ * Files are spread in directories of kBenchmarkFilesPerDirectory entries,
+ * grouped by 100 in a second level, like a large source or package tree.
+ */
+static const std::string& getBenchmarkTree(size_t files) {
+  static std::map<size_t, std::string> trees;
+  auto& root = trees[files];
+  if (!root.empty()) {
+    return root;
+  }
+
+  auto path = fs::temp_directory_path() /
+              fs::unique_path("osquery.benchmark_metadata.%%%%.%%%%");
+  for (size_t i = 0; i < files; ++i) {
+    auto leaf = i / kBenchmarkFilesPerDirectory;
+    auto directory = path / std::to_string(leaf / 100) / std::to_string(leaf);
+    if (i % kBenchmarkFilesPerDirectory == 0) {
+      fs::create_directories(directory);
+    }
+    std::ofstream((directory / std::to_string(i)).string());
+  }
+
+  root = path.string();
+  return root;
+}
+
+/// The previous walk: a recursive iterator, then lstat and stat by path.
+static void FILE_METADATA_boost_recursive(benchmark::State& state) {
+  const auto& root = getBenchmarkTree(state.range(0));
+
+  while (state.KeepRunning()) {
+    size_t regular = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+      struct stat link_stat;
+      struct stat file_stat;
+      auto path = entry.path().string();
+      if (::lstat(path.c_str(), &link_stat) == 0 &&
+          ::stat(path.c_str(), &file_stat) == 0 &&
+          S_ISREG(file_stat.st_mode)) {
+        regular++;
+      }
+    }
+    benchmark::DoNotOptimize(regular);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(FILE_METADATA_boost_recursive)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Walk the tree with a metadata mask, range(1) threads, range(2) fields.
+static void FILE_METADATA_walk_directory(benchmark::State& state) {
+  const auto& root = getBenchmarkTree(state.range(0));
+
+  FileWalkOptions options;
+  options.max_depth = 2;
+  options.threads = state.range(1);
+  options.mask = (state.range(2) != 0) ? kFileMetadataBasic : 0;
+
+  while (state.KeepRunning()) {
+    std::atomic<size_t> regular{0};
+    walkDirectory(root,
+                  options,
+                  [&regular](const std::string&,
+                             const DirectoryEntry& entry,
+                             const FileMetadata&) {
+                    if (entry.type == S_IFREG) {
+                      regular++;
+                    }
+                  });
+    benchmark::DoNotOptimize(regular.load());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void getWalkArguments(benchmark::internal::Benchmark* b) {
+  for (auto files : {10000, 100000, 1000000}) {
+    for (auto threads : {1, 4}) {
+      b->Args({files, threads, 0});
+      b->Args({files, threads, 1});
+    }
+  }
+}
+
+BENCHMARK(FILE_METADATA_walk_directory)
+    ->Apply(getWalkArguments)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void FILE_METADATA_lstat(benchmark::State& state) {
+  auto path = (fs::path(getBenchmarkTree(1000)) / "0" / "0" / "0").string();
+
+  struct stat st;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(::lstat(path.c_str(), &st));
+  }
+}
+
+BENCHMARK(FILE_METADATA_lstat);
+
+/// A lookup of the fields of a single column, as the file table makes.
+static void FILE_METADATA_get_file_metadata(benchmark::State& state) {
+  auto path = (fs::path(getBenchmarkTree(1000)) / "0" / "0" / "0").string();
+  std::uint32_t mask = (state.range(0) != 0) ? kFileMetadataBasic
+                                             : kFileMetadataSize;
+
+  FileMetadata metadata;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        getFileMetadata(AT_FDCWD, path, mask, false, metadata));
+  }
+}
+
+BENCHMARK(FILE_METADATA_get_file_metadata)->Arg(0)->Arg(1);
+
+} // namespace osquery
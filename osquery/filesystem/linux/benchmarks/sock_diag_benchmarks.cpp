@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/filesystem/linux/proc.h>
+#include <osquery/filesystem/linux/sock_diag.h>
+
+namespace osquery {
+
+/// Keep (at least) count TCP sockets listening on the loopback interface.
+static void createListeningSockets(size_t count) {
+  static std::vector<int> fds;
+  while (fds.size() < count) {
+    auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return;
+    }
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd,
+               reinterpret_cast<struct sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(fd, 1) != 0) {
+      ::close(fd);
+      return;
+    }
+    fds.push_back(fd);
+  }
+}
+
+static void SOCKETS_proc_get_socket_list(benchmark::State& state) {
+  createListeningSockets(static_cast<size_t>(state.range(0)));
+
+  while (state.KeepRunning()) {
+    SocketInfoList socket_list;
+    procGetSocketList(AF_INET, IPPROTO_TCP, 0, "self", socket_list);
+    benchmark::DoNotOptimize(socket_list);
+  }
+}
+
+BENCHMARK(SOCKETS_proc_get_socket_list)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void SOCKETS_sock_diag_get_socket_list(benchmark::State& state) {
+  createListeningSockets(static_cast<size_t>(state.range(0)));
+
+  std::unique_ptr<SocketDiag> sock_diag;
+  if (!SocketDiag::open(sock_diag).ok()) {
+    state.SkipWithError("NETLINK_SOCK_DIAG is not available");
+    return;
+  }
+
+  while (state.KeepRunning()) {
+    SocketInfoList socket_list;
+    sock_diag->getSocketList(
+        AF_INET, IPPROTO_TCP, 0, SocketDiagFilter(), socket_list);
+    benchmark::DoNotOptimize(socket_list);
+  }
+}
+
+BENCHMARK(SOCKETS_sock_diag_get_socket_list)->Arg(100)->Arg(1000)->Arg(10000);
+
+/// A port constraint is evaluated by the kernel, only one socket is copied.
+static void SOCKETS_sock_diag_port_filter(benchmark::State& state) {
+  createListeningSockets(static_cast<size_t>(state.range(0)));
+
+  std::unique_ptr<SocketDiag> sock_diag;
+  if (!SocketDiag::open(sock_diag).ok()) {
+    state.SkipWithError("NETLINK_SOCK_DIAG is not available");
+    return;
+  }
+
+  SocketDiagFilter filter;
+  filter.local_port = 22;
+  while (state.KeepRunning()) {
+    SocketInfoList socket_list;
+    sock_diag->getSocketList(AF_INET, IPPROTO_TCP, 0, filter, socket_list);
+    benchmark::DoNotOptimize(socket_list);
+  }
+}
+
+BENCHMARK(SOCKETS_sock_diag_port_filter)->Arg(100)->Arg(1000)->Arg(10000);
+
+} // namespace osquery
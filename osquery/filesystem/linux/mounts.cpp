@@ -44,7 +44,8 @@ Status getMountData(MountData& obj) {
 }
 } // namespace
 
-Status getMountedFilesystems(MountedFilesystems& mounted_fs_info) {
+Status getMountedFilesystems(MountedFilesystems& mounted_fs_info,
+                             bool statfs) {
   mounted_fs_info = {};
 
   MountData mount_data;
@@ -75,13 +76,16 @@ Status getMountedFilesystems(MountedFilesystems& mounted_fs_info) {
     mount_info.path = ent.mnt_dir;
     mount_info.flags = ent.mnt_opts;
 
-    if (mount_info.type == "autofs") {
+    if (!statfs) {
+      // The caller does not need the statfs information.
+
+    } else if (mount_info.type == "autofs") {
       VLOG(1) << "Skipping statfs information for autofs mount: "
               << mount_info.path;
 
     } else {
       struct statfs stats = {};
-      if (statfs(mount_info.path.c_str(), &stats) == 0) {
+      if (::statfs(mount_info.path.c_str(), &stats) == 0) {
         MountInformation::StatFsInfo statfs_info = {};
 
         statfs_info.block_size = static_cast<std::uint32_t>(stats.f_bsize);
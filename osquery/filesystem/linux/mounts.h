@@ -59,5 +59,7 @@ struct MountInformation final {
 // Information about all mounted filesystems
 using MountedFilesystems = std::vector<MountInformation>;
 
-Status getMountedFilesystems(MountedFilesystems& mounted_fs_info);
+// Set statfs to false to skip the statfs call on every mount path
+Status getMountedFilesystems(MountedFilesystems& mounted_fs_info,
+                             bool statfs = true);
 } // namespace osquery
@@ -0,0 +1,332 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/packet_diag.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/unix_diag.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <osquery/filesystem/linux/sock_diag.h>
+
+namespace osquery {
+
+/// Size of the netlink receive buffer, large enough for many replies.
+const size_t kSocketDiagBufferSize{64 * 1024};
+
+namespace {
+
+Status createSocketDiag(int& fd) {
+  fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (fd < 0) {
+    return Status::failure(std::string("Cannot open sock_diag socket: ") +
+                           std::strerror(errno));
+  }
+  return Status::success();
+}
+
+/// Append a NLMSG_ALIGN-ed copy of an object to a netlink request.
+template <typename T>
+void appendRequest(std::vector<char>& request, const T& object) {
+  auto offset = request.size();
+  request.resize(offset + NLMSG_ALIGN(sizeof(T)), 0);
+  std::memcpy(request.data() + offset, &object, sizeof(T));
+}
+
+/**
+ * @brief Append a port comparison to inet_diag bytecode.
+ *
+ * Each comparison is two operations. A mismatch jumps past the end of the
+ * program, which rejects the socket. The "no" offsets are patched once the
+ * full program length is known.
+ */
+void appendPortComparison(std::vector<inet_diag_bc_op>& program,
+                          unsigned char code,
+                          std::uint16_t port) {
+  program.push_back({code, sizeof(inet_diag_bc_op) * 2, 0});
+  program.push_back({0, 0, port});
+}
+
+std::vector<inet_diag_bc_op> buildPortFilter(const SocketDiagFilter& filter) {
+  std::vector<inet_diag_bc_op> program;
+  if (filter.local_port) {
+    appendPortComparison(program, INET_DIAG_BC_S_GE, *filter.local_port);
+    appendPortComparison(program, INET_DIAG_BC_S_LE, *filter.local_port);
+  }
+  if (filter.remote_port) {
+    appendPortComparison(program, INET_DIAG_BC_D_GE, *filter.remote_port);
+    appendPortComparison(program, INET_DIAG_BC_D_LE, *filter.remote_port);
+  }
+
+  auto length = program.size() * sizeof(inet_diag_bc_op);
+  for (size_t i = 0; i < program.size(); i += 2) {
+    auto remaining = length - i * sizeof(inet_diag_bc_op);
+    program[i].no = static_cast<unsigned short>(remaining + 4);
+  }
+  return program;
+}
+
+std::string formatInetAddress(int family, const __be32* address) {
+  char buffer[INET6_ADDRSTRLEN] = {0};
+  if (family == AF_INET) {
+    struct in_addr decoded;
+    decoded.s_addr = address[0];
+    inet_ntop(AF_INET, &decoded, buffer, INET_ADDRSTRLEN);
+  } else {
+    struct in6_addr decoded;
+    std::memcpy(&decoded, address, sizeof(decoded));
+    inet_ntop(AF_INET6, &decoded, buffer, INET6_ADDRSTRLEN);
+  }
+  return std::string(buffer);
+}
+
+/**
+ * Match the /proc/net/unix rendering.
+ *
+ * Pathnames end at their terminating NUL. Abstract names start with a NUL and
+ * may contain more, each is rendered as '@'.
+ */
+std::string formatUnixName(const char* name, size_t length) {
+  if (length == 0) {
+    return "";
+  }
+  if (name[0] != '\0') {
+    return std::string(name, strnlen(name, length));
+  }
+  std::string path(name, length);
+  std::replace(path.begin(), path.end(), '\0', '@');
+  return path;
+}
+
+} // namespace
+
+SocketDiag::SocketDiag(int fd) : fd_(fd), buffer_(kSocketDiagBufferSize) {}
+
+SocketDiag::~SocketDiag() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+Status SocketDiag::open(std::unique_ptr<SocketDiag>& handle,
+                        const std::string& pid) {
+  int fd = -1;
+  Status status;
+  if (pid.empty()) {
+    status = createSocketDiag(fd);
+  } else {
+    // setns only affects the calling thread, a netlink socket stays bound to
+    // the namespace it was created in.
+    auto ns_path = kLinuxProcPath + "/" + pid + "/ns/net";
+    std::thread([&fd, &status, &ns_path]() {
+      auto ns_fd = ::open(ns_path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (ns_fd < 0) {
+        status = Status::failure("Cannot open " + ns_path);
+        return;
+      }
+
+      if (::setns(ns_fd, CLONE_NEWNET) != 0) {
+        status = Status::failure("Cannot enter network namespace " + ns_path +
+                                 ": " + std::strerror(errno));
+      } else {
+        status = createSocketDiag(fd);
+      }
+      ::close(ns_fd);
+    }).join();
+  }
+
+  if (!status.ok()) {
+    return status;
+  }
+
+  handle.reset(new SocketDiag(fd));
+  return Status::success();
+}
+
+bool SocketDiag::isSupported(int family, int protocol) {
+  switch (family) {
+  case AF_INET:
+  case AF_INET6:
+    return protocol == IPPROTO_TCP || protocol == IPPROTO_UDP ||
+           protocol == IPPROTO_UDPLITE;
+  case AF_UNIX:
+    return protocol == IPPROTO_IP;
+  case AF_PACKET:
+    return true;
+  }
+  return false;
+}
+
+Status SocketDiag::dump(const std::vector<char>& request,
+                        const std::function<void(const nlmsghdr*)>& callback) {
+  struct sockaddr_nl kernel = {};
+  kernel.nl_family = AF_NETLINK;
+
+  auto sent = ::sendto(fd_,
+                       request.data(),
+                       request.size(),
+                       0,
+                       reinterpret_cast<struct sockaddr*>(&kernel),
+                       sizeof(kernel));
+  if (sent < 0 || static_cast<size_t>(sent) != request.size()) {
+    return Status::failure(std::string("Cannot send sock_diag request: ") +
+                           std::strerror(errno));
+  }
+
+  while (true) {
+    auto received = ::recv(fd_, buffer_.data(), buffer_.size(), 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::failure(std::string("Cannot read sock_diag reply: ") +
+                             std::strerror(errno));
+    }
+
+    auto length = static_cast<int>(received);
+    auto header = reinterpret_cast<const nlmsghdr*>(buffer_.data());
+    for (; NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+      if (header->nlmsg_seq != sequence_) {
+        continue;
+      }
+
+      if (header->nlmsg_type == NLMSG_DONE) {
+        return Status::success();
+      }
+
+      if (header->nlmsg_type == NLMSG_ERROR) {
+        auto error = static_cast<const nlmsgerr*>(NLMSG_DATA(header));
+        return Status::failure(std::string("sock_diag request failed: ") +
+                               std::strerror(-error->error));
+      }
+
+      callback(header);
+    }
+  }
+}
+
+Status SocketDiag::getSocketList(int family,
+                                 int protocol,
+                                 ino_t net_ns,
+                                 const SocketDiagFilter& filter,
+                                 SocketInfoList& result) {
+  if (!isSupported(family, protocol)) {
+    return Status::failure("Unsupported sock_diag family " +
+                           std::to_string(family) + " and protocol " +
+                           std::to_string(protocol));
+  }
+
+  std::vector<char> request;
+  nlmsghdr header = {};
+  header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  header.nlmsg_seq = ++sequence_;
+  appendRequest(request, header);
+
+  if (family == AF_INET || family == AF_INET6) {
+    inet_diag_req_v2 inet_request = {};
+    inet_request.sdiag_family = static_cast<__u8>(family);
+    inet_request.sdiag_protocol = static_cast<__u8>(protocol);
+    // UDP reuses the TCP state numbering, only filter TCP sockets by state.
+    inet_request.idiag_states =
+        (protocol == IPPROTO_TCP) ? filter.tcp_states : kSocketDiagAllStates;
+    appendRequest(request, inet_request);
+
+    auto program = buildPortFilter(filter);
+    if (!program.empty()) {
+      auto program_size = program.size() * sizeof(inet_diag_bc_op);
+      nlattr attribute = {};
+      attribute.nla_type = INET_DIAG_REQ_BYTECODE;
+      attribute.nla_len = static_cast<__u16>(NLA_HDRLEN + program_size);
+      appendRequest(request, attribute);
+
+      auto offset = request.size();
+      request.resize(offset + NLA_ALIGN(program_size), 0);
+      std::memcpy(request.data() + offset, program.data(), program_size);
+    }
+  } else if (family == AF_UNIX) {
+    unix_diag_req unix_request = {};
+    unix_request.sdiag_family = AF_UNIX;
+    unix_request.udiag_states = kSocketDiagAllStates;
+    unix_request.udiag_show = UDIAG_SHOW_NAME;
+    appendRequest(request, unix_request);
+  } else {
+    // The packet dump does not accept a protocol, filter below instead.
+    packet_diag_req packet_request = {};
+    packet_request.sdiag_family = AF_PACKET;
+    appendRequest(request, packet_request);
+  }
+
+  reinterpret_cast<nlmsghdr*>(request.data())->nlmsg_len =
+      static_cast<__u32>(request.size());
+
+  return dump(request, [&](const nlmsghdr* reply) {
+    SocketInfo socket_info = {};
+    socket_info.net_ns = net_ns;
+    socket_info.family = family;
+
+    if (family == AF_INET || family == AF_INET6) {
+      auto msg = static_cast<const inet_diag_msg*>(NLMSG_DATA(reply));
+      socket_info.socket = std::to_string(msg->idiag_inode);
+      socket_info.protocol = protocol;
+      socket_info.local_address =
+          formatInetAddress(family, msg->id.idiag_src);
+      socket_info.local_port = ntohs(msg->id.idiag_sport);
+      socket_info.remote_address =
+          formatInetAddress(family, msg->id.idiag_dst);
+      socket_info.remote_port = ntohs(msg->id.idiag_dport);
+
+      if (protocol == IPPROTO_TCP) {
+        socket_info.state = (msg->idiag_state == 0 ||
+                             msg->idiag_state >= tcp_states.size())
+                                ? "UNKNOWN"
+                                : tcp_states[msg->idiag_state];
+      }
+    } else if (family == AF_UNIX) {
+      auto msg = static_cast<const unix_diag_msg*>(NLMSG_DATA(reply));
+      socket_info.socket = std::to_string(msg->udiag_ino);
+      socket_info.protocol = IPPROTO_IP;
+
+      auto attribute_length =
+          static_cast<int>(reply->nlmsg_len - NLMSG_LENGTH(sizeof(*msg)));
+      auto attribute = reinterpret_cast<const rtattr*>(msg + 1);
+      for (; RTA_OK(attribute, attribute_length);
+           attribute = RTA_NEXT(attribute, attribute_length)) {
+        if (attribute->rta_type == UNIX_DIAG_NAME) {
+          socket_info.unix_socket_path =
+              formatUnixName(static_cast<const char*>(RTA_DATA(attribute)),
+                             RTA_PAYLOAD(attribute));
+        }
+      }
+    } else {
+      auto msg = static_cast<const packet_diag_msg*>(NLMSG_DATA(reply));
+      if (protocol > 0 && msg->pdiag_num != protocol) {
+        return;
+      }
+      socket_info.socket = std::to_string(msg->pdiag_ino);
+      socket_info.protocol = msg->pdiag_num;
+      socket_info.state = kSocketStateNone;
+    }
+
+    result.push_back(std::move(socket_info));
+  });
+}
+
+} // namespace osquery
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <osquery/filesystem/linux/proc.h>
+#include <osquery/utils/status/status.h>
+
+struct nlmsghdr;
+
+namespace osquery {
+
+/// Every TCP state, used as the default state mask of a dump request.
+const std::uint32_t kSocketDiagAllStates{0xffffffffU};
+
+/**
+ * @brief Filters pushed down into NETLINK_SOCK_DIAG dump requests.
+ *
+ * These are evaluated by the kernel, so sockets that cannot match the query
+ * constraints are never copied to userspace. They only narrow the results,
+ * callers must still apply their own constraints.
+ */
+struct SocketDiagFilter final {
+  /// Bitmask of (1 << state) for the TCP states to dump.
+  std::uint32_t tcp_states{kSocketDiagAllStates};
+
+  /// Only dump inet sockets bound to this local port.
+  boost::optional<std::uint16_t> local_port;
+
+  /// Only dump inet sockets connected to this remote port.
+  boost::optional<std::uint16_t> remote_port;
+};
+
+/**
+ * @brief A NETLINK_SOCK_DIAG socket used to dump socket tables in binary form.
+ *
+ * This is an alternative to parsing the /proc/<pid>/net/{tcp,udp,unix,packet}
+ * text files with procGetSocketList, it fills the same SocketInfo structure.
+ * The netlink socket is bound to the network namespace it was created in.
+ */
+class SocketDiag final : private boost::noncopyable {
+ public:
+  /**
+   * @brief Open a sock_diag netlink socket.
+   *
+   * @param handle The output parameter, set on success.
+   * @param pid If not empty, open the socket within the network namespace of
+   * this process. This requires the privileges to call setns(2).
+   */
+  static Status open(std::unique_ptr<SocketDiag>& handle,
+                     const std::string& pid = "");
+
+  ~SocketDiag();
+
+  /**
+   * @brief Dump the sockets of a family and protocol, same as procGetSocketList.
+   *
+   * The output parameter result is used as-is, i.e. it IS NOT cleared
+   * beforehand.
+   *
+   * @param family The socket family. One of AF_INET, AF_INET6, AF_UNIX or
+   * AF_PACKET.
+   * @param protocol For AF_INET and AF_INET6 one of IPPROTO_TCP, IPPROTO_UDP
+   * or IPPROTO_UDPLITE. For AF_UNIX only IPPROTO_IP is valid. For AF_PACKET
+   * 0 returns all protocols.
+   * @param net_ns The network namespace to set in the SocketInfo entry.
+   * @param filter Kernel-side filters for the dump.
+   * @param result The output parameter.
+   */
+  Status getSocketList(int family,
+                       int protocol,
+                       ino_t net_ns,
+                       const SocketDiagFilter& filter,
+                       SocketInfoList& result);
+
+  /// Check if a family/protocol pair can be dumped through sock_diag.
+  static bool isSupported(int family, int protocol);
+
+ private:
+  explicit SocketDiag(int fd);
+
+  /// Send a dump request and call the callback for each reply message.
+  Status dump(const std::vector<char>& request,
+              const std::function<void(const nlmsghdr*)>& callback);
+
+ private:
+  /// The netlink socket.
+  int fd_{-1};
+
+  /// The sequence number of the last request.
+  std::uint32_t sequence_{0};
+
+  /// Receive buffer, reused across dumps.
+  std::vector<char> buffer_;
+};
+
+} // namespace osquery
@@ -0,0 +1,408 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <osquery/filesystem/posix/file_metadata.h>
+
+namespace osquery {
+
+namespace {
+
+#if defined(__linux__)
+
+#if !defined(SYS_statx)
+#if defined(__x86_64__)
+#define SYS_statx 332
+#elif defined(__aarch64__)
+#define SYS_statx 291
+#endif
+#endif
+
+/// Do not synchronize attributes with the server of a network filesystem.
+const int kStatxDontSync{0x4000};
+
+/// The statx(2) structure, older system headers do not define it.
+struct StatxBuffer {
+  struct Timestamp {
+    std::int64_t tv_sec;
+    std::uint32_t tv_nsec;
+    std::int32_t reserved;
+  };
+
+  std::uint32_t mask;
+  std::uint32_t blksize;
+  std::uint64_t attributes;
+  std::uint32_t nlink;
+  std::uint32_t uid;
+  std::uint32_t gid;
+  std::uint16_t mode;
+  std::uint16_t spare0;
+  std::uint64_t ino;
+  std::uint64_t size;
+  std::uint64_t blocks;
+  std::uint64_t attributes_mask;
+  Timestamp atime;
+  Timestamp btime;
+  Timestamp ctime;
+  Timestamp mtime;
+  std::uint32_t rdev_major;
+  std::uint32_t rdev_minor;
+  std::uint32_t dev_major;
+  std::uint32_t dev_minor;
+  std::uint64_t spare2[14];
+};
+
+static_assert(sizeof(StatxBuffer) == 256, "Unexpected statx layout");
+
+/// The getdents64(2) record, older C libraries do not wrap the call.
+struct LinuxDirent64 {
+  std::uint64_t d_ino;
+  std::int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+
+/// Set once statx(2) is found to be missing or filtered.
+std::atomic<bool> kStatxUnavailable{false};
+
+/// Entries are read from the kernel in buffers of this size.
+const size_t kDirectoryBufferSize{32 * 1024};
+
+#endif
+
+bool isDotEntry(const char* name) {
+  return name[0] == '.' &&
+         (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+void fromStat(const struct stat& st, FileMetadata& metadata) {
+  metadata.mask = kFileMetadataBasic;
+  metadata.mode = st.st_mode;
+  metadata.inode = st.st_ino;
+  metadata.size = st.st_size;
+  metadata.blocks = st.st_blocks;
+  metadata.block_size = st.st_blksize;
+  metadata.hard_links = st.st_nlink;
+  metadata.uid = st.st_uid;
+  metadata.gid = st.st_gid;
+  metadata.device = st.st_rdev;
+  metadata.atime = st.st_atime;
+  metadata.mtime = st.st_mtime;
+  metadata.ctime = st.st_ctime;
+#if defined(__APPLE__) || defined(__FreeBSD__)
+  metadata.btime = st.st_birthtimespec.tv_sec;
+  metadata.mask |= kFileMetadataBtime;
+  metadata.flags = st.st_flags;
+#endif
+}
+
+Status statFileMetadata(int dirfd,
+                        const std::string& path,
+                        bool follow,
+                        FileMetadata& metadata) {
+  struct stat st;
+  if (::fstatat(dirfd, path.c_str(), &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) !=
+      0) {
+    return Status::failure("Cannot stat " + path + ": " +
+                           std::strerror(errno));
+  }
+
+  metadata = FileMetadata();
+  fromStat(st, metadata);
+  return Status::success();
+}
+
+} // namespace
+
+Status getFileMetadata(int dirfd,
+                       const std::string& path,
+                       std::uint32_t mask,
+                       bool follow,
+                       FileMetadata& metadata) {
+#if defined(__linux__) && defined(SYS_statx)
+  if (!kStatxUnavailable) {
+    // Like stat(2), do not trigger the automount of the last component.
+    int flags = AT_NO_AUTOMOUNT | kStatxDontSync;
+    if (!follow) {
+      flags |= AT_SYMLINK_NOFOLLOW;
+    }
+
+    StatxBuffer stx;
+    if (::syscall(SYS_statx, dirfd, path.c_str(), flags, mask, &stx) == 0) {
+      metadata = FileMetadata();
+      metadata.mask = stx.mask;
+      metadata.mode = stx.mode;
+      metadata.inode = stx.ino;
+      metadata.size = stx.size;
+      metadata.blocks = stx.blocks;
+      metadata.block_size = stx.blksize;
+      metadata.hard_links = stx.nlink;
+      metadata.uid = stx.uid;
+      metadata.gid = stx.gid;
+      metadata.device = makedev(stx.rdev_major, stx.rdev_minor);
+      metadata.atime = stx.atime.tv_sec;
+      metadata.mtime = stx.mtime.tv_sec;
+      metadata.ctime = stx.ctime.tv_sec;
+      metadata.btime = stx.btime.tv_sec;
+      return Status::success();
+    }
+
+    // Kernels before 4.11, and some seccomp profiles, do not allow statx.
+    if (errno != ENOSYS && errno != EPERM) {
+      return Status::failure("Cannot stat " + path + ": " +
+                             std::strerror(errno));
+    }
+
+    auto status = statFileMetadata(dirfd, path, follow, metadata);
+    if (status.ok()) {
+      kStatxUnavailable = true;
+    }
+    return status;
+  }
+#endif
+
+  return statFileMetadata(dirfd, path, follow, metadata);
+}
+
+Status DirectoryReader::open(int dirfd,
+                             const std::string& path,
+                             std::unique_ptr<DirectoryReader>& reader,
+                             bool follow) {
+  int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+  if (!follow) {
+    flags |= O_NOFOLLOW;
+  }
+
+  auto fd = ::openat(dirfd, path.c_str(), flags);
+  if (fd < 0) {
+    return Status::failure("Cannot open directory " + path + ": " +
+                           std::strerror(errno));
+  }
+
+  reader.reset(new DirectoryReader());
+  reader->fd_ = fd;
+#if defined(__linux__)
+  reader->buffer_.resize(kDirectoryBufferSize);
+#else
+  // The stream owns the fd from now on.
+  reader->stream_ = ::fdopendir(fd);
+  if (reader->stream_ == nullptr) {
+    // Without a stream the reader still owns, and closes, the fd.
+    reader.reset();
+    return Status::failure("Cannot read directory " + path);
+  }
+#endif
+  return Status::success();
+}
+
+DirectoryReader::~DirectoryReader() {
+  if (stream_ != nullptr) {
+    ::closedir(static_cast<DIR*>(stream_));
+  } else if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool DirectoryReader::next(DirectoryEntry& entry) {
+#if defined(__linux__)
+  while (true) {
+    if (offset_ >= size_) {
+      auto size =
+          ::syscall(SYS_getdents64, fd_, buffer_.data(), buffer_.size());
+      if (size <= 0) {
+        return false;
+      }
+      size_ = static_cast<size_t>(size);
+      offset_ = 0;
+    }
+
+    const auto* dirent =
+        reinterpret_cast<const LinuxDirent64*>(buffer_.data() + offset_);
+    offset_ += dirent->d_reclen;
+    if (isDotEntry(dirent->d_name)) {
+      continue;
+    }
+
+    entry.name = dirent->d_name;
+    entry.inode = dirent->d_ino;
+    entry.type = DTTOIF(dirent->d_type);
+    return true;
+  }
+#else
+  while (true) {
+    const auto* dirent = ::readdir(static_cast<DIR*>(stream_));
+    if (dirent == nullptr) {
+      return false;
+    }
+    if (isDotEntry(dirent->d_name)) {
+      continue;
+    }
+
+    entry.name = dirent->d_name;
+    entry.inode = dirent->d_ino;
+    entry.type = DTTOIF(dirent->d_type);
+    return true;
+  }
+#endif
+}
+
+namespace {
+
+/// A walk of a directory tree, possibly on several threads.
+class FileWalk : private boost::noncopyable {
+ public:
+  FileWalk(const FileWalkOptions& options, const FileVisitor& visitor)
+      : options_(options), visitor_(visitor) {}
+
+  void run(DirectoryReader& root, const std::string& path) {
+    // The root is visited first, the other threads wait for directories.
+    busy_ = 1;
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < options_.threads; ++i) {
+      workers.emplace_back([this]() { work(); });
+    }
+
+    visit(root, path, 0);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_--;
+    }
+    ready_.notify_all();
+
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+ private:
+  /// Visit directories until none is left and no thread may add one.
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      ready_.wait(lock, [this]() { return !pending_.empty() || busy_ == 0; });
+      if (pending_.empty()) {
+        return;
+      }
+
+      auto directory = std::move(pending_.back());
+      pending_.pop_back();
+      busy_++;
+      lock.unlock();
+
+      // Symlinks were not followed when the directory was found.
+      std::unique_ptr<DirectoryReader> reader;
+      if (DirectoryReader::open(AT_FDCWD, directory.first, reader, false)
+              .ok()) {
+        visit(*reader, directory.first, directory.second);
+      }
+
+      lock.lock();
+      busy_--;
+      if (busy_ == 0 && pending_.empty()) {
+        ready_.notify_all();
+      }
+    }
+  }
+
+  void visit(DirectoryReader& reader, const std::string& path, size_t depth) {
+    bool recurse = depth < options_.max_depth;
+    DirectoryEntry entry;
+    while (reader.next(entry)) {
+      FileMetadata metadata;
+      auto mask = options_.mask;
+      if (recurse && entry.type == 0) {
+        mask |= kFileMetadataType;
+      }
+
+      if (mask != 0 &&
+          !getFileMetadata(reader.fd(), entry.name, mask, false, metadata)
+               .ok()) {
+        metadata = FileMetadata();
+      }
+
+      if (fileMetadataType(metadata) != 0) {
+        entry.type = fileMetadataType(metadata);
+      } else if (entry.type != 0) {
+        metadata.mode |= entry.type;
+        metadata.mask |= kFileMetadataType;
+      }
+
+      visitor_(path, entry, metadata);
+      if (recurse && S_ISDIR(entry.type)) {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          pending_.emplace_back(joinDirectoryEntry(path, entry.name),
+                                depth + 1);
+        }
+        ready_.notify_one();
+      }
+    }
+  }
+
+ private:
+  const FileWalkOptions& options_;
+  const FileVisitor& visitor_;
+
+  /// Directories to visit, with their depth, the last found is next.
+  std::vector<std::pair<std::string, size_t>> pending_;
+
+  /// The number of directories being visited.
+  size_t busy_{0};
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+};
+
+} // namespace
+
+Status walkDirectory(const std::string& root,
+                     const FileWalkOptions& options,
+                     const FileVisitor& visitor) {
+  std::unique_ptr<DirectoryReader> reader;
+  auto status = DirectoryReader::open(AT_FDCWD, root, reader);
+  if (!status.ok()) {
+    return status;
+  }
+
+  FileWalk walk(options, visitor);
+  walk.run(*reader, root);
+  return Status::success();
+}
+
+std::string joinDirectoryEntry(const std::string& directory,
+                               const std::string& name) {
+  if (directory.empty()) {
+    return name;
+  }
+  if (directory.back() == '/') {
+    return directory + name;
+  }
+  return directory + '/' + name;
+}
+
+} // namespace osquery
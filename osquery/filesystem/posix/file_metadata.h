@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/**
+ * @brief Fields of a file metadata lookup.
+ *
+ * The values are the statx(2) mask bits. Lookups only ask the filesystem for
+ * the requested fields, others may be filled anyway, FileMetadata::mask
+ * tells which ones are.
+ */
+const std::uint32_t kFileMetadataType{0x001U};
+const std::uint32_t kFileMetadataMode{0x002U};
+const std::uint32_t kFileMetadataHardLinks{0x004U};
+const std::uint32_t kFileMetadataUid{0x008U};
+const std::uint32_t kFileMetadataGid{0x010U};
+const std::uint32_t kFileMetadataAtime{0x020U};
+const std::uint32_t kFileMetadataMtime{0x040U};
+const std::uint32_t kFileMetadataCtime{0x080U};
+const std::uint32_t kFileMetadataInode{0x100U};
+const std::uint32_t kFileMetadataSize{0x200U};
+const std::uint32_t kFileMetadataBlocks{0x400U};
+const std::uint32_t kFileMetadataBtime{0x800U};
+
+/// Every field filled by a stat(2) call.
+const std::uint32_t kFileMetadataBasic{0x7ffU};
+
+/**
+ * @brief The metadata of a file, as returned by statx(2) or stat(2).
+ *
+ * The block size and the device numbers are always filled.
+ */
+struct FileMetadata {
+  /// The kFileMetadata fields that are filled.
+  std::uint32_t mask{0};
+
+  /// The file type and permission bits, as st_mode.
+  std::uint32_t mode{0};
+
+  std::uint64_t inode{0};
+  std::uint64_t size{0};
+  std::uint64_t blocks{0};
+  std::uint32_t block_size{0};
+  std::uint32_t hard_links{0};
+  std::uint32_t uid{0};
+  std::uint32_t gid{0};
+
+  /// The device of a special file, as st_rdev.
+  std::uint64_t device{0};
+
+  /// Times in seconds since the epoch.
+  std::int64_t atime{0};
+  std::int64_t mtime{0};
+  std::int64_t ctime{0};
+  std::int64_t btime{0};
+
+  /// BSD file flags, as st_flags, where the platform has them.
+  std::uint32_t flags{0};
+};
+
+/**
+ * @brief Look up the metadata of a file.
+ *
+ * On Linux this uses a single statx(2) call asking for the requested fields
+ * only, without synchronizing with the server of network filesystems. Other
+ * platforms, and kernels older than 4.11, use fstatat(2).
+ *
+ * @param dirfd The directory relative paths are opened from, or AT_FDCWD.
+ * @param path A path, or the name of a directory entry.
+ * @param mask The kFileMetadata fields to look up.
+ * @param follow Follow a symlink instead of describing the link itself.
+ * @param metadata The output parameter, set on success.
+ */
+Status getFileMetadata(int dirfd,
+                       const std::string& path,
+                       std::uint32_t mask,
+                       bool follow,
+                       FileMetadata& metadata);
+
+/// Get the file type bits of a mode, or 0 if the type is not known.
+inline std::uint32_t fileMetadataType(const FileMetadata& metadata) {
+  return (metadata.mask & kFileMetadataType) ? (metadata.mode & 0170000U)
+                                             : 0;
+}
+
+/// An entry of a directory, as returned by the kernel.
+struct DirectoryEntry {
+  std::string name;
+  std::uint64_t inode{0};
+
+  /// The file type bits of the mode, 0 if the filesystem does not tell.
+  std::uint32_t type{0};
+};
+
+/**
+ * @brief Reads the entries of a directory from a directory fd.
+ *
+ * On Linux entries are read with getdents64(2) into a large buffer, other
+ * platforms use readdir(3). The fd can be used to open or stat entries with
+ * the *at(2) system calls, without resolving the directory path again.
+ */
+class DirectoryReader : private boost::noncopyable {
+ public:
+  /**
+   * @brief Open a directory.
+   *
+   * @param dirfd The directory relative paths are opened from, or AT_FDCWD.
+   * @param path The path of the directory.
+   * @param reader The output parameter, set on success.
+   * @param follow Open the target of a symlink to a directory.
+   */
+  static Status open(int dirfd,
+                     const std::string& path,
+                     std::unique_ptr<DirectoryReader>& reader,
+                     bool follow = true);
+
+  ~DirectoryReader();
+
+  /// The directory fd.
+  int fd() const {
+    return fd_;
+  }
+
+  /**
+   * @brief Read the next entry, "." and ".." are skipped.
+   *
+   * @return false at the end of the directory, or if it cannot be read.
+   */
+  bool next(DirectoryEntry& entry);
+
+ private:
+  DirectoryReader() = default;
+
+ private:
+  int fd_{-1};
+
+  /// Entries read but not yet returned.
+  std::vector<char> buffer_;
+  size_t offset_{0};
+  size_t size_{0};
+
+  /// The readdir(3) stream, where getdents64(2) is not available.
+  void* stream_{nullptr};
+};
+
+/// Options of a directory tree walk.
+struct FileWalkOptions {
+  /// The kFileMetadata fields to look up for each entry, 0 for none.
+  std::uint32_t mask{0};
+
+  /// How many levels of subdirectories to visit, 0 for the root only.
+  size_t max_depth{0};
+
+  /// The number of threads walking the tree, each visits whole directories.
+  size_t threads{1};
+};
+
+/**
+ * @brief A visitor of the entries of a directory tree.
+ *
+ * Metadata is looked up without following symlinks, its mask is empty if
+ * the lookup failed. The type is always filled when the kernel knows it.
+ * With several threads, visitors are called concurrently.
+ */
+using FileVisitor = std::function<void(const std::string& directory,
+                                       const DirectoryEntry& entry,
+                                       const FileMetadata& metadata)>;
+
+/**
+ * @brief Visit every entry of a directory tree.
+ *
+ * Symlinks to directories are visited but not followed. Directories that
+ * cannot be read are skipped.
+ *
+ * @param root The path of the directory to walk.
+ * @param options What to look up for each entry, and how.
+ * @param visitor Called for each entry, with its directory path.
+ */
+Status walkDirectory(const std::string& root,
+                     const FileWalkOptions& options,
+                     const FileVisitor& visitor);
+
+/// Join a directory path and an entry name, as boost::filesystem would.
+std::string joinDirectoryEntry(const std::string& directory,
+                               const std::string& name);
+
+} // namespace osquery
@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <osquery/filesystem/linux/sock_diag.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+namespace {
+
+class SocketDiagTests : public testing::Test {
+ protected:
+  void TearDown() override {
+    for (auto fd : fds_) {
+      ::close(fd);
+    }
+  }
+
+  /// Create a listening TCP socket on 127.0.0.1, returns the bound port.
+  std::uint16_t listenTCP() {
+    auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT_GE(fd, 0);
+    fds_.push_back(fd);
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(
+        ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)),
+        0);
+    EXPECT_EQ(::listen(fd, 1), 0);
+
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&address), &length);
+    inodes_.push_back(socketInode(fd));
+    return ntohs(address.sin_port);
+  }
+
+  std::string socketInode(int fd) {
+    struct stat st;
+    EXPECT_EQ(::fstat(fd, &st), 0);
+    return std::to_string(st.st_ino);
+  }
+
+  const SocketInfo* find(const SocketInfoList& list, const std::string& inode) {
+    auto it = std::find_if(list.begin(), list.end(), [&](const SocketInfo& i) {
+      return i.socket == inode;
+    });
+    return (it == list.end()) ? nullptr : &*it;
+  }
+
+  std::vector<int> fds_;
+  std::vector<std::string> inodes_;
+};
+
+TEST_F(SocketDiagTests, test_tcp_listen_socket) {
+  std::unique_ptr<SocketDiag> sock_diag;
+  ASSERT_TRUE(SocketDiag::open(sock_diag).ok());
+
+  auto port = listenTCP();
+  SocketInfoList socket_list;
+  ASSERT_TRUE(sock_diag
+                  ->getSocketList(
+                      AF_INET, IPPROTO_TCP, 42, SocketDiagFilter(), socket_list)
+                  .ok());
+
+  auto info = find(socket_list, inodes_[0]);
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->family, AF_INET);
+  EXPECT_EQ(info->protocol, IPPROTO_TCP);
+  EXPECT_EQ(info->net_ns, 42U);
+  EXPECT_EQ(info->local_address, "127.0.0.1");
+  EXPECT_EQ(info->local_port, port);
+  EXPECT_EQ(info->remote_address, "0.0.0.0");
+  EXPECT_EQ(info->remote_port, 0);
+  EXPECT_EQ(info->state, "LISTEN");
+
+  // The same socket is reported by the /proc parser.
+  SocketInfoList proc_list;
+  ASSERT_TRUE(procGetSocketList(AF_INET, IPPROTO_TCP, 0, "self", proc_list).ok());
+  auto proc_info = find(proc_list, inodes_[0]);
+  ASSERT_NE(proc_info, nullptr);
+  EXPECT_EQ(proc_info->local_port, info->local_port);
+  EXPECT_EQ(proc_info->state, info->state);
+}
+
+TEST_F(SocketDiagTests, test_filters) {
+  std::unique_ptr<SocketDiag> sock_diag;
+  ASSERT_TRUE(SocketDiag::open(sock_diag).ok());
+
+  auto first_port = listenTCP();
+  listenTCP();
+
+  SocketDiagFilter filter;
+  filter.local_port = first_port;
+  SocketInfoList socket_list;
+  ASSERT_TRUE(
+      sock_diag->getSocketList(AF_INET, IPPROTO_TCP, 0, filter, socket_list)
+          .ok());
+  EXPECT_NE(find(socket_list, inodes_[0]), nullptr);
+  EXPECT_EQ(find(socket_list, inodes_[1]), nullptr);
+  for (const auto& info : socket_list) {
+    EXPECT_EQ(info.local_port, first_port);
+  }
+
+  // No listening socket is in the ESTABLISHED state.
+  filter = SocketDiagFilter();
+  filter.tcp_states = 1U << 1;
+  socket_list.clear();
+  ASSERT_TRUE(
+      sock_diag->getSocketList(AF_INET, IPPROTO_TCP, 0, filter, socket_list)
+          .ok());
+  EXPECT_EQ(find(socket_list, inodes_[0]), nullptr);
+  EXPECT_EQ(find(socket_list, inodes_[1]), nullptr);
+}
+
+TEST_F(SocketDiagTests, test_unix_socket_names) {
+  std::unique_ptr<SocketDiag> sock_diag;
+  ASSERT_TRUE(SocketDiag::open(sock_diag).ok());
+
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  fds_.push_back(fd);
+
+  // Bind to an abstract name, rendered with a leading '@' like /proc/net/unix.
+  std::string name = "osquery.sock_diag_tests." + std::to_string(::getpid());
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path + 1, name.data(), name.size());
+  auto length =
+      static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 +
+                             name.size());
+  ASSERT_EQ(
+      ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), length), 0);
+
+  SocketInfoList socket_list;
+  ASSERT_TRUE(sock_diag
+                  ->getSocketList(
+                      AF_UNIX, IPPROTO_IP, 0, SocketDiagFilter(), socket_list)
+                  .ok());
+
+  auto info = find(socket_list, socketInode(fd));
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->family, AF_UNIX);
+  EXPECT_EQ(info->unix_socket_path, "@" + name);
+}
+
+TEST_F(SocketDiagTests, test_unix_socket_pathnames) {
+  std::unique_ptr<SocketDiag> sock_diag;
+  ASSERT_TRUE(SocketDiag::open(sock_diag).ok());
+
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  fds_.push_back(fd);
+
+  // Bind to a pathname, the kernel reports it with the terminating NUL.
+  auto path = (fs::temp_directory_path() /
+               fs::unique_path("osquery.sock_diag_tests.%%%%-%%%%"))
+                  .string();
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  ASSERT_LT(path.size(), sizeof(address.sun_path));
+  std::memcpy(address.sun_path, path.data(), path.size());
+  ASSERT_EQ(::bind(fd,
+                   reinterpret_cast<struct sockaddr*>(&address),
+                   sizeof(address)),
+            0);
+
+  SocketInfoList socket_list;
+  auto status = sock_diag->getSocketList(
+      AF_UNIX, IPPROTO_IP, 0, SocketDiagFilter(), socket_list);
+  SocketInfoList proc_list;
+  auto proc_status =
+      procGetSocketList(AF_UNIX, IPPROTO_IP, 0, "self", proc_list);
+  ::unlink(path.c_str());
+  ASSERT_TRUE(status.ok());
+  ASSERT_TRUE(proc_status.ok());
+
+  auto info = find(socket_list, socketInode(fd));
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->unix_socket_path, path);
+
+  // The same path is reported by the /proc parser.
+  auto proc_info = find(proc_list, socketInode(fd));
+  ASSERT_NE(proc_info, nullptr);
+  EXPECT_EQ(proc_info->unix_socket_path, info->unix_socket_path);
+}
+
+TEST_F(SocketDiagTests, test_unsupported_protocols) {
+  EXPECT_TRUE(SocketDiag::isSupported(AF_INET6, IPPROTO_UDP));
+  EXPECT_TRUE(SocketDiag::isSupported(AF_PACKET, 0));
+  EXPECT_FALSE(SocketDiag::isSupported(AF_INET, IPPROTO_ICMP));
+  EXPECT_FALSE(SocketDiag::isSupported(AF_UNIX, IPPROTO_TCP));
+}
+
+} // namespace
+} // namespace osquery
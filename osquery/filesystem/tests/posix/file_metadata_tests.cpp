@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/posix/file_metadata.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+class FileMetadataTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = fs::temp_directory_path() /
+            fs::unique_path("osquery.tests.file_metadata.%%%%.%%%%");
+    fs::create_directories(root_ / "a" / "b");
+    writeTextFile((root_ / "file").string(), "content");
+    writeTextFile((root_ / "a" / "file").string(), "content");
+    writeTextFile((root_ / "a" / "b" / "file").string(), "content");
+    fs::create_symlink(root_ / "a", root_ / "link");
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+  }
+
+  /// Walk the test tree, return the paths relative to the root.
+  std::set<std::string> walk(const FileWalkOptions& options) {
+    std::set<std::string> paths;
+    std::mutex mutex;
+    auto root = root_.string();
+    auto status = walkDirectory(
+        root,
+        options,
+        [&](const std::string& directory,
+            const DirectoryEntry& entry,
+            const FileMetadata& metadata) {
+          auto path = joinDirectoryEntry(directory, entry.name);
+          std::lock_guard<std::mutex> lock(mutex);
+          paths.insert(path.substr(root.size() + 1));
+        });
+    EXPECT_TRUE(status.ok()) << status.getMessage();
+    return paths;
+  }
+
+ protected:
+  fs::path root_;
+};
+
+TEST_F(FileMetadataTests, test_get_file_metadata) {
+  auto path = (root_ / "file").string();
+  struct stat st;
+  ASSERT_EQ(::stat(path.c_str(), &st), 0);
+
+  FileMetadata metadata;
+  auto status =
+      getFileMetadata(AT_FDCWD, path, kFileMetadataBasic, false, metadata);
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+
+  EXPECT_EQ(metadata.mask & kFileMetadataBasic, kFileMetadataBasic);
+  EXPECT_EQ(metadata.mode, st.st_mode);
+  EXPECT_EQ(fileMetadataType(metadata), static_cast<uint32_t>(S_IFREG));
+  EXPECT_EQ(metadata.inode, st.st_ino);
+  EXPECT_EQ(metadata.size, 7U);
+  EXPECT_EQ(metadata.hard_links, 1U);
+  EXPECT_EQ(metadata.uid, st.st_uid);
+  EXPECT_EQ(metadata.gid, st.st_gid);
+  EXPECT_EQ(metadata.mtime, st.st_mtime);
+
+  auto missing = (root_ / "missing").string();
+  status =
+      getFileMetadata(AT_FDCWD, missing, kFileMetadataSize, true, metadata);
+  EXPECT_FALSE(status.ok());
+}
+
+TEST_F(FileMetadataTests, test_get_file_metadata_symlink) {
+  auto path = (root_ / "link").string();
+
+  FileMetadata metadata;
+  ASSERT_TRUE(
+      getFileMetadata(AT_FDCWD, path, kFileMetadataType, false, metadata)
+          .ok());
+  EXPECT_EQ(fileMetadataType(metadata), static_cast<uint32_t>(S_IFLNK));
+
+  ASSERT_TRUE(
+      getFileMetadata(AT_FDCWD, path, kFileMetadataType, true, metadata)
+          .ok());
+  EXPECT_EQ(fileMetadataType(metadata), static_cast<uint32_t>(S_IFDIR));
+}
+
+TEST_F(FileMetadataTests, test_directory_reader) {
+  std::unique_ptr<DirectoryReader> reader;
+  auto status = DirectoryReader::open(AT_FDCWD, root_.string(), reader);
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+
+  std::set<std::string> names;
+  DirectoryEntry entry;
+  while (reader->next(entry)) {
+    names.insert(entry.name);
+
+    // Entries are looked up relative to the directory fd.
+    FileMetadata metadata;
+    auto lookup = getFileMetadata(
+        reader->fd(), entry.name, kFileMetadataInode, false, metadata);
+    ASSERT_TRUE(lookup.ok()) << lookup.getMessage();
+    EXPECT_EQ(metadata.inode, entry.inode);
+    if (entry.type != 0) {
+      EXPECT_EQ(entry.type, fileMetadataType(metadata));
+    }
+  }
+  EXPECT_EQ(names, std::set<std::string>({"a", "file", "link"}));
+
+  // A symlink to a directory is only opened when following links.
+  auto link = (root_ / "link").string();
+  EXPECT_TRUE(DirectoryReader::open(AT_FDCWD, link, reader).ok());
+  EXPECT_FALSE(DirectoryReader::open(AT_FDCWD, link, reader, false).ok());
+  EXPECT_FALSE(
+      DirectoryReader::open(AT_FDCWD, (root_ / "file").string(), reader)
+          .ok());
+}
+
+TEST_F(FileMetadataTests, test_walk_directory) {
+  FileWalkOptions options;
+  EXPECT_EQ(walk(options), std::set<std::string>({"a", "file", "link"}));
+
+  options.max_depth = 1;
+  EXPECT_EQ(walk(options),
+            std::set<std::string>({"a", "a/b", "a/file", "file", "link"}));
+
+  // Symlinks are not followed, with or without threads.
+  std::set<std::string> expected(
+      {"a", "a/b", "a/b/file", "a/file", "file", "link"});
+  options.max_depth = 16;
+  options.mask = kFileMetadataMode;
+  EXPECT_EQ(walk(options), expected);
+
+  options.threads = 4;
+  EXPECT_EQ(walk(options), expected);
+}
+
+TEST_F(FileMetadataTests, test_walk_directory_missing) {
+  auto status = walkDirectory((root_ / "missing").string(),
+                              FileWalkOptions(),
+                              [](const std::string&,
+                                 const DirectoryEntry&,
+                                 const FileMetadata&) {});
+  EXPECT_FALSE(status.ok());
+}
+
+TEST_F(FileMetadataTests, test_join_directory_entry) {
+  EXPECT_EQ(joinDirectoryEntry("/tmp", "file"), "/tmp/file");
+  EXPECT_EQ(joinDirectoryEntry("/tmp/", "file"), "/tmp/file");
+  EXPECT_EQ(joinDirectoryEntry("/", "file"), "/file");
+  EXPECT_EQ(joinDirectoryEntry("", "file"), "file");
+}
+
+} // namespace osquery
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/hashing/file_hash_cache.h>
+#include <osquery/hashing/hashing.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+/// The number of distinct files used by the cache benchmarks.
+const size_t kBenchmarkFileCount{256};
+
+/// Create (once) a directory of small files shared by every benchmark thread.
+static const std::vector<std::string>& getBenchmarkFiles() {
+  static const std::vector<std::string> files = ([]() {
+    auto dir = fs::temp_directory_path() /
+               fs::unique_path("osquery.benchmark_hashing.%%%%.%%%%");
+    fs::create_directories(dir);
+
+    std::vector<std::string> paths;
+    std::string content(4096, 'A');
+    for (size_t i = 0; i < kBenchmarkFileCount; ++i) {
+      auto path = (dir / std::to_string(i)).string();
+      std::ofstream file(path);
+      file << i << content;
+      paths.push_back(path);
+    }
+    return paths;
+  })();
+  return files;
+}
+
+/// Create (once) a single large file used by the throughput benchmarks.
+static const std::string& getBenchmarkLargeFile() {
+  static const std::string file = ([]() {
+    auto path = fs::temp_directory_path() /
+                fs::unique_path("osquery.benchmark_hashing.%%%%.%%%%");
+    std::ofstream stream(path.string(), std::ios::binary);
+    std::string block(1024 * 1024, 'A');
+    for (size_t i = 0; i < 32; ++i) {
+      stream << block;
+    }
+    return path.string();
+  })();
+  return file;
+}
+
+/// Digest masks for the 1, 2 and 3 digest throughput benchmarks.
+static int getBenchmarkMask(int64_t digests) {
+  if (digests == 1) {
+    return HASH_TYPE_SHA256;
+  } else if (digests == 2) {
+    return HASH_TYPE_SHA1 | HASH_TYPE_SHA256;
+  }
+  return HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256;
+}
+
+static void HASHING_multi_from_file(benchmark::State& state) {
+  const auto& path = getBenchmarkLargeFile();
+  auto mask = getBenchmarkMask(state.range(0));
+  auto size = static_cast<int64_t>(fs::file_size(path));
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(hashMultiFromFile(mask, path));
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK(HASHING_multi_from_file)->Arg(1)->Arg(2)->Arg(3);
+
+/// The previous driver: small readFile blocks fed to each digest in turn.
+static void HASHING_read_file_blocks(benchmark::State& state) {
+  const auto& path = getBenchmarkLargeFile();
+  auto mask = getBenchmarkMask(state.range(0));
+  auto size = static_cast<int64_t>(fs::file_size(path));
+
+  while (state.KeepRunning()) {
+    std::vector<std::unique_ptr<Hash>> hashes;
+    for (auto type : {HASH_TYPE_MD5, HASH_TYPE_SHA1, HASH_TYPE_SHA256}) {
+      if (mask & type) {
+        hashes.push_back(std::make_unique<Hash>(type));
+      }
+    }
+
+    readFile(path,
+             0,
+             4096,
+             false,
+             ([&hashes](std::string& buffer, size_t size) {
+               for (auto& hash : hashes) {
+                 hash->update(&buffer[0], size);
+               }
+             }),
+             true);
+    for (auto& hash : hashes) {
+      benchmark::DoNotOptimize(hash->digest());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK(HASHING_read_file_blocks)->Arg(1)->Arg(2)->Arg(3);
+
+static void HASHING_file_hash_cache_hit(benchmark::State& state) {
+  const auto& files = getBenchmarkFiles();
+
+  // Every file fits, after the first pass all loads are hits.
+  static FileHashCache cache(kBenchmarkFileCount * 2, 16);
+
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    MultiHashes hashes;
+    cache.load(files[i++ % files.size()], hashes);
+    benchmark::DoNotOptimize(hashes);
+  }
+}
+
+BENCHMARK(HASHING_file_hash_cache_hit)->ThreadRange(1, 8)->UseRealTime();
+
+static void HASHING_file_hash_cache_miss(benchmark::State& state) {
+  const auto& files = getBenchmarkFiles();
+
+  // A single entry per shard, cycling through the files always misses.
+  static FileHashCache cache(16, 16);
+
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    MultiHashes hashes;
+    cache.load(files[i++ % files.size()], hashes);
+    benchmark::DoNotOptimize(hashes);
+  }
+}
+
+BENCHMARK(HASHING_file_hash_cache_miss)->ThreadRange(1, 8)->UseRealTime();
+
+static void HASHING_file_hash_cache_lookup(benchmark::State& state) {
+  static FileHashCache cache(kBenchmarkFileCount, 16);
+  static const bool populated = ([]() {
+    for (size_t i = 0; i < kBenchmarkFileCount; ++i) {
+      FileHashCacheKey key;
+      key.inode = i;
+      cache.insert(key, MultiHashes{});
+    }
+    return true;
+  })();
+  benchmark::DoNotOptimize(populated);
+
+  FileHashCacheKey key;
+  while (state.KeepRunning()) {
+    MultiHashes hashes;
+    key.inode = (key.inode + 1) % kBenchmarkFileCount;
+    benchmark::DoNotOptimize(cache.lookup(key, hashes));
+  }
+}
+
+BENCHMARK(HASHING_file_hash_cache_lookup)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace osquery
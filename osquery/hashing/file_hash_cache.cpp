@@ -0,0 +1,294 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+// clang-format off
+#include <sys/types.h>
+#include <sys/stat.h>
+// clang-format on
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/functional/hash.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/database/database.h>
+#include <osquery/hashing/file_hash_cache.h>
+#include <osquery/utils/conversions/split.h>
+#include <osquery/utils/conversions/tryto.h>
+#include <osquery/utils/system/time.h>
+
+namespace osquery {
+
+FLAG(bool,
+     disable_hash_cache,
+     false,
+     "Cache calculated file hashes, re-calculate only if inode times change");
+
+FLAG(uint32, hash_cache_max, 500, "Size of LRU file hash cache");
+
+FLAG(bool,
+     hash_cache_persist,
+     false,
+     "Persist calculated file hashes in the backing store across restarts");
+
+FLAG(uint64,
+     hash_cache_persist_expiry,
+     604800,
+     "Seconds a persisted file hash is kept after it was last used");
+
+DECLARE_uint64(read_max);
+
+/// The number of independently locked shards in the process-wide cache.
+const size_t kHashCacheShards{16};
+
+/// Hashes are always calculated together so one entry serves every caller.
+const int kHashCacheMask{HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256};
+
+/// Persisted entries are swept for expiry once every this many writes.
+const size_t kHashCachePersistSweep{1024};
+
+#if defined(WIN32)
+
+#define stat _stat
+
+#endif
+
+namespace {
+
+FileHashCacheKey keyFromStat(const struct stat& st) {
+  FileHashCacheKey key;
+  key.device = static_cast<uint64_t>(st.st_dev);
+  key.inode = static_cast<uint64_t>(st.st_ino);
+  key.size = static_cast<int64_t>(st.st_size);
+  key.mtime = static_cast<int64_t>(st.st_mtime);
+  key.ctime = static_cast<int64_t>(st.st_ctime);
+  return key;
+}
+
+/// Persisted entries are indexed by file, so a changed file replaces its row.
+std::string persistedKey(const FileHashCacheKey& key) {
+  return std::to_string(key.device) + "." + std::to_string(key.inode);
+}
+
+/// The value is the file identity, the hashes, and when it was last used.
+std::string persistedValue(const FileHashCacheKey& key,
+                           const MultiHashes& hashes,
+                           uint64_t used) {
+  return std::to_string(key.size) + "," + std::to_string(key.mtime) + "," +
+         std::to_string(key.ctime) + "," + hashes.md5 + "," + hashes.sha1 +
+         "," + hashes.sha256 + "," + std::to_string(used);
+}
+
+/// Parse when a persisted value was last used, false if it is malformed.
+bool getPersistedUse(const std::vector<std::string_view>& fields,
+                     uint64_t& used) {
+  if (fields.size() != 7) {
+    return false;
+  }
+  auto time = tryTo<uint64_t>(std::string(fields[6]));
+  if (time.isError()) {
+    return false;
+  }
+  used = time.get();
+  return true;
+}
+
+bool isPersistedExpired(uint64_t used, uint64_t now) {
+  return used + FLAGS_hash_cache_persist_expiry < now;
+}
+
+} // namespace
+
+FileHashCache& FileHashCache::get() {
+  static FileHashCache cache(FLAGS_hash_cache_max, kHashCacheShards);
+  return cache;
+}
+
+FileHashCache::FileHashCache(size_t capacity, size_t shards) {
+  shards = std::max<size_t>(shards, 1);
+  auto per_shard = std::max<size_t>(capacity / shards, 1);
+  for (size_t i = 0; i < shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>(per_shard));
+  }
+}
+
+FileHashCache::Shard& FileHashCache::shardFor(
+    const FileHashCacheKey& key) const {
+  return *shards_[std::hash<FileHashCacheKey>()(key) % shards_.size()];
+}
+
+Status FileHashCache::load(const std::string& path, MultiHashes& hashes) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return Status::failure("Cannot stat file: " + path + ": " +
+                           std::strerror(errno));
+  }
+
+  auto key = keyFromStat(st);
+  if (static_cast<uint64_t>(key.size) > FLAGS_read_max) {
+    // Files over the read limit have empty hashes, like hashMultiFromFile.
+    hashes = MultiHashes();
+    return Status::success();
+  }
+
+  if (lookup(key, hashes)) {
+    return Status::success();
+  }
+
+  if (FLAGS_hash_cache_persist && loadPersisted(key, hashes)) {
+    insert(key, hashes);
+    return Status::success();
+  }
+
+  // Hash outside of any shard lock, concurrent misses on other files proceed.
+  hashes = hashMultiFromFile(kHashCacheMask, path);
+  if (hashes.md5.empty()) {
+    return Status::failure("Cannot hash file: " + path);
+  }
+
+  insert(key, hashes);
+  if (FLAGS_hash_cache_persist) {
+    persist(key, hashes);
+  }
+  return Status::success();
+}
+
+bool FileHashCache::lookup(const FileHashCacheKey& key, MultiHashes& hashes) {
+  auto& shard = shardFor(key);
+  WriteLock lock(shard.mutex);
+  auto cached = shard.entries.get(key);
+  if (cached == nullptr) {
+    return false;
+  }
+  hashes = *cached;
+  return true;
+}
+
+void FileHashCache::insert(const FileHashCacheKey& key,
+                           const MultiHashes& hashes) {
+  auto& shard = shardFor(key);
+  WriteLock lock(shard.mutex);
+  shard.entries.insert(key, hashes);
+}
+
+void FileHashCache::clear() {
+  for (auto& shard : shards_) {
+    WriteLock lock(shard->mutex);
+    shard->entries.clear();
+  }
+}
+
+size_t FileHashCache::size() const {
+  size_t count = 0;
+  for (const auto& shard : shards_) {
+    WriteLock lock(shard->mutex);
+    count += shard->entries.size();
+  }
+  return count;
+}
+
+bool FileHashCache::loadPersisted(const FileHashCacheKey& key,
+                                  MultiHashes& hashes) {
+  if (!databaseInitialized()) {
+    return false;
+  }
+
+  std::string value;
+  auto status = getDatabaseValue(kFileHashes, persistedKey(key), value);
+  if (!status.ok() || value.empty()) {
+    return false;
+  }
+
+  auto now = getUnixTime();
+  auto fields = vsplit(value, ',');
+  uint64_t used = 0;
+  if (!getPersistedUse(fields, used) || isPersistedExpired(used, now)) {
+    deleteDatabaseValue(kFileHashes, persistedKey(key));
+    return false;
+  }
+
+  auto size = tryTo<int64_t>(std::string(fields[0]));
+  auto mtime = tryTo<int64_t>(std::string(fields[1]));
+  auto ctime = tryTo<int64_t>(std::string(fields[2]));
+  if (size.isError() || mtime.isError() || ctime.isError()) {
+    deleteDatabaseValue(kFileHashes, persistedKey(key));
+    return false;
+  }
+
+  if (size.get() != key.size || mtime.get() != key.mtime ||
+      ctime.get() != key.ctime) {
+    // The file changed since it was persisted, the entry is stale.
+    deleteDatabaseValue(kFileHashes, persistedKey(key));
+    return false;
+  }
+
+  hashes.mask = kHashCacheMask;
+  hashes.md5 = std::string(fields[3]);
+  hashes.sha1 = std::string(fields[4]);
+  hashes.sha256 = std::string(fields[5]);
+
+  // Refresh the last use of entries halfway to their expiry, not every load.
+  if (used + FLAGS_hash_cache_persist_expiry / 2 < now) {
+    setDatabaseValue(
+        kFileHashes, persistedKey(key), persistedValue(key, hashes, now));
+  }
+  return true;
+}
+
+void FileHashCache::persist(const FileHashCacheKey& key,
+                            const MultiHashes& hashes) {
+  if (!databaseInitialized()) {
+    return;
+  }
+
+  // The first write of the process, and then every sweep interval, expires
+  // entries of files that are no longer hashed.
+  if (persisted_++ % kHashCachePersistSweep == 0) {
+    sweepPersisted();
+  }
+
+  setDatabaseValue(kFileHashes,
+                   persistedKey(key),
+                   persistedValue(key, hashes, getUnixTime()));
+}
+
+void FileHashCache::sweepPersisted() {
+  std::vector<std::string> keys;
+  if (!scanDatabaseKeys(kFileHashes, keys).ok()) {
+    return;
+  }
+
+  auto now = getUnixTime();
+  for (const auto& key : keys) {
+    std::string value;
+    if (!getDatabaseValue(kFileHashes, key, value).ok()) {
+      continue;
+    }
+
+    uint64_t used = 0;
+    if (!getPersistedUse(vsplit(value, ','), used) ||
+        isPersistedExpired(used, now)) {
+      deleteDatabaseValue(kFileHashes, key);
+    }
+  }
+}
+
+} // namespace osquery
+
+size_t std::hash<osquery::FileHashCacheKey>::operator()(
+    const osquery::FileHashCacheKey& key) const {
+  size_t seed = 0;
+  boost::hash_combine(seed, key.device);
+  boost::hash_combine(seed, key.inode);
+  boost::hash_combine(seed, key.size);
+  boost::hash_combine(seed, key.mtime);
+  boost::hash_combine(seed, key.ctime);
+  return seed;
+}
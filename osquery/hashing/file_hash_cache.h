@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/hashing/hashing.h>
+#include <osquery/utils/caches/lru.h>
+#include <osquery/utils/mutex.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/**
+ * @brief The identity of a file's content as observed through stat.
+ *
+ * Two stat results with an equal identity are assumed to describe the same
+ * content, which allows hard links and renamed files to share cache entries.
+ */
+struct FileHashCacheKey {
+  /// The device containing the file.
+  uint64_t device{0};
+
+  /// The file's serial or information number (inode).
+  uint64_t inode{0};
+
+  /// The file's size.
+  int64_t size{0};
+
+  /// The file's modification time, changes with a touch.
+  int64_t mtime{0};
+
+  /// The file's inode change time, changes with metadata updates.
+  int64_t ctime{0};
+
+  bool operator==(const FileHashCacheKey& other) const {
+    return device == other.device && inode == other.inode &&
+           size == other.size && mtime == other.mtime && ctime == other.ctime;
+  }
+};
+
+} // namespace osquery
+
+namespace std {
+template <>
+struct hash<osquery::FileHashCacheKey> {
+  size_t operator()(const osquery::FileHashCacheKey& key) const;
+};
+} // namespace std
+
+namespace osquery {
+
+/**
+ * @brief A process-wide, sharded cache of file content hashes.
+ *
+ * The cache is shared by the `hash` table, the file event subscribers and any
+ * other component that needs MD5/SHA1/SHA256 content hashes of files on disk.
+ * Entries are keyed by the (device, inode, size, mtime, ctime) identity so a
+ * hash is recalculated whenever a file changes.
+ *
+ * The keyspace is split into independently locked shards, each with an LRU
+ * eviction policy, so concurrent readers only contend when they land in the
+ * same shard. When `--hash_cache_persist` is enabled, computed hashes are
+ * also written to the backing store and used to warm the cache after a
+ * restart. Persisted entries not used within `--hash_cache_persist_expiry`
+ * are removed.
+ */
+class FileHashCache : private boost::noncopyable {
+ public:
+  /// Access the process-wide cache instance.
+  static FileHashCache& get();
+
+  /**
+   * @brief Create a cache with an explicit capacity and shard count.
+   *
+   * The process-wide instance is sized using `--hash_cache_max`, this
+   * constructor exists for tests and benchmarks.
+   *
+   * @param capacity the maximum number of entries across all shards.
+   * @param shards the number of independently locked shards.
+   */
+  FileHashCache(size_t capacity, size_t shards);
+
+  /**
+   * @brief Do-it-all access function.
+   *
+   * Stats the file at path, and if its identity is not present in the cache
+   * calculates the hashes and caches the result. Files larger than
+   * `--read_max` are not read and have empty hashes.
+   *
+   * @param path the path of file to hash.
+   * @param hashes stores the calculated hashes.
+   *
+   * @return failure if the file could not be stat-ed or read.
+   */
+  Status load(const std::string& path, MultiHashes& hashes);
+
+  /// Look up a file identity without hashing on a miss.
+  bool lookup(const FileHashCacheKey& key, MultiHashes& hashes);
+
+  /// Insert or replace the hashes for a file identity.
+  void insert(const FileHashCacheKey& key, const MultiHashes& hashes);
+
+  /// Drop every in-memory entry, the backing store is left untouched.
+  void clear();
+
+  /// The number of in-memory entries across all shards.
+  size_t size() const;
+
+ private:
+  struct Shard {
+    explicit Shard(size_t capacity) : entries(capacity) {}
+
+    Mutex mutex;
+    caches::LRU<FileHashCacheKey, MultiHashes> entries;
+  };
+
+  Shard& shardFor(const FileHashCacheKey& key) const;
+
+  /// Read a persisted entry into the in-memory cache.
+  bool loadPersisted(const FileHashCacheKey& key, MultiHashes& hashes);
+
+  /// Write an entry to the backing store.
+  void persist(const FileHashCacheKey& key, const MultiHashes& hashes);
+
+  /// Remove expired entries from the backing store.
+  void sweepPersisted();
+
+ private:
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  /// The number of entries written to the backing store.
+  std::atomic<size_t> persisted_{0};
+};
+
+} // namespace osquery
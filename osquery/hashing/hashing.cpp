@@ -8,14 +8,18 @@
  */
 
 #include <algorithm>
-#include <iomanip>
-#include <sstream>
-#include <unordered_map>
+#include <array>
+#include <memory>
 #include <vector>
 
-#include <openssl/md5.h>
-#include <openssl/sha.h>
+#ifndef WIN32
+#include <fcntl.h>
+#endif
 
+#include <openssl/evp.h>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/fileops.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/utils/base64.h>
@@ -24,12 +28,54 @@
 
 namespace osquery {
 
+DECLARE_uint64(read_max);
+
 /// The buffer read size from file IO to hashing structures.
-const size_t kHashChunkSize{4096};
+const size_t kHashChunkSize{256 * 1024};
+
+/// Hex characters used to render digests.
+const char kHexDigits[] = "0123456789abcdef";
+
+namespace {
+
+const EVP_MD* getDigest(HashType algorithm) {
+  switch (algorithm) {
+  case HASH_TYPE_MD5:
+    return EVP_md5();
+  case HASH_TYPE_SHA1:
+    return EVP_sha1();
+  case HASH_TYPE_SHA256:
+    return EVP_sha256();
+  }
+  return nullptr;
+}
+
+/// Hint to the kernel that the file will be read sequentially, once.
+void adviseSequential(const PlatformFile& file) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+  ::posix_fadvise(file.nativeHandle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+  ::fcntl(file.nativeHandle(), F_RDAHEAD, 1);
+#endif
+}
+
+/**
+ * @brief A per-thread read buffer reused across files.
+ *
+ * The buffer is allocated once per thread. Its size is a multiple of the
+ * page size, so every read starts at a page-aligned file offset. The buffer
+ * itself has no particular alignment, the reads are not O_DIRECT.
+ */
+char* getHashReadBuffer() {
+  thread_local std::unique_ptr<char[]> buffer(new char[kHashChunkSize]);
+  return buffer.get();
+}
+
+} // namespace
 
 Hash::~Hash() {
   if (ctx_ != nullptr) {
-    free(ctx_);
+    EVP_MD_CTX_free(ctx_);
   }
 }
 
@@ -38,57 +84,37 @@ Hash::Hash(HashType algorithm)
 
 Hash::Hash(HashType algorithm, HashEncodingType encoding)
     : algorithm_(algorithm), encoding_(encoding) {
-  if (algorithm_ == HASH_TYPE_MD5) {
-    length_ = MD5_DIGEST_LENGTH;
-    ctx_ = static_cast<MD5_CTX*>(malloc(sizeof(MD5_CTX)));
-    MD5_Init(static_cast<MD5_CTX*>(ctx_));
-  } else if (algorithm_ == HASH_TYPE_SHA1) {
-    length_ = SHA_DIGEST_LENGTH;
-    ctx_ = static_cast<SHA_CTX*>(malloc(sizeof(SHA_CTX)));
-    SHA1_Init(static_cast<SHA_CTX*>(ctx_));
-  } else if (algorithm_ == HASH_TYPE_SHA256) {
-    length_ = SHA256_DIGEST_LENGTH;
-    ctx_ = static_cast<SHA256_CTX*>(malloc(sizeof(SHA256_CTX)));
-    SHA256_Init(static_cast<SHA256_CTX*>(ctx_));
-  } else {
+  auto md = getDigest(algorithm_);
+  if (md == nullptr) {
     throw std::domain_error("Unknown hash function");
   }
+
+  length_ = static_cast<size_t>(EVP_MD_size(md));
+  ctx_ = EVP_MD_CTX_new();
+  if (ctx_ == nullptr || EVP_DigestInit_ex(ctx_, md, nullptr) != 1) {
+    throw std::runtime_error("Cannot initialize hash function");
+  }
 }
 
 void Hash::update(const void* buffer, size_t size) {
-  if (algorithm_ == HASH_TYPE_MD5) {
-    MD5_Update(static_cast<MD5_CTX*>(ctx_), buffer, size);
-  } else if (algorithm_ == HASH_TYPE_SHA1) {
-    SHA1_Update(static_cast<SHA_CTX*>(ctx_), buffer, size);
-  } else if (algorithm_ == HASH_TYPE_SHA256) {
-    SHA256_Update(static_cast<SHA256_CTX*>(ctx_), buffer, size);
-  }
+  EVP_DigestUpdate(ctx_, buffer, size);
 }
 
 std::string Hash::digest() {
-  std::vector<unsigned char> hash;
-  hash.assign(length_, '\0');
-
-  if (algorithm_ == HASH_TYPE_MD5) {
-    MD5_Final(hash.data(), static_cast<MD5_CTX*>(ctx_));
-  } else if (algorithm_ == HASH_TYPE_SHA1) {
-    SHA1_Final(hash.data(), static_cast<SHA_CTX*>(ctx_));
-  } else if (algorithm_ == HASH_TYPE_SHA256) {
-    SHA256_Final(hash.data(), static_cast<SHA256_CTX*>(ctx_));
-  }
+  std::array<unsigned char, EVP_MAX_MD_SIZE> hash{};
+  unsigned int hash_length = 0;
+  EVP_DigestFinal_ex(ctx_, hash.data(), &hash_length);
 
   if (encoding_ == HASH_ENCODING_TYPE_HEX) {
-    std::stringstream digest;
+    std::string digest(length_ * 2, '\0');
     for (size_t i = 0; i < length_; i++) {
-      digest << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+      digest[i * 2] = kHexDigits[hash[i] >> 4];
+      digest[i * 2 + 1] = kHexDigits[hash[i] & 0x0f];
     }
-    return digest.str();
+    return digest;
   } else if (encoding_ == HASH_ENCODING_TYPE_BASE64) {
-    std::stringstream digest;
-    for (size_t i = 0; i < length_; i++) {
-      digest << hash[i];
-    }
-    return base64::encode(digest.str());
+    return base64::encode(
+        std::string(reinterpret_cast<const char*>(hash.data()), length_));
   }
 
   return "";
@@ -103,40 +129,65 @@ std::string hashFromBuffer(HashType hash_type,
 }
 
 MultiHashes hashMultiFromFile(int mask, const std::string& path) {
-  std::map<HashType, std::shared_ptr<Hash>> hashes = {
-      {HASH_TYPE_MD5, std::make_shared<Hash>(HASH_TYPE_MD5)},
-      {HASH_TYPE_SHA1, std::make_shared<Hash>(HASH_TYPE_SHA1)},
-      {HASH_TYPE_SHA256, std::make_shared<Hash>(HASH_TYPE_SHA256)},
-  };
-
-  auto blocking = isPlatform(PlatformType::TYPE_WINDOWS);
-  auto s = readFile(path,
-                    0,
-                    kHashChunkSize,
-                    false,
-                    ([&hashes, &mask](std::string& buffer, size_t size) {
-                      for (auto& hash : hashes) {
-                        if (mask & hash.first) {
-                          hash.second->update(&buffer[0], size);
-                        }
-                      }
-                    }),
-                    blocking);
+  // Windows requires blocking reads to avoid overlapped IO.
+  int mode = PF_OPEN_EXISTING | PF_READ;
+  if (!isPlatform(PlatformType::TYPE_WINDOWS)) {
+    mode |= PF_NONBLOCK;
+  }
 
-  MultiHashes mh = {};
-  if (!s.ok()) {
-    return mh;
+  PlatformFile file(path, mode);
+  if (!file.isValid()) {
+    return {};
+  }
+
+  // Apply the max byte-read, special files are checked while reading.
+  auto read_max = FLAGS_read_max;
+  if (!file.isSpecialFile() && file.size() > read_max) {
+    return {};
   }
 
+#ifndef WIN32
+  adviseSequential(file);
+#endif
+
+  std::vector<std::unique_ptr<Hash>> hashes;
+  for (auto type : {HASH_TYPE_MD5, HASH_TYPE_SHA1, HASH_TYPE_SHA256}) {
+    hashes.push_back(mask & type ? std::make_unique<Hash>(type) : nullptr);
+  }
+
+  // Each block is read once and fed to every requested digest.
+  auto buffer = getHashReadBuffer();
+  uint64_t total_bytes = 0;
+  ssize_t part_bytes = 0;
+  do {
+    part_bytes = file.read(buffer, kHashChunkSize);
+    if (part_bytes > 0) {
+      total_bytes += static_cast<uint64_t>(part_bytes);
+      if (total_bytes > read_max) {
+        return {};
+      }
+      for (auto& hash : hashes) {
+        if (hash != nullptr) {
+          hash->update(buffer, static_cast<size_t>(part_bytes));
+        }
+      }
+    }
+  } while (part_bytes > 0);
+
+  if (part_bytes < 0) {
+    return {};
+  }
+
+  MultiHashes mh = {};
   mh.mask = mask;
   if (mask & HASH_TYPE_MD5) {
-    mh.md5 = hashes.at(HASH_TYPE_MD5)->digest();
+    mh.md5 = hashes[0]->digest();
   }
   if (mask & HASH_TYPE_SHA1) {
-    mh.sha1 = hashes.at(HASH_TYPE_SHA1)->digest();
+    mh.sha1 = hashes[1]->digest();
   }
   if (mask & HASH_TYPE_SHA256) {
-    mh.sha256 = hashes.at(HASH_TYPE_SHA256)->digest();
+    mh.sha256 = hashes[2]->digest();
   }
   return mh;
 }
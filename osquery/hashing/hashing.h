@@ -13,6 +13,8 @@
 
 #include <boost/noncopyable.hpp>
 
+struct evp_md_ctx_st;
+
 namespace osquery {
 
 /**
@@ -116,9 +118,9 @@ class Hash : private boost::noncopyable {
   /// The encoding type used to encode the digest.
   HashEncodingType encoding_;
 
-  /// The buffer used to maintain the context and state of the hashing
+  /// The OpenSSL EVP context used to maintain the state of the hashing
   /// operations
-  void* ctx_;
+  evp_md_ctx_st* ctx_{nullptr};
 
   /// The length of the hash to be returned
   size_t length_;
@@ -136,6 +138,9 @@ std::string hashFromFile(HashType hash_type, const std::string& path);
 /**
  * @brief Compute multiple hashes from a files contents simultaneously.
  *
+ * The file is read once, sequentially, in large blocks and each block is fed
+ * to every requested digest. Files larger than `--read_max` are not hashed.
+ *
  * @param mask Bitmask specifying target osquery-supported algorithms.
  * @param path Filesystem path (the hash target).
  * @return A struct containing string (hex) representations
@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/core/system.h>
+#include <osquery/database/database.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/hashing/file_hash_cache.h>
+#include <osquery/registry/registry_interface.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_uint64(read_max);
+DECLARE_bool(hash_cache_persist);
+
+namespace {
+const std::string kHelloMD5Digest("eb61eead90e3b899c6bcbe27ac581660");
+const std::string kWorldMD5Digest("361fadf1c712e812d198c4cab5712a79");
+} // namespace
+
+class FileHashCacheTests : public testing::Test {
+ protected:
+  fs::path test_working_dir_;
+
+  void SetUp() override {
+    initializeFilesystemAPILocale();
+
+    test_working_dir_ = fs::temp_directory_path() /
+                        fs::unique_path("osquery.test_working_dir.%%%%.%%%%");
+    fs::create_directories(test_working_dir_);
+  }
+
+  void TearDown() override {
+    fs::remove_all(test_working_dir_);
+  }
+
+  std::string writeFile(const std::string& name, const std::string& content) {
+    auto file_path = test_working_dir_ / name;
+    std::ofstream test_file(file_path.string(), std::ios::trunc);
+    test_file.write(content.c_str(), content.length());
+    test_file.close();
+    return file_path.string();
+  }
+};
+
+TEST_F(FileHashCacheTests, test_load_caches_hashes) {
+  auto path = writeFile("hello.txt", "HELLO");
+
+  FileHashCache cache(16, 4);
+  MultiHashes hashes;
+  ASSERT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_EQ(hashes.md5, kHelloMD5Digest);
+  EXPECT_EQ(cache.size(), 1U);
+
+  // A second load with an unchanged identity is served from the cache.
+  MultiHashes cached;
+  ASSERT_TRUE(cache.load(path, cached).ok());
+  EXPECT_EQ(cached.md5, kHelloMD5Digest);
+  EXPECT_EQ(cached.sha256, hashes.sha256);
+  EXPECT_EQ(cache.size(), 1U);
+}
+
+TEST_F(FileHashCacheTests, test_load_detects_changes) {
+  auto path = writeFile("hello.txt", "HELLO");
+
+  FileHashCache cache(16, 4);
+  MultiHashes hashes;
+  ASSERT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_EQ(hashes.md5, kHelloMD5Digest);
+
+  // Changing the size changes the identity even within the same second.
+  writeFile("hello.txt", "HELLO WORLD");
+  ASSERT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_EQ(hashes.md5, kWorldMD5Digest);
+}
+
+TEST_F(FileHashCacheTests, test_load_missing_file) {
+  FileHashCache cache(16, 4);
+  MultiHashes hashes;
+  auto status = cache.load((test_working_dir_ / "missing").string(), hashes);
+  EXPECT_FALSE(status.ok());
+  EXPECT_TRUE(hashes.md5.empty());
+  EXPECT_EQ(cache.size(), 0U);
+}
+
+TEST_F(FileHashCacheTests, test_load_over_read_max) {
+  auto path = writeFile("hello.txt", "HELLO");
+
+  // A file over the read limit is not hashed, which is not an error.
+  auto read_max = FLAGS_read_max;
+  FLAGS_read_max = 3;
+  FileHashCache cache(16, 4);
+  MultiHashes hashes;
+  EXPECT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_TRUE(hashes.md5.empty());
+  EXPECT_TRUE(hashes.sha256.empty());
+  EXPECT_EQ(cache.size(), 0U);
+
+  FLAGS_read_max = read_max;
+  ASSERT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_EQ(hashes.md5, kHelloMD5Digest);
+}
+
+TEST_F(FileHashCacheTests, test_persisted_expiry) {
+  platformSetup();
+  registryAndPluginInit();
+  initDatabasePluginForTesting();
+
+  // An entry last used at the epoch, and one in the previous format.
+  setDatabaseValue(kFileHashes, "0.1", "5,1,1,md5,sha1,sha256,0");
+  setDatabaseValue(kFileHashes, "0.2", "5,1,1,md5,sha1,sha256");
+
+  auto persist = FLAGS_hash_cache_persist;
+  FLAGS_hash_cache_persist = true;
+  auto path = writeFile("hello.txt", "HELLO");
+  {
+    FileHashCache cache(16, 4);
+    MultiHashes hashes;
+    ASSERT_TRUE(cache.load(path, hashes).ok());
+    EXPECT_EQ(hashes.md5, kHelloMD5Digest);
+  }
+
+  // The first write removed the expired entries.
+  std::vector<std::string> keys;
+  ASSERT_TRUE(scanDatabaseKeys(kFileHashes, keys).ok());
+  ASSERT_EQ(keys.size(), 1U);
+  EXPECT_NE(keys[0], "0.1");
+  EXPECT_NE(keys[0], "0.2");
+
+  // A restarted cache reuses the persisted entry.
+  FileHashCache cache(16, 4);
+  MultiHashes hashes;
+  ASSERT_TRUE(cache.load(path, hashes).ok());
+  EXPECT_EQ(hashes.md5, kHelloMD5Digest);
+  FLAGS_hash_cache_persist = persist;
+  deleteDatabaseValue(kFileHashes, keys[0]);
+}
+
+TEST_F(FileHashCacheTests, test_eviction_and_clear) {
+  FileHashCache cache(4, 1);
+  for (size_t i = 0; i < 8; ++i) {
+    FileHashCacheKey key;
+    key.inode = i;
+    cache.insert(key, MultiHashes{});
+  }
+  EXPECT_EQ(cache.size(), 4U);
+
+  MultiHashes hashes;
+  FileHashCacheKey evicted;
+  evicted.inode = 0;
+  EXPECT_FALSE(cache.lookup(evicted, hashes));
+
+  FileHashCacheKey recent;
+  recent.inode = 7;
+  EXPECT_TRUE(cache.lookup(recent, hashes));
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0U);
+}
+
+TEST_F(FileHashCacheTests, test_concurrent_load) {
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < 8; ++i) {
+    paths.push_back(writeFile("hello" + std::to_string(i) + ".txt", "HELLO"));
+  }
+
+  FileHashCache cache(64, 4);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> mismatches{0};
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &paths, &mismatches]() {
+      for (size_t round = 0; round < 16; ++round) {
+        for (const auto& path : paths) {
+          MultiHashes hashes;
+          if (!cache.load(path, hashes).ok() ||
+              hashes.md5 != kHelloMD5Digest) {
+            mismatches++;
+          }
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(mismatches, 0U);
+  EXPECT_EQ(cache.size(), paths.size());
+}
+
+} // namespace osquery
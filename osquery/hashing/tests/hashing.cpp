@@ -66,6 +66,54 @@ TEST_F(HashingFilesystemTests, test_multi_hashing_file) {
             kHelloSHA256Digest);
 }
 
+TEST_F(HashingFilesystemTests, test_multi_hashing_large_file) {
+  auto file_path = test_working_dir_ / "hashing_large_file.txt";
+
+  // Spans several read blocks and ends with a partial block.
+  std::ofstream test_file(file_path.string());
+  std::string line(1000, 'A');
+  for (size_t i = 0; i < 1000; i++) {
+    test_file << line << "\n";
+  }
+  test_file.close();
+
+  const auto mask = HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256;
+  const auto hashes = hashMultiFromFile(mask, file_path.string());
+
+  EXPECT_EQ(hashes.md5, "53a54a885f12972a527734a621cbc977");
+  EXPECT_EQ(hashes.sha1, "7c7c42e53710a88466c9534299aeb32018929c00");
+  EXPECT_EQ(
+      hashes.sha256,
+      "da3de4c6da194b70778d1a3dabe7636ed52dea9925cc791a38c0694ce38809a2");
+
+  // Only the requested digests are calculated.
+  const auto md5 = hashMultiFromFile(HASH_TYPE_MD5, file_path.string());
+  EXPECT_EQ(md5.md5, hashes.md5);
+  EXPECT_TRUE(md5.sha1.empty());
+  EXPECT_TRUE(md5.sha256.empty());
+}
+
+TEST_F(HashingFilesystemTests, test_multi_hashing_empty_file) {
+  auto file_path = test_working_dir_ / "hashing_empty_file.txt";
+  std::ofstream test_file(file_path.string());
+  test_file.close();
+
+  EXPECT_EQ(hashFromFile(HASH_TYPE_MD5, file_path.string()),
+            "d41d8cd98f00b204e9800998ecf8427e");
+}
+
+TEST_F(HashingFilesystemTests, test_multi_hashing_missing_file) {
+  auto file_path = test_working_dir_ / "missing.txt";
+  const auto hashes = hashMultiFromFile(HASH_TYPE_MD5, file_path.string());
+  EXPECT_TRUE(hashes.md5.empty());
+}
+
+TEST(HashingTests, test_hashing_base64) {
+  Hash hash(HASH_TYPE_MD5, HASH_ENCODING_TYPE_BASE64);
+  hash.update(kHelloString.c_str(), kHelloString.length());
+  EXPECT_EQ(hash.digest(), "62HurZDjuJnGvL4nrFgWYA==");
+}
+
 TEST(HashingTests, test_hashing_md5) {
   Hash hash(HASH_TYPE_MD5);
   hash.update(kHelloString.c_str(), kHelloString.length());
@@ -398,8 +398,12 @@ Status logString(const std::string& message,
 }
 
 namespace {
-const std::string kTotalQueryCounterMonitorPath("query.total.count");
+const monitoring::Metric& getTotalQueryCounter() {
+  static const monitoring::Metric counter("query.total.count",
+                                          monitoring::PreAggregationType::Sum);
+  return counter;
 }
+} // namespace
 
 Status logQueryLogItem(const QueryLogItem& results) {
   return logQueryLogItem(results, RegistryFactory::get().getActive("logger"));
@@ -412,8 +416,7 @@ Status logQueryLogItem(const QueryLogItem& results,
   }
 
   if (FLAGS_enable_numeric_monitoring) {
-    monitoring::record(
-        kTotalQueryCounterMonitorPath, 1, monitoring::PreAggregationType::Sum);
+    getTotalQueryCounter().record(1);
   }
 
   std::vector<std::string> json_items;
@@ -441,8 +444,7 @@ Status logSnapshotQuery(const QueryLogItem& item) {
   }
 
   if (FLAGS_enable_numeric_monitoring) {
-    monitoring::record(
-        kTotalQueryCounterMonitorPath, 1, monitoring::PreAggregationType::Sum);
+    getTotalQueryCounter().record(1);
   }
 
   std::vector<std::string> json_items;
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/core/flags.h>
+#include <osquery/numeric_monitoring/metric_shards.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+
+namespace osquery {
+
+DECLARE_bool(enable_numeric_monitoring);
+DECLARE_uint64(numeric_monitoring_pre_aggregation_time);
+
+static void enableMonitoring() {
+  FLAGS_enable_numeric_monitoring = true;
+  FLAGS_numeric_monitoring_pre_aggregation_time = 60;
+}
+
+static void NUMERIC_MONITORING_record_path(benchmark::State& state) {
+  enableMonitoring();
+  const std::string path = "benchmark.record.path";
+  while (state.KeepRunning()) {
+    monitoring::record(path, 1, monitoring::PreAggregationType::Sum);
+  }
+}
+
+BENCHMARK(NUMERIC_MONITORING_record_path)->ThreadRange(1, 8)->UseRealTime();
+
+static void NUMERIC_MONITORING_record_metric(benchmark::State& state) {
+  enableMonitoring();
+  static const monitoring::Metric metric("benchmark.record.metric",
+                                         monitoring::PreAggregationType::Sum);
+  while (state.KeepRunning()) {
+    metric.record(1);
+  }
+}
+
+BENCHMARK(NUMERIC_MONITORING_record_metric)->ThreadRange(1, 8)->UseRealTime();
+
+static void NUMERIC_MONITORING_take_points(benchmark::State& state) {
+  // Profile merging the accumulators of a thread with many metrics.
+  monitoring::MetricShards shards;
+  std::vector<monitoring::MetricShards::MetricId> ids;
+  for (int i = 0; i < state.range(0); ++i) {
+    ids.push_back(shards.registerMetric("benchmark.metric." + std::to_string(i),
+                                        monitoring::PreAggregationType::Max));
+  }
+
+  const auto now = monitoring::Clock::now();
+  while (state.KeepRunning()) {
+    for (auto id : ids) {
+      shards.record(id, monitoring::PreAggregationType::Max, 1, now);
+    }
+    benchmark::DoNotOptimize(shards.takePoints());
+  }
+}
+
+BENCHMARK(NUMERIC_MONITORING_take_points)->Arg(10)->Arg(1000);
+} // namespace osquery
@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+
+#include <osquery/numeric_monitoring/metric_shards.h>
+
+namespace osquery {
+
+namespace monitoring {
+
+namespace {
+
+/// Accumulators are allocated in chunks, the first time a thread uses one.
+const std::size_t kMetricChunkSize{64};
+const std::size_t kMaxMetricChunks{256};
+
+/// An accumulator without a value, this value cannot be accumulated.
+const ValueType kEmptyValue{std::numeric_limits<ValueType>::min()};
+
+std::atomic<std::uint64_t> kNextInstanceId{1};
+
+struct Accumulator {
+  std::atomic<ValueType> value{kEmptyValue};
+
+  /// The latest time point, as a count of clock ticks.
+  std::atomic<TimePoint::rep> time{0};
+};
+
+struct MetricChunk {
+  std::array<Accumulator, kMetricChunkSize> accumulators;
+};
+
+ValueType accumulate(PreAggregationType pre_aggregation,
+                     ValueType previous,
+                     ValueType value) {
+  if (previous == kEmptyValue) {
+    return value;
+  }
+
+  switch (pre_aggregation) {
+  case PreAggregationType::Min:
+    return std::min(previous, value);
+  case PreAggregationType::Max:
+    return std::max(previous, value);
+  default:
+    return previous + value;
+  }
+}
+
+} // namespace
+
+struct MetricShard {
+  ~MetricShard() {
+    for (auto& chunk : chunks) {
+      delete chunk.load();
+    }
+  }
+
+  /// Chunks are only allocated by the owning thread.
+  std::array<std::atomic<MetricChunk*>, kMaxMetricChunks> chunks{};
+
+  /// Set when the owning thread exits, the shard is removed once taken.
+  std::atomic<bool> retired{false};
+};
+
+namespace {
+
+/// The shards of the calling thread, for each MetricShards instance.
+struct ThreadShards {
+  ~ThreadShards() {
+    for (auto& shard : shards) {
+      shard.second->retired = true;
+    }
+  }
+
+  std::unordered_map<std::uint64_t, std::shared_ptr<MetricShard>> shards;
+
+  /// The last shard used, most threads record to a single instance.
+  std::uint64_t last_instance_id{0};
+  MetricShard* last{nullptr};
+};
+
+thread_local ThreadShards kThreadShards;
+
+} // namespace
+
+const MetricShards::MetricId MetricShards::kInvalidMetric{
+    std::numeric_limits<MetricShards::MetricId>::max()};
+
+const std::size_t MetricShards::kMaxMetrics{kMetricChunkSize *
+                                            kMaxMetricChunks};
+
+MetricShards::MetricShards() : instance_id_(kNextInstanceId++) {}
+
+bool MetricShards::isAccumulated(PreAggregationType pre_aggregation) {
+  return pre_aggregation == PreAggregationType::Sum ||
+         pre_aggregation == PreAggregationType::Min ||
+         pre_aggregation == PreAggregationType::Max;
+}
+
+MetricShards::MetricId MetricShards::registerMetric(
+    const std::string& path, PreAggregationType pre_aggregation) {
+  if (!isAccumulated(pre_aggregation)) {
+    return kInvalidMetric;
+  }
+
+  auto key = path + "." + to<std::string>(pre_aggregation);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = metrics_index_.find(key);
+  if (it != metrics_index_.end()) {
+    return it->second;
+  }
+
+  if (metrics_.size() >= kMaxMetrics) {
+    return kInvalidMetric;
+  }
+
+  auto id = metrics_.size();
+  metrics_.push_back({path, pre_aggregation});
+  metrics_index_.emplace(std::move(key), id);
+  return id;
+}
+
+MetricShard& MetricShards::getShard() {
+  auto& thread_shards = kThreadShards;
+  if (thread_shards.last_instance_id == instance_id_) {
+    return *thread_shards.last;
+  }
+
+  auto& shard = thread_shards.shards[instance_id_];
+  if (shard == nullptr) {
+    shard = std::make_shared<MetricShard>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.push_back(shard);
+  }
+
+  thread_shards.last_instance_id = instance_id_;
+  thread_shards.last = shard.get();
+  return *shard;
+}
+
+void MetricShards::record(MetricId id,
+                          PreAggregationType pre_aggregation,
+                          ValueType value,
+                          const TimePoint& time_point) {
+  if (id >= kMaxMetrics) {
+    return;
+  }
+
+  auto& chunk = getShard().chunks[id / kMetricChunkSize];
+  auto* accumulators = chunk.load(std::memory_order_acquire);
+  if (accumulators == nullptr) {
+    accumulators = new MetricChunk();
+    chunk.store(accumulators, std::memory_order_release);
+  }
+
+  // Only takePoints competes with the owning thread, the loops rarely retry.
+  auto& accumulator = accumulators->accumulators[id % kMetricChunkSize];
+  auto previous = accumulator.value.load(std::memory_order_relaxed);
+  while (!accumulator.value.compare_exchange_weak(
+      previous,
+      accumulate(pre_aggregation, previous, value),
+      std::memory_order_relaxed)) {
+  }
+
+  auto time = time_point.time_since_epoch().count();
+  auto latest = accumulator.time.load(std::memory_order_relaxed);
+  while (latest < time && !accumulator.time.compare_exchange_weak(
+                              latest, time, std::memory_order_relaxed)) {
+  }
+}
+
+std::vector<Point> MetricShards::takePoints() {
+  std::vector<Metric> metrics;
+  std::vector<std::shared_ptr<MetricShard>> shards;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    metrics = metrics_;
+    shards = shards_;
+    shards_.erase(std::remove_if(shards_.begin(),
+                                 shards_.end(),
+                                 [](const std::shared_ptr<MetricShard>& shard) {
+                                   return shard->retired.load();
+                                 }),
+                  shards_.end());
+  }
+
+  std::vector<ValueType> values(metrics.size(), kEmptyValue);
+  std::vector<TimePoint::rep> times(metrics.size(), 0);
+  for (const auto& shard : shards) {
+    for (std::size_t id = 0; id < metrics.size(); ++id) {
+      auto* accumulators = shard->chunks[id / kMetricChunkSize].load(
+          std::memory_order_acquire);
+      if (accumulators == nullptr) {
+        // Skip the whole chunk.
+        id += kMetricChunkSize - 1 - id % kMetricChunkSize;
+        continue;
+      }
+
+      auto& accumulator = accumulators->accumulators[id % kMetricChunkSize];
+      auto value = accumulator.value.exchange(kEmptyValue);
+      if (value == kEmptyValue) {
+        continue;
+      }
+      values[id] = accumulate(metrics[id].pre_aggregation, values[id], value);
+      times[id] = std::max(times[id], accumulator.time.exchange(0));
+    }
+  }
+
+  std::vector<Point> points;
+  for (std::size_t id = 0; id < metrics.size(); ++id) {
+    if (values[id] == kEmptyValue) {
+      continue;
+    }
+
+    // The time may have been taken with a previous value.
+    auto time_point = (times[id] == 0)
+                          ? Clock::now()
+                          : TimePoint(TimePoint::duration(times[id]));
+    points.emplace_back(
+        metrics[id].path, values[id], metrics[id].pre_aggregation, time_point);
+  }
+  return points;
+}
+
+std::size_t MetricShards::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return metrics_.size();
+}
+
+} // namespace monitoring
+} // namespace osquery
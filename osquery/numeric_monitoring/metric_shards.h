@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+#include <osquery/numeric_monitoring/pre_aggregation_cache.h>
+
+namespace osquery {
+
+namespace monitoring {
+
+/// The accumulators of a single thread, see MetricShards.
+struct MetricShard;
+
+/**
+ * Thread-local accumulators for registered metrics.
+ *
+ * Adding a point to the PreAggregationCache takes a mutex shared by every
+ * recording thread, and hashes the point's path. Metrics are instead
+ * registered once with their path and a Sum, Min or Max pre-aggregation.
+ * Recording then updates an accumulator owned by the recording thread,
+ * without taking locks or allocating memory.
+ *
+ * The accumulators of every thread are merged when the points are taken.
+ */
+class MetricShards final : private boost::noncopyable {
+ public:
+  using MetricId = std::size_t;
+
+  /// The identifier of a metric that cannot be accumulated.
+  static const MetricId kInvalidMetric;
+
+  /// The maximum number of registered metrics.
+  static const std::size_t kMaxMetrics;
+
+  MetricShards();
+
+  /// Check if points of a pre-aggregation type can be accumulated.
+  static bool isAccumulated(PreAggregationType pre_aggregation);
+
+  /**
+   * Register a metric.
+   *
+   * The same path and pre-aggregation type always return the same identifier.
+   * Returns kInvalidMetric if the type cannot be accumulated, or if too many
+   * metrics were registered.
+   */
+  MetricId registerMetric(const std::string& path,
+                          PreAggregationType pre_aggregation);
+
+  /// Accumulate a value, using the type the metric was registered with.
+  void record(MetricId id,
+              PreAggregationType pre_aggregation,
+              ValueType value,
+              const TimePoint& time_point);
+
+  /// Merge and reset the accumulators of every thread.
+  std::vector<Point> takePoints();
+
+  /// The number of registered metrics.
+  std::size_t size() const;
+
+ private:
+  struct Metric {
+    std::string path;
+    PreAggregationType pre_aggregation;
+  };
+
+  /// The calling thread's shard, created on the first call.
+  MetricShard& getShard();
+
+ private:
+  /// Identifies this instance within thread-local storage.
+  const std::uint64_t instance_id_;
+
+  /// Registered metrics, indexed by identifier.
+  std::vector<Metric> metrics_;
+  std::unordered_map<std::string, MetricId> metrics_index_;
+
+  /// The shards of every thread that recorded a point.
+  std::vector<std::shared_ptr<MetricShard>> shards_;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace monitoring
+} // namespace osquery
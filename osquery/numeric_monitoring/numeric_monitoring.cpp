@@ -14,6 +14,7 @@
 #include <osquery/core/flags.h>
 #include <osquery/dispatcher/dispatcher.h>
 #include <osquery/logger/logger.h>
+#include <osquery/numeric_monitoring/metric_shards.h>
 #include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/numeric_monitoring/plugin_interface.h>
 #include <osquery/numeric_monitoring/pre_aggregation_cache.h>
@@ -104,6 +105,12 @@ namespace {
 class FlusherIsScheduled {};
 FlusherIsScheduled schedule();
 
+/// Metrics may be registered during static initialization, before flags.
+MetricShards& getMetricShards() {
+  static MetricShards shards;
+  return shards;
+}
+
 class PreAggregationBuffer final {
  public:
   static PreAggregationBuffer& get() {
@@ -126,6 +133,13 @@ class PreAggregationBuffer final {
     }
   }
 
+  void recordAccumulated(std::size_t id,
+                         const ValueType& value,
+                         const PreAggregationType& pre_aggregation,
+                         const TimePoint& time_point) {
+    getMetricShards().record(id, pre_aggregation, value, time_point);
+  }
+
   void flush() {
     auto points = takeCachedPoints();
     for (const auto& pt : points) {
@@ -136,7 +150,11 @@ class PreAggregationBuffer final {
 
  private:
   std::vector<Point> takeCachedPoints() {
+    auto accumulated = getMetricShards().takePoints();
     std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& point : accumulated) {
+      cache_.addPoint(std::move(point));
+    }
     auto points = cache_.takePoints();
     return points;
   }
@@ -206,5 +224,26 @@ void record(const std::string& path,
       path, value, pre_aggregation, sync, std::move(time_point));
 }
 
+Metric::Metric(std::string path, PreAggregationType pre_aggregation)
+    : path_(std::move(path)),
+      pre_aggregation_(pre_aggregation),
+      id_(getMetricShards().registerMetric(path_, pre_aggregation)) {}
+
+void Metric::record(ValueType value,
+                    const bool sync,
+                    TimePoint time_point) const {
+  if (!FLAGS_enable_numeric_monitoring) {
+    return;
+  }
+
+  auto& buffer = PreAggregationBuffer::get();
+  if (id_ == MetricShards::kInvalidMetric || sync ||
+      0 == FLAGS_numeric_monitoring_pre_aggregation_time) {
+    buffer.record(path_, value, pre_aggregation_, sync, time_point);
+  } else {
+    buffer.recordAccumulated(id_, value, pre_aggregation_, time_point);
+  }
+}
+
 } // namespace monitoring
 } // namespace osquery
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <string>
 
 #include "osquery/utils/conversions/tryto.h"
@@ -89,6 +90,45 @@ void record(const std::string& path,
             const bool sync = false,
             TimePoint time_point = Clock::now());
 
+/**
+ * @brief A metric registered once, to record points without building paths.
+ *
+ * Points of Sum, Min and Max metrics are pre-aggregated by accumulators owned
+ * by the recording thread, recording does not take locks or allocate memory.
+ * The accumulators are merged when the pre-aggregation buffer is flushed.
+ * Points of other metrics, or synchronous points, are recorded by path.
+ *
+ * Common way to use it:
+ * @code{.cpp}
+ * static const monitoring::Metric kQueries(
+ *     "query.total.count", monitoring::PreAggregationType::Sum);
+ * kQueries.record(1);
+ * @endcode
+ */
+class Metric {
+ public:
+  Metric() = default;
+
+  /// Register the metric, paths of accumulated metrics should be bounded.
+  Metric(std::string path, PreAggregationType pre_aggregation);
+
+  /// Record a new point, @see monitoring::record.
+  void record(ValueType value,
+              const bool sync = false,
+              TimePoint time_point = Clock::now()) const;
+
+  const std::string& path() const {
+    return path_;
+  }
+
+ private:
+  std::string path_;
+  PreAggregationType pre_aggregation_{PreAggregationType::None};
+
+  /// The accumulators identifier, or an invalid identifier.
+  std::size_t id_{static_cast<std::size_t>(-1)};
+};
+
 /**
  * Force flush the pre-aggregation buffer.
  * Please use it, only when it's totally necessary.
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/numeric_monitoring/metric_shards.h>
+
+namespace osquery {
+
+using monitoring::MetricShards;
+using monitoring::PreAggregationType;
+
+GTEST_TEST(MetricShards, register_metric) {
+  MetricShards shards;
+  auto sum = shards.registerMetric("test.path", PreAggregationType::Sum);
+  EXPECT_NE(sum, MetricShards::kInvalidMetric);
+  EXPECT_EQ(sum, shards.registerMetric("test.path", PreAggregationType::Sum));
+
+  // The same path may be pre-aggregated with a different type.
+  auto max = shards.registerMetric("test.path", PreAggregationType::Max);
+  EXPECT_NE(max, MetricShards::kInvalidMetric);
+  EXPECT_NE(max, sum);
+  EXPECT_EQ(shards.size(), 2U);
+
+  // Points of other types are not pre-aggregated.
+  EXPECT_EQ(shards.registerMetric("test.path", PreAggregationType::Avg),
+            MetricShards::kInvalidMetric);
+  EXPECT_EQ(shards.registerMetric("test.path", PreAggregationType::None),
+            MetricShards::kInvalidMetric);
+}
+
+GTEST_TEST(MetricShards, take_points) {
+  MetricShards shards;
+  auto sum = shards.registerMetric("test.sum", PreAggregationType::Sum);
+  auto min = shards.registerMetric("test.min", PreAggregationType::Min);
+  auto max = shards.registerMetric("test.max", PreAggregationType::Max);
+  shards.registerMetric("test.unused", PreAggregationType::Sum);
+
+  const auto now = monitoring::Clock::now();
+  const auto later = now + std::chrono::seconds(1);
+  for (auto value : {5, -2, 9}) {
+    shards.record(sum, PreAggregationType::Sum, value, now);
+    shards.record(min, PreAggregationType::Min, value, now);
+    shards.record(max, PreAggregationType::Max, value, later);
+  }
+
+  auto points = shards.takePoints();
+  ASSERT_EQ(points.size(), 3U);
+  EXPECT_EQ(points[0].path_, "test.sum");
+  EXPECT_EQ(points[0].value_, 12);
+  EXPECT_EQ(points[0].time_point_, now);
+  EXPECT_EQ(points[1].path_, "test.min");
+  EXPECT_EQ(points[1].value_, -2);
+  EXPECT_EQ(points[2].path_, "test.max");
+  EXPECT_EQ(points[2].value_, 9);
+  EXPECT_EQ(points[2].time_point_, later);
+  EXPECT_EQ(points[2].pre_aggregation_type_, PreAggregationType::Max);
+
+  // The accumulators are reset when taken.
+  EXPECT_TRUE(shards.takePoints().empty());
+  shards.record(sum, PreAggregationType::Sum, 0, now);
+  points = shards.takePoints();
+  ASSERT_EQ(points.size(), 1U);
+  EXPECT_EQ(points[0].value_, 0);
+}
+
+GTEST_TEST(MetricShards, concurrent_record) {
+  MetricShards shards;
+  auto sum = shards.registerMetric("test.sum", PreAggregationType::Sum);
+  auto max = shards.registerMetric("test.max", PreAggregationType::Max);
+
+  const size_t kThreads = 4;
+  const size_t kPoints = 10000;
+  const auto now = monitoring::Clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&shards, sum, max, now, i]() {
+      for (size_t j = 0; j < kPoints; ++j) {
+        shards.record(sum, PreAggregationType::Sum, 1, now);
+      }
+      shards.record(max, PreAggregationType::Max, static_cast<int>(i), now);
+    });
+  }
+
+  // Points taken while threads record are not lost.
+  monitoring::ValueType total = 0;
+  auto points = shards.takePoints();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& taken : {points, shards.takePoints()}) {
+    for (const auto& point : taken) {
+      if (point.path_ == "test.sum") {
+        total += point.value_;
+      }
+    }
+  }
+  EXPECT_EQ(total, static_cast<monitoring::ValueType>(kThreads * kPoints));
+
+  // Shards of exited threads are merged, then released.
+  shards.record(max, PreAggregationType::Max, -1, now);
+  points = shards.takePoints();
+  ASSERT_EQ(points.size(), 1U);
+  EXPECT_EQ(points[0].value_, -1);
+}
+
+} // namespace osquery
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <thread>
+
 #include <gtest/gtest.h>
 
 #include <boost/filesystem.hpp>
@@ -138,6 +140,61 @@ TEST_F(NumericMonitoringTests, record_with_buffer) {
   Dispatcher::joinServices();
 }
 
+TEST_F(NumericMonitoringTests, record_with_metric) {
+  const auto isEnabled = FLAGS_enable_numeric_monitoring;
+  const auto plugins = FLAGS_numeric_monitoring_plugins;
+  const auto pre_aggregation_time =
+      FLAGS_numeric_monitoring_pre_aggregation_time;
+
+  FLAGS_enable_numeric_monitoring = true;
+  FLAGS_numeric_monitoring_plugins = kNameForTestPlugin;
+  FLAGS_numeric_monitoring_pre_aggregation_time = 1;
+
+  auto status = RegistryFactory::get().setActive(
+      monitoring::registryName(), FLAGS_numeric_monitoring_plugins);
+  ASSERT_TRUE(status.ok());
+
+  monitoring::flush();
+  NumericMonitoringInMemoryTestPlugin::points.clear();
+
+  const auto monitoring_path = "some.metric.to.heaven";
+  const monitoring::Metric metric(monitoring_path,
+                                  monitoring::PreAggregationType::Sum);
+  metric.record(monitoring::ValueType{83});
+  std::thread([&metric]() { metric.record(monitoring::ValueType{88}); })
+      .join();
+
+  // Points recorded by path are pre-aggregated with the metric's points.
+  monitoring::record(monitoring_path,
+                     monitoring::ValueType{93},
+                     monitoring::PreAggregationType::Sum);
+  monitoring::flush();
+
+  ASSERT_EQ(1, NumericMonitoringInMemoryTestPlugin::points.size());
+  EXPECT_EQ(monitoring_path,
+            NumericMonitoringInMemoryTestPlugin::points.back().at(
+                monitoring::recordKeys().path));
+  auto valueInStr = NumericMonitoringInMemoryTestPlugin::points.back().at(
+      monitoring::recordKeys().value);
+  EXPECT_EQ(83 + 88 + 93, std::stoll(valueInStr));
+
+  // Metrics which are not pre-aggregated record each point.
+  NumericMonitoringInMemoryTestPlugin::points.clear();
+  const monitoring::Metric average(monitoring_path,
+                                   monitoring::PreAggregationType::Avg);
+  average.record(monitoring::ValueType{1});
+  average.record(monitoring::ValueType{2});
+  monitoring::flush();
+  EXPECT_EQ(2, NumericMonitoringInMemoryTestPlugin::points.size());
+
+  FLAGS_enable_numeric_monitoring = isEnabled;
+  FLAGS_numeric_monitoring_plugins = plugins;
+  FLAGS_numeric_monitoring_pre_aggregation_time = pre_aggregation_time;
+
+  Dispatcher::stopServices();
+  Dispatcher::joinServices();
+}
+
 TEST_F(NumericMonitoringTests, record_without_buffer) {
   const auto isEnabled = FLAGS_enable_numeric_monitoring;
   const auto plugins = FLAGS_numeric_monitoring_plugins;
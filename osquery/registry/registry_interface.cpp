@@ -14,6 +14,7 @@
 
 namespace osquery {
 void RegistryInterface::removeUnsafe(const std::string& item_name) {
+  generation_++;
   if (items_.count(item_name) > 0) {
     items_[item_name]->tearDown();
     items_.erase(item_name);
@@ -67,6 +68,12 @@ size_t RegistryInterface::count() const {
   return items_.size();
 }
 
+size_t RegistryInterface::generation() const {
+  ReadLock lock(mutex_);
+
+  return generation_;
+}
+
 Status RegistryInterface::setActive(const std::string& item_name) {
   UpgradeLock lock(mutex_);
 
@@ -177,6 +184,7 @@ Status RegistryInterface::addAlias(const std::string& item_name,
     return Status::failure("Duplicate alias: " + alias);
   }
   aliases_[alias] = item_name;
+  generation_++;
   return Status::success();
 }
 
@@ -200,6 +208,7 @@ Status RegistryInterface::addPlugin(const std::string& plugin_name,
 
   plugin_item->setName(plugin_name);
   items_.emplace(std::make_pair(plugin_name, plugin_item));
+  generation_++;
 
   // The item can be listed as internal, meaning it does not broadcast.
   if (internal) {
@@ -261,6 +270,7 @@ Status RegistryInterface::addExternal(const RouteUUID& uuid,
     {
       WriteLock wlock(mutex_);
       routes_[route.first] = route.second;
+      generation_++;
     }
 
     auto status = addExternalPlugin(route.first, route.second);
@@ -301,6 +311,7 @@ void RegistryInterface::removeExternal(const RouteUUID& uuid) {
       external_.erase(item);
       routes_.erase(item);
     }
+    generation_++;
   }
 }
 
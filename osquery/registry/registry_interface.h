@@ -90,6 +90,14 @@ class RegistryInterface : private boost::noncopyable {
   /// Facility method to list the registry item identifiers.
   std::vector<std::string> names() const;
 
+  /**
+   * @brief A counter incremented whenever items or aliases change.
+   *
+   * Consumers caching information derived from the registry items, such as
+   * table schemas, compare generations to detect stale information.
+   */
+  size_t generation() const;
+
   /**
    * @brief Allow a plugin to perform some setup functions when osquery starts.
    *
@@ -230,6 +238,9 @@ class RegistryInterface : private boost::noncopyable {
   /// be directed to the 'active' plugin.
   std::string active_;
 
+  /// Incremented whenever items, aliases or external routes change.
+  size_t generation_{0};
+
   /// Protect concurrent accesses to object's data
   mutable Mutex mutex_;
 
@@ -10,6 +10,7 @@
 #include <benchmark/benchmark.h>
 
 #include <osquery/core/core.h>
+#include <osquery/core/table_results_cache.h>
 #include <osquery/core/tables.h>
 #include <osquery/registry/registry.h>
 #include <osquery/sql/sql.h>
@@ -18,6 +19,8 @@
 
 namespace osquery {
 
+DECLARE_bool(memoize_table_probes);
+
 class BenchmarkTablePlugin : public TablePlugin {
  protected:
   TableColumns columns() const {
@@ -151,6 +154,30 @@ static void SQL_virtual_table_internal_unique(benchmark::State& state) {
 
 BENCHMARK(SQL_virtual_table_internal_unique);
 
+static void SQL_virtual_table_attach_all(benchmark::State& state) {
+  // Profile creating a connection, which attaches every registered table.
+  while (state.KeepRunning()) {
+    auto dbc = SQLiteDBManager::getUnique();
+    benchmark::DoNotOptimize(dbc);
+  }
+}
+
+BENCHMARK(SQL_virtual_table_attach_all);
+
+static void SQL_virtual_table_attach_all_query(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("benchmark", std::make_shared<BenchmarkTablePlugin>());
+
+  // Profile an isolated query connection, referencing a single table.
+  while (state.KeepRunning()) {
+    auto dbc = SQLiteDBManager::getUnique();
+    QueryData results;
+    queryInternal("select * from benchmark", results, dbc);
+  }
+}
+
+BENCHMARK(SQL_virtual_table_attach_all_query);
+
 class BenchmarkLongTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const {
@@ -190,6 +217,85 @@ static void SQL_virtual_table_internal_long(benchmark::State& state) {
 
 BENCHMARK(SQL_virtual_table_internal_long);
 
+/// A table scanning every process for each call, like process_open_sockets.
+class BenchmarkProbeTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const {
+    return {
+        std::make_tuple("pid", INTEGER_TYPE, ColumnOptions::INDEX),
+        std::make_tuple("socket", TEXT_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  TableRows generate(QueryContext& ctx) {
+    auto pids = ctx.constraints["pid"].getAll<int>(EQUALS);
+
+    TableRows results;
+    for (int pid = 0; pid < 1000; pid++) {
+      auto socket = "socket:[" + std::to_string(pid) + "]";
+      benchmark::DoNotOptimize(socket);
+      if (pids.empty() || pids.count(pid) > 0) {
+        results.push_back(make_table_row(
+            {{"pid", INTEGER(pid)}, {"socket", std::move(socket)}}));
+      }
+    }
+    return results;
+  }
+};
+
+static void SQL_virtual_table_in_list(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("probe_benchmark",
+              std::make_shared<BenchmarkProbeTablePlugin>());
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("probe_benchmark", dbc, false);
+
+  std::string query = "select * from probe_benchmark where pid in (0";
+  for (int64_t pid = 1; pid < state.range(0); pid++) {
+    query += ", " + std::to_string(pid);
+  }
+  query += ")";
+
+  while (state.KeepRunning()) {
+    QueryData results;
+    queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+  }
+}
+
+BENCHMARK(SQL_virtual_table_in_list)->Arg(50)->Arg(500);
+
+/// JOIN the table against rows sharing 50 pids, like sockets of processes.
+static void SQL_virtual_table_join_probes(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("probe_benchmark",
+              std::make_shared<BenchmarkProbeTablePlugin>());
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("probe_benchmark", dbc, false);
+
+  auto query =
+      "with recursive probes(v) as (select 0 union all select v + 1 from "
+      "probes where v + 1 < " +
+      std::to_string(state.range(0)) +
+      ") select * from probes join probe_benchmark on "
+      "probe_benchmark.pid = probes.v % 50";
+
+  auto memoize_table_probes = FLAGS_memoize_table_probes;
+  FLAGS_memoize_table_probes = (state.range(1) != 0);
+  while (state.KeepRunning()) {
+    QueryData results;
+    queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+  }
+  FLAGS_memoize_table_probes = memoize_table_probes;
+}
+
+BENCHMARK(SQL_virtual_table_join_probes)
+    ->ArgPair(500, 0)
+    ->ArgPair(500, 1);
+
 size_t kWideCount{0};
 
 class BenchmarkWideTablePlugin : public TablePlugin {
@@ -284,6 +390,48 @@ BENCHMARK(SQL_virtual_table_internal_wide_yield)
     ->ArgPair(0, 100)
     ->ArgPair(0, 1000);
 
+/// Generate wide rows similar to the results of a large cacheable table.
+static TableRows generateWideRows(size_t count) {
+  TableRows results;
+  for (size_t k = 0; k < count; k++) {
+    auto r = make_table_row();
+    for (size_t i = 0; i < 20; i++) {
+      r["test_" + std::to_string(i)] = "value_" + std::to_string(k);
+    }
+    results.push_back(std::move(r));
+  }
+  return results;
+}
+
+/// The previous results cache: deserializing rows stored as JSON.
+static void SQL_table_results_cache_json(benchmark::State& state) {
+  auto rows = generateWideRows(static_cast<size_t>(state.range(0)));
+  std::string content;
+  serializeTableRowsJSON(rows, content);
+
+  while (state.KeepRunning()) {
+    TableRows cached;
+    deserializeTableRowsJSON(content, cached);
+    benchmark::DoNotOptimize(cached);
+  }
+}
+
+BENCHMARK(SQL_table_results_cache_json)->Arg(10)->Arg(1000)->Arg(10000);
+
+static void SQL_table_results_cache_shared(benchmark::State& state) {
+  TableResultsCache cache(size_t{1} << 30);
+  auto rows = generateWideRows(static_cast<size_t>(state.range(0)));
+  cache.insert("benchmark", "", 0, 60, rows);
+
+  while (state.KeepRunning()) {
+    TableRows cached;
+    cache.lookup("benchmark", "", 0, cached);
+    benchmark::DoNotOptimize(cached);
+  }
+}
+
+BENCHMARK(SQL_table_results_cache_shared)->Arg(10)->Arg(1000)->Arg(10000);
+
 static void SQL_select_metadata(benchmark::State& state) {
   auto dbc = SQLiteDBManager::getUnique();
   while (state.KeepRunning()) {
@@ -100,13 +100,15 @@ int DynamicTableRow::get_column(sqlite3_context* ctx,
         pVtab->content->columns[pVtab->content->aliases.at(column_name)]);
   }
 
+  // Rows may be shared between cursors, a missing column is read as empty
+  // without inserting it into the row.
+  static const std::string kMissingValue;
+  auto value_it = row.find(column_name);
+  const auto& value =
+      (value_it != row.end()) ? value_it->second : kMissingValue;
+
   // Attempt to cast each xFilter-populated row/column to the SQLite type.
-  const auto& value = row[column_name];
-  if (this->row.count(column_name) == 0) {
-    // Missing content.
-    VLOG(1) << "Error " << column_name << " is empty";
-    sqlite3_result_null(ctx);
-  } else if (type == TEXT_TYPE || type == BLOB_TYPE) {
+  if (type == TEXT_TYPE || type == BLOB_TYPE) {
     sqlite3_result_text(
         ctx, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
   } else if (value.empty() &&
@@ -157,6 +159,16 @@ Status DynamicTableRow::serialize(JSON& doc, rj::Value& obj) const {
   return Status::success();
 }
 
+size_t DynamicTableRow::getMemorySize() const {
+  size_t size = sizeof(*this);
+  for (const auto& column : row) {
+    // Account for the map node as well as both strings.
+    size += sizeof(column) + 4 * sizeof(void*) + column.first.capacity() +
+            column.second.capacity();
+  }
+  return size;
+}
+
 TableRowHolder DynamicTableRow::clone() const {
   Row new_row = row;
   return TableRowHolder(new DynamicTableRow(std::move(new_row)));
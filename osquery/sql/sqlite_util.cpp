@@ -421,6 +421,9 @@ void SQLiteDBInstance::clearAffectedTables() {
     table.second->cache.clear();
     table.second->colsUsed.clear();
     table.second->colsUsedBitsets.clear();
+    table.second->limits.clear();
+    table.second->inLists.clear();
+    table.second->probes.clear();
   }
   // Since the affected tables are cleared, there are no more affected tables.
   // There is no concept of compounding tables between queries.
@@ -7,12 +7,18 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <atomic>
+#include <set>
+
 #include <gtest/gtest.h>
 
 #include <osquery/core/core.h>
+#include <osquery/core/query_resources.h>
 #include <osquery/core/system.h>
+#include <osquery/core/table_results_cache.h>
 #include <osquery/database/database.h>
 #include <osquery/logger/logger.h>
+#include <osquery/process/process.h>
 #include <osquery/registry/registry.h>
 #include <osquery/sql/dynamic_table_row.h>
 #include <osquery/sql/sql.h>
@@ -22,6 +28,7 @@
 namespace osquery {
 
 DECLARE_bool(ignore_table_exceptions);
+DECLARE_bool(memoize_table_probes);
 
 class VirtualTableTests : public testing::Test {
  public:
@@ -249,6 +256,74 @@ TEST_F(VirtualTableTests, test_sqlite3_table_joins) {
   ASSERT_EQ(results.size(), 1U);
 }
 
+class lazyTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    column_requests++;
+    return {
+        std::make_tuple("x", INTEGER_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  std::vector<std::string> aliases() const override {
+    return {"lazy_alias"};
+  }
+
+ public:
+  TableRows generate(QueryContext&) override {
+    TableRows tr;
+    tr.push_back(make_table_row({{"x", "1"}}));
+    return tr;
+  }
+
+  static std::atomic<size_t> column_requests;
+};
+
+std::atomic<size_t> lazyTablePlugin::column_requests{0};
+
+TEST_F(VirtualTableTests, test_sqlite3_lazy_attach) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("lazy", std::make_shared<lazyTablePlugin>());
+
+  // Tables are not created when the connection is created.
+  auto dbc = SQLiteDBManager::getUnique();
+  QueryData results;
+  auto status = queryInternal(
+      "SELECT count(*) AS c FROM sqlite_temp_master WHERE name = 'lazy'",
+      results,
+      dbc);
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["c"], "0");
+
+  // The table, and its alias, are connected when first referenced.
+  results.clear();
+  status = queryInternal("SELECT x FROM lazy", results, dbc);
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["x"], "1");
+
+  results.clear();
+  status = queryInternal("SELECT x FROM lazy_alias", results, dbc);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(results.size(), 1U);
+
+  // Further connections reuse the parsed schema.
+  auto requests = lazyTablePlugin::column_requests.load();
+  auto other = SQLiteDBManager::getUnique();
+  results.clear();
+  status = queryInternal("SELECT x FROM lazy", results, other);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(results.size(), 1U);
+  EXPECT_EQ(lazyTablePlugin::column_requests.load(), requests);
+
+  // A detached table is no longer connected.
+  EXPECT_TRUE(detachTableInternal("lazy", other).ok());
+  results.clear();
+  status = queryInternal("SELECT x FROM lazy", results, other);
+  EXPECT_FALSE(status.ok());
+}
+
 class pTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -512,8 +587,9 @@ class tableCacheTablePlugin : public TablePlugin {
   }
 
   TableRows generate(QueryContext& ctx) override {
-    if (isCached(60, ctx)) {
-      return getCache();
+    TableRows cached;
+    if (getCache(60, ctx, cached)) {
+      return cached;
     }
 
     generates_++;
@@ -592,6 +668,84 @@ TEST_F(VirtualTableTests, test_table_results_cache) {
   EXPECT_EQ(results.size(), 1U);
   // The table should NOT have used the cache.
   EXPECT_EQ(cache->generates_, 5U);
+
+  // The same constraints share the results cached for them.
+  results.clear();
+  queryInternal(statement, results, dbc);
+  EXPECT_EQ(results.size(), 1U);
+  EXPECT_EQ(cache->generates_, 5U);
+
+  // While different constraints are cached separately.
+  results.clear();
+  statement = "SELECT * from table_cache where i = '2';";
+  queryInternal(statement, results, dbc);
+  EXPECT_EQ(results.size(), 0U);
+  EXPECT_EQ(cache->generates_, 6U);
+
+  // Constraints on columns not passed to generate share the results.
+  results.clear();
+  statement = "SELECT * from table_cache where d = '';";
+  queryInternal(statement, results, dbc);
+  EXPECT_EQ(results.size(), 1U);
+  EXPECT_EQ(cache->generates_, 6U);
+}
+
+TEST_F(VirtualTableTests, test_table_results_cache_shared_rows) {
+  TableResultsCache cache(1 << 20);
+
+  TableRows rows;
+  rows.push_back(make_table_row({{"i", "1"}, {"d", "one"}}));
+  rows.push_back(make_table_row({{"i", "2"}, {"d", "two"}}));
+  cache.insert("shared", "", 10, 5, rows);
+
+  // The generated rows remain usable after they are moved into the cache.
+  ASSERT_EQ(rows.size(), 2U);
+  EXPECT_EQ(static_cast<Row>(*rows[1]).at("d"), "two");
+  EXPECT_EQ(cache.size(), 1U);
+  EXPECT_GT(cache.bytes(), 0U);
+
+  // Fresh results are returned within the interval, and by fingerprint.
+  TableRows cached;
+  EXPECT_FALSE(cache.lookup("shared", "i=1", 10, cached));
+  EXPECT_FALSE(cache.lookup("shared", "", 15, cached));
+  EXPECT_TRUE(cache.contains("shared", "", 14));
+  EXPECT_TRUE(cache.lookup("shared", "", 14, cached));
+  ASSERT_EQ(cached.size(), 2U);
+  EXPECT_EQ(static_cast<Row>(*cached[0]).at("i"), "1");
+
+  // Clones and evicted results keep referencing the shared rows.
+  auto clone = cached[0]->clone();
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0U);
+  EXPECT_EQ(static_cast<Row>(*clone).at("d"), "one");
+}
+
+TEST_F(VirtualTableTests, test_table_results_cache_eviction) {
+  TableRows rows;
+  rows.push_back(make_table_row({{"d", std::string(1024, 'A')}}));
+  size_t row_size = rows[0]->clone()->getMemorySize();
+
+  // Room for two of the single-row results.
+  TableResultsCache cache(row_size * 2);
+  for (const auto& table : {"first", "second", "third"}) {
+    TableRows results;
+    results.push_back(rows[0]->clone());
+    cache.insert(table, "", 0, 60, results);
+  }
+
+  // The least recently used results were evicted.
+  EXPECT_EQ(cache.size(), 2U);
+  EXPECT_LE(cache.bytes(), row_size * 2);
+  EXPECT_FALSE(cache.contains("first", "", 0));
+  EXPECT_TRUE(cache.contains("third", "", 0));
+
+  // Results larger than the cache are not cached at all.
+  TableResultsCache small(row_size / 2);
+  TableRows results;
+  results.push_back(rows[0]->clone());
+  small.insert("large", "", 0, 60, results);
+  EXPECT_EQ(small.size(), 0U);
+  EXPECT_EQ(results.size(), 1U);
 }
 
 TEST_F(VirtualTableTests, test_table_results_cache_colcheck) {
@@ -675,6 +829,54 @@ TEST_F(VirtualTableTests, test_yield_generator) {
   EXPECT_EQ(results[0]["index"], "10");
 }
 
+class slowTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("x", INTEGER_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    sleepFor(5);
+    TableRows results;
+    auto r = make_table_row();
+    r["x"] = INTEGER(1);
+    results.push_back(std::move(r));
+    return results;
+  }
+};
+
+TEST_F(VirtualTableTests, test_table_resource_accounting) {
+  auto table_registry = RegistryFactory::get().registry("table");
+  table_registry->add("slow", std::make_shared<slowTablePlugin>());
+  table_registry->add("yield_accounting", std::make_shared<yieldTablePlugin>());
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("slow", dbc, false);
+  attachTableInternal("yield_accounting", dbc, false);
+
+  QueryData results;
+  QueryResourceAccounting accounting;
+  auto status = queryInternal(
+      "SELECT * FROM slow, yield_accounting", results, dbc);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(results.size(), 10U);
+
+  const auto& usage = accounting.stop();
+  ASSERT_EQ(usage.table_time_us.count("slow"), 1U);
+  EXPECT_GE(usage.table_time_us.at("slow"), 5000U);
+  EXPECT_EQ(usage.table_time_us.count("yield_accounting"), 1U);
+  EXPECT_GE(usage.wall_time_ms, 5U);
+
+  // Tables are not timed once the accounting is stopped.
+  results.clear();
+  queryInternal("SELECT * FROM slow", results, dbc);
+  EXPECT_EQ(usage.table_time_us.size(), 2U);
+  EXPECT_GE(usage.getGenerateTimeMs(), 5U);
+}
+
 class likeTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -1226,4 +1428,407 @@ TEST_F(VirtualTableTests, test_table_exceptions) {
   FLAGS_ignore_table_exceptions = backup_flag;
 }
 
+class limitPushdownTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, ColumnOptions::INDEX),
+        std::make_tuple("name", TEXT_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  TableAttributes attributes() const override {
+    return TableAttributes::LIMIT_PUSHDOWN;
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    limit = context.limit;
+
+    auto ids = context.constraints["id"].getAll<int>(EQUALS);
+    TableRows results;
+    for (int id = 0; id < 10; ++id) {
+      if (context.limit && results.size() >= *context.limit) {
+        break;
+      }
+      if (!ids.empty() && ids.count(id) == 0) {
+        continue;
+      }
+      results.push_back(make_table_row(
+          {{"id", INTEGER(id)}, {"name", (id % 2 == 0) ? "even" : "odd"}}));
+    }
+    return results;
+  }
+
+  /// The limit of the last generate call.
+  boost::optional<size_t> limit;
+
+ private:
+  FRIEND_TEST(VirtualTableTests, test_limit_pushdown);
+};
+
+TEST_F(VirtualTableTests, test_limit_pushdown) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto limited = std::make_shared<limitPushdownTablePlugin>();
+  tables->add("limited", limited);
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("limited", dbc, false);
+
+  {
+    // The table generates the skipped OFFSET rows.
+    QueryData results;
+    auto status =
+        queryInternal("SELECT * FROM limited LIMIT 2 OFFSET 1", results, dbc);
+    EXPECT_TRUE(status.ok());
+    ASSERT_EQ(results.size(), 2U);
+    EXPECT_EQ(results[0]["id"], "1");
+    ASSERT_TRUE(limited->limit.is_initialized());
+    EXPECT_EQ(*limited->limit, 3U);
+  }
+
+  {
+    QueryData results;
+    auto status = queryInternal(
+        "SELECT * FROM limited WHERE id = 4 LIMIT 1", results, dbc);
+    EXPECT_TRUE(status.ok());
+    ASSERT_EQ(results.size(), 1U);
+    EXPECT_EQ(results[0]["id"], "4");
+    ASSERT_TRUE(limited->limit.is_initialized());
+    EXPECT_EQ(*limited->limit, 1U);
+  }
+
+  {
+    // SQLite filters the name, the table must generate every row.
+    QueryData results;
+    auto status = queryInternal(
+        "SELECT * FROM limited WHERE name = 'odd' LIMIT 2", results, dbc);
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(results.size(), 2U);
+    EXPECT_FALSE(limited->limit.is_initialized());
+  }
+
+  {
+    // SQLite sorts the rows, the table must generate every row.
+    QueryData results;
+    auto status = queryInternal(
+        "SELECT * FROM limited ORDER BY id DESC LIMIT 2", results, dbc);
+    EXPECT_TRUE(status.ok());
+    ASSERT_EQ(results.size(), 2U);
+    EXPECT_EQ(results[0]["id"], "9");
+    EXPECT_FALSE(limited->limit.is_initialized());
+  }
+}
+
+class inListTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, ColumnOptions::INDEX),
+    };
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    scans++;
+
+    auto ids = context.constraints["id"].getAll<int>(EQUALS);
+    last_ids = ids;
+    TableRows results;
+    for (int id = 0; id < 10; ++id) {
+      if (ids.empty() || ids.count(id) > 0) {
+        results.push_back(make_table_row({{"id", INTEGER(id)}}));
+      }
+    }
+    return results;
+  }
+
+  size_t scans{0};
+  std::set<int> last_ids;
+
+ private:
+  FRIEND_TEST(VirtualTableTests, test_in_list_constraints);
+};
+
+TEST_F(VirtualTableTests, test_in_list_constraints) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto in_list = std::make_shared<inListTablePlugin>();
+  tables->add("in_list", in_list);
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("in_list", dbc, false);
+
+  // Every value of the IN operator is filtered with a single scan.
+  QueryData results;
+  queryInternal(
+      "SELECT * FROM in_list WHERE id IN (1, 3, 5, 11)", results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(in_list->scans, 1U);
+  EXPECT_EQ(results, makeResult("id", {"1", "3", "5"}));
+
+  // An empty value is skipped, the other values are still constraints.
+  in_list->scans = 0;
+  results.clear();
+  queryInternal("SELECT * FROM in_list WHERE id IN ('', 2)", results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(in_list->scans, 1U);
+  EXPECT_EQ(in_list->last_ids, std::set<int>({2}));
+  EXPECT_EQ(results, makeResult("id", {"2"}));
+
+  // Each probe of a JOIN is a scan, unless repeated probes are memoized.
+  const std::string join =
+      "SELECT in_list.id FROM (SELECT 1 AS v UNION ALL SELECT 1 UNION ALL "
+      "SELECT 2 UNION ALL SELECT 1) AS probes JOIN in_list ON in_list.id = "
+      "probes.v";
+  in_list->scans = 0;
+  results.clear();
+  queryInternal(join, results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(in_list->scans, 4U);
+  EXPECT_EQ(results, makeResult("id", {"1", "1", "2", "1"}));
+
+  auto memoize_table_probes = FLAGS_memoize_table_probes;
+  FLAGS_memoize_table_probes = true;
+  in_list->scans = 0;
+  results.clear();
+  queryInternal(join, results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(in_list->scans, 2U);
+  EXPECT_EQ(results, makeResult("id", {"1", "1", "2", "1"}));
+
+  // Memoized results do not outlive the query.
+  results.clear();
+  queryInternal(join, results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(in_list->scans, 4U);
+  FLAGS_memoize_table_probes = memoize_table_probes;
+}
+
+class inListMatchesTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("name", TEXT_TYPE, ColumnOptions::INDEX),
+    };
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    TableRows results;
+    for (const auto& name : {"alpha", "beta", "charlie"}) {
+      if (context.constraints["name"].notExistsOrMatches(name)) {
+        results.push_back(make_table_row({{"name", name}}));
+      }
+    }
+    return results;
+  }
+};
+
+TEST_F(VirtualTableTests, test_in_list_constraints_matches) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("in_list_matches", std::make_shared<inListMatchesTablePlugin>());
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("in_list_matches", dbc, false);
+
+  // Tables filtering with matches() return a row for every value of an IN.
+  QueryData results;
+  queryInternal(
+      "SELECT * FROM in_list_matches WHERE name IN ('alpha', 'charlie')",
+      results,
+      dbc);
+  EXPECT_EQ(results, makeResult("name", {"alpha", "charlie"}));
+
+  // An empty value does not discard the other values.
+  results.clear();
+  queryInternal(
+      "SELECT * FROM in_list_matches WHERE name IN ('', 'beta')", results, dbc);
+  EXPECT_EQ(results, makeResult("name", {"beta"}));
+}
+
+class costTablePlugin : public TablePlugin {
+ public:
+  costTablePlugin(TableCost table_cost, ColumnOptions options)
+      : table_cost_(std::move(table_cost)), options_(options) {}
+
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, options_),
+        std::make_tuple("digest", TEXT_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  TableCost cost() const override {
+    return table_cost_;
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    auto ids = context.constraints["id"].getAll<int>(EQUALS);
+    if (ids.empty()) {
+      scans++;
+    }
+
+    TableRows results;
+    for (int id = 1; id <= 5; ++id) {
+      if (ids.empty() || ids.count(id) > 0) {
+        results.push_back(
+            make_table_row({{"id", INTEGER(id)}, {"digest", "digest"}}));
+      }
+    }
+    return results;
+  }
+
+  /// The number of generate calls without an id constraint.
+  size_t scans{0};
+
+ private:
+  TableCost table_cost_;
+  ColumnOptions options_;
+
+ private:
+  FRIEND_TEST(VirtualTableTests, test_table_cost_hints);
+};
+
+TEST_F(VirtualTableTests, test_table_cost_hints) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto dbc = SQLiteDBManager::getUnique();
+
+  TableCost processes_cost;
+  processes_cost.rows = 500;
+  processes_cost.row_cost = 10;
+  auto processes =
+      std::make_shared<costTablePlugin>(processes_cost, ColumnOptions::INDEX);
+  tables->add("cost_processes", processes);
+  attachTableInternal("cost_processes", dbc, false);
+
+  TableCost sockets_cost;
+  sockets_cost.rows = 2000;
+  sockets_cost.row_cost = 10;
+  auto sockets =
+      std::make_shared<costTablePlugin>(sockets_cost, ColumnOptions::INDEX);
+  tables->add("cost_sockets", sockets);
+  attachTableInternal("cost_sockets", dbc, false);
+
+  TableCost hash_cost;
+  hash_cost.rows = 1;
+  hash_cost.row_cost = 10;
+  hash_cost.columns["digest"] = 1000;
+  auto hash = std::make_shared<costTablePlugin>(
+      hash_cost, ColumnOptions::INDEX | ColumnOptions::REQUIRED);
+  tables->add("cost_hash", hash);
+  attachTableInternal("cost_hash", dbc, false);
+
+  auto reset = [&processes, &sockets, &hash]() {
+    processes->scans = 0;
+    sockets->scans = 0;
+    hash->scans = 0;
+  };
+
+  // The table with fewer expected rows drives the JOIN, in either order.
+  for (const auto& query : {
+           "SELECT * FROM cost_sockets JOIN cost_processes USING (id)",
+           "SELECT * FROM cost_processes JOIN cost_sockets USING (id)",
+       }) {
+    reset();
+    QueryData results;
+    queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+    EXPECT_EQ(results.size(), 5U) << query;
+    EXPECT_EQ(processes->scans, 1U) << query;
+    EXPECT_EQ(sockets->scans, 0U) << query;
+  }
+
+  // An expensive table with a required column is only probed.
+  for (const auto& query : {
+           "SELECT s.id, h.digest FROM cost_hash h JOIN cost_sockets s "
+           "USING (id)",
+           "SELECT p.id, h.digest FROM cost_processes p, cost_sockets s, "
+           "cost_hash h WHERE h.id = s.id AND s.id = p.id",
+       }) {
+    reset();
+    QueryData results;
+    queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+    EXPECT_EQ(results.size(), 5U) << query;
+    EXPECT_EQ(hash->scans, 0U) << query;
+  }
+
+  // Without a JOIN the hints do not change the results.
+  reset();
+  QueryData results;
+  queryInternal("SELECT * FROM cost_processes WHERE id > 2", results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(results.size(), 3U);
+  EXPECT_EQ(processes->scans, 1U);
+}
+
+class columnGroupsTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("name", TEXT_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("digest", TEXT_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+ public:
+  ColumnGroups columnGroups() const override {
+    return {{"digest", UsedColumnsBitset(1ULL << 2)}};
+  }
+
+  TableRows generate(QueryContext& context) override {
+    context.columnGroups = columnGroups();
+
+    TableRows results;
+    for (int id = 1; id <= 3; ++id) {
+      auto r = make_table_row({{"id", INTEGER(id)}, {"name", "name"}});
+      if (context.isColumnGroupUsed("digest")) {
+        lookups++;
+        r["digest"] = "digest";
+      }
+      results.push_back(std::move(r));
+    }
+    return results;
+  }
+
+  /// The number of digest lookups.
+  size_t lookups{0};
+};
+
+TEST_F(VirtualTableTests, test_column_groups) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto dbc = SQLiteDBManager::getUnique();
+  auto table = std::make_shared<columnGroupsTablePlugin>();
+  tables->add("column_groups", table);
+  attachTableInternal("column_groups", dbc, false);
+
+  // The group's lookup is skipped if none of its columns is used.
+  QueryData results;
+  queryInternal("SELECT id, name FROM column_groups", results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(results.size(), 3U);
+  EXPECT_EQ(table->lookups, 0U);
+
+  for (const auto& query : {
+           "SELECT * FROM column_groups",
+           "SELECT id, digest FROM column_groups",
+           "SELECT id FROM column_groups WHERE digest = 'digest'",
+       }) {
+    table->lookups = 0;
+    results.clear();
+    queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+    EXPECT_EQ(results.size(), 3U) << query;
+    EXPECT_EQ(table->lookups, 3U) << query;
+  }
+
+  // Unknown groups, and groups of tables without any, are always used.
+  QueryContext context;
+  context.colsUsedBitset = UsedColumnsBitset(1);
+  EXPECT_TRUE(context.isColumnGroupUsed("digest"));
+  context.columnGroups = table->columnGroups();
+  EXPECT_FALSE(context.isColumnGroupUsed("digest"));
+  EXPECT_TRUE(context.isColumnGroupUsed("unknown"));
+}
+
 } // namespace osquery
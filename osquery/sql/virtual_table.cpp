@@ -7,12 +7,15 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
 #include <unordered_set>
 
 #include <osquery/core/core.h>
 #include <osquery/core/flagalias.h>
 #include <osquery/core/flags.h>
+#include <osquery/core/query_resources.h>
 #include <osquery/core/system.h>
 #include <osquery/logger/logger.h>
 #include <osquery/process/process.h>
@@ -44,6 +47,11 @@ FLAG(bool,
      "Ignore exceptions thrown by tables. osquery and extensions default to "
      "true.");
 
+FLAG(bool,
+     memoize_table_probes,
+     false,
+     "Reuse table results for repeated constraint values within a query");
+
 SHELL_FLAG(bool, planner, false, "Enable osquery runtime planner output");
 
 DECLARE_bool(disable_events);
@@ -119,6 +127,217 @@ TableList extension_table_list;
 std::unordered_map<std::string, struct sqlite3_module> sqlite_module_map;
 Mutex sqlite_module_map_mutex;
 
+/// A table schema parsed from its plugin's column details.
+struct VirtualTableSchema {
+  /// The statement declaring the table, including HIDDEN column aliases.
+  std::string statement;
+
+  /// Table columns, followed by column aliases.
+  TableColumns columns;
+
+  /// Column aliases to the index of their target column.
+  std::map<std::string, size_t> aliases;
+
+  /// Table attributes, passed to the SQL and optional Query for inspection.
+  TableAttributes attributes{TableAttributes::NONE};
+
+  /// Table cost hints, passed to the planner.
+  TableCost cost;
+
+  /// Table aliases, attached as views or modules.
+  std::set<std::string> views;
+};
+
+using VirtualTableSchemaRef = std::shared_ptr<const VirtualTableSchema>;
+
+/**
+ * @brief The table schemas parsed for a generation of the table registry.
+ *
+ * Each connection used to request and parse the column details of every
+ * table. The schemas are parsed once and shared by connections until the
+ * table registry changes.
+ */
+class TableSchemaCache final {
+ public:
+  VirtualTableSchemaRef get(const std::string& name, size_t generation) const {
+    ReadLock lock(mutex_);
+
+    if (generation != generation_) {
+      return nullptr;
+    }
+    auto schema = schemas_.find(name);
+    return (schema == schemas_.end()) ? nullptr : schema->second;
+  }
+
+  void insert(const std::string& name,
+              size_t generation,
+              VirtualTableSchemaRef schema) {
+    WriteLock lock(mutex_);
+
+    if (generation < generation_) {
+      // The registry changed while the schema was parsed.
+      return;
+    } else if (generation > generation_) {
+      schemas_.clear();
+      generation_ = generation;
+    }
+
+    for (const auto& view : schema->views) {
+      views_[view] = name;
+    }
+    schemas_[name] = std::move(schema);
+  }
+
+  /// Parse a table's schema again, its plugin is replaced or attached again.
+  void erase(const std::string& name) {
+    WriteLock lock(mutex_);
+
+    schemas_.erase(name);
+  }
+
+  /// Resolve a table alias to its table name.
+  std::string getTableName(const std::string& name) const {
+    ReadLock lock(mutex_);
+
+    auto view = views_.find(name);
+    return (view == views_.end()) ? name : view->second;
+  }
+
+ private:
+  std::unordered_map<std::string, VirtualTableSchemaRef> schemas_;
+
+  /// Table aliases to table names, kept across generations.
+  std::unordered_map<std::string, std::string> views_;
+
+  size_t generation_{0};
+  mutable Mutex mutex_;
+};
+
+TableSchemaCache table_schemas;
+
+void parseTableSchema(const PluginResponse& response,
+                      bool is_extension,
+                      VirtualTableSchema& schema) {
+  for (const auto& column : response) {
+    auto cid = column.find("id");
+    if (cid == column.end()) {
+      // This does not define a column type.
+      continue;
+    }
+
+    auto cname = column.find("name");
+    auto ctype = column.find("type");
+    if (cid->second == "column" && cname != column.end() &&
+        ctype != column.end()) {
+      // This is a malformed column definition.
+      // Populate the virtual table specific persistent column information.
+      auto options = ColumnOptions::DEFAULT;
+      auto cop = column.find("op");
+      if (cop != column.end()) {
+        auto op = tryTo<long>(cop->second);
+        if (op) {
+          options = static_cast<ColumnOptions>(op.take());
+        }
+      }
+
+      if (is_extension && FLAGS_extensions_default_index) {
+        if (ColumnOptions::DEFAULT == options) {
+          options = ColumnOptions::INDEX;
+        } else {
+          // The extension is effected by extensions_default_index.
+          // Consider adding a deprecation warning (#6035).
+        }
+      }
+
+      schema.columns.push_back(std::make_tuple(
+          cname->second, columnTypeName(ctype->second), options));
+    } else if (cid->second == "alias") {
+      // Create associated views for table aliases.
+      auto calias = column.find("alias");
+      if (calias != column.end()) {
+        schema.views.insert(calias->second);
+      }
+    } else if (cid->second == "columnAlias" && cname != column.end()) {
+      auto ctarget = column.find("target");
+      if (ctarget == column.end()) {
+        continue;
+      }
+
+      // Record the column in the set of columns.
+      // This is required because SQLITE uses indexes to identify columns.
+      // Use an UNKNOWN_TYPE as a pseudo-mask, since the type does not matter.
+      schema.columns.push_back(
+          std::make_tuple(cname->second, UNKNOWN_TYPE, ColumnOptions::HIDDEN));
+      // Record a mapping of the requested column alias name.
+      size_t target_index = 0;
+      for (size_t i = 0; i < schema.columns.size(); i++) {
+        const auto& target_column = schema.columns[i];
+        if (std::get<0>(target_column) == ctarget->second) {
+          target_index = i;
+          break;
+        }
+      }
+      schema.aliases[cname->second] = target_index;
+    } else if (cid->second == "attributes") {
+      auto cattr = column.find("attributes");
+      // Store the attributes locally so they may be passed to the SQL object.
+      if (cattr != column.end()) {
+        auto attr = tryTo<long>(cattr->second);
+        if (attr) {
+          schema.attributes = static_cast<TableAttributes>(attr.take());
+        }
+      }
+    } else if (cid->second == "cost") {
+      auto crows = column.find("rows");
+      if (crows != column.end()) {
+        schema.cost.rows = tryTo<uint64_t>(crows->second).takeOr(uint64_t{0});
+      }
+      auto crow_cost = column.find("row_cost");
+      if (crow_cost != column.end()) {
+        schema.cost.row_cost =
+            tryTo<uint64_t>(crow_cost->second).takeOr(uint64_t{0});
+      }
+    } else if (cid->second == "columnCost" && cname != column.end()) {
+      auto ccost = column.find("cost");
+      if (ccost != column.end()) {
+        schema.cost.columns[cname->second] =
+            tryTo<uint64_t>(ccost->second).takeOr(uint64_t{0});
+      }
+    }
+  }
+}
+
+/// Get the parsed schema of a table, requesting its column details once.
+VirtualTableSchemaRef getTableSchema(const std::string& name) {
+  auto generation = RegistryFactory::get().registry("table")->generation();
+  auto schema = table_schemas.get(name, generation);
+  if (schema != nullptr) {
+    return schema;
+  }
+
+  // Create a TablePlugin Registry call, expect column details as the response.
+  PluginResponse response;
+  auto status =
+      Registry::call("table", name, {{"action", "columns"}}, response);
+  if (!status.ok() || response.size() == 0) {
+    return nullptr;
+  }
+
+  // Tables implemented from extensions can be made read/write if they implement
+  // the correct methods
+  bool is_extension = extension_table_list.contains(name);
+
+  // Generate an SQL create table statement from the retrieved column details.
+  // This call to columnDefinition requests column aliases (as HIDDEN columns).
+  auto parsed = std::make_shared<VirtualTableSchema>();
+  parsed->statement =
+      "CREATE TABLE " + name + columnDefinition(response, true, is_extension);
+  parseTableSchema(response, is_extension, *parsed);
+
+  table_schemas.insert(name, generation, parsed);
+  return parsed;
+}
+
 bool getColumnValue(std::string& value,
                     size_t index,
                     size_t argc,
@@ -349,6 +568,9 @@ int xDestroy(sqlite3_vtab* p) {
 int xNext(sqlite3_vtab_cursor* cur) {
   BaseCursor* pCur = (BaseCursor*)cur;
   if (pCur->uses_generator) {
+    // Generators produce rows lazily, account for each resumption.
+    auto* pVtab = (VirtualTable*)cur->pVtab;
+    TableResourceScope scope(pVtab->content->name);
     pCur->generator->operator()();
     if (*pCur->generator) {
       pCur->current = pCur->generator->get();
@@ -560,127 +782,45 @@ int xCreate(sqlite3* db,
     return SQLITE_NOMEM;
   }
 
-  auto* pVtab = new VirtualTable;
-  pVtab->base = {};
-  pVtab->content = std::make_shared<VirtualTableContent>();
-  pVtab->instance = (SQLiteDBInstance*)pAux;
-
-  // Create a TablePlugin Registry call, expect column details as the response.
-  PluginResponse response;
-  pVtab->content->name = std::string(argv[0]);
-  const auto& name = pVtab->content->name;
-
-  // Get the table column information.
-  auto status =
-      Registry::call("table", name, {{"action", "columns"}}, response);
-  if (!status.ok() || response.size() == 0) {
-    delete pVtab;
+  // Lazily attached table aliases are modules named after the alias.
+  auto name = table_schemas.getTableName(argv[0]);
+  auto schema = getTableSchema(name);
+  if (schema == nullptr) {
     return SQLITE_ERROR;
   }
 
-  // Tables implemented from extensions can be made read/write if they implement
-  // the correct methods
-  bool is_extension = extension_table_list.contains(name);
-
-  // Generate an SQL create table statement from the retrieved column details.
-  // This call to columnDefinition requests column aliases (as HIDDEN columns).
-  auto statement =
-      "CREATE TABLE " + name + columnDefinition(response, true, is_extension);
-
-  int rc = sqlite3_declare_vtab(db, statement.c_str());
-  if (rc != SQLITE_OK || !status.ok() || response.size() == 0) {
+  int rc = sqlite3_declare_vtab(db, schema->statement.c_str());
+  if (rc != SQLITE_OK) {
     LOG(ERROR) << "Error creating virtual table: " << name << " (" << rc
                << "): " << getStringForSQLiteReturnCode(rc);
 
-    VLOG(1) << "Cannot create virtual table using: " << statement;
-    delete pVtab;
-    return (rc != SQLITE_OK) ? rc : SQLITE_ERROR;
+    VLOG(1) << "Cannot create virtual table using: " << schema->statement;
+    return rc;
   }
 
-  // Tables may request aliases as views.
-  std::set<std::string> views;
+  auto* pVtab = new VirtualTable;
+  pVtab->base = {};
+  pVtab->content = std::make_shared<VirtualTableContent>();
+  pVtab->instance = (SQLiteDBInstance*)pAux;
 
   // Keep a local copy of the column details in the VirtualTableContent struct.
   // This allows introspection into the column type without additional calls.
-  for (const auto& column : response) {
-    auto cid = column.find("id");
-    if (cid == column.end()) {
-      // This does not define a column type.
-      continue;
-    }
-
-    auto cname = column.find("name");
-    auto ctype = column.find("type");
-    if (cid->second == "column" && cname != column.end() &&
-        ctype != column.end()) {
-      // This is a malformed column definition.
-      // Populate the virtual table specific persistent column information.
-      auto options = ColumnOptions::DEFAULT;
-      auto cop = column.find("op");
-      if (cop != column.end()) {
-        auto op = tryTo<long>(cop->second);
-        if (op) {
-          options = static_cast<ColumnOptions>(op.take());
-        }
-      }
-
-      if (is_extension && FLAGS_extensions_default_index) {
-        if (ColumnOptions::DEFAULT == options) {
-          options = ColumnOptions::INDEX;
-        } else {
-          // The extension is effected by extensions_default_index.
-          // Consider adding a deprecation warning (#6035).
-        }
-      }
-
-      pVtab->content->columns.push_back(std::make_tuple(
-          cname->second, columnTypeName(ctype->second), options));
-    } else if (cid->second == "alias") {
-      // Create associated views for table aliases.
-      auto calias = column.find("alias");
-      if (calias != column.end()) {
-        views.insert(calias->second);
-      }
-    } else if (cid->second == "columnAlias" && cname != column.end()) {
-      auto ctarget = column.find("target");
-      if (ctarget == column.end()) {
-        continue;
-      }
-
-      // Record the column in the set of columns.
-      // This is required because SQLITE uses indexes to identify columns.
-      // Use an UNKNOWN_TYPE as a pseudo-mask, since the type does not matter.
-      pVtab->content->columns.push_back(
-          std::make_tuple(cname->second, UNKNOWN_TYPE, ColumnOptions::HIDDEN));
-      // Record a mapping of the requested column alias name.
-      size_t target_index = 0;
-      for (size_t i = 0; i < pVtab->content->columns.size(); i++) {
-        const auto& target_column = pVtab->content->columns[i];
-        if (std::get<0>(target_column) == ctarget->second) {
-          target_index = i;
-          break;
-        }
-      }
-      pVtab->content->aliases[cname->second] = target_index;
-    } else if (cid->second == "attributes") {
-      auto cattr = column.find("attributes");
-      // Store the attributes locally so they may be passed to the SQL object.
-      if (cattr != column.end()) {
-        auto attr = tryTo<long>(cattr->second);
-        if (attr) {
-          pVtab->content->attributes =
-              static_cast<TableAttributes>(attr.take());
-        }
-      }
+  pVtab->content->name = name;
+  pVtab->content->columns = schema->columns;
+  pVtab->content->aliases = schema->aliases;
+  pVtab->content->attributes = schema->attributes;
+  pVtab->content->cost = schema->cost;
+
+  // Create the requested 'aliases' for tables created by attachTableInternal.
+  // Eponymous tables are connected while a statement is prepared, their
+  // aliases are attached as modules instead.
+  if (argc > 1 && argv[1] != nullptr && std::string(argv[1]) == "temp") {
+    for (const auto& view : schema->views) {
+      auto statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
+      sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
     }
   }
 
-  // Create the requested 'aliases'.
-  for (const auto& view : views) {
-    statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
-    sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
-  }
-
   *ppVtab = (sqlite3_vtab*)pVtab;
   return rc;
 }
@@ -712,6 +852,90 @@ static inline bool sensibleComparison(ColumnType type, unsigned char op) {
   return true;
 }
 
+static inline bool isLimitConstraint(unsigned char op) {
+  return op == SQLITE_INDEX_CONSTRAINT_LIMIT ||
+         op == SQLITE_INDEX_CONSTRAINT_OFFSET;
+}
+
+/**
+ * @brief Consume the ORDER BY, LIMIT and OFFSET of a query.
+ *
+ * Only tables with the LIMIT_PUSHDOWN attribute are considered. Event-based
+ * tables generate rows from a time-ordered index, they can order rows by
+ * time. A LIMIT is only consumed when SQLite does not need to sort the rows,
+ * and when the table filters every constraint it received.
+ */
+static LimitPushdown consumeLimit(const VirtualTableContent& content,
+                                  sqlite3_index_info* pIdxInfo,
+                                  bool filters_constraints,
+                                  size_t& expr_index) {
+  LimitPushdown limit;
+  if ((content.attributes & TableAttributes::LIMIT_PUSHDOWN) == 0) {
+    return limit;
+  }
+
+  bool ordered = (pIdxInfo->nOrderBy == 0);
+  if (pIdxInfo->nOrderBy == 1 &&
+      (content.attributes & TableAttributes::EVENT_BASED) != 0) {
+    const auto& order_by = pIdxInfo->aOrderBy[0];
+    if (order_by.iColumn >= 0 &&
+        static_cast<size_t>(order_by.iColumn) < content.columns.size() &&
+        std::get<0>(content.columns[order_by.iColumn]) == "time") {
+      limit.order.push_back({"time", order_by.desc != 0});
+      pIdxInfo->orderByConsumed = 1;
+      ordered = true;
+    }
+  }
+
+  if (!ordered || !filters_constraints) {
+    return limit;
+  }
+
+  // The values are passed to xFilter after the column constraints.
+  for (size_t i = 0; i < static_cast<size_t>(pIdxInfo->nConstraint); ++i) {
+    const auto& constraint_info = pIdxInfo->aConstraint[i];
+    if (!constraint_info.usable || !isLimitConstraint(constraint_info.op)) {
+      continue;
+    }
+
+    pIdxInfo->aConstraintUsage[i].argvIndex = static_cast<int>(++expr_index);
+    if (constraint_info.op == SQLITE_INDEX_CONSTRAINT_LIMIT) {
+      limit.limit_argument = expr_index;
+    } else {
+      limit.offset_argument = expr_index;
+    }
+  }
+
+  return limit;
+}
+
+/**
+ * @brief Apply the cost hints of a table to an access plan.
+ *
+ * Without hints a scan costs kMaxIndexCost and an indexed lookup costs 1.
+ * When the expected number of rows is known, a scan costs those rows. Each
+ * row then costs the table's row cost and the cost of the expensive columns
+ * used by the query.
+ */
+static void estimateCost(const VirtualTableContent& content,
+                         const UsedColumns& colsUsed,
+                         bool scan,
+                         double cost,
+                         sqlite3_index_info* pIdxInfo) {
+  double row_cost = 1 + static_cast<double>(content.cost.row_cost);
+  for (const auto& column : content.cost.columns) {
+    if (colsUsed.count(column.first) > 0) {
+      row_cost += static_cast<double>(column.second);
+    }
+  }
+
+  if (content.cost.rows > 0 && scan) {
+    cost = static_cast<double>(content.cost.rows);
+    pIdxInfo->estimatedRows = static_cast<sqlite3_int64>(content.cost.rows);
+  }
+  pIdxInfo->estimatedCost = cost * row_cost;
+}
+
 static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   auto* pVtab = (VirtualTable*)tab;
   const auto& columns = pVtab->content->columns;
@@ -729,6 +953,13 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   bool hasRequiredColumns = false;
   bool hasRequiredConstraints = false;
 
+  // A LIMIT can only be pushed down if every constraint is consumed, and the
+  // table filters rows using each of them.
+  bool filtersConstraints = true;
+
+  // Constraints receiving every value of an IN operator within one xFilter.
+  std::set<size_t> inLists;
+
   // Expressions operating on the same virtual table are loosely identified by
   // the consecutive sets of terms each of the constraint sets are applied onto.
   // Subsequent attempts from failed (unusable) constraints replace the set,
@@ -744,7 +975,7 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
              " term=" + std::to_string((int)constraint_info.iTermOffset) +
              " usable=" + std::to_string((int)constraint_info.usable) + "]");
       }
-      if (!constraint_info.usable) {
+      if (!constraint_info.usable || isLimitConstraint(constraint_info.op)) {
         continue;
       }
 
@@ -752,11 +983,13 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
       if (constraint_info.iColumn < 0 ||
           static_cast<size_t>(constraint_info.iColumn) >=
               pVtab->content->columns.size()) {
+        filtersConstraints = false;
         continue;
       }
       const auto& name = std::get<0>(columns[constraint_info.iColumn]);
       const auto& type = std::get<1>(columns[constraint_info.iColumn]);
       if (!sensibleComparison(type, constraint_info.op)) {
+        filtersConstraints = false;
         cost += 10;
         continue;
       }
@@ -770,9 +1003,25 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
         cost = 1;
       } else {
         // not indexed, let sqlite filter it
+        filtersConstraints = false;
         continue;
       }
 
+      // Tables are only expected to filter equality and range comparisons.
+      // Event-based tables only filter using a lower bound of the time.
+      bool filtered = (constraint_info.op == EQUALS ||
+                       constraint_info.op == GREATER_THAN ||
+                       constraint_info.op == GREATER_THAN_OR_EQUALS);
+      if ((pVtab->content->attributes & TableAttributes::EVENT_BASED) != 0) {
+        filtered = filtered && name == "time";
+      } else {
+        filtered = filtered || constraint_info.op == LESS_THAN ||
+                   constraint_info.op == LESS_THAN_OR_EQUALS;
+      }
+      if (!filtered) {
+        filtersConstraints = false;
+      }
+
       // Save a pair of the name and the constraint operator.
       // Use this constraint during xFilter by performing a scan and column
       // name lookup through out all cursor constraint lists.
@@ -780,12 +1029,19 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
           std::make_pair(name, Constraint(constraint_info.op)));
 
       // important: if we specify an index, it means xFilter will be called
-      // once for every row.  So if you have an IN() list with 50 items,
-      // xFilter will get called 50 times, once for each item.  If you have
-      // a JOIN with 500 rows, xFilter is called 500 times.  Therefore,
-      // when a spec file specifies a column to be required or index, the
-      // table implementation must be able to quickly find and return a
-      // single row. See issue 5379.
+      // once for every row.  If you have a JOIN with 500 rows, xFilter is
+      // called 500 times.  Therefore, when a spec file specifies a column to
+      // be required or index, the table implementation must be able to
+      // quickly find and return a single row. See issue 5379.
+      //
+      // The values of an IN() list are received all at once instead, as a
+      // set of EQUALS constraints. Event-based tables only use a single time.
+      if (constraint_info.op == EQUALS &&
+          (pVtab->content->attributes & TableAttributes::EVENT_BASED) == 0 &&
+          sqlite3_vtab_in(pIdxInfo, static_cast<int>(i), -1)) {
+        sqlite3_vtab_in(pIdxInfo, static_cast<int>(i), 1);
+        inLists.insert(constraints.size() - 1);
+      }
 
       pIdxInfo->aConstraintUsage[i].argvIndex = static_cast<int>(++expr_index);
 
@@ -793,7 +1049,9 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
         plan("xBestIndex Adding index constraint for table: " +
              pVtab->content->name + " [column=" + name +
              " arg_index=" + std::to_string(expr_index) +
-             " op=" + std::to_string(constraint_info.op) + "]");
+             " op=" + std::to_string(constraint_info.op) +
+             " in_list=" + std::to_string(inLists.count(expr_index - 1)) +
+             "]");
       }
     }
   }
@@ -831,26 +1089,150 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
 
   // Return max-cost if a required constraint is not present.
   // For example, you can't do a hash of a file if path not provided.
-  if (hasRequiredColumns && !hasRequiredConstraints) {
+  bool required_missing = hasRequiredColumns && !hasRequiredConstraints;
+  if (required_missing) {
     cost = kMaxIndexCost;
   }
 
+  auto limit = consumeLimit(
+      *pVtab->content, pIdxInfo, filtersConstraints, expr_index);
+
+  estimateCost(*pVtab->content,
+               colsUsed,
+               cost >= kMaxIndexCost && !required_missing,
+               cost,
+               pIdxInfo);
+
   pIdxInfo->idxNum = static_cast<int>(kConstraintIndexID++);
   if (FLAGS_planner) {
     plan("xBestIndex Recording constraint set for table: " +
-         pVtab->content->name + " [cost=" + std::to_string(cost) +
+         pVtab->content->name +
+         " [cost=" + std::to_string(pIdxInfo->estimatedCost) +
+         " rows=" + std::to_string(pIdxInfo->estimatedRows) +
          " size=" + std::to_string(constraints.size()) +
-         " idx=" + std::to_string(pIdxInfo->idxNum) + "]");
+         " idx=" + std::to_string(pIdxInfo->idxNum) +
+         " limit=" + std::to_string(limit.limit_argument != 0) +
+         " ordered=" + std::to_string(pIdxInfo->orderByConsumed) + "]");
   }
   // Add the constraint set to the table's tracked constraints.
   pVtab->content->constraints[pIdxInfo->idxNum] = std::move(constraints);
   pVtab->content->colsUsed[pIdxInfo->idxNum] = std::move(colsUsed);
   pVtab->content->colsUsedBitsets[pIdxInfo->idxNum] = colsUsedBitset;
-  pIdxInfo->estimatedCost = cost;
+  if (limit.limit_argument != 0 || !limit.order.empty()) {
+    pVtab->content->limits[pIdxInfo->idxNum] = std::move(limit);
+  }
+  if (!inLists.empty()) {
+    pVtab->content->inLists[pIdxInfo->idxNum] = std::move(inLists);
+  }
 
   return SQLITE_OK;
 }
 
+/// Set the row limit of a query from the LIMIT and OFFSET values.
+static void setContextLimit(const LimitPushdown& limit,
+                            int argc,
+                            sqlite3_value** argv,
+                            QueryContext& context) {
+  if (limit.limit_argument == 0 ||
+      limit.limit_argument > static_cast<size_t>(argc)) {
+    return;
+  }
+
+  // A negative LIMIT means there is no limit.
+  auto rows = sqlite3_value_int64(argv[limit.limit_argument - 1]);
+  if (rows < 0) {
+    return;
+  }
+
+  // SQLite skips the OFFSET rows itself, the table must generate them.
+  if (limit.offset_argument != 0 &&
+      limit.offset_argument <= static_cast<size_t>(argc)) {
+    auto offset = sqlite3_value_int64(argv[limit.offset_argument - 1]);
+    if (offset > 0 &&
+        rows <= std::numeric_limits<sqlite3_int64>::max() - offset) {
+      rows += offset;
+    }
+  }
+
+  context.limit = static_cast<size_t>(rows);
+}
+
+/**
+ * @brief Add a constraint for each value of an IN operator.
+ *
+ * NULL and empty values are skipped, as they are for single constraints.
+ * Nothing is added if the list cannot be read, the table then generates
+ * every row and SQLite filters them.
+ */
+static void addInListConstraints(sqlite3_value* list,
+                                 const std::pair<std::string, Constraint>& in,
+                                 QueryContext& context) {
+  std::vector<std::string> values;
+  sqlite3_value* value = nullptr;
+  auto rc = sqlite3_vtab_in_first(list, &value);
+  for (; rc == SQLITE_OK && value != nullptr;
+       rc = sqlite3_vtab_in_next(list, &value)) {
+    if (sqlite3_value_type(value) == SQLITE_NULL) {
+      // A NULL is never equal to a column value.
+      continue;
+    }
+
+    auto expr = (const char*)sqlite3_value_text(value);
+    if (expr == nullptr || expr[0] == 0) {
+      continue;
+    }
+    values.emplace_back(expr);
+  }
+
+  if (rc != SQLITE_DONE && rc != SQLITE_OK) {
+    return;
+  }
+
+  for (auto& expr : values) {
+    if (FLAGS_planner) {
+      plan("xFilter Adding IN constraint: " + in.first + " " +
+           opString(in.second.op) + " " + expr);
+    }
+    context.constraints[in.first].add(
+        Constraint(in.second.op, std::move(expr)));
+  }
+}
+
+/// Identify the results of a table generated with the same constraints.
+static std::string getProbeKey(const QueryContext& context) {
+  std::string key;
+  for (const auto& column : context.constraints) {
+    for (const auto& constraint : column.second.getAll()) {
+      key += column.first + '\x1f' + std::to_string(constraint.op) + '\x1f' +
+             constraint.expr + '\x1e';
+    }
+  }
+
+  if (key.empty()) {
+    // A scan is not a probe, it is not repeated within a query.
+    return key;
+  }
+
+  if (context.colsUsedBitset) {
+    key += context.colsUsedBitset->to_string();
+  }
+  if (context.limit) {
+    key += '\x1e' + std::to_string(*context.limit);
+  }
+  for (const auto& order : context.orderBy) {
+    key += '\x1e' + order.column + (order.descending ? "-" : "+");
+  }
+  return key;
+}
+
+/// Copy memoized table results to a cursor.
+static void copyRows(const TableRows& rows, TableRows& copy) {
+  copy.reserve(rows.size());
+  for (const auto& row : rows) {
+    copy.push_back(row->clone());
+  }
+}
+
 static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
                    int idxNum,
                    const char* idxStr,
@@ -915,8 +1297,17 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
   // Iterate over every argument to xFilter, filling in constraint values.
   if (content->constraints.size() > 0) {
     auto& constraints = content->constraints[idxNum];
+    auto in_lists = content->inLists.find(idxNum);
     if (argc > 0) {
-      for (size_t i = 0; i < static_cast<size_t>(argc); ++i) {
+      // A LIMIT and OFFSET may follow the column constraints.
+      auto constraint_count =
+          std::min(static_cast<size_t>(argc), constraints.size());
+      for (size_t i = 0; i < constraint_count; ++i) {
+        if (in_lists != content->inLists.end() && in_lists->second.count(i)) {
+          addInListConstraints(argv[i], constraints[i], context);
+          continue;
+        }
+
         auto expr = (const char*)sqlite3_value_text(argv[i]);
         if (expr == nullptr || expr[0] == 0) {
           // SQLite did not expose the expression value.
@@ -963,6 +1354,12 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     context.colsUsed = content->colsUsed[idxNum];
   }
 
+  auto limit = content->limits.find(idxNum);
+  if (limit != content->limits.end()) {
+    context.orderBy = limit->second.order;
+    setContextLimit(limit->second, argc, argv, context);
+  }
+
   // Reset the virtual table contents.
   pCur->rows.clear();
   options.clear();
@@ -993,8 +1390,23 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     }
   }
 
+  // Repeated probes of a JOIN may reuse the rows generated for the same
+  // constraint values.
+  std::string probe_key;
+  if (FLAGS_memoize_table_probes) {
+    probe_key = getProbeKey(context);
+    auto probe = content->probes.find(probe_key);
+    if (!probe_key.empty() && probe != content->probes.end()) {
+      copyRows(probe->second, pCur->rows);
+      pCur->n = pCur->rows.size();
+      plan("Reusing rows for cursor (" + std::to_string(pCur->id) + ")");
+      return SQLITE_OK;
+    }
+  }
+
   // Generate the row data set.
   plan("Scanning rows for cursor (" + std::to_string(pCur->id) + ")");
+  TableResourceScope scope(pVtab->content->name);
   if (Registry::get().exists("table", pVtab->content->name, true)) {
     auto plugin = Registry::get().plugin("table", pVtab->content->name);
     auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
@@ -1035,6 +1447,10 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     pCur->rows = tableRowsFromQueryData(std::move(qd));
   }
 
+  if (!probe_key.empty()) {
+    copyRows(pCur->rows, content->probes[probe_key]);
+  }
+
   // Set the number of rows.
   pCur->n = pCur->rows.size();
 
@@ -1099,6 +1515,9 @@ Status attachTableInternal(const std::string& name,
     return Status(1);
   }
 
+  // The table plugin may have been replaced, or its extension attached again.
+  tables::sqlite::table_schemas.erase(name);
+
   // Note, if the clientData API is used then this will save a registry call
   // within xCreate.
   auto lock(instance->attachLock());
@@ -1129,7 +1548,11 @@ Status detachTableInternal(const std::string& name,
   int rc = sqlite3_exec(instance->db(), format.c_str(), nullptr, nullptr, 0);
   if (rc != SQLITE_OK) {
     LOG(ERROR) << "Error detaching table: " << name << " (" << rc << ")";
+  } else {
+    // Also remove the module, which would otherwise connect the table lazily.
+    sqlite3_create_module(instance->db(), name.c_str(), nullptr, nullptr);
   }
+  tables::sqlite::table_schemas.erase(name);
 
   return Status(rc, getStringForSQLiteReturnCode(rc));
 }
@@ -1162,14 +1585,27 @@ void attachVirtualTables(const SQLiteDBInstanceRef& instance) {
 #endif
   }
 
-  PluginResponse response;
-  bool is_extension = false;
-
+  // Tables are not created, each table module is eponymous and connects its
+  // table the first time a statement references it.
   for (const auto& name : RegistryFactory::get().names("table")) {
-    auto status =
-        Registry::call("table", name, {{"action", "columns"}}, response);
-    if (status.ok()) {
-      attachTableInternal(name, instance, is_extension);
+    if (SQLiteDBManager::isDisabled(name)) {
+      continue;
+    }
+
+    auto schema = tables::sqlite::getTableSchema(name);
+    if (schema == nullptr) {
+      continue;
+    }
+
+    auto* module = tables::sqlite::getVirtualTableModule(name, false);
+    auto lock(instance->attachLock());
+    sqlite3_create_module(
+        instance->db(), name.c_str(), module, (void*)&(*instance));
+
+    // Table aliases use the table's module, which resolves them in xCreate.
+    for (const auto& view : schema->views) {
+      sqlite3_create_module(
+          instance->db(), view.c_str(), module, (void*)&(*instance));
     }
   }
 }
@@ -91,7 +91,12 @@ Status attachFunctionInternal(
     std::function<
         void(sqlite3_context* context, int argc, sqlite3_value** argv)> func);
 
-/// Attach all table plugins to an in-memory SQLite database.
+/**
+ * @brief Attach all table plugins to an in-memory SQLite database.
+ *
+ * Only the table modules are created, each table is connected when a
+ * statement first references it. Use attachTableInternal to create a table.
+ */
 void attachVirtualTables(const SQLiteDBInstanceRef& instance);
 
 #if !defined(OSQUERY_EXTERNAL)
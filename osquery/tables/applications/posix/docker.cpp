@@ -10,23 +10,20 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <regex>
+#include <sstream>
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
-#include <boost/asio.hpp>
 #include <boost/foreach.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
-#if !defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
-#error Boost error: Local sockets not available
-#endif
-
 #include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/logger/logger.h>
+#include <osquery/tables/applications/posix/docker_api.h>
 #include <osquery/utils/conversions/join.h>
+#include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/info/platform_type.h>
 #include <osquery/utils/json/json.h>
 
@@ -37,7 +34,7 @@
 #endif
 
 namespace pt = boost::property_tree;
-namespace local = boost::asio::local;
+namespace rj = rapidjson;
 
 namespace osquery {
 
@@ -54,6 +51,27 @@ FLAG(string,
 
 namespace tables {
 
+/**
+ * @brief Parses the JSON body of a docker API response.
+ *
+ * @param uri Relative URI the response is for.
+ * @param body JSON body of the response.
+ * @param tree Property tree where JSON result is stored.
+ */
+Status parseDockerResponse(const std::string& uri,
+                           const std::string& body,
+                           pt::ptree& tree) {
+  try {
+    std::istringstream stream(body);
+    pt::read_json(stream, tree);
+  } catch (const pt::ptree_error& e) {
+    return Status(
+        1, "Error reading docker API response for " + uri + ": " + e.what());
+  }
+
+  return Status(0);
+}
+
 /**
  * @brief Makes API calls to the docker UNIX socket.
  *
@@ -63,54 +81,35 @@ namespace tables {
  *         message.
  */
 Status dockerApi(const std::string& uri, pt::ptree& tree) {
-  static const std::regex httpOkRegex("HTTP/1\\.(0|1) 200 OK\\\r");
-
-  try {
-    local::stream_protocol::endpoint ep(FLAGS_docker_socket);
-    local::stream_protocol::iostream stream(ep);
-    if (!stream) {
-      return Status(
-          1, "Error connecting to docker sock: " + stream.error().message());
-    }
-
-    // Since keep-alive connections are not used, use HTTP/1.0
-    stream << "GET " << uri
-           << " HTTP/1.0\r\nAccept: */*\r\nConnection: close\r\n\r\n"
-           << std::flush;
-    if (stream.eof()) {
-      stream.close();
-      return Status(1, "Empty docker API response for: " + uri);
-    }
-
-    // All status responses are expected to be 200
-    std::string str;
-    getline(stream, str);
-
-    std::smatch match;
-    if (!std::regex_match(str, match, httpOkRegex)) {
-      stream.close();
-      return Status(1, "Invalid docker API response for " + uri + ": " + str);
-    }
+  std::string body;
+  auto s = DockerClientPool::get().request(FLAGS_docker_socket, uri, body);
+  if (!s.ok()) {
+    return s;
+  }
 
-    // Skip empty line between header and body
-    while (!stream.eof() && str != "\r") {
-      getline(stream, str);
-    }
+  return parseDockerResponse(uri, body, tree);
+}
 
-    try {
-      pt::read_json(stream, tree);
-    } catch (const pt::ptree_error& e) {
-      stream.close();
-      return Status(
-          1, "Error reading docker API response for " + uri + ": " + e.what());
+/**
+ * @brief Makes concurrent API calls to the docker UNIX socket.
+ *
+ * @param uris Relative URIs to invoke GET HTTP method.
+ * @param trees Property trees where JSON results are stored, in order.
+ * @return Status of each call, in the order of the URIs.
+ */
+std::vector<Status> dockerApiAll(const std::vector<std::string>& uris,
+                                 std::vector<pt::ptree>& trees) {
+  std::vector<std::string> bodies;
+  auto statuses =
+      DockerClientPool::get().requestAll(FLAGS_docker_socket, uris, bodies);
+
+  trees.assign(uris.size(), pt::ptree());
+  for (size_t i = 0; i < uris.size(); ++i) {
+    if (statuses[i].ok()) {
+      statuses[i] = parseDockerResponse(uris[i], bodies[i], trees[i]);
     }
-
-    stream.close();
-  } catch (const std::exception& e) {
-    return Status(1, std::string("Error calling docker API: ") + e.what());
   }
-
-  return Status(0);
+  return statuses;
 }
 
 /**
@@ -380,6 +379,15 @@ QueryData genContainers(QueryContext& context) {
     return results;
   }
 
+  // The inspect request is needed for its columns and for the pid of the
+  // container's namespaces.
+  bool with_inspect = context.isColumnGroupUsed("inspect");
+  bool with_namespaces = false;
+#ifdef __linux__
+  with_namespaces = context.isColumnGroupUsed("namespaces");
+#endif
+
+  std::vector<std::string> uris;
   for (const auto& entry : containers) {
     const pt::ptree& container = entry.second;
     Row r;
@@ -400,13 +408,29 @@ QueryData genContainers(QueryContext& context) {
     r["created"] = BIGINT(container.get<uint64_t>("Created", 0));
     r["state"] = container.get<std::string>("State", "");
     r["status"] = container.get<std::string>("Status", "");
+    uris.push_back("/containers/" + r["id"] + "/json?stream=false");
+    results.push_back(r);
+  }
+
+  if (!with_inspect && !with_namespaces) {
+    return results;
+  }
 
-    pt::ptree container_details;
-    s = dockerApi("/containers/" + r["id"] + "/json?stream=false",
-                  container_details);
+  // Inspect every container at once, on several connections.
+  std::vector<pt::ptree> details;
+  auto statuses = dockerApiAll(uris, details);
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& r = results[i];
+    const pt::ptree& container_details = details[i];
+
+    std::string pid = "-1";
+    s = statuses[i];
     if (s.ok()) {
-      r["pid"] =
-          BIGINT(container_details.get_child("State").get<pid_t>("Pid", -1));
+      pid = BIGINT(container_details.get_child("State").get<pid_t>("Pid", -1));
+    }
+
+    if (s.ok() && with_inspect) {
+      r["pid"] = pid;
       r["started_at"] = container_details.get_child("State").get<std::string>(
           "StartedAt", "");
       if (r["state"] != "running") {
@@ -446,7 +470,7 @@ QueryData genContainers(QueryContext& context) {
       }
       r["env_variables"] = osquery::join(env_vars, ", ");
 
-    } else {
+    } else if (!s.ok()) {
       VLOG(1) << "Failed to retrieve the inspect data for container "
               << r["id"];
     }
@@ -454,9 +478,9 @@ QueryData genContainers(QueryContext& context) {
 // When building on linux, the extended schema of docker_containers will
 // add some additional columns to support user namespaces
 #ifdef __linux__
-    if (r["pid"] != "-1") {
+    if (with_namespaces && pid != "-1") {
       ProcessNamespaceList namespace_list;
-      s = procGetProcessNamespaces(r["pid"], namespace_list);
+      s = procGetProcessNamespaces(pid, namespace_list);
       if (s.ok()) {
         for (const auto& pair : namespace_list) {
           r[pair.first + "_namespace"] = std::to_string(pair.second);
@@ -467,8 +491,6 @@ QueryData genContainers(QueryContext& context) {
       }
     }
 #endif
-
-    results.push_back(r);
   }
 
   return results;
@@ -486,15 +508,21 @@ QueryData genContainerEnvs(QueryContext& context) {
     return results;
   }
 
+  std::vector<std::string> container_ids;
+  std::vector<std::string> uris;
   for (const auto& entry : containers) {
     const pt::ptree& container = entry.second;
-    auto id = getValue(container, ids, "Id");
+    container_ids.push_back(getValue(container, ids, "Id"));
+    uris.push_back("/containers/" + container_ids.back() +
+                   "/json?stream=false");
+  }
 
-    pt::ptree container_details;
-    s = dockerApi("/containers/" + id + "/json?stream=false",
-                  container_details);
-    if (s.ok()) {
-      for (const auto& env_var : container_details.get_child("Config.Env")) {
+  std::vector<pt::ptree> details;
+  auto statuses = dockerApiAll(uris, details);
+  for (size_t i = 0; i < container_ids.size(); ++i) {
+    const auto& id = container_ids[i];
+    if (statuses[i].ok()) {
+      for (const auto& env_var : details[i].get_child("Config.Env")) {
         Row r;
         r["id"] = id;
         auto buf = std::string(env_var.second.data());
@@ -819,118 +847,281 @@ long diffNanos(const std::string& iso1, const std::string& iso2) {
 }
 
 /**
- * @brief Utility method to get cumulative value for specified "op" from
- *        child node in provided "tree".
+ * @brief Reads the docker_container_stats columns out of a stats response.
  *
- * @param tree Tree to iterate.
- * @param op IO operation to look for in the child nodes.
- * @return Cumulative value for type "op".
+ * A stats response includes per-CPU and per-cgroup details the table does not
+ * use, it is parsed as a stream of values instead of into a tree. Scalars are
+ * kept by their dotted path, the disk and network counters are summed while
+ * they are read.
  */
-std::string getIOBytes(const pt::ptree& tree, const std::string& op) {
-  uint64_t value = 0;
-  for (const auto& entry : tree) {
-    const pt::ptree& node = entry.second;
-    if (node.get<std::string>("op", "") == op) {
-      value += node.get<uint64_t>("value", 0);
+class ContainerStatsHandler
+    : public rj::BaseReaderHandler<rj::UTF8<>, ContainerStatsHandler> {
+ public:
+  bool Null() {
+    return true;
+  }
+
+  bool Bool(bool b) {
+    return scalar(b ? "1" : "0");
+  }
+
+  bool Int(int i) {
+    return scalar(std::to_string(i));
+  }
+
+  bool Uint(unsigned u) {
+    return scalar(std::to_string(u));
+  }
+
+  bool Int64(int64_t i) {
+    return scalar(std::to_string(i));
+  }
+
+  bool Uint64(uint64_t u) {
+    return scalar(std::to_string(u));
+  }
+
+  bool Double(double d) {
+    return scalar(std::to_string(d));
+  }
+
+  bool String(const char* str, rj::SizeType length, bool /* copy */) {
+    return scalar(std::string(str, length));
+  }
+
+  bool Key(const char* str, rj::SizeType length, bool /* copy */) {
+    key_.assign(str, length);
+    return true;
+  }
+
+  bool StartObject() {
+    push(false);
+    if (path_ == kIOServiceBytesPath) {
+      io_op_.clear();
+      io_value_ = 0;
     }
+    return true;
   }
 
-  return BIGINT(value);
-}
+  bool EndObject(rj::SizeType /* members */) {
+    if (path_ == kIOServiceBytesPath) {
+      if (io_op_ == "Read") {
+        disk_read += io_value_;
+      } else if (io_op_ == "Write") {
+        disk_write += io_value_;
+      }
+    }
+    pop();
+    return true;
+  }
+
+  bool StartArray() {
+    push(true);
+    return true;
+  }
+
+  bool EndArray(rj::SizeType /* elements */) {
+    pop();
+    return true;
+  }
+
+  /// Get a scalar by its dotted path.
+  std::string get(const std::string& path,
+                  const std::string& default_value) const {
+    auto it = values_.find(path);
+    return (it == values_.end()) ? default_value : it->second;
+  }
+
+  /// Get a number by its dotted path.
+  uint64_t getNumber(const std::string& path) const {
+    return tryTo<uint64_t>(get(path, "0")).takeOr(uint64_t{0});
+  }
+
+ public:
+  /// Sum of the "Read" and "Write" io_service_bytes_recursive entries.
+  uint64_t disk_read{0};
+  uint64_t disk_write{0};
+
+  /// Sum of the network counters of every interface.
+  uint64_t network_rx_bytes{0};
+  uint64_t network_tx_bytes{0};
+
+ private:
+  /// Path of the objects of the blkio io_service_bytes_recursive array.
+  static constexpr const char* kIOServiceBytesPath =
+      "blkio_stats.io_service_bytes_recursive.[]";
+
+  /// The path component of the next value, "[]" for array elements.
+  const std::string& component() const {
+    static const std::string kElement = "[]";
+    return (arrays_.empty() || !arrays_.back()) ? key_ : kElement;
+  }
+
+  void push(bool array) {
+    if (!arrays_.empty()) {
+      lengths_.push_back(path_.size());
+      if (!path_.empty()) {
+        path_ += '.';
+      }
+      path_ += component();
+    }
+    arrays_.push_back(array);
+  }
+
+  void pop() {
+    arrays_.pop_back();
+    if (!arrays_.empty()) {
+      path_.resize(lengths_.back());
+      lengths_.pop_back();
+    }
+  }
+
+  bool scalar(std::string value) {
+    if (path_ == kIOServiceBytesPath) {
+      if (key_ == "op") {
+        io_op_ = std::move(value);
+      } else if (key_ == "value") {
+        io_value_ = tryTo<uint64_t>(value).takeOr(uint64_t{0});
+      }
+      return true;
+    }
+
+    // The networks object holds an object per interface.
+    if (arrays_.size() == 3 && boost::starts_with(path_, "networks.")) {
+      auto bytes = tryTo<uint64_t>(value).takeOr(uint64_t{0});
+      if (key_ == "rx_bytes") {
+        network_rx_bytes += bytes;
+      } else if (key_ == "tx_bytes") {
+        network_tx_bytes += bytes;
+      }
+      return true;
+    }
+
+    if (path_.empty()) {
+      values_[component()] = std::move(value);
+    } else {
+      values_[path_ + '.' + component()] = std::move(value);
+    }
+    return true;
+  }
+
+ private:
+  /// The dotted path of the current object or array.
+  std::string path_;
+
+  /// The length of the path before each nested object or array.
+  std::vector<size_t> lengths_;
+
+  /// Whether each nested value is an array.
+  std::vector<bool> arrays_;
+
+  /// The last key read.
+  std::string key_;
+
+  /// The blkio entry being read.
+  std::string io_op_;
+  uint64_t io_value_{0};
+
+  std::map<std::string, std::string> values_;
+};
 
 /**
- * @brief Utility method to get cumulative value for specified "key" from
- *        child node in provided "tree".
- *
- * @param tree Tree to iterate.
- * @param key Key to look for in the child nodes.
- * @return Cumulative value for "key".
+ * @brief Parses a container stats response into a docker_container_stats row.
  */
-std::string getNetworkBytes(const pt::ptree& tree, const std::string& key) {
-  uint64_t value = 0;
-  for (const auto& node : tree) {
-    value += node.second.get<uint64_t>(key, 0);
+Status parseContainerStats(const std::string& body, Row& r) {
+  ContainerStatsHandler stats;
+  rj::Reader reader;
+  rj::StringStream stream(body.c_str());
+  auto result = reader.Parse(stream, stats);
+  if (result.IsError()) {
+    return Status(1,
+                  "Error reading docker container stats: " +
+                      std::string(rj::GetParseError_En(result.Code())));
   }
 
-  return BIGINT(value);
+  r["name"] = stats.get("name", "");
+  r["pids"] = INTEGER(stats.getNumber("pids_stats.current"));
+  const std::string& read = stats.get("read", "");
+  long read_unix_time = getUnixTime(read, false);
+  r["read"] = BIGINT(read_unix_time);
+  const std::string& preread = stats.get("preread", "");
+  long preread_unix_time = getUnixTime(preread, false);
+  r["preread"] = BIGINT(preread_unix_time);
+  long intervalNanos = ((read_unix_time - preread_unix_time) * 1000000000) +
+                       diffNanos(read, preread);
+  r["interval"] = BIGINT(intervalNanos);
+  r["disk_read"] = BIGINT(stats.disk_read);
+  r["disk_write"] = BIGINT(stats.disk_write);
+  r["num_procs"] = INTEGER(stats.getNumber("num_procs"));
+  r["cpu_total_usage"] =
+      BIGINT(stats.getNumber("cpu_stats.cpu_usage.total_usage"));
+  r["cpu_kernelmode_usage"] =
+      BIGINT(stats.getNumber("cpu_stats.cpu_usage.usage_in_kernelmode"));
+  r["cpu_usermode_usage"] =
+      BIGINT(stats.getNumber("cpu_stats.cpu_usage.usage_in_usermode"));
+  r["system_cpu_usage"] = BIGINT(stats.getNumber("cpu_stats.system_cpu_usage"));
+  r["online_cpus"] = INTEGER(stats.getNumber("cpu_stats.online_cpus"));
+  r["pre_cpu_total_usage"] =
+      BIGINT(stats.getNumber("precpu_stats.cpu_usage.total_usage"));
+  r["pre_cpu_kernelmode_usage"] =
+      BIGINT(stats.getNumber("precpu_stats.cpu_usage.usage_in_kernelmode"));
+  r["pre_cpu_usermode_usage"] =
+      BIGINT(stats.getNumber("precpu_stats.cpu_usage.usage_in_usermode"));
+  r["pre_system_cpu_usage"] =
+      BIGINT(stats.getNumber("precpu_stats.system_cpu_usage"));
+  r["pre_online_cpus"] = INTEGER(stats.getNumber("precpu_stats.online_cpus"));
+  r["memory_usage"] = BIGINT(stats.getNumber("memory_stats.usage"));
+  r["memory_cached"] = BIGINT(stats.getNumber("memory_stats.stats.cache"));
+  r["memory_max_usage"] = BIGINT(stats.getNumber("memory_stats.max_usage"));
+  r["memory_limit"] = BIGINT(stats.getNumber("memory_stats.limit"));
+  r["network_rx_bytes"] = BIGINT(stats.network_rx_bytes);
+  r["network_tx_bytes"] = BIGINT(stats.network_tx_bytes);
+  return Status(0);
 }
 
 /**
  * @brief Entry point for docker_container_stats table.
  */
 QueryData genContainerStats(QueryContext& context) {
-  QueryData results;
+  // Without the previous sample the daemon answers without waiting for one.
+  std::string query = "/stats?stream=false";
+  if (!context.isColumnGroupUsed("precpu")) {
+    query.append("&one-shot=true");
+  }
+
+  std::vector<std::string> ids;
+  std::vector<std::string> uris;
   for (const auto& id : context.constraints["id"].getAll(EQUALS)) {
     if (!checkConstraintValue(id)) {
       continue;
     }
+    ids.push_back(id);
+    uris.push_back("/containers/" + id + query);
+  }
 
-    pt::ptree container;
-    Status s =
-        dockerApi("/containers/" + id + "/stats?stream=false", container);
-    if (!s.ok()) {
-      VLOG(1) << "Error getting docker container " << id << ": " << s.what();
+  // Each stats request waits for a sample, request them all at once.
+  std::vector<std::string> bodies;
+  auto statuses =
+      DockerClientPool::get().requestAll(FLAGS_docker_socket, uris, bodies);
+
+  QueryData results;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    const auto& id = ids[i];
+    if (!statuses[i].ok()) {
+      VLOG(1) << "Error getting docker container " << id << ": "
+              << statuses[i].what();
       continue;
     }
 
-    try {
-      Row r;
-      r["id"] = id;
-      r["name"] = container.get<std::string>("name", "");
-      r["pids"] = INTEGER(container.get<int>("pids_stats.current", 0));
-      const std::string& read = container.get<std::string>("read", "");
-      long read_unix_time = getUnixTime(read, false);
-      r["read"] = BIGINT(read_unix_time);
-      const std::string& preread = container.get<std::string>("preread", "");
-      long preread_unix_time = getUnixTime(preread, false);
-      r["preread"] = BIGINT(preread_unix_time);
-      long intervalNanos = ((read_unix_time - preread_unix_time) * 1000000000) +
-                           diffNanos(read, preread);
-      r["interval"] = BIGINT(intervalNanos);
-      r["disk_read"] = getIOBytes(
-          container.get_child("blkio_stats.io_service_bytes_recursive"),
-          "Read");
-      r["disk_write"] = getIOBytes(
-          container.get_child("blkio_stats.io_service_bytes_recursive"),
-          "Write");
-      r["num_procs"] = INTEGER(container.get<int>("num_procs", 0));
-      r["cpu_total_usage"] =
-          BIGINT(container.get<uint64_t>("cpu_stats.cpu_usage.total_usage", 0));
-      r["cpu_kernelmode_usage"] = BIGINT(container.get<uint64_t>(
-          "cpu_stats.cpu_usage.usage_in_kernelmode", 0));
-      r["cpu_usermode_usage"] = BIGINT(
-          container.get<uint64_t>("cpu_stats.cpu_usage.usage_in_usermode", 0));
-      r["system_cpu_usage"] =
-          BIGINT(container.get<uint64_t>("cpu_stats.system_cpu_usage", 0));
-      r["online_cpus"] =
-          INTEGER(container.get<uint64_t>("cpu_stats.online_cpus", 0));
-      r["pre_cpu_total_usage"] = BIGINT(
-          container.get<uint64_t>("precpu_stats.cpu_usage.total_usage", 0));
-      r["pre_cpu_kernelmode_usage"] = BIGINT(container.get<uint64_t>(
-          "precpu_stats.cpu_usage.usage_in_kernelmode", 0));
-      r["pre_cpu_usermode_usage"] = BIGINT(container.get<uint64_t>(
-          "precpu_stats.cpu_usage.usage_in_usermode", 0));
-      r["pre_system_cpu_usage"] =
-          BIGINT(container.get<uint64_t>("precpu_stats.system_cpu_usage", 0));
-      r["pre_online_cpus"] =
-          INTEGER(container.get<uint64_t>("precpu_stats.online_cpus", 0));
-      r["memory_usage"] =
-          BIGINT(container.get<uint64_t>("memory_stats.usage", 0));
-      r["memory_cached"] =
-          BIGINT(container.get<uint64_t>("memory_stats.stats.cache", 0));
-      r["memory_max_usage"] =
-          BIGINT(container.get<uint64_t>("memory_stats.max_usage", 0));
-      r["memory_limit"] =
-          BIGINT(container.get<uint64_t>("memory_stats.limit", 0));
-      r["network_rx_bytes"] = getNetworkBytes(
-          container.get_child("networks", pt::ptree()), "rx_bytes");
-      r["network_tx_bytes"] = getNetworkBytes(
-          container.get_child("networks", pt::ptree()), "tx_bytes");
-      results.push_back(r);
-    } catch (const pt::ptree_error& e) {
+    Row r;
+    r["id"] = id;
+    auto s = parseContainerStats(bodies[i], r);
+    if (!s.ok()) {
       VLOG(1) << "Error getting docker container stats " << id << ": "
-              << e.what();
+              << s.what();
+      continue;
     }
+    results.push_back(r);
   }
 
   return results;
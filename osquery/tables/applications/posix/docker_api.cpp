@@ -0,0 +1,336 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/asio.hpp>
+
+#if !defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+#error Boost error: Local sockets not available
+#endif
+
+#include <osquery/core/flags.h>
+#include <osquery/logger/logger.h>
+#include <osquery/tables/applications/posix/docker_api.h>
+#include <osquery/utils/conversions/tryto.h>
+
+namespace local = boost::asio::local;
+
+namespace osquery {
+
+FLAG(uint32,
+     docker_api_connections,
+     4,
+     "Maximum concurrent connections to the docker socket");
+
+/**
+ * @brief A keep-alive HTTP/1.1 connection to the docker UNIX socket.
+ *
+ * Transport and protocol errors are thrown, the connection must not be used
+ * after an error.
+ */
+class DockerConnection : private boost::noncopyable {
+ public:
+  /// Connect to a docker socket.
+  explicit DockerConnection(const std::string& socket) : socket_(io_context_) {
+    socket_.connect(local::stream_protocol::endpoint(socket));
+  }
+
+  /**
+   * @brief Send a GET request and read the whole response.
+   *
+   * @param uri Relative URI, including the query string.
+   * @param body The body of the response, after any chunked decoding.
+   * @param status_line The first line of the response.
+   * @return The HTTP status code.
+   */
+  size_t get(const std::string& uri,
+             std::string& body,
+             std::string& status_line);
+
+  /// Check if the server keeps the connection open after the response.
+  bool keepAlive() const {
+    return keep_alive_;
+  }
+
+ private:
+  /// Remove the first bytes of the receive buffer.
+  std::string take(size_t size);
+
+  /// Read more bytes of the body.
+  void readBody(size_t size, std::string& body);
+
+  /// Read a body sent with "Transfer-Encoding: chunked".
+  void readChunkedBody(std::string& body);
+
+  /// Read a body delimited by the end of the connection.
+  void readRemainingBody(std::string& body);
+
+ private:
+  boost::asio::io_context io_context_;
+  local::stream_protocol::socket socket_;
+
+  /// Bytes received but not yet consumed.
+  boost::asio::streambuf buffer_;
+
+  bool keep_alive_{true};
+};
+
+namespace {
+
+size_t parseSize(const std::string& text, int base) {
+  auto size = tryTo<size_t>(text, base);
+  if (size.isError()) {
+    throw std::runtime_error("Invalid docker API response size: " + text);
+  }
+  return size.take();
+}
+
+} // namespace
+
+std::string DockerConnection::take(size_t size) {
+  auto begin = boost::asio::buffers_begin(buffer_.data());
+  std::string bytes(begin, begin + size);
+  buffer_.consume(size);
+  return bytes;
+}
+
+void DockerConnection::readBody(size_t size, std::string& body) {
+  if (buffer_.size() < size) {
+    boost::asio::read(socket_,
+                      buffer_,
+                      boost::asio::transfer_exactly(size - buffer_.size()));
+  }
+  body.append(take(size));
+}
+
+void DockerConnection::readChunkedBody(std::string& body) {
+  while (true) {
+    // Each chunk starts with its size in hex, optionally followed by ';'.
+    auto line = take(boost::asio::read_until(socket_, buffer_, "\r\n"));
+    auto size = parseSize(line, 16);
+    if (size == 0) {
+      // Skip any trailer, up to the empty line ending the response.
+      while (take(boost::asio::read_until(socket_, buffer_, "\r\n")) !=
+             "\r\n") {
+      }
+      break;
+    }
+
+    readBody(size, body);
+    std::string delimiter;
+    readBody(2, delimiter);
+  }
+}
+
+void DockerConnection::readRemainingBody(std::string& body) {
+  boost::system::error_code ec;
+  boost::asio::read(socket_, buffer_, boost::asio::transfer_all(), ec);
+  if (ec != boost::asio::error::eof) {
+    throw boost::system::system_error(ec);
+  }
+  body.append(take(buffer_.size()));
+  keep_alive_ = false;
+}
+
+size_t DockerConnection::get(const std::string& uri,
+                             std::string& body,
+                             std::string& status_line) {
+  std::string request = "GET " + uri +
+                        " HTTP/1.1\r\nHost: docker\r\n"
+                        "Accept: application/json\r\n\r\n";
+  boost::asio::write(socket_, boost::asio::buffer(request));
+
+  auto headers = take(boost::asio::read_until(socket_, buffer_, "\r\n\r\n"));
+  auto end = headers.find("\r\n");
+  status_line = headers.substr(0, end);
+  if (!boost::starts_with(status_line, "HTTP/1.") ||
+      status_line.size() < 12) {
+    throw std::runtime_error("Invalid docker API response: " + status_line);
+  }
+  auto code = parseSize(status_line.substr(9, 3), 10);
+
+  // HTTP/1.0 servers close the connection unless asked otherwise.
+  keep_alive_ = !boost::starts_with(status_line, "HTTP/1.0");
+  bool chunked = false;
+  bool has_length = false;
+  size_t length = 0;
+  for (auto start = end + 2; start < headers.size(); start = end + 2) {
+    end = headers.find("\r\n", start);
+    auto line = headers.substr(start, end - start);
+    auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+
+    auto name = boost::algorithm::to_lower_copy(line.substr(0, colon));
+    auto value = boost::algorithm::trim_copy(line.substr(colon + 1));
+    if (name == "content-length") {
+      length = parseSize(value, 10);
+      has_length = true;
+    } else if (name == "transfer-encoding") {
+      chunked = boost::iequals(value, "chunked");
+    } else if (name == "connection") {
+      keep_alive_ = !boost::iequals(value, "close");
+    }
+  }
+
+  body.clear();
+  if (chunked) {
+    readChunkedBody(body);
+  } else if (has_length) {
+    readBody(length, body);
+  } else if (code != 204 && code != 304) {
+    readRemainingBody(body);
+  }
+  return code;
+}
+
+DockerClientPool& DockerClientPool::get() {
+  static DockerClientPool instance;
+  return instance;
+}
+
+Status DockerClientPool::request(const std::string& socket,
+                                 const std::string& uri,
+                                 std::string& body) {
+  std::shared_ptr<Endpoint> endpoint;
+  std::unique_ptr<DockerConnection> connection;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& slot = endpoints_[socket];
+    if (slot == nullptr) {
+      slot = std::make_shared<Endpoint>();
+    }
+    endpoint = slot;
+
+    size_t limit = std::max(FLAGS_docker_api_connections, 1U);
+    endpoint->returned.wait(lock, [&]() { return endpoint->active < limit; });
+
+    endpoint->active++;
+    if (!endpoint->idle.empty()) {
+      connection = std::move(endpoint->idle.back());
+      endpoint->idle.pop_back();
+    }
+  }
+
+  bool reused = (connection != nullptr);
+  Status status;
+  while (true) {
+    try {
+      if (connection == nullptr) {
+        connection = std::make_unique<DockerConnection>(socket);
+      }
+
+      std::string status_line;
+      if (connection->get(uri, body, status_line) == 200) {
+        status = Status::success();
+      } else {
+        status = Status(
+            1, "Invalid docker API response for " + uri + ": " + status_line);
+      }
+
+      if (!connection->keepAlive()) {
+        connection.reset();
+      }
+      break;
+    } catch (const std::exception& e) {
+      connection.reset();
+      status = Status(1, "Error calling docker API: " + std::string(e.what()));
+      if (!reused) {
+        break;
+      }
+      // The daemon may have closed the connection while it was idle.
+      VLOG(1) << "Reconnecting to docker socket: " << socket;
+      reused = false;
+    }
+  }
+
+  release(socket, endpoint, std::move(connection));
+  return status;
+}
+
+std::vector<Status> DockerClientPool::requestAll(
+    const std::string& socket,
+    const std::vector<std::string>& uris,
+    std::vector<std::string>& bodies) {
+  std::vector<Status> statuses(uris.size());
+  bodies.assign(uris.size(), std::string());
+
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    for (auto i = next++; i < uris.size(); i = next++) {
+      statuses[i] = request(socket, uris[i], bodies[i]);
+    }
+  };
+
+  // The calling thread sends requests too.
+  size_t limit = std::max(FLAGS_docker_api_connections, 1U);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min(limit, uris.size()); ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return statuses;
+}
+
+void DockerClientPool::release(const std::string& socket,
+                               const std::shared_ptr<Endpoint>& endpoint,
+                               std::unique_ptr<DockerConnection> connection) {
+  std::unique_ptr<DockerConnection> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoint->active--;
+
+    // The endpoint is replaced when the pool is cleared.
+    auto it = endpoints_.find(socket);
+    if (connection != nullptr && it != endpoints_.end() &&
+        it->second == endpoint &&
+        endpoint->idle.size() < std::max(FLAGS_docker_api_connections, 1U)) {
+      endpoint->idle.push_back(std::move(connection));
+    } else {
+      stale = std::move(connection);
+    }
+  }
+  endpoint->returned.notify_one();
+
+  // Close a connection that is not kept outside of the lock.
+  stale.reset();
+}
+
+void DockerClientPool::clear() {
+  std::vector<std::unique_ptr<DockerConnection>> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& endpoint : endpoints_) {
+      std::move(endpoint.second->idle.begin(),
+                endpoint.second->idle.end(),
+                std::back_inserter(stale));
+      endpoint.second->idle.clear();
+    }
+    endpoints_.clear();
+  }
+}
+
+size_t DockerClientPool::idleConnections(const std::string& socket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = endpoints_.find(socket);
+  return (it == endpoints_.end()) ? 0 : it->second->idle.size();
+}
+
+} // namespace osquery
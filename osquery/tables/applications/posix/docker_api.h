@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+class DockerConnection;
+
+/**
+ * @brief Persistent HTTP/1.1 connections to the docker Engine API.
+ *
+ * Each docker table used to connect to the docker UNIX socket for every
+ * request, and requested the details of each container one after the other.
+ * Requests made through the pool reuse idle keep-alive connections instead,
+ * and a batch of requests is sent on several connections at once.
+ *
+ * The pool limits the number of concurrent connections to each socket,
+ * callers wait for a connection to be returned when the limit is reached. A
+ * request that fails on a reused connection is retried once on a new one.
+ *
+ * Example:
+ *   @code{.cpp}
+ *     std::string body;
+ *     auto status = DockerClientPool::get().request(
+ *         "/var/run/docker.sock", "/version", body);
+ *   @endcode
+ */
+class DockerClientPool : private boost::noncopyable {
+ public:
+  /// Access the process-wide pool.
+  static DockerClientPool& get();
+
+  /**
+   * @brief Send a GET request and read the response body.
+   *
+   * Responses other than 200 OK are returned as a failed Status, their
+   * connection stays in the pool.
+   *
+   * @param socket Path of the docker UNIX domain socket.
+   * @param uri Relative URI, including the query string.
+   * @param body The body of the response, after any chunked decoding.
+   */
+  Status request(const std::string& socket,
+                 const std::string& uri,
+                 std::string& body);
+
+  /**
+   * @brief Send GET requests concurrently, one per URI.
+   *
+   * At most --docker_api_connections requests are in flight at a time.
+   *
+   * @param bodies The body of each response, in the order of the URIs.
+   * @return The Status of each request, in the order of the URIs.
+   */
+  std::vector<Status> requestAll(const std::string& socket,
+                                 const std::vector<std::string>& uris,
+                                 std::vector<std::string>& bodies);
+
+  /// Close every idle connection.
+  void clear();
+
+  /// The number of idle connections to a socket.
+  size_t idleConnections(const std::string& socket);
+
+ private:
+  DockerClientPool() = default;
+
+  /// The connections to a socket path.
+  struct Endpoint {
+    /// Idle connections, the most recently used is at the back.
+    std::vector<std::unique_ptr<DockerConnection>> idle;
+
+    /// The number of connections checked out of the pool.
+    size_t active{0};
+
+    /// Signaled when a connection is returned to the pool.
+    std::condition_variable returned;
+  };
+
+ private:
+  /// Return a checked out connection, a null connection only frees the slot.
+  void release(const std::string& socket,
+               const std::shared_ptr<Endpoint>& endpoint,
+               std::unique_ptr<DockerConnection> connection);
+
+ private:
+  /// Connections by socket path.
+  std::map<std::string, std::shared_ptr<Endpoint>> endpoints_;
+
+  /// Protects the endpoints.
+  std::mutex mutex_;
+};
+
+} // namespace osquery
@@ -0,0 +1,428 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/core/tables.h>
+#include <osquery/tables/applications/posix/docker_api.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_string(docker_socket);
+DECLARE_uint32(docker_api_connections);
+
+namespace tables {
+QueryData genContainerStats(QueryContext& context);
+} // namespace tables
+
+namespace {
+
+/// A stand-in for the docker daemon, answering GET requests on a UNIX socket.
+class DockerStandIn {
+ public:
+  DockerStandIn() {
+    path_ = (fs::temp_directory_path() /
+             fs::unique_path("osquery.docker.%%%%.%%%%.sock"))
+                .string();
+  }
+
+  ~DockerStandIn() {
+    stop();
+  }
+
+  bool start() {
+    listener_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ < 0) {
+      return false;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path_.c_str(), sizeof(address.sun_path) - 1);
+    if (::bind(listener_,
+               reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(listener_, 16) != 0) {
+      return false;
+    }
+
+    accepter_ = std::thread([this]() { accept(); });
+    return true;
+  }
+
+  void stop() {
+    stopping_ = true;
+    if (accepter_.joinable()) {
+      accepter_.join();
+    }
+    for (auto& connection : connections_) {
+      connection.join();
+    }
+    connections_.clear();
+
+    if (listener_ >= 0) {
+      ::close(listener_);
+      listener_ = -1;
+      fs::remove(path_);
+    }
+  }
+
+  const std::string& path() const {
+    return path_;
+  }
+
+  std::vector<std::string> requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+
+ public:
+  /// Response bodies by URI, other URIs are not found.
+  std::map<std::string, std::string> bodies;
+
+  /// Time spent on each request before answering.
+  std::chrono::milliseconds latency{0};
+
+  /// Send bodies with "Transfer-Encoding: chunked".
+  bool chunked{false};
+
+  /// Answer with "Connection: close" and close the connection.
+  bool close_connections{false};
+
+  /// Close the connection after the response, without telling the client.
+  bool drop_connections{false};
+
+  /// The number of accepted connections.
+  std::atomic<size_t> accepted{0};
+
+  /// The highest number of requests handled at once.
+  std::atomic<size_t> max_in_flight{0};
+
+ private:
+  void accept() {
+    while (!stopping_) {
+      pollfd fds[] = {{listener_, POLLIN, 0}};
+      if (::poll(fds, 1, 50) <= 0) {
+        continue;
+      }
+
+      auto connection = ::accept(listener_, nullptr, nullptr);
+      if (connection >= 0) {
+        accepted++;
+        connections_.emplace_back([this, connection]() { serve(connection); });
+      }
+    }
+  }
+
+  void serve(int connection) {
+    std::string buffer;
+    char data[4096];
+    while (!stopping_) {
+      auto end = buffer.find("\r\n\r\n");
+      if (end == std::string::npos) {
+        pollfd fds[] = {{connection, POLLIN, 0}};
+        if (::poll(fds, 1, 50) <= 0) {
+          continue;
+        }
+
+        auto size = ::recv(connection, data, sizeof(data), 0);
+        if (size <= 0) {
+          break;
+        }
+        buffer.append(data, static_cast<size_t>(size));
+        continue;
+      }
+
+      // The request line is "GET <uri> HTTP/1.1".
+      auto uri = buffer.substr(4, buffer.find(' ', 4) - 4);
+      buffer.erase(0, end + 4);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(uri);
+      }
+
+      auto current = ++in_flight_;
+      auto highest = max_in_flight.load();
+      while (current > highest &&
+             !max_in_flight.compare_exchange_weak(highest, current)) {
+      }
+      std::this_thread::sleep_for(latency);
+      in_flight_--;
+
+      auto response = respond(uri);
+      ::send(connection, response.data(), response.size(), MSG_NOSIGNAL);
+      if (close_connections || drop_connections) {
+        break;
+      }
+    }
+    ::close(connection);
+  }
+
+  std::string respond(const std::string& uri) {
+    auto it = bodies.find(uri);
+    if (it == bodies.end()) {
+      std::string body = "{\"message\":\"page not found\"}";
+      return "HTTP/1.1 404 Not Found\r\nContent-Length: " +
+             std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    std::string response = "HTTP/1.1 200 OK\r\n";
+    response += "Content-Type: application/json\r\n";
+    const auto& body = it->second;
+    if (close_connections) {
+      return response + "Connection: close\r\n\r\n" + body;
+    }
+
+    if (!chunked) {
+      return response + "Content-Length: " + std::to_string(body.size()) +
+             "\r\n\r\n" + body;
+    }
+
+    response += "Transfer-Encoding: chunked\r\n\r\n";
+    for (size_t i = 0; i < body.size(); i += 7) {
+      auto chunk = body.substr(i, 7);
+      char size[16];
+      std::snprintf(size, sizeof(size), "%zx", chunk.size());
+      response += std::string(size) + "\r\n" + chunk + "\r\n";
+    }
+    return response + "0\r\n\r\n";
+  }
+
+ private:
+  std::string path_;
+  int listener_{-1};
+  std::atomic<bool> stopping_{false};
+  std::atomic<size_t> in_flight_{0};
+
+  std::thread accepter_;
+
+  /// Only modified by the accepting thread, until it is joined.
+  std::vector<std::thread> connections_;
+
+  std::vector<std::string> requests_;
+  std::mutex mutex_;
+};
+
+const std::string kVersion =
+    "{\"Version\":\"20.10.7\",\"ApiVersion\":\"1.41\"}";
+
+} // namespace
+
+class DockerApiTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    max_connections_ = FLAGS_docker_api_connections;
+    server_.bodies["/version"] = kVersion;
+  }
+
+  void TearDown() override {
+    // Close the pooled connections before stopping the stand-in.
+    DockerClientPool::get().clear();
+    server_.stop();
+    FLAGS_docker_api_connections = max_connections_;
+  }
+
+ protected:
+  DockerStandIn server_;
+
+ private:
+  uint32_t max_connections_{0};
+};
+
+TEST_F(DockerApiTests, test_keep_alive) {
+  ASSERT_TRUE(server_.start());
+
+  auto& pool = DockerClientPool::get();
+  for (size_t i = 0; i < 3; ++i) {
+    std::string body;
+    auto s = pool.request(server_.path(), "/version", body);
+    ASSERT_TRUE(s.ok()) << s.getMessage();
+    EXPECT_EQ(body, kVersion);
+  }
+
+  // Every request was sent on the same connection.
+  EXPECT_EQ(server_.accepted.load(), 1U);
+  EXPECT_EQ(pool.idleConnections(server_.path()), 1U);
+}
+
+TEST_F(DockerApiTests, test_chunked_body) {
+  server_.chunked = true;
+  ASSERT_TRUE(server_.start());
+
+  std::string body;
+  auto& pool = DockerClientPool::get();
+  ASSERT_TRUE(pool.request(server_.path(), "/version", body).ok());
+  EXPECT_EQ(body, kVersion);
+
+  // The whole chunked response was consumed.
+  ASSERT_TRUE(pool.request(server_.path(), "/version", body).ok());
+  EXPECT_EQ(body, kVersion);
+  EXPECT_EQ(server_.accepted.load(), 1U);
+}
+
+TEST_F(DockerApiTests, test_error_response) {
+  ASSERT_TRUE(server_.start());
+
+  std::string body;
+  auto& pool = DockerClientPool::get();
+  auto s = pool.request(server_.path(), "/containers/missing/json", body);
+  EXPECT_FALSE(s.ok());
+
+  // The connection is still usable after an error response.
+  ASSERT_TRUE(pool.request(server_.path(), "/version", body).ok());
+  EXPECT_EQ(body, kVersion);
+  EXPECT_EQ(server_.accepted.load(), 1U);
+
+  // Missing sockets are reported.
+  auto missing = server_.path() + ".missing";
+  EXPECT_FALSE(pool.request(missing, "/version", body).ok());
+}
+
+TEST_F(DockerApiTests, test_connection_close) {
+  server_.close_connections = true;
+  ASSERT_TRUE(server_.start());
+
+  std::string body;
+  auto& pool = DockerClientPool::get();
+  ASSERT_TRUE(pool.request(server_.path(), "/version", body).ok());
+  EXPECT_EQ(body, kVersion);
+  EXPECT_EQ(pool.idleConnections(server_.path()), 0U);
+}
+
+TEST_F(DockerApiTests, test_reconnect) {
+  server_.drop_connections = true;
+  ASSERT_TRUE(server_.start());
+
+  auto& pool = DockerClientPool::get();
+  for (size_t i = 0; i < 2; ++i) {
+    std::string body;
+    auto s = pool.request(server_.path(), "/version", body);
+    ASSERT_TRUE(s.ok()) << s.getMessage();
+    EXPECT_EQ(body, kVersion);
+  }
+
+  // The second request was retried after the idle connection was closed.
+  EXPECT_EQ(server_.accepted.load(), 2U);
+}
+
+TEST_F(DockerApiTests, test_concurrent_requests) {
+  FLAGS_docker_api_connections = 4;
+  server_.latency = std::chrono::milliseconds(200);
+
+  std::vector<std::string> uris;
+  for (size_t i = 0; i < 8; ++i) {
+    uris.push_back("/containers/" + std::to_string(i) + "/json");
+    server_.bodies[uris.back()] = "{\"Id\":\"" + std::to_string(i) + "\"}";
+  }
+  uris.push_back("/containers/missing/json");
+  ASSERT_TRUE(server_.start());
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::string> bodies;
+  auto statuses =
+      DockerClientPool::get().requestAll(server_.path(), uris, bodies);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  ASSERT_EQ(statuses.size(), uris.size());
+  ASSERT_EQ(bodies.size(), uris.size());
+  for (size_t i = 0; i < 8; ++i) {
+    EXPECT_TRUE(statuses[i].ok());
+    EXPECT_EQ(bodies[i], server_.bodies.at(uris[i]));
+  }
+  EXPECT_FALSE(statuses.back().ok());
+
+  // Nine requests of 200ms each took about three rounds, not nine.
+  EXPECT_LT(elapsed, std::chrono::milliseconds(1400));
+  EXPECT_GT(server_.max_in_flight.load(), 1U);
+  EXPECT_LE(server_.max_in_flight.load(), 4U);
+  EXPECT_LE(server_.accepted.load(), 4U);
+}
+
+TEST_F(DockerApiTests, test_container_stats) {
+  server_.bodies["/containers/abc123/stats?stream=false&one-shot=true"] =
+      R"({"read":"2021-05-01T16:08:43.661631023Z",)"
+      R"("preread":"0001-01-01T00:00:00Z","name":"/web",)"
+      R"("pids_stats":{"current":3},)"
+      R"("blkio_stats":{"io_service_bytes_recursive":[)"
+      R"({"major":8,"minor":0,"op":"Read","value":100},)"
+      R"({"major":8,"minor":0,"op":"Write","value":20},)"
+      R"({"value":5,"op":"Read"}],"io_serviced_recursive":null},)"
+      R"("num_procs":0,"cpu_stats":{"cpu_usage":{"total_usage":900,)"
+      R"("percpu_usage":[400,500],"usage_in_kernelmode":300,)"
+      R"("usage_in_usermode":600},"system_cpu_usage":5000,)"
+      R"("online_cpus":2},"precpu_stats":{"cpu_usage":{"total_usage":0}},)"
+      R"("memory_stats":{"usage":4096,"max_usage":8192,)"
+      R"("stats":{"cache":1024,"rss":2048},"limit":65536},)"
+      R"("networks":{"eth0":{"rx_bytes":10,"tx_bytes":1},)"
+      R"("eth1":{"rx_bytes":30,"tx_bytes":2}}})";
+  ASSERT_TRUE(server_.start());
+
+  auto socket = FLAGS_docker_socket;
+  FLAGS_docker_socket = server_.path();
+
+  // Only the id column is used, none of the previous sample's columns.
+  QueryContext context;
+  context.constraints["id"].add(Constraint(EQUALS, "abc123"));
+  context.constraints["id"].add(Constraint(EQUALS, "not-an-id"));
+  context.colsUsedBitset = UsedColumnsBitset(1);
+  context.columnGroups = {{"precpu", UsedColumnsBitset(0x7c030ULL)}};
+
+  auto results = tables::genContainerStats(context);
+  ASSERT_EQ(results.size(), 1U);
+  auto& r = results[0];
+  EXPECT_EQ(r["id"], "abc123");
+  EXPECT_EQ(r["name"], "/web");
+  EXPECT_EQ(r["pids"], "3");
+  EXPECT_EQ(r["disk_read"], "105");
+  EXPECT_EQ(r["disk_write"], "20");
+  EXPECT_EQ(r["cpu_total_usage"], "900");
+  EXPECT_EQ(r["cpu_kernelmode_usage"], "300");
+  EXPECT_EQ(r["system_cpu_usage"], "5000");
+  EXPECT_EQ(r["online_cpus"], "2");
+  EXPECT_EQ(r["pre_cpu_total_usage"], "0");
+  EXPECT_EQ(r["memory_usage"], "4096");
+  EXPECT_EQ(r["memory_cached"], "1024");
+  EXPECT_EQ(r["memory_limit"], "65536");
+  EXPECT_EQ(r["network_rx_bytes"], "40");
+  EXPECT_EQ(r["network_tx_bytes"], "3");
+
+  // The previous sample is requested when its columns are used.
+  QueryContext all_columns;
+  all_columns.constraints["id"].add(Constraint(EQUALS, "abc123"));
+  EXPECT_TRUE(tables::genContainerStats(all_columns).empty());
+
+  auto requests = server_.requests();
+  ASSERT_EQ(requests.size(), 2U);
+  EXPECT_EQ(requests[1], "/containers/abc123/stats?stream=false");
+
+  FLAGS_docker_socket = socket;
+}
+
+} // namespace osquery
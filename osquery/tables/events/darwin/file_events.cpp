@@ -37,6 +37,11 @@ class FileEventSubscriber : public EventSubscriber<FSEventsEventPublisher> {
   /// Walk the configuration's file paths, create subscriptions.
   void configure() override;
 
+  /// The file paths are read from the "file_paths" parser.
+  std::set<std::string> configParsers() const override {
+    return {"file_paths"};
+  }
+
   /**
    * @brief This exports a single Callback for INotifyEventPublisher events.
    *
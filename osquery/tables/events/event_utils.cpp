@@ -7,13 +7,17 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <osquery/core/flags.h>
 #include <osquery/sql/sql.h>
 
+#include <osquery/hashing/file_hash_cache.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/tables/events/event_utils.h>
 
 namespace osquery {
 
+DECLARE_bool(disable_hash_cache);
+
 const std::set<std::string> kCommonFileColumns = {
     "inode", "uid", "gid", "mode", "size", "atime", "mtime", "ctime",
 };
@@ -30,8 +34,14 @@ void decorateFileEvent(const std::string& path, bool hash, Row& r) {
   }
 
   if (hash) {
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
+    // Share the hash table's cache, subscribers often see unchanged content.
+    MultiHashes hashes;
+    if (!FLAGS_disable_hash_cache) {
+      FileHashCache::get().load(path, hashes);
+    } else {
+      hashes = hashMultiFromFile(
+          HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
+    }
     r["md5"] = std::move(hashes.md5);
     r["sha1"] = std::move(hashes.sha1);
     r["sha256"] = std::move(hashes.sha256);
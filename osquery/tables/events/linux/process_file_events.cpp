@@ -1198,6 +1198,10 @@ void ProcessFileEventSubscriber::configure() {
   });
 }
 
+std::set<std::string> ProcessFileEventSubscriber::configParsers() const {
+  return {"file_paths"};
+}
+
 Status ProcessFileEventSubscriber::Callback(const ECRef& event_context,
                                             const SCRef& subscription_context) {
   std::vector<Row> emitted_row_list;
@@ -288,6 +288,9 @@ class ProcessFileEventSubscriber final
   /// Applies the user configuration to the subscriber
   void configure() override;
 
+  /// The configuration is read from the "file_paths" parser
+  std::set<std::string> configParsers() const override;
+
   /// This callback is called once for each AuditdFimEventPublisher::fire()
   Status Callback(const ECRef& event_context,
                   const SCRef& subscription_context);
@@ -260,6 +260,10 @@ void NTFSEventSubscriber::configure() {
       });
 }
 
+std::set<std::string> NTFSEventSubscriber::configParsers() const {
+  return {"file_paths"};
+}
+
 Status NTFSEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
   std::vector<Row> emitted_row_list;
 
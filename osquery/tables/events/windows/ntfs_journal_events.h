@@ -38,6 +38,9 @@ class NTFSEventSubscriber final : public EventSubscriber<NTFSEventPublisher> {
   /// Configuration callback; may be called more than once
   void configure() override;
 
+  /// Config parsers read by configure
+  std::set<std::string> configParsers() const override;
+
   /// Events are received from the publisher through this callback
   Status Callback(const ECRef& ec, const SCRef& sc);
 };
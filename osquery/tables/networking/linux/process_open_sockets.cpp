@@ -7,14 +7,142 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+#include <memory>
+
 #include <osquery/core/core.h>
+#include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/filesystem/linux/proc.h>
+#include <osquery/filesystem/linux/sock_diag.h>
 
 namespace osquery {
+
+FLAG(bool,
+     disable_sock_diag,
+     false,
+     "Read socket tables by parsing /proc instead of using NETLINK_SOCK_DIAG");
+
 namespace tables {
 
+/// TCP states rendered as UNKNOWN, below or beyond the known state names.
+const std::uint32_t kUnknownTCPStates{~((1U << 12) - 1) | 1U};
+
+/// The families and protocols queried per network namespace.
+struct SocketListRequest final {
+  /// Socket families (AF_*) to collect, empty means all.
+  std::set<int> families;
+
+  /// Set if non-TCP sockets, which have no state, cannot match the query.
+  bool tcp_only{false};
+
+  /// Filters pushed down to the sock_diag backend.
+  SocketDiagFilter filter;
+};
+
+static boost::optional<std::uint16_t> getPortConstraint(
+    QueryContext& context, const std::string& column) {
+  auto ports = context.constraints[column].getAll<int>(EQUALS);
+  if (ports.size() != 1) {
+    return boost::none;
+  }
+
+  auto port = *ports.begin();
+  if (port < 0 || port > 0xffff) {
+    return boost::none;
+  }
+  return static_cast<std::uint16_t>(port);
+}
+
+static SocketListRequest getSocketListRequest(QueryContext& context) {
+  SocketListRequest request;
+  if (context.constraints["family"].exists(EQUALS)) {
+    request.families = context.constraints["family"].getAll<int>(EQUALS);
+  }
+
+  if (context.constraints["state"].exists(EQUALS)) {
+    auto states = context.constraints["state"].getAll(EQUALS);
+    request.tcp_only =
+        (states.count("") == 0 && states.count(kSocketStateNone) == 0);
+
+    request.filter.tcp_states = 0;
+    for (const auto& state : states) {
+      auto it = std::find(tcp_states.begin(), tcp_states.end(), state);
+      if (state == "UNKNOWN") {
+        request.filter.tcp_states |= kUnknownTCPStates;
+      } else if (it != tcp_states.end()) {
+        request.filter.tcp_states |= 1U << (it - tcp_states.begin());
+      }
+    }
+  }
+
+  request.filter.local_port = getPortConstraint(context, "local_port");
+  request.filter.remote_port = getPortConstraint(context, "remote_port");
+  return request;
+}
+
+/**
+ * @brief Collect basic socket information for one network namespace.
+ *
+ * Uses NETLINK_SOCK_DIAG when possible and falls back to parsing the
+ * /proc/<pid>/net files of the first pid found in the namespace.
+ */
+static void genSocketList(const SocketListRequest& request,
+                          ino_t ns,
+                          bool own_namespace,
+                          const std::string& pid,
+                          SocketInfoList& socket_list) {
+  std::unique_ptr<SocketDiag> sock_diag;
+  if (!FLAGS_disable_sock_diag) {
+    auto status = SocketDiag::open(sock_diag, own_namespace ? "" : pid);
+    if (!status.ok()) {
+      VLOG(1) << "Cannot use sock_diag for the network namespace of pid "
+              << pid << ", reading /proc instead: " << status.what();
+    }
+  }
+
+  auto collect = [&](int family, int protocol, const std::string& name) {
+    if (!request.families.empty() && request.families.count(family) == 0) {
+      return;
+    }
+
+    if (request.tcp_only && protocol != IPPROTO_TCP) {
+      return;
+    }
+
+    if (sock_diag != nullptr && SocketDiag::isSupported(family, protocol)) {
+      auto size = socket_list.size();
+      auto status = sock_diag->getSocketList(
+          family, protocol, ns, request.filter, socket_list);
+      if (status.ok()) {
+        return;
+      }
+
+      // Discard a partial dump before falling back to /proc.
+      socket_list.resize(size);
+      VLOG(1) << "Cannot use sock_diag for " << name
+              << ", reading /proc instead: " << status.what();
+    }
+
+    auto status = procGetSocketList(family, protocol, ns, pid, socket_list);
+    if (!status.ok()) {
+      VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
+                 "to acquire basic socket information for "
+              << name << ": " << status.what();
+    }
+  };
+
+  for (const auto& pair : kLinuxProtocolNames) {
+    collect(AF_INET, pair.first, "AF_INET " + pair.second);
+    collect(AF_INET6, pair.first, "AF_INET6 " + pair.second);
+  }
+  collect(AF_UNIX, IPPROTO_IP, "AF_UNIX");
+
+  // protocol is 0, we want all protocols here.
+  collect(AF_PACKET, 0, "AF_PACKET");
+}
+
 QueryData genOpenSockets(QueryContext& context) {
   Status status;
   QueryData results;
@@ -56,26 +184,42 @@ QueryData genOpenSockets(QueryContext& context) {
    * information.
    *
    * 3. Collect basic socket information for all sockets under a specifc network
-   * namespace. This is done by reading through files under /proc/<pid>/net for
-   * the first pid we find in a certain namespace. Notice this will collect
-   * information for all sockets on the namespace not only for sockets
-   * associated with the specific pid, therefore only needs to be run once. From
+   * namespace. This is done with a NETLINK_SOCK_DIAG dump, or by reading
+   * through files under /proc/<pid>/net for the first pid we find in a certain
+   * namespace. Notice this will collect information for all sockets on the
+   * namespace not only for sockets associated with the specific pid, therefore
+   * only needs to be run once. From
    * this step we collect the inodes of each of the sockets, and will use that
    * to correlate the socket information with the information collect on steps
    * 1 and 2.
    */
 
+  /* Step 1 walks every fd of every process, skip it unless pid or fd are
+   * selected or filtered on.
+   */
+  bool map_inodes = pid_filter || context.isColumnGroupUsed("process");
+
+  /* Filters from the query constraints, used to skip unneeded sockets */
+  auto request = getSocketListRequest(context);
+
+  /* Sockets in the namespace of osquery itself need no setns for sock_diag */
+  ino_t own_ns = 0;
+  procGetNamespaceInode(own_ns, "net", kLinuxProcPath + "/self/ns");
+
   /* Use a set to record the namespaces already processed */
   std::set<ino_t> netns_list;
   SocketInodeToProcessInfoMap inode_proc_map;
   SocketInfoList socket_list;
   for (const auto& pid : pids) {
     /* Step 1 */
-    status = procGetSocketInodeToProcessInfoMap(pid, inode_proc_map);
-    if (!status.ok()) {
-      VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire socket inode to process map for pid "
-              << pid << ": " << status.what();
+    if (map_inodes) {
+      status = procGetSocketInodeToProcessInfoMap(pid, inode_proc_map);
+      if (!status.ok()) {
+        VLOG(1)
+            << "Results for process_open_sockets might be incomplete. Failed "
+               "to acquire socket inode to process map for pid "
+            << pid << ": " << status.what();
+      }
     }
 
     /* Step 2 */
@@ -99,39 +243,7 @@ QueryData genOpenSockets(QueryContext& context) {
       netns_list.insert(ns);
 
       /* Step 3 */
-      for (const auto& pair : kLinuxProtocolNames) {
-        status = procGetSocketList(AF_INET, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET "
-              << pair.second << ": " << status.what();
-        }
-
-        status = procGetSocketList(AF_INET6, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET6 "
-              << pair.second << ": " << status.what();
-        }
-      }
-      status = procGetSocketList(AF_UNIX, IPPROTO_IP, ns, pid, socket_list);
-      if (!status.ok()) {
-        VLOG(1)
-            << "Results for process_open_sockets might be incomplete. Failed "
-               "to acquire basic socket information for AF_UNIX: "
-            << status.what();
-      }
-
-      // protocol is 0, we want all protocols here.
-      status = procGetSocketList(AF_PACKET, 0, ns, pid, socket_list);
-      if (!status.ok()) {
-        VLOG(1)
-            << "Results for process_open_sockets might be incomplete. Failed "
-               "to acquire basic socket information for AF_PACKET: "
-            << status.what();
-      }
+      genSocketList(request, ns, ns == own_ns, pid, socket_list);
     }
   }
 
@@ -143,7 +255,9 @@ QueryData genOpenSockets(QueryContext& context) {
   for (const auto& info : socket_list) {
     Row r;
     auto proc_it = inode_proc_map.find(info.socket);
-    if (proc_it != inode_proc_map.end()) {
+    if (!map_inodes) {
+      /* Neither pid nor fd were requested. */
+    } else if (proc_it != inode_proc_map.end()) {
       r["pid"] = proc_it->second.pid;
       r["fd"] = proc_it->second.fd;
     } else if (!pid_filter) {
@@ -22,7 +22,34 @@ namespace tables {
 QueryData genListeningPorts(QueryContext& context) {
   QueryData results;
 
-  auto sockets = SQL::selectAllFrom("process_open_sockets");
+  // Mapping sockets to processes walks every process' fds, only ask for
+  // pid and fd when they are needed.
+  bool with_process = context.isColumnGroupUsed("process");
+
+  QueryData sockets;
+  if (isPlatform(PlatformType::TYPE_LINUX)) {
+    // Every non-inet socket reports a remote_port of 0 on Linux, so the
+    // listening filter can be pushed down to the socket dump.
+    if (with_process) {
+      sockets = SQL::selectAllFrom(
+          "process_open_sockets", "remote_port", EQUALS, "0");
+    } else {
+      sockets = SQL::selectFrom({"socket",
+                                 "family",
+                                 "protocol",
+                                 "local_address",
+                                 "local_port",
+                                 "remote_port",
+                                 "path",
+                                 "net_namespace"},
+                                "process_open_sockets",
+                                "remote_port",
+                                EQUALS,
+                                "0");
+    }
+  } else {
+    sockets = SQL::selectAllFrom("process_open_sockets");
+  }
 
   for (const auto& socket : sockets) {
     if (socket.at("family") == kAF_UNIX && socket.at("path").empty()) {
@@ -37,7 +64,9 @@ QueryData genListeningPorts(QueryContext& context) {
     }
 
     Row r;
-    r["pid"] = socket.at("pid");
+    if (with_process) {
+      r["pid"] = socket.at("pid");
+    }
 
     if (socket.at("family") == kAF_UNIX) {
       r["port"] = "0";
@@ -58,11 +87,13 @@ QueryData genListeningPorts(QueryContext& context) {
     r["protocol"] = socket.at("protocol");
     r["family"] = socket.at("family");
 
-    auto fd_it = socket.find("fd");
-    if (fd_it != socket.end()) {
-      r["fd"] = fd_it->second;
-    } else {
-      r["fd"] = "0";
+    if (with_process) {
+      auto fd_it = socket.find("fd");
+      if (fd_it != socket.end()) {
+        r["fd"] = fd_it->second;
+      } else {
+        r["fd"] = "0";
+      }
     }
 
     // When running under linux, we also have the user namespace
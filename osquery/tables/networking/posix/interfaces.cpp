@@ -186,8 +186,9 @@ void genDetailsFromAddr(const struct ifaddrs* addr,
         r["type"] = INTEGER_FROM_UCHAR(ifr.ifr_hwaddr.sa_family);
       }
 
-      r["link_speed"] = "0";
-      if (context.isColumnUsed("link_speed")) {
+      // The ethtool requests reach into the driver of each interface.
+      if (context.isColumnGroupUsed("driver")) {
+        r["link_speed"] = "0";
         struct ethtool_cmd cmd;
         ifr.ifr_data = reinterpret_cast<char*>(&cmd);
         cmd.cmd = ETHTOOL_GSET;
@@ -199,15 +200,16 @@ void genDetailsFromAddr(const struct ifaddrs* addr,
             r["link_speed"] = BIGINT_FROM_UINT32(speed);
           }
         }
-      }
-      struct ethtool_drvinfo drvInfo;
-      ifr.ifr_data = reinterpret_cast<char*>(&drvInfo);
-      drvInfo.cmd = ETHTOOL_GDRVINFO;
-
-      if (ioctl(fd, SIOCETHTOOL, &ifr) >= 0) {
-        r["pci_slot"] = drvInfo.bus_info;
-      } else {
-        r["pci_slot"] = "-1";
+
+        struct ethtool_drvinfo drvInfo;
+        ifr.ifr_data = reinterpret_cast<char*>(&drvInfo);
+        drvInfo.cmd = ETHTOOL_GDRVINFO;
+
+        if (ioctl(fd, SIOCETHTOOL, &ifr) >= 0) {
+          r["pci_slot"] = drvInfo.bus_info;
+        } else {
+          r["pci_slot"] = "-1";
+        }
       }
 
       close(fd);
@@ -237,8 +239,8 @@ void genDetailsFromAddr(const struct ifaddrs* addr,
     r["odrops"] = INTEGER(0);
     r["collisions"] = BIGINT_FROM_UINT32(ifd->ifi_collisions);
     r["last_change"] = BIGINT_FROM_UINT32(ifd->ifi_lastchange.tv_sec);
-    r["link_speed"] = "0";
-    if (context.isColumnUsed("link_speed")) {
+    if (context.isColumnGroupUsed("driver")) {
+      r["link_speed"] = "0";
       int fd = socket(AF_INET, SOCK_DGRAM, 0);
       if (fd >= 0) {
         struct ifmediareq ifmr = {};
@@ -23,7 +23,10 @@ QueryData genMounts(QueryContext& context) {
   int mnts = 0;
   int i;
 
-  mnts = getmntinfo(&mnt, MNT_WAIT);
+  // MNT_WAIT refreshes the statistics of every filesystem, which may block
+  // on network mounts. The cached information is enough without them.
+  bool with_statfs = context.isColumnGroupUsed("statfs");
+  mnts = getmntinfo(&mnt, with_statfs ? MNT_WAIT : MNT_NOWAIT);
   if (mnts == 0) {
     // Failed to get mount information.
     return results;
@@ -36,12 +39,14 @@ QueryData genMounts(QueryContext& context) {
     r["device_alias"] = canonicalize_file_name(mnt[i].f_mntfromname);
     r["type"] = SQL_TEXT(mnt[i].f_fstypename);
     r["flags"] = INTEGER(mnt[i].f_flags);
-    r["blocks"] = BIGINT(mnt[i].f_blocks);
-    r["blocks_free"] = BIGINT(mnt[i].f_bfree);
-    r["blocks_available"] = BIGINT(mnt[i].f_bavail);
-    r["blocks_size"] = BIGINT(mnt[i].f_bsize);
-    r["inodes"] = BIGINT(mnt[i].f_files);
-    r["inodes_free"] = BIGINT(mnt[i].f_ffree);
+    if (with_statfs) {
+      r["blocks"] = BIGINT(mnt[i].f_blocks);
+      r["blocks_free"] = BIGINT(mnt[i].f_bfree);
+      r["blocks_available"] = BIGINT(mnt[i].f_bavail);
+      r["blocks_size"] = BIGINT(mnt[i].f_bsize);
+      r["inodes"] = BIGINT(mnt[i].f_files);
+      r["inodes_free"] = BIGINT(mnt[i].f_ffree);
+    }
     r["owner"] = INTEGER(mnt[i].f_owner);
     results.push_back(r);
   }
@@ -131,7 +131,7 @@ QueryData genGroups(QueryContext& context) {
   return results;
 }
 
-void genUserRow(Row& r, const passwd* pwd) {
+void genUserRow(Row& r, const passwd* pwd, bool with_uuid) {
   r["username"] = SQL_TEXT(pwd->pw_name);
   r["uid"] = BIGINT(pwd->pw_uid);
   r["gid"] = BIGINT(pwd->pw_gid);
@@ -141,6 +141,11 @@ void genUserRow(Row& r, const passwd* pwd) {
   r["directory"] = SQL_TEXT(pwd->pw_dir);
   r["shell"] = SQL_TEXT(pwd->pw_shell);
 
+  // The UUID is resolved by the membership service.
+  if (!with_uuid) {
+    return;
+  }
+
   uuid_t uuid = {0};
   uuid_string_t uuid_string = {0};
 
@@ -155,6 +160,7 @@ void genUserRow(Row& r, const passwd* pwd) {
 
 QueryData genUsers(QueryContext& context) {
   QueryData results;
+  auto with_uuid = context.isColumnGroupUsed("membership");
   @autoreleasepool {
     if (context.constraints["uid"].exists(EQUALS)) {
       auto uids = context.constraints["uid"].getAll<long long>(EQUALS);
@@ -169,7 +175,7 @@ QueryData genUsers(QueryContext& context) {
         genODEntries(kODRecordTypeUsers, username, usernames);
 
         Row r;
-        genUserRow(r, pwd);
+        genUserRow(r, pwd, with_uuid);
         r["is_hidden"] = INTEGER(usernames[r["username"]]);
         results.push_back(r);
       }
@@ -187,7 +193,7 @@ QueryData genUsers(QueryContext& context) {
 
         struct passwd* pwd = getpwnam(username.first.c_str());
         if (pwd != nullptr) {
-          genUserRow(r, pwd);
+          genUserRow(r, pwd, with_uuid);
         } else {
           r["username"] = SQL_TEXT(username.first.c_str());
         }
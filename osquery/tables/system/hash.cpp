@@ -7,27 +7,31 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
-// clang-format off
-#include <sys/types.h>
-#include <sys/stat.h>
-// clang-format on
-
 #ifndef WIN32
-#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <set>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
 #include <osquery/core/flags.h>
 #include <osquery/filesystem/filesystem.h>
+#ifndef WIN32
+#include <osquery/filesystem/posix/file_metadata.h>
+#endif
+#include <osquery/hashing/file_hash_cache.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
 #include <osquery/core/tables.h>
 #include <osquery/sql/dynamic_table_row.h>
-#include <osquery/utils/mutex.h>
 #include <osquery/utils/info/platform_type.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
@@ -35,201 +39,185 @@
 
 namespace osquery {
 
-FLAG(bool,
-     disable_hash_cache,
-     false,
-     "Cache calculated file hashes, re-calculate only if inode times change");
-
-FLAG(uint32, hash_cache_max, 500, "Size of LRU file hash cache");
+FLAG(uint32,
+     hash_threads,
+     1,
+     "Number of threads used to hash files within one hash table query");
 
 HIDDEN_FLAG(uint32,
             hash_delay,
             20,
             "Number of milliseconds to delay after hashing");
 
+DECLARE_bool(disable_hash_cache);
 DECLARE_uint64(read_max);
 
 namespace tables {
 
-/// Clear this amount of rows every time cache eviction is triggered.
-const size_t kHashCacheEvictSize{5};
+/// The digests calculated for every row of the hash table.
+const int kHashTableMask{HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256};
 
-/**
- * @brief Implements persistent in-memory caching of files' hashes.
- *
- * This cache has LRU eviction policy. The hash is recalculated
- * every time the mtime or size of the file changes.
- */
-struct FileHashCache {
-  /// The file's modification time, changes with a touch.
-  time_t file_mtime;
+/// The digests whose column groups are used by the query.
+int getHashMask(const QueryContext& context) {
+  int mask = 0;
+  if (context.isColumnGroupUsed("md5")) {
+    mask |= HASH_TYPE_MD5;
+  }
+  if (context.isColumnGroupUsed("sha1")) {
+    mask |= HASH_TYPE_SHA1;
+  }
+  if (context.isColumnGroupUsed("sha256")) {
+    mask |= HASH_TYPE_SHA256;
+  }
+  return mask;
+}
 
-  /// The file's serial or information number (inode).
-  ino_t file_inode;
+/// A regular file selected by the path or directory constraints.
+struct HashTarget {
+  /// The file path, as expanded from the query constraints.
+  std::string path;
 
-  /// The file's size.
-  off_t file_size;
+  /// The directory column, which may be the directory constraint itself.
+  std::string directory;
 
-  /// For eviction, the last time this cache item was used.
-  time_t cache_access_time;
+  /// The digests to calculate.
+  int mask{kHashTableMask};
 
-  /// Cache content, the hashes.
+  /// The calculated hashes.
   MultiHashes hashes;
 
-  /// Cache index, the file path.
-  std::string path;
+  /// The result of loading the hashes through the file hash cache.
+  Status status;
 
-  /// Comparison function for organizing the LRU heap.
-  static bool greater(const FileHashCache* l, const FileHashCache* r) {
-    return l->cache_access_time > r->cache_access_time;
-  }
-
-  /**
-   * @brief Do-it-all access function.
-   *
-   * Maintains the cache of hash sums, stats file at path, if it has changed or
-   * it is not present in cache calculates the hashes and caches the result.
-   *
-   * @param path the path of file to hash.
-   * @param out stores the calculated hashes.
-   *
-   * @return true if succeeded, false if something went wrong.
-   */
-  static bool load(const std::string& path, MultiHashes& out, Logger& logger);
+  /// Set if the inner-query cache already has this path.
+  bool cached{false};
 };
 
-#if defined(WIN32)
-
-#define stat _stat
-#define strerror_r(e, buf, sz) strerror_s((buf), (sz), (e))
-
-#endif
-
-/**
- * @brief Checks the current stat output against the cached view.
- *
- * If the modified/altered time or the file's inode has changed then the hash
- * should be recalculated.
- */
-static inline bool statInvalid(const struct stat& st, const FileHashCache& fh) {
-  if (st.st_ino != fh.file_inode || st.st_mtime != fh.file_mtime) {
-    // Most plausible case for modification detection.
-    return true;
+void genHashForTarget(HashTarget& target) {
+  if (target.mask == 0) {
+    // No digest is selected, the file is not read.
+    return;
   }
 
-  if (st.st_size != fh.file_size) {
-    // Just in case there's tomfoolery.
-    return true;
+  if (!FLAGS_disable_hash_cache) {
+    target.status = FileHashCache::get().load(target.path, target.hashes);
+  } else if (!target.cached) {
+    target.hashes = hashMultiFromFile(target.mask, target.path);
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_hash_delay));
   }
-  return false;
 }
 
-bool FileHashCache::load(const std::string& path,
-                         MultiHashes& out,
-                         Logger& logger) {
-  // synchronize the access to cache
-  static Mutex mx;
-  // path => cache entry
-  static std::unordered_map<std::string, FileHashCache> cache;
-  // minheap on cache_access_time
-  static std::vector<FileHashCache*> lru;
-
-  WriteLock guard(mx);
-
-  struct stat st;
-  if (stat(path.c_str(), &st) != 0) {
-    char buf[0x200] = {0};
-    strerror_r(errno, buf, sizeof(buf));
-    logger.log(google::GLOG_WARNING, "Cannot stat file: " + path + ": " + buf);
-    return false;
+/**
+ * @brief Hash every target, optionally across a small pool of threads.
+ *
+ * With more than one thread the reads of one file overlap with the hashing
+ * of another. Targets are handed out in order and results are stored in
+ * place, so the output order does not depend on the thread count.
+ *
+ * A path selected by both the path and directory constraints has a target
+ * for each, it is hashed once and the result is copied to the others.
+ */
+void genHashForTargets(std::vector<HashTarget>& targets) {
+  std::unordered_map<std::string, size_t> first_targets;
+  std::vector<size_t> unique_targets;
+  std::vector<std::pair<size_t, size_t>> duplicate_targets;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    auto inserted = first_targets.emplace(targets[i].path, i);
+    if (inserted.second) {
+      unique_targets.push_back(i);
+    } else {
+      duplicate_targets.emplace_back(i, inserted.first->second);
+    }
   }
 
-  auto entry = cache.find(path);
-  if (entry == cache.end()) { // none, load
-    if (cache.size() >= FLAGS_hash_cache_max) {
-      // too large, evict
-      for (size_t i = 0; i < kHashCacheEvictSize; ++i) {
-        if (lru.empty()) {
-          continue;
-        }
-        std::string key = lru[0]->path;
-        std::pop_heap(lru.begin(), lru.end(), FileHashCache::greater);
-        lru.pop_back();
-        if (cache.find(key) != cache.end()) {
-          cache.erase(key);
+  auto workers = std::min<size_t>(FLAGS_hash_threads, unique_targets.size());
+  if (workers <= 1) {
+    for (auto index : unique_targets) {
+      genHashForTarget(targets[index]);
+    }
+  } else {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; ++i) {
+      threads.emplace_back([&targets, &unique_targets, &next]() {
+        for (auto index = next++; index < unique_targets.size();
+             index = next++) {
+          genHashForTarget(targets[unique_targets[index]]);
         }
-      }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
     }
+  }
 
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    FileHashCache rec = {st.st_mtime, // .file_mtime
-                         st.st_ino, // .file_inode
-                         st.st_size, // .file_size
-                         time(nullptr), // .cache_access_time
-                         std::move(hashes), // .hashes
-                         path}; // .path
-    cache[path] = std::move(rec);
-    lru.push_back(&cache[path]);
-    std::push_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = cache[path].hashes;
-  } else if (statInvalid(st, entry->second)) { // changed, update
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    entry->second.cache_access_time = time(nullptr);
-    entry->second.file_inode = st.st_ino;
-    entry->second.file_mtime = st.st_mtime;
-    entry->second.file_size = st.st_size;
-    entry->second.hashes = std::move(hashes);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = entry->second.hashes;
-  } else { // ok, got it
-    out = entry->second.hashes;
-    entry->second.cache_access_time = time(nullptr);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
+  for (const auto& duplicate : duplicate_targets) {
+    const auto& first = targets[duplicate.second];
+    targets[duplicate.first].hashes = first.hashes;
+    targets[duplicate.first].status = first.status;
   }
-  return true;
 }
 
-void genHashForFile(const std::string& path,
-                    const std::string& dir,
-                    QueryContext& context,
-                    QueryData& results,
-                    Logger& logger) {
+void genHashRow(HashTarget& target,
+                QueryContext& context,
+                QueryData& results,
+                Logger& logger) {
+  if (!target.status.ok()) {
+    logger.log(google::GLOG_WARNING, target.status.getMessage());
+  }
+
   // Must provide the path, filename, directory separate from boost path->string
   // helpers to match any explicit (query-parsed) predicate constraints.
   auto tr = TableRowHolder(new DynamicTableRow());
-  MultiHashes hashes;
-  if (!FLAGS_disable_hash_cache) {
-    FileHashCache::load(path, hashes, logger);
-  } else {
-    if (context.isCached(path)) {
-      // Use the inner-query cache if the global hash cache is disabled.
-      // This protects against hashing the same content twice in the same query.
-      tr = context.getCache(path);
-    } else {
-      hashes = hashMultiFromFile(
-          HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-      std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_hash_delay));
-    }
-  }
-
   DynamicTableRow& r = *dynamic_cast<DynamicTableRow*>(tr.get());
-  r["path"] = path;
-  r["directory"] = dir;
-  r["md5"] = std::move(hashes.md5);
-  r["sha1"] = std::move(hashes.sha1);
-  r["sha256"] = std::move(hashes.sha256);
-
-  if (FLAGS_disable_hash_cache) {
-    context.setCache(path, tr);
+  r["path"] = target.path;
+  r["directory"] = target.directory;
+  if (target.mask & HASH_TYPE_MD5) {
+    r["md5"] = std::move(target.hashes.md5);
+  }
+  if (target.mask & HASH_TYPE_SHA1) {
+    r["sha1"] = std::move(target.hashes.sha1);
+  }
+  if (target.mask & HASH_TYPE_SHA256) {
+    r["sha256"] = std::move(target.hashes.sha256);
   }
-
   r["pid_with_namespace"] = "0";
 
+  // Only rows with every digest are reused by the inner-query cache.
+  if (FLAGS_disable_hash_cache && !target.cached &&
+      target.mask == kHashTableMask) {
+    context.setCache(target.path, tr);
+  }
+
   results.push_back(static_cast<Row>(r));
 }
 
+void addHashTarget(const std::string& path,
+                   const std::string& dir,
+                   int mask,
+                   QueryContext& context,
+                   std::vector<HashTarget>& targets) {
+  HashTarget target;
+  target.path = path;
+  target.directory = dir;
+  target.mask = mask;
+
+  if (FLAGS_disable_hash_cache && mask != 0 && context.isCached(path)) {
+    // Use the inner-query cache if the global hash cache is disabled.
+    // This protects against hashing the same content twice in the same query.
+    auto cached = context.getCache(path);
+    DynamicTableRow& r = *dynamic_cast<DynamicTableRow*>(cached.get());
+    target.hashes.mask = kHashTableMask;
+    target.hashes.md5 = r["md5"];
+    target.hashes.sha1 = r["sha1"];
+    target.hashes.sha256 = r["sha256"];
+    target.cached = true;
+  }
+
+  targets.push_back(std::move(target));
+}
+
 void expandFSPathConstraints(QueryContext& context,
                              const std::string& path_column_name,
                              std::set<std::string>& paths) {
@@ -250,9 +238,21 @@ void expandFSPathConstraints(QueryContext& context,
       }));
 }
 
+#ifndef WIN32
+/// Check if a path, or a directory entry, is or links to a regular file.
+bool isRegularFileAt(int dirfd, const std::string& path) {
+  FileMetadata metadata;
+  return getFileMetadata(dirfd, path, kFileMetadataType, true, metadata)
+             .ok() &&
+         fileMetadataType(metadata) == S_IFREG;
+}
+#endif
+
 QueryData genHashImpl(QueryContext& context, Logger& logger) {
   QueryData results;
   boost::system::error_code ec;
+  std::vector<HashTarget> targets;
+  auto mask = getHashMask(context);
 
   // The query must provide a predicate with constraints including path or
   // directory. We search for the parsed predicate constraints with the equals
@@ -260,15 +260,21 @@ QueryData genHashImpl(QueryContext& context, Logger& logger) {
   auto paths = context.constraints["path"].getAll(EQUALS);
   expandFSPathConstraints(context, "path", paths);
 
-  // Iterate through the file paths, adding the hash results
+  // Iterate through the file paths, adding the hash targets
   for (const auto& path_string : paths) {
     boost::filesystem::path path = path_string;
+#ifndef WIN32
+    if (!isRegularFileAt(AT_FDCWD, path_string)) {
+      continue;
+    }
+#else
     if (!boost::filesystem::is_regular_file(path, ec)) {
       continue;
     }
+#endif
 
-    genHashForFile(
-        path_string, path.parent_path().string(), context, results, logger);
+    addHashTarget(
+        path_string, path.parent_path().string(), mask, context, targets);
   }
 
   // Now loop through constraints using the directory column constraint.
@@ -277,20 +283,50 @@ QueryData genHashImpl(QueryContext& context, Logger& logger) {
 
   // Iterate over the directory paths
   for (const auto& directory_string : directories) {
+#ifndef WIN32
+    std::unique_ptr<DirectoryReader> reader;
+    if (!DirectoryReader::open(AT_FDCWD, directory_string, reader).ok()) {
+      continue;
+    }
+
+    // The entry type usually comes with the directory listing, only
+    // symlinks and entries of unknown type are looked up.
+    DirectoryEntry entry;
+    while (reader->next(entry)) {
+      bool regular = (entry.type == S_IFREG);
+      if (entry.type == 0 || entry.type == S_IFLNK) {
+        regular = isRegularFileAt(reader->fd(), entry.name);
+      }
+
+      if (regular) {
+        addHashTarget(joinDirectoryEntry(directory_string, entry.name),
+                      directory_string,
+                      mask,
+                      context,
+                      targets);
+      }
+    }
+#else
     boost::filesystem::path directory = directory_string;
     if (!boost::filesystem::is_directory(directory, ec)) {
       continue;
     }
 
-    // Iterate over the directory files and generate a hash for each regular
+    // Iterate over the directory files and add a target for each regular
     // file.
     boost::filesystem::directory_iterator begin(directory), end;
     for (; begin != end; ++begin) {
       if (boost::filesystem::is_regular_file(begin->path(), ec)) {
-        genHashForFile(
-            begin->path().string(), directory_string, context, results, logger);
+        addHashTarget(
+            begin->path().string(), directory_string, mask, context, targets);
       }
     }
+#endif
+  }
+
+  genHashForTargets(targets);
+  for (auto& target : targets) {
+    genHashRow(target, context, results, logger);
   }
 
   return results;
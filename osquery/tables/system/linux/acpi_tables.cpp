@@ -21,7 +21,9 @@ namespace tables {
 
 const std::string kLinuxACPIPath = "/sys/firmware/acpi/tables";
 
-void genACPITable(const std::string& table, QueryData& results) {
+void genACPITable(const std::string& table,
+                  bool with_content,
+                  QueryData& results) {
   fs::path table_path = table;
 
   // There may be "categories" of tables in the form of directories.
@@ -31,7 +33,7 @@ void genACPITable(const std::string& table, QueryData& results) {
     status = osquery::listFilesInDirectory(table_path, child_tables);
     if (status.ok()) {
       for (const auto& child_table : child_tables) {
-        genACPITable(child_table, results);
+        genACPITable(child_table, with_content, results);
       }
     }
 
@@ -40,6 +42,11 @@ void genACPITable(const std::string& table, QueryData& results) {
 
   Row r;
   r["name"] = table_path.filename().string();
+  if (!with_content) {
+    // The size of the sysfs nodes is only known after reading them.
+    results.push_back(r);
+    return;
+  }
 
   std::string table_content;
   status = osquery::readFile(table_path, table_content);
@@ -65,8 +72,9 @@ QueryData genACPITables(QueryContext& context) {
     return {};
   }
 
+  auto with_content = context.isColumnGroupUsed("content");
   for (const auto& table : tables) {
-    genACPITable(table, results);
+    genACPITable(table, with_content, results);
   }
 
   return results;
@@ -9,6 +9,7 @@
 
 #include <boost/algorithm/string/replace.hpp>
 
+#include <osquery/core/table_source_cache.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
@@ -198,9 +199,7 @@ static void genAptSource(const std::string& source,
   }
 }
 
-QueryData genAptSrcsImpl(QueryContext& context, Logger& logger) {
-  QueryData results;
-
+static Status genAptSrcRows(Logger& logger, QueryData& results) {
   // We are going to read a few files.
   auto dropper = DropPrivileges::get();
   dropper->dropTo("nobody");
@@ -211,23 +210,38 @@ QueryData genAptSrcsImpl(QueryContext& context, Logger& logger) {
   if (!resolveFilePattern(
           "/etc/apt/sources.list.d/%.list", sources, GLOB_FILES)) {
     logger.vlog(1, "Cannot resolve apt sources /etc/apt/sources.list.d");
-    return results;
+    return Status::failure("Cannot resolve apt sources");
   }
 
   for (const auto& source : sources) {
     genAptSource(source, results, logger);
   }
 
+  return Status::success();
+}
+
+QueryData genAptSrcsImpl(QueryContext& context, Logger& logger) {
+  QueryData results;
+  genAptSrcRows(logger, results);
   return results;
 }
 
 QueryData genAptSrcs(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "apt_sources", genAptSrcsImpl);
-  } else {
-    GLOGLogger logger;
-    return genAptSrcsImpl(context, logger);
   }
+
+  // Source names are read from the cached Release files of each source.
+  GLOGLogger logger;
+  return TableSourceCache::get().generate(
+      "apt_sources",
+      "",
+      {"/etc/apt/sources.list",
+       "/etc/apt/sources.list.d",
+       "/var/lib/apt/lists"},
+      ([&logger](SourceFingerprint&, QueryData& results) {
+        return genAptSrcRows(logger, results);
+      }));
 }
 } // namespace tables
 } // namespace osquery
@@ -62,7 +62,20 @@ void populatePVChildren(lvm_t lvm,
   lvm_vg_close(vg);
 }
 
+/// The optional lookups made for each block device.
+struct BlockDeviceLookups {
+  /// Read the model and vendor of the SCSI parent device.
+  bool scsi{true};
+
+  /// Report the type, UUID and label found by probing the superblocks.
+  bool probe{true};
+
+  /// Map LVM logical volumes to their physical volume, this also probes.
+  bool lvm{true};
+};
+
 static void getBlockDevice(struct udev_device* dev,
+                           const BlockDeviceLookups& lookups,
                            QueryData& results,
                            std::map<std::string, std::string>& lvm_lv2pv) {
   Row r;
@@ -94,7 +107,11 @@ static void getBlockDevice(struct udev_device* dev,
     r["block_size"] = block_size;
   }
 
-  subdev = udev_device_get_parent_with_subsystem_devtype(dev, "scsi", nullptr);
+  subdev = nullptr;
+  if (lookups.scsi) {
+    subdev =
+        udev_device_get_parent_with_subsystem_devtype(dev, "scsi", nullptr);
+  }
   if (subdev != nullptr) {
     const char *model = udev_device_get_sysattr_value(subdev, "model");
     std::string model_string = std::string(model);
@@ -107,27 +124,38 @@ static void getBlockDevice(struct udev_device* dev,
     r["vendor"] = model_string;
   }
 
-  blkid_probe pr = blkid_new_probe_from_filename(name);
+  // Probing opens and reads from every device.
+  blkid_probe pr = nullptr;
+  if (lookups.probe || lookups.lvm) {
+    pr = blkid_new_probe_from_filename(name);
+  }
   if (pr != nullptr) {
     blkid_probe_enable_superblocks(pr, 1);
     blkid_probe_set_superblocks_flags(
         pr, BLKID_SUBLKS_LABEL | BLKID_SUBLKS_UUID | BLKID_SUBLKS_TYPE);
 
     if (!blkid_do_safeprobe(pr)) {
+      // Without the probe group the values are only used for LVM.
+      Row probed;
       const char *blk_value = nullptr;
       if (!blkid_probe_lookup_value(pr, "TYPE", &blk_value, nullptr)) {
-        r["type"] = blk_value;
+        probed["type"] = blk_value;
       }
       if (!blkid_probe_lookup_value(pr, "UUID", &blk_value, nullptr)) {
-        r["uuid"] = blk_value;
+        probed["uuid"] = blk_value;
       }
       if (!blkid_probe_lookup_value(pr, "LABEL", &blk_value, nullptr)) {
-        r["label"] = blk_value;
+        probed["label"] = blk_value;
+      }
+      if (lookups.probe) {
+        r.insert(probed.begin(), probed.end());
       }
-      if (boost::algorithm::starts_with(r["type"], "LVM")) {
+      auto type = probed.find("type");
+      if (lookups.lvm && type != probed.end() &&
+          boost::algorithm::starts_with(type->second, "LVM")) {
         lvm_t lvm = lvm_init(nullptr);
         if (lvm != nullptr) {
-          populatePVChildren(lvm, name, r["uuid"], lvm_lv2pv);
+          populatePVChildren(lvm, name, probed["uuid"], lvm_lv2pv);
           lvm_quit(lvm);
         }
       }
@@ -154,6 +182,11 @@ QueryData genBlockDevs(QueryContext &context) {
   udev_enumerate_add_match_subsystem(enumerate, "block");
   udev_enumerate_scan_devices(enumerate);
 
+  BlockDeviceLookups lookups;
+  lookups.scsi = context.isColumnGroupUsed("scsi");
+  lookups.probe = context.isColumnGroupUsed("probe");
+  lookups.lvm = context.isColumnUsed("parent");
+
   std::map<std::string, std::string> lvm_lv2pv;
   struct udev_list_entry *devices, *dev_list_entry;
   devices = udev_enumerate_get_list_entry(enumerate);
@@ -161,7 +194,7 @@ QueryData genBlockDevs(QueryContext &context) {
     const char* path = udev_list_entry_get_name(dev_list_entry);
     struct udev_device* dev = udev_device_new_from_syspath(udev, path);
     if (path != nullptr && dev != nullptr) {
-      getBlockDevice(dev, results, lvm_lv2pv);
+      getBlockDevice(dev, lookups, results, lvm_lv2pv);
     }
     udev_device_unref(dev);
   }
@@ -61,6 +61,15 @@ struct CertificateInformation final {
 
 using CertificateInformationList = std::vector<CertificateInformation>;
 
+/// The optional parts of each certificate to decode.
+struct CertificateLookups final {
+  /// Encode the certificate to hash it.
+  bool digest{true};
+
+  /// Decode the key usage and key identifier extensions.
+  bool extensions{true};
+};
+
 enum class OpenSSLError {
   OpenFailed,
   ReadFailed,
@@ -96,7 +105,7 @@ Expected<UniqueX509InfoStack, OpenSSLError> readCertificateStackFromBIO(
 }
 
 Expected<CertificateInformation, OpenSSLError> generateCertificateInformation(
-    X509_INFO* x509_info) {
+    X509_INFO* x509_info, const CertificateLookups& lookups) {
   if (x509_info == nullptr) {
     return createError(OpenSSLError::InvalidX509Info);
   }
@@ -157,26 +166,30 @@ Expected<CertificateInformation, OpenSSLError> generateCertificateInformation(
     cert_info.not_valid_after = opt_not_valid_after.value();
   }
 
-  auto opt_digest = generateCertificateSHA1Digest(x509);
-  if (opt_digest.has_value()) {
-    cert_info.sha1 = opt_digest.value();
+  if (lookups.digest) {
+    auto opt_digest = generateCertificateSHA1Digest(x509);
+    if (opt_digest.has_value()) {
+      cert_info.sha1 = opt_digest.value();
+    }
   }
 
   getCertificateAttributes(x509, cert_info.is_ca, cert_info.is_self_signed);
 
-  auto opt_cert_key_usage = getCertificateKeyUsage(x509);
-  if (opt_cert_key_usage.has_value()) {
-    cert_info.key_usage = opt_cert_key_usage.value();
-  }
+  if (lookups.extensions) {
+    auto opt_cert_key_usage = getCertificateKeyUsage(x509);
+    if (opt_cert_key_usage.has_value()) {
+      cert_info.key_usage = opt_cert_key_usage.value();
+    }
 
-  auto opt_authority_key_id = getCertificateAuthorityKeyID(x509);
-  if (opt_authority_key_id.has_value()) {
-    cert_info.authority_key_id = opt_authority_key_id.value();
-  }
+    auto opt_authority_key_id = getCertificateAuthorityKeyID(x509);
+    if (opt_authority_key_id.has_value()) {
+      cert_info.authority_key_id = opt_authority_key_id.value();
+    }
 
-  auto opt_subject_key_id = getCertificateSubjectKeyID(x509);
-  if (opt_subject_key_id.has_value()) {
-    cert_info.subject_key_id = opt_subject_key_id.value();
+    auto opt_subject_key_id = getCertificateSubjectKeyID(x509);
+    if (opt_subject_key_id.has_value()) {
+      cert_info.subject_key_id = opt_subject_key_id.value();
+    }
   }
 
   auto opt_cert_serial_number = getCertificateSerialNumber(x509);
@@ -188,11 +201,12 @@ Expected<CertificateInformation, OpenSSLError> generateCertificateInformation(
 }
 
 Expected<CertificateInformationList, OpenSSLError> parseX509InfoStack(
-    UniqueX509InfoList x509_info_list) {
+    UniqueX509InfoList x509_info_list, const CertificateLookups& lookups) {
   CertificateInformationList cert_info_list;
 
   for (auto& x509_info : x509_info_list) {
-    auto exp_cert_info = generateCertificateInformation(x509_info.get());
+    auto exp_cert_info =
+        generateCertificateInformation(x509_info.get(), lookups);
     if (exp_cert_info.isError()) {
       return exp_cert_info.takeError();
     }
@@ -205,7 +219,7 @@ Expected<CertificateInformationList, OpenSSLError> parseX509InfoStack(
 }
 
 Expected<CertificateInformationList, OpenSSLError> enumerateBundleCertificates(
-    const std::filesystem::path& path) {
+    const std::filesystem::path& path, const CertificateLookups& lookups) {
   // Open the bundle file
   auto exp_cert_bundle = createFileBasedBIO(path);
   if (exp_cert_bundle.isError()) {
@@ -238,7 +252,7 @@ Expected<CertificateInformationList, OpenSSLError> enumerateBundleCertificates(
     }
   }
 
-  return parseX509InfoStack(std::move(x509_info_list));
+  return parseX509InfoStack(std::move(x509_info_list), lookups);
 }
 
 } // namespace
@@ -258,8 +272,12 @@ QueryData genCerts(QueryContext& context) {
     }
   }
 
+  CertificateLookups lookups;
+  lookups.digest = context.isColumnGroupUsed("digest");
+  lookups.extensions = context.isColumnGroupUsed("extensions");
+
   for (const auto& bundle_path : bundle_path_list) {
-    auto exp_cert_info_list = enumerateBundleCertificates(bundle_path);
+    auto exp_cert_info_list = enumerateBundleCertificates(bundle_path, lookups);
     if (exp_cert_info_list.isError()) {
       auto error = exp_cert_info_list.takeError();
       LOG(ERROR) << error.getMessage();
@@ -284,10 +302,14 @@ QueryData genCerts(QueryContext& context) {
       row["signing_algorithm"] = SQL_TEXT(cert_info.signing_algorithm);
       row["key_algorithm"] = SQL_TEXT(cert_info.key_algorithm);
       row["key_strength"] = SQL_TEXT(cert_info.key_strength);
-      row["key_usage"] = SQL_TEXT(cert_info.key_usage);
-      row["subject_key_id"] = SQL_TEXT(cert_info.subject_key_id);
-      row["authority_key_id"] = SQL_TEXT(cert_info.authority_key_id);
-      row["sha1"] = SQL_TEXT(cert_info.sha1);
+      if (lookups.extensions) {
+        row["key_usage"] = SQL_TEXT(cert_info.key_usage);
+        row["subject_key_id"] = SQL_TEXT(cert_info.subject_key_id);
+        row["authority_key_id"] = SQL_TEXT(cert_info.authority_key_id);
+      }
+      if (lookups.digest) {
+        row["sha1"] = SQL_TEXT(cert_info.sha1);
+      }
       row["serial"] = SQL_TEXT(cert_info.serial);
 
       results.push_back(std::move(row));
@@ -8,8 +8,10 @@
  */
 
 #include <osquery/core/system.h>
+#include <osquery/core/table_source_cache.h>
 #include <osquery/core/tables.h>
 #include <osquery/logger/logger.h>
+#include <osquery/utils/conversions/join.h>
 #include <osquery/utils/linux/idpkgquery.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
@@ -37,9 +39,7 @@ void logError(Logger& logger,
                  " (admindir='" + admindir + "')");
 }
 
-} // namespace
-
-QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
+std::vector<std::string> getAdminDirs(QueryContext& context) {
   std::vector<std::string> admindir_list{};
 
   if (context.hasConstraint("admindir", EQUALS)) {
@@ -52,6 +52,12 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
     admindir_list.push_back(kAdminDir);
   }
 
+  return admindir_list;
+}
+
+Status genDebPackageRows(const std::vector<std::string>& admindir_list,
+                         Logger& logger,
+                         QueryData& results) {
   // Drop to 'nobody' to ensure that the libdpkg library
   // can't change the package database. Privileges will be
   // restored automatically when the `dropper` object goes
@@ -61,8 +67,7 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
   auto dropper = DropPrivileges::get();
   dropper->dropTo("nobody");
 
-  QueryData results;
-
+  Status status;
   for (const auto& admindir : admindir_list) {
     auto dpkg_query_exp = IDpkgQuery::create(admindir);
     if (dpkg_query_exp.isError()) {
@@ -71,6 +76,7 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
                dpkg_query_exp.takeError(),
                admindir);
 
+      status = Status::failure("Failed to open the dpkg database");
       continue;
     }
 
@@ -83,6 +89,7 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
                package_list_exp.takeError(),
                admindir);
 
+      status = Status::failure("Failed to list the packages");
       continue;
     }
 
@@ -107,16 +114,39 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
     }
   }
 
+  return status;
+}
+
+} // namespace
+
+QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
+  QueryData results;
+  genDebPackageRows(getAdminDirs(context), logger, results);
   return results;
 }
 
 QueryData genDebPackages(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "deb_packages", genDebPackagesImpl);
-  } else {
-    GLOGLogger logger;
-    return genDebPackagesImpl(context, logger);
   }
+
+  // The status file is replaced, and pending updates are journaled, when
+  // packages are installed or removed.
+  auto admindir_list = getAdminDirs(context);
+  std::vector<std::string> sources;
+  for (const auto& admindir : admindir_list) {
+    sources.push_back(admindir + "/status");
+    sources.push_back(admindir + "/updates");
+  }
+
+  GLOGLogger logger;
+  return TableSourceCache::get().generate(
+      "deb_packages",
+      join(admindir_list, ":"),
+      sources,
+      ([&admindir_list, &logger](SourceFingerprint&, QueryData& results) {
+        return genDebPackageRows(admindir_list, logger, results);
+      }));
 }
 } // namespace tables
 } // namespace osquery
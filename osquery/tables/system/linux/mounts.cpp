@@ -14,8 +14,11 @@
 namespace osquery {
 namespace tables {
 QueryData genMounts(QueryContext& context) {
+  // A statfs on a network mount may block, skip it when unused.
+  bool with_statfs = context.isColumnGroupUsed("statfs");
+
   MountedFilesystems mounted_fs{};
-  auto status = getMountedFilesystems(mounted_fs);
+  auto status = getMountedFilesystems(mounted_fs, with_statfs);
   if (!status.ok()) {
     LOG(ERROR) << "Failed to list the system mounts: " << status.getMessage();
     return {};
@@ -34,7 +37,10 @@ QueryData genMounts(QueryContext& context) {
 
     // optional::has_value is not present in Boost 1.66 (which is
     // what we have when compiling with BUCK)
-    if (mount_info.optional_statfs_info != boost::none) {
+    if (!with_statfs) {
+      // The statfs columns were not requested.
+
+    } else if (mount_info.optional_statfs_info != boost::none) {
       const auto& statfs_info = mount_info.optional_statfs_info.value();
 
       r["blocks_size"] = BIGINT(statfs_info.block_size);
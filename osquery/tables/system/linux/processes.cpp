@@ -452,8 +452,6 @@ void genProcess(const std::string& pid,
                 TableRows& results) {
   // Parse the process stat and status.
   SimpleProcStat proc_stat(pid);
-  // Parse the process io
-  SimpleProcIo proc_io(pid);
 
   if (!proc_stat.status.ok()) {
     VLOG(1) << proc_stat.status.getMessage() << " for pid " << pid;
@@ -463,19 +461,22 @@ void genProcess(const std::string& pid,
   auto r = make_table_row();
   r["pid"] = pid;
   r["parent"] = proc_stat.parent;
-  r["path"] = readProcLink("exe", pid);
   r["name"] = proc_stat.name;
   r["pgroup"] = proc_stat.group;
   r["state"] = proc_stat.state;
   r["nice"] = proc_stat.nice;
   r["threads"] = proc_stat.threads;
-  // Read/parse cmdline arguments.
-  r["cmdline"] = readProcCMDLine(pid);
-  if (context.isColumnUsed("cgroup_path")) {
+  if (context.isColumnGroupUsed("cmdline")) {
+    // Read/parse cmdline arguments.
+    r["cmdline"] = readProcCMDLine(pid);
+  }
+  if (context.isColumnGroupUsed("cgroup")) {
     r["cgroup_path"] = readProcCgroup(pid);
   }
-  r["cwd"] = readProcLink("cwd", pid);
-  r["root"] = readProcLink("root", pid);
+  if (context.isColumnGroupUsed("links")) {
+    r["cwd"] = readProcLink("cwd", pid);
+    r["root"] = readProcLink("root", pid);
+  }
   r["uid"] = proc_stat.real_uid;
   r["euid"] = proc_stat.effective_uid;
   r["suid"] = proc_stat.saved_uid;
@@ -483,7 +484,10 @@ void genProcess(const std::string& pid,
   r["egid"] = proc_stat.effective_gid;
   r["sgid"] = proc_stat.saved_gid;
 
-  r["on_disk"] = INTEGER(getOnDisk(pid, r["path"]));
+  if (context.isColumnGroupUsed("exe")) {
+    r["path"] = readProcLink("exe", pid);
+    r["on_disk"] = INTEGER(getOnDisk(pid, r["path"]));
+  }
 
   // size/memory information
   r["wired_size"] = "0"; // No support for unpagable counters in linux.
@@ -505,17 +509,22 @@ void genProcess(const std::string& pid,
     r["start_time"] = "-1";
   }
 
-  if (!proc_io.status.ok()) {
-    // /proc/<pid>/io can require root to access, so don't fail if we can't
-    VLOG(1) << proc_io.status.getMessage();
-  } else {
-    r["disk_bytes_read"] = proc_io.read_bytes;
-    long long write_bytes = tryTo<long long>(proc_io.write_bytes).takeOr(0ll);
-    long long cancelled_write_bytes =
-        tryTo<long long>(proc_io.cancelled_write_bytes).takeOr(0ll);
-
-    r["disk_bytes_written"] =
-        std::to_string(write_bytes - cancelled_write_bytes);
+  if (context.isColumnGroupUsed("io")) {
+    // Parse the process io
+    SimpleProcIo proc_io(pid);
+    if (!proc_io.status.ok()) {
+      // /proc/<pid>/io can require root to access, so don't fail if we can't
+      VLOG(1) << proc_io.status.getMessage();
+    } else {
+      r["disk_bytes_read"] = proc_io.read_bytes;
+      long long write_bytes =
+          tryTo<long long>(proc_io.write_bytes).takeOr(0ll);
+      long long cancelled_write_bytes =
+          tryTo<long long>(proc_io.cancelled_write_bytes).takeOr(0ll);
+
+      r["disk_bytes_written"] =
+          std::to_string(write_bytes - cancelled_write_bytes);
+    }
   }
 
   results.push_back(r);
@@ -18,6 +18,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <osquery/core/system.h>
+#include <osquery/core/table_source_cache.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
@@ -39,6 +40,19 @@ namespace tables {
 // Maximum number of files per RPM.
 #define MAX_RPM_FILES (64 * 1024)
 
+/**
+ * @brief The files rewritten when packages are installed or removed.
+ *
+ * The rpmdb is either a Berkeley DB or, since RPM 4.16, an SQLite database.
+ * Other files in the rpmdb directory, such as the Berkeley DB environment
+ * and the SQLite shared memory index, are written by readers as well.
+ */
+const std::vector<std::string> kRpmDatabaseFiles = {
+    "/var/lib/rpm/Packages",
+    "/var/lib/rpm/rpmdb.sqlite",
+    "/var/lib/rpm/rpmdb.sqlite-wal",
+};
+
 /**
  * @brief Return a string representation of the RPM tag type.
  *
@@ -125,13 +139,13 @@ class RpmEnvironmentManager : public boost::noncopyable {
   Logger* logger_;
 };
 
-QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
-  QueryData results;
-
+static Status genRpmPackageRows(QueryContext& context,
+                                Logger& logger,
+                                QueryData& results) {
   auto dropper = DropPrivileges::get();
   if (!dropper->dropTo("nobody") && isUserAdmin()) {
     logger.log(google::GLOG_WARNING, "Cannot drop privileges for rpm_packages");
-    return results;
+    return Status::failure("Cannot drop privileges");
   }
 
   // Isolate RPM/package inspection to the canonical: /usr/lib/rpm.
@@ -141,12 +155,12 @@ QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
   rpmInitCrypto();
   if (rpmReadConfigFiles(nullptr, nullptr) != 0) {
     logger.vlog(1, "Cannot read RPM configuration files");
-    return results;
+    return Status::failure("Cannot read RPM configuration files");
   }
 
   rpmts ts = rpmtsCreate();
   rpmdbMatchIterator matches;
-  if (context.constraints["name"].exists(EQUALS)) {
+  if (context.constraints["name"].getAll(EQUALS).size() == 1) {
     auto name = (*context.constraints["name"].getAll(EQUALS).begin());
     matches = rpmtsInitIterator(ts, RPMTAG_NAME, name.c_str(), name.size());
   } else {
@@ -180,19 +194,63 @@ QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
   rpmFreeCrypto();
   rpmFreeRpmrc();
 
+  return Status::success();
+}
+
+QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
+  QueryData results;
+  genRpmPackageRows(context, logger, results);
   return results;
 }
 
 QueryData genRpmPackages(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "rpm_packages", genRpmPackagesImpl);
-  } else {
-    GLOGLogger logger;
-    return genRpmPackagesImpl(context, logger);
   }
+
+  // The implementation only uses a single name constraint.
+  std::string key;
+  if (context.constraints["name"].getAll(EQUALS).size() == 1) {
+    key = "name=" + *context.constraints["name"].getAll(EQUALS).begin();
+  }
+
+  GLOGLogger logger;
+  return TableSourceCache::get().generate(
+      "rpm_packages",
+      key,
+      kRpmDatabaseFiles,
+      ([&context, &logger](SourceFingerprint&, QueryData& results) {
+        return genRpmPackageRows(context, logger, results);
+      }));
 }
 
 void genRpmPackageFiles(RowYield& yield, QueryContext& context) {
+  // The implementation only uses a single package constraint.
+  std::string key;
+  if (context.constraints["package"].getAll(EQUALS).size() == 1) {
+    key = "package=" + *context.constraints["package"].getAll(EQUALS).begin();
+  }
+
+  // Rows without digests are cached apart from complete rows.
+  bool with_digest = context.isColumnGroupUsed("digest");
+  if (!with_digest) {
+    key += ";nodigest";
+  }
+
+  auto& cache = TableSourceCache::get();
+  QueryData cached;
+  if (cache.lookup("rpm_package_files", key, cached)) {
+    for (auto& row : cached) {
+      yield(TableRowHolder(new DynamicTableRow(std::move(row))));
+    }
+    return;
+  }
+
+  // Rows are kept for the cache until they exceed its maximum size.
+  SourceFingerprint sources(kRpmDatabaseFiles);
+  bool cacheable = true;
+  size_t cached_bytes = 0;
+
   GLOGLogger logger;
   auto dropper = DropPrivileges::get();
   if (!dropper->dropTo("nobody") && isUserAdmin()) {
@@ -211,7 +269,7 @@ void genRpmPackageFiles(RowYield& yield, QueryContext& context) {
 
   rpmts ts = rpmtsCreate();
   rpmdbMatchIterator matches;
-  if (context.constraints["package"].exists(EQUALS)) {
+  if (context.constraints["package"].getAll(EQUALS).size() == 1) {
     auto name = (*context.constraints["package"].getAll(EQUALS).begin());
     matches = rpmtsInitIterator(ts, RPMTAG_NAME, name.c_str(), name.size());
   } else {
@@ -241,7 +299,7 @@ void genRpmPackageFiles(RowYield& yield, QueryContext& context) {
 
     // Iterate over every file in this package.
     for (size_t i = 0; rpmfiNext(fi) >= 0 && i < file_count; i++) {
-      auto r = make_table_row();
+      Row r;
       auto path = rpmfiFN(fi);
       r["package"] = package_name;
       r["path"] = (path != nullptr) ? path : "";
@@ -252,16 +310,27 @@ void genRpmPackageFiles(RowYield& yield, QueryContext& context) {
       r["mode"] = lsperms(rpmfiFMode(fi));
       r["size"] = BIGINT(rpmfiFSize(fi));
 
-      int digest_algo;
-      auto digest = rpmfiFDigestHex(fi, &digest_algo);
-      if (digest_algo == PGPHASHALGO_SHA256) {
-        r["sha256"] = (digest != nullptr) ? digest : "";
-      }
-      if (digest != nullptr) {
-        free(digest);
+      if (with_digest) {
+        int digest_algo;
+        auto digest = rpmfiFDigestHex(fi, &digest_algo);
+        if (digest_algo == PGPHASHALGO_SHA256) {
+          r["sha256"] = (digest != nullptr) ? digest : "";
+        }
+        if (digest != nullptr) {
+          free(digest);
+        }
       }
 
-      yield(std::move(r));
+      if (cacheable) {
+        cached_bytes += TableSourceCache::getMemorySize(r);
+        cacheable = (cached_bytes <= cache.capacity());
+        if (cacheable) {
+          cached.push_back(r);
+        } else {
+          QueryData().swap(cached);
+        }
+      }
+      yield(TableRowHolder(new DynamicTableRow(std::move(r))));
     }
 
     rpmfiFree(fi);
@@ -271,6 +340,11 @@ void genRpmPackageFiles(RowYield& yield, QueryContext& context) {
   rpmdbFreeIterator(matches);
   rpmtsFree(ts);
   rpmFreeRpmrc();
+
+  if (cacheable) {
+    cache.insert(
+        "rpm_package_files", key, std::move(sources), std::move(cached));
+  }
 }
 } // namespace tables
 } // namespace osquery
@@ -27,19 +27,27 @@ namespace tables {
 
 QueryData genSystemInfo(QueryContext& context) {
   Row r;
-  r["hostname"] = osquery::getFqdn();
   r["computer_name"] = osquery::getHostname();
-  r["local_hostname"] = r["hostname"];
 
-  std::string uuid;
-  r["uuid"] = (osquery::getHostUUID(uuid)) ? uuid : "";
+  // The FQDN lookup may wait on DNS.
+  if (context.isColumnGroupUsed("hostname")) {
+    r["hostname"] = osquery::getFqdn();
+    r["local_hostname"] = r["hostname"];
+  }
+
+  if (context.isColumnGroupUsed("uuid")) {
+    std::string uuid;
+    r["uuid"] = (osquery::getHostUUID(uuid)) ? uuid : "";
+  }
 
 #ifdef __x86_64__
-  auto qd = SQL::selectAllFrom("cpuid");
-  for (const auto& row : qd) {
-    if (row.at("feature") == "product_name") {
-      r["cpu_brand"] = row.at("value");
-      boost::trim(r["cpu_brand"]);
+  if (context.isColumnGroupUsed("cpuid")) {
+    auto qd = SQL::selectAllFrom("cpuid");
+    for (const auto& row : qd) {
+      if (row.at("feature") == "product_name") {
+        r["cpu_brand"] = row.at("value");
+        boost::trim(r["cpu_brand"]);
+      }
     }
   }
 #endif /* __x86_64__ */
@@ -58,8 +66,6 @@ QueryData genSystemInfo(QueryContext& context) {
     r["physical_memory"] = "-1";
   }
 
-  r["cpu_subtype"] = "0";
-
   struct utsname utsbuf;
   if (uname(&utsbuf) == -1) {
     LOG(WARNING) << "Failed to get cpu_type, uname failed with error code: "
@@ -69,39 +75,43 @@ QueryData genSystemInfo(QueryContext& context) {
   }
 
   // Read the types from CPU info within proc.
-  std::string content;
-  if (readFile("/proc/cpuinfo", content)) {
-    for (const auto& line : osquery::split(content, "\n")) {
-      // Iterate each line and look for labels (there is also a model type).
-      if (line.find("model\t") == 0) {
-        auto details = osquery::split(line, ":");
-        if (details.size() == 2) {
-          r["cpu_subtype"] = details[1];
+  if (context.isColumnGroupUsed("cpuinfo")) {
+    r["cpu_subtype"] = "0";
+
+    std::string content;
+    if (readFile("/proc/cpuinfo", content)) {
+      for (const auto& line : osquery::split(content, "\n")) {
+        // Iterate each line and look for labels (there is also a model type).
+        if (line.find("model\t") == 0) {
+          auto details = osquery::split(line, ":");
+          if (details.size() == 2) {
+            r["cpu_subtype"] = details[1];
+          }
+        } else if (line.find("microcode") == 0) {
+          auto details = osquery::split(line, ":");
+          if (details.size() == 2) {
+            r["cpu_microcode"] = details[1];
+          }
+        } else if (line.find("siblings") == 0) {
+          auto details = osquery::split(line, ":");
+          if (details.size() == 2) {
+            unsigned int logical_cores_per_socket = std::stoi(details[1]);
+            r["cpu_sockets"] =
+                (logical_cores > 0 && logical_cores_per_socket > 0)
+                    ? INTEGER(logical_cores / logical_cores_per_socket)
+                    : "-1";
+          }
         }
-      } else if (line.find("microcode") == 0) {
-        auto details = osquery::split(line, ":");
-        if (details.size() == 2) {
-          r["cpu_microcode"] = details[1];
-        }
-      } else if (line.find("siblings") == 0) {
-        auto details = osquery::split(line, ":");
-        if (details.size() == 2) {
-          unsigned int logical_cores_per_socket = std::stoi(details[1]);
-          r["cpu_sockets"] =
-              (logical_cores > 0 && logical_cores_per_socket > 0)
-                  ? INTEGER(logical_cores / logical_cores_per_socket)
-                  : "-1";
-        }
-      }
 
-      // Minor optimization to not parse every line.
-      if (line.size() == 0) {
-        break;
+        // Minor optimization to not parse every line.
+        if (line.size() == 0) {
+          break;
+        }
       }
     }
   }
 
-  {
+  if (context.isColumnGroupUsed("smbios")) {
     LinuxSMBIOSParser parser;
     if (!parser.discover()) {
       r["hardware_model"] = "";
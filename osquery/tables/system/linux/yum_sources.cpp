@@ -11,6 +11,7 @@
 #include <fstream>
 #include <iostream>
 
+#include <osquery/core/table_source_cache.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
@@ -73,35 +74,51 @@ void parseYumConf(const std::string& source,
   }
 }
 
-QueryData genYumSrcsImpl(QueryContext& context, Logger& logger) {
-  QueryData results;
+static Status genYumSrcRows(SourceFingerprint& fingerprint,
+                            Logger& logger,
+                            QueryData& results) {
   // Expect the YUM home to be /etc/yum.conf
   std::string repos_dir;
   parseYumConf(kYumConf, results, repos_dir, logger);
 
+  // The repos directory is configured in yum.conf.
+  fingerprint.add(repos_dir);
   std::vector<std::string> sources;
   if (!resolveFilePattern(
           repos_dir + "/%" + kYumConfigFileExtension, sources, GLOB_FILES)) {
     logger.vlog(1,
                 "Cannot resolve yum conf files under " + repos_dir + "/*" +
                     kYumConfigFileExtension);
-    return results;
+    return Status::failure("Cannot resolve yum conf files");
   }
 
   for (const auto& source : sources) {
     parseYumConf(source, results, repos_dir, logger);
   }
 
+  return Status::success();
+}
+
+QueryData genYumSrcsImpl(QueryContext& context, Logger& logger) {
+  QueryData results;
+  SourceFingerprint fingerprint;
+  genYumSrcRows(fingerprint, logger, results);
   return results;
 }
 
 QueryData genYumSrcs(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "yum_sources", genYumSrcsImpl);
-  } else {
-    GLOGLogger logger;
-    return genYumSrcsImpl(context, logger);
   }
+
+  GLOGLogger logger;
+  return TableSourceCache::get().generate(
+      "yum_sources",
+      "",
+      {kYumConf},
+      ([&logger](SourceFingerprint& sources, QueryData& results) {
+        return genYumSrcRows(sources, logger, results);
+      }));
 }
 } // namespace tables
 } // namespace osquery
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <osquery/core/flags.h>
+#include <osquery/tables/system/posix/append_only_file.h>
+
+namespace osquery {
+
+DECLARE_uint64(read_max);
+
+namespace tables {
+
+namespace {
+
+/// The number of bytes preceding an offset covered by its checksum.
+const size_t kAppendOnlyChecksumSize{4096};
+
+/// FNV-1a, a cheap checksum of the bytes preceding an offset.
+uint64_t getChecksum(const char* data, size_t size) {
+  uint64_t checksum = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    checksum ^= static_cast<unsigned char>(data[i]);
+    checksum *= 1099511628211ULL;
+  }
+  return checksum;
+}
+
+/// Read exactly size bytes at an offset, a short read is an error.
+bool readAt(int fd, uint64_t offset, size_t size, std::string& buffer) {
+  buffer.resize(size);
+  size_t total = 0;
+  while (total < size) {
+    auto part = ::pread(fd,
+                        &buffer[total],
+                        size - total,
+                        static_cast<off_t>(offset + total));
+    if (part < 0 && errno == EINTR) {
+      continue;
+    }
+    if (part <= 0) {
+      return false;
+    }
+    total += static_cast<size_t>(part);
+  }
+  return true;
+}
+
+/// Checksum the bytes preceding an offset.
+bool getChecksumAt(int fd, uint64_t offset, uint64_t& checksum) {
+  auto size = static_cast<size_t>(
+      std::min(offset, static_cast<uint64_t>(kAppendOnlyChecksumSize)));
+  std::string buffer;
+  if (!readAt(fd, offset - size, size, buffer)) {
+    return false;
+  }
+  checksum = getChecksum(buffer.data(), buffer.size());
+  return true;
+}
+
+} // namespace
+
+Status readAppendedLines(const std::string& path,
+                         const AppendOnlyFileState& from,
+                         AppendedLines& lines) {
+  lines = AppendedLines();
+
+  // Histories may be replaced by FIFOs, never block opening or reading.
+  auto fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return Status::failure("Cannot open file for reading: " + path);
+  }
+
+  struct stat file;
+  if (::fstat(fd, &file) != 0 || !S_ISREG(file.st_mode)) {
+    ::close(fd);
+    return Status::failure("Cannot read a non-regular file: " + path);
+  }
+
+  auto inode = static_cast<uint64_t>(file.st_ino);
+  auto size = static_cast<uint64_t>(file.st_size);
+
+  // Resume only if the bytes preceding the offset are unchanged.
+  uint64_t start = 0;
+  if (from.offset > 0 && from.inode == inode && from.offset <= size) {
+    uint64_t checksum = 0;
+    if (getChecksumAt(fd, from.offset, checksum) &&
+        checksum == from.checksum) {
+      start = from.offset;
+      lines.resumed = true;
+    }
+  }
+
+  if (size - start > FLAGS_read_max) {
+    ::close(fd);
+    return Status::failure("Cannot read " + path + " size exceeds limit");
+  }
+
+  std::string content;
+  if (!readAt(fd, start, static_cast<size_t>(size - start), content)) {
+    ::close(fd);
+    return Status::failure("Cannot read file: " + path);
+  }
+
+  // A line without a newline may still be written to, it is read again.
+  auto newline = content.rfind('\n');
+  auto consumed = (newline == std::string::npos) ? 0 : newline + 1;
+  lines.tail = content.substr(consumed);
+  content.resize(consumed);
+  lines.content = std::move(content);
+
+  lines.state.inode = inode;
+  lines.state.offset = start + consumed;
+  if (!getChecksumAt(fd, lines.state.offset, lines.state.checksum)) {
+    // The file was truncated while it was read, do not resume from it.
+    lines.state = AppendOnlyFileState();
+  }
+
+  ::close(fd);
+  return Status::success();
+}
+
+} // namespace tables
+} // namespace osquery
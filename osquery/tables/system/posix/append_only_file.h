@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+namespace tables {
+
+/// Where a read of an append-only file stopped.
+struct AppendOnlyFileState {
+  /// The inode of the file, a rotated file has a new inode.
+  uint64_t inode{0};
+
+  /// The offset following the last complete line read.
+  uint64_t offset{0};
+
+  /// A checksum of the bytes preceding the offset.
+  uint64_t checksum{0};
+
+  bool operator==(const AppendOnlyFileState& other) const {
+    return inode == other.inode && offset == other.offset &&
+           checksum == other.checksum;
+  }
+
+  bool operator!=(const AppendOnlyFileState& other) const {
+    return !(*this == other);
+  }
+};
+
+/// The lines read from an append-only file.
+struct AppendedLines {
+  /// Complete lines, each followed by a newline.
+  std::string content;
+
+  /// A final line without a newline, it is read again by the next read.
+  std::string tail;
+
+  /// True if content follows the state read from, otherwise the whole file.
+  bool resumed{false};
+
+  /// The state following content, to read from next.
+  AppendOnlyFileState state;
+};
+
+/**
+ * @brief Read the lines appended to a file since a previous read.
+ *
+ * Tables parsing histories and logs, such as shell_history, reparse the whole
+ * file on every query although only a few lines were appended since. A caller
+ * keeping what it parsed in memory also keeps the state where the previous
+ * read stopped, and only reads the lines appended since.
+ *
+ * A file is read from its beginning if it was rotated (its inode changed),
+ * truncated (it is smaller than the offset) or rewritten (the bytes before the
+ * offset changed). Callers must then discard what they parsed previously.
+ *
+ * Example:
+ *   @code{.cpp}
+ *     AppendedLines lines;
+ *     if (readAppendedLines(path, cached.state, lines).ok()) {
+ *       parse(lines.content, lines.resumed);
+ *       cached.state = lines.state;
+ *     }
+ *   @endcode
+ *
+ * @param path The file path.
+ * @param from Where the previous read stopped, an empty state reads the whole
+ * file.
+ * @param lines The output lines, and the state following them.
+ */
+Status readAppendedLines(const std::string& path,
+                         const AppendOnlyFileState& from,
+                         AppendedLines& lines);
+
+} // namespace tables
+} // namespace osquery
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <map>
+#include <memory>
 #include <regex>
 #include <string>
 #include <vector>
@@ -14,8 +16,10 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/tables/system/posix/append_only_file.h>
 #include <osquery/tables/system/posix/shell_history.h>
 #include <osquery/tables/system/system_utils.h>
+#include <osquery/utils/mutex.h>
 #include <osquery/utils/system/system.h>
 
 namespace osquery {
@@ -29,84 +33,187 @@ const std::vector<std::string> kShellHistoryFiles = {
     ".sh_history",
 };
 
-struct HistoryState {
-  std::string content;
-  std::regex bash_timestamp_rx{"^#([0-9]+)$"};
-  std::regex zsh_timestamp_rx{"^: {0,10}([0-9]{1,11}):[0-9]+;(.*)$"};
+/// The maximum memory of the history lines kept between queries.
+const size_t kShellHistoryCacheMaxSize{64 * 1024 * 1024};
+
+/// A parsed history line.
+struct HistoryCommand {
+  std::string time;
+  std::string command;
+};
+
+using HistoryCommands = std::vector<HistoryCommand>;
+
+/// The lines parsed from a history file, up to where its last read stopped.
+struct HistoryFile {
+  AppendOnlyFileState state;
+
+  /// Readers keep a reference, the lines are copied before appending.
+  std::shared_ptr<HistoryCommands> commands;
+
+  /// A bash timestamp waiting for its command line.
   std::string prev_bash_timestamp;
+
+  /// The estimated memory of the parsed lines.
+  size_t bytes{0};
+
+  /// The cache use count when the file was last read, to evict the oldest.
+  size_t last_use{0};
 };
 
+/// Parsed history files by path, histories are only appended to.
+struct HistoryCache {
+  std::map<std::string, HistoryFile> files;
+  size_t bytes{0};
+  size_t uses{0};
+  Mutex mutex;
+};
+
+HistoryCache& getHistoryCache() {
+  static HistoryCache cache;
+  return cache;
+}
+
+/**
+ * @brief Parse a history line.
+ *
+ * @return False if the line is a bash timestamp, the timestamp of the
+ * following line.
+ */
+bool parseHistoryLine(std::string& line,
+                      std::string& prev_bash_timestamp,
+                      HistoryCommand& command) {
+  static const std::regex bash_timestamp_rx{"^#([0-9]+)$"};
+  static const std::regex zsh_timestamp_rx{
+      "^: {0,10}([0-9]{1,11}):[0-9]+;(.*)$"};
+
+  std::smatch bash_timestamp_matches;
+  std::smatch zsh_timestamp_matches;
+
+  if (prev_bash_timestamp.empty() &&
+      std::regex_search(line, bash_timestamp_matches, bash_timestamp_rx)) {
+    prev_bash_timestamp = bash_timestamp_matches[1];
+    return false;
+  }
+
+  if (!prev_bash_timestamp.empty()) {
+    command.time = INTEGER(prev_bash_timestamp);
+    command.command = std::move(line);
+    prev_bash_timestamp.clear();
+  } else if (std::regex_search(
+                 line, zsh_timestamp_matches, zsh_timestamp_rx)) {
+    std::string timestamp = zsh_timestamp_matches[1];
+    command.time = INTEGER(timestamp);
+    command.command = zsh_timestamp_matches[2];
+  } else {
+    command.time = INTEGER(0);
+    command.command = std::move(line);
+  }
+  return true;
+}
+
 void genShellHistoryFromFile(
     const std::string& uid,
     const boost::filesystem::path& history_file,
     std::function<void(DynamicTableRowHolder& row)> predicate) {
-  struct HistoryState hState;
-
-  auto parseLine =
-      [&hState, &uid, &history_file, &predicate](std::string& line) {
-        std::smatch bash_timestamp_matches;
-        std::smatch zsh_timestamp_matches;
-
-        if (hState.prev_bash_timestamp.empty() &&
-            std::regex_search(
-                line, bash_timestamp_matches, hState.bash_timestamp_rx)) {
-          hState.prev_bash_timestamp = bash_timestamp_matches[1];
-          return;
-        }
+  auto path = history_file.string();
+  auto& cache = getHistoryCache();
 
-        auto r = make_table_row();
-
-        if (!hState.prev_bash_timestamp.empty()) {
-          r["time"] = INTEGER(hState.prev_bash_timestamp);
-          r["command"] = std::move(line);
-          hState.prev_bash_timestamp.clear();
-        } else if (std::regex_search(
-                       line, zsh_timestamp_matches, hState.zsh_timestamp_rx)) {
-          std::string timestamp = zsh_timestamp_matches[1];
-          r["time"] = INTEGER(timestamp);
-          r["command"] = zsh_timestamp_matches[2];
-        } else {
-          r["time"] = INTEGER(0);
-          r["command"] = std::move(line);
-        }
+  std::shared_ptr<const HistoryCommands> commands;
+  std::string tail;
+  std::string prev_bash_timestamp;
+  {
+    WriteLock lock(cache.mutex);
+    auto& file = cache.files[path];
 
-        r["uid"] = uid;
-        r["history_file"] = history_file.string();
-        predicate(r);
-      };
-
-  auto parseChunk = [&hState, &parseLine](std::string& buffer, size_t size) {
-    // We may be appending this chunk to the end of the previous.
-    if (buffer.size() == size) {
-      hState.content += std::move(buffer);
-    } else {
-      hState.content += buffer.substr(0, size);
+    // Resume only if lines were parsed up to where the last read stopped.
+    AppendOnlyFileState from;
+    if (file.commands != nullptr) {
+      from = file.state;
     }
 
-    // Search for newlines and parse each.
+    AppendedLines lines;
+    if (!readAppendedLines(path, from, lines).ok()) {
+      cache.bytes -= file.bytes;
+      cache.files.erase(path);
+      return;
+    }
+
+    if (!lines.resumed) {
+      cache.bytes -= file.bytes;
+      file = HistoryFile();
+      file.commands = std::make_shared<HistoryCommands>();
+    } else if (file.commands.use_count() > 1) {
+      file.commands = std::make_shared<HistoryCommands>(*file.commands);
+    }
+
+    // Parse each complete line appended since the last read.
     size_t last_newline = 0;
-    auto newline = hState.content.find('\n');
+    auto newline = lines.content.find('\n');
     while (newline != std::string::npos) {
-      auto line = hState.content.substr(last_newline, newline - last_newline);
-      parseLine(line);
+      auto line = lines.content.substr(last_newline, newline - last_newline);
+      HistoryCommand command;
+      if (parseHistoryLine(line, file.prev_bash_timestamp, command)) {
+        auto bytes = sizeof(HistoryCommand) + command.time.size() +
+                     command.command.size();
+        file.bytes += bytes;
+        cache.bytes += bytes;
+        file.commands->push_back(std::move(command));
+      }
 
       last_newline = newline + 1;
-      newline = hState.content.find('\n', last_newline);
+      newline = lines.content.find('\n', last_newline);
     }
 
-    if (last_newline != hState.content.size() - 1) {
-      // We need to buffer the end of the string.
-      hState.content = hState.content.substr(last_newline);
+    file.state = lines.state;
+    file.last_use = ++cache.uses;
+    commands = file.commands;
+    tail = std::move(lines.tail);
+    prev_bash_timestamp = file.prev_bash_timestamp;
+
+    // Evict the least recently read files, then this file if it is too large.
+    while (cache.bytes > kShellHistoryCacheMaxSize) {
+      auto oldest = cache.files.end();
+      for (auto it = cache.files.begin(); it != cache.files.end(); ++it) {
+        if (it->first == path) {
+          continue;
+        }
+        if (oldest == cache.files.end() ||
+            it->second.last_use < oldest->second.last_use) {
+          oldest = it;
+        }
+      }
+      if (oldest == cache.files.end()) {
+        // Too large to keep, the file is read entirely by the next query.
+        cache.bytes -= file.bytes;
+        cache.files.erase(path);
+        break;
+      }
+      cache.bytes -= oldest->second.bytes;
+      cache.files.erase(oldest);
     }
-  };
+  }
 
-  if (!readFile(history_file, 0, 4096, false, parseChunk, false)) {
-    return;
+  // Rows are yielded outside of the lock, the table may be scanned again.
+  for (const auto& command : *commands) {
+    auto r = make_table_row();
+    r["time"] = command.time;
+    r["command"] = command.command;
+    r["uid"] = uid;
+    r["history_file"] = path;
+    predicate(r);
   }
 
-  // Parse the final line.
-  if (!hState.content.empty()) {
-    parseLine(hState.content);
+  // Parse the final line, it is parsed again until it is complete.
+  HistoryCommand command;
+  if (!tail.empty() &&
+      parseHistoryLine(tail, prev_bash_timestamp, command)) {
+    auto r = make_table_row();
+    r["time"] = std::move(command.time);
+    r["command"] = std::move(command.command);
+    r["uid"] = uid;
+    r["history_file"] = path;
+    predicate(r);
   }
 }
 
@@ -7,22 +7,21 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
-#include <pwd.h>
+#include <fcntl.h>
 #include <grp.h>
+#include <pwd.h>
 #include <sys/stat.h>
 
+#include <limits>
 #include <sstream>
 
-#include <boost/filesystem.hpp>
-
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/posix/file_metadata.h>
 #include <osquery/logger/logger.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
 
-namespace fs = boost::filesystem;
-
 namespace osquery {
 namespace tables {
 
@@ -31,37 +30,48 @@ std::vector<std::string> kBinarySearchPaths = {
     "/usr/local/bin", "/usr/local/sbin", "/tmp",
 };
 
-Status genBin(const fs::path& path, int perms, QueryData& results) {
-  struct stat info;
-  // store user and group
-  if (stat(path.c_str(), &info) != 0) {
-    return Status(1, "stat failed");
-  }
+/// Only the type, permissions and owner of each entry are looked up.
+const std::uint32_t kSuidBinMetadataMask{
+    kFileMetadataType | kFileMetadataMode | kFileMetadataUid |
+    kFileMetadataGid};
 
-  // store path
-  Row r;
-  r["path"] = path.string();
-  struct passwd* pw = getpwuid(info.st_uid);
-  struct group* gr = getgrgid(info.st_gid);
+void genBinOwner(const FileMetadata& metadata, Row& r) {
+  struct passwd* pw = getpwuid(metadata.uid);
+  struct group* gr = getgrgid(metadata.gid);
 
   // get user name + group
   std::string user;
   if (pw != nullptr) {
     user = std::string(pw->pw_name);
   } else {
-    user = std::to_string(info.st_uid);
+    user = std::to_string(metadata.uid);
   }
 
   std::string group;
   if (gr != nullptr) {
     group = std::string(gr->gr_name);
   } else {
-    group = std::to_string(info.st_gid);
+    group = std::to_string(metadata.gid);
   }
 
   r["username"] = user;
   r["groupname"] = group;
+}
+
+void genBin(const std::string& path,
+            const FileMetadata& metadata,
+            bool with_owner,
+            QueryData& results) {
+  // store path
+  Row r;
+  r["path"] = path;
 
+  // The owner lookups may query a directory service for every binary.
+  if (with_owner) {
+    genBinOwner(metadata, r);
+  }
+
+  auto perms = metadata.mode;
   r["permissions"] = "";
   if ((perms & 04000) == 04000) {
     r["permissions"] += "S";
@@ -72,39 +82,52 @@ Status genBin(const fs::path& path, int perms, QueryData& results) {
   }
   r["pid_with_namespace"] = "0";
   results.push_back(r);
-  return Status::success();
 }
 
 void genSuidBinsFromPath(const std::string& path,
+                         bool with_owner,
                          QueryData& results,
                          Logger& logger) {
   if (!pathExists(path).ok()) {
     return;
   }
 
-  boost::filesystem::path dir_entry_path;
-
-  try {
-    auto dir_entry_it = fs::recursive_directory_iterator(fs::path(path));
-
-    for (const auto& dir_entry : dir_entry_it) {
-      dir_entry_path = dir_entry.path();
-
-      boost::system::error_code error_code{};
-      if (!fs::is_regular_file(dir_entry_path, error_code)) {
-        continue;
-      }
-
-      auto perms = dir_entry.status().permissions();
-      if ((perms & 04000) == 04000 || (perms & 02000) == 02000) {
-        genBin(dir_entry_path, perms, results);
-      }
-    }
-
-  } catch (fs::filesystem_error& e) {
+  FileWalkOptions options;
+  options.mask = kSuidBinMetadataMask;
+  // The search paths are walked recursively, without following symlinks.
+  options.max_depth = std::numeric_limits<size_t>::max();
+
+  auto status = walkDirectory(
+      path,
+      options,
+      [&](const std::string& directory,
+          const DirectoryEntry& entry,
+          const FileMetadata& link_metadata) {
+        auto entry_path = joinDirectoryEntry(directory, entry.name);
+
+        // A symlink to a setuid/setgid binary is reported with its target.
+        auto metadata = link_metadata;
+        if (fileMetadataType(metadata) == S_IFLNK &&
+            !getFileMetadata(
+                 AT_FDCWD, entry_path, kSuidBinMetadataMask, true, metadata)
+                 .ok()) {
+          return;
+        }
+
+        if (fileMetadataType(metadata) != S_IFREG) {
+          return;
+        }
+
+        if ((metadata.mode & 04000) == 04000 ||
+            (metadata.mode & 02000) == 02000) {
+          genBin(entry_path, metadata, with_owner, results);
+        }
+      });
+
+  if (!status.ok()) {
     std::stringstream buffer;
     buffer << "Failed to iterate through the setuid/setgid binaries in "
-           << buffer.str() << " Error: " << e.what();
+           << path << " Error: " << status.getMessage();
 
     logger.vlog(1, buffer.str());
   }
@@ -112,10 +135,11 @@ void genSuidBinsFromPath(const std::string& path,
 
 QueryData genSuidBinImpl(QueryContext& context, Logger& logger) {
   QueryData results;
+  auto with_owner = context.isColumnGroupUsed("owner");
 
   // Todo: add hidden column to select on that triggers non-std path searches.
   for (const auto& path : kBinarySearchPaths) {
-    genSuidBinsFromPath(path, results, logger);
+    genSuidBinsFromPath(path, with_owner, results, logger);
   }
 
   return results;
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <osquery/tables/system/posix/append_only_file.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+namespace tables {
+
+class AppendOnlyFileTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ =
+        fs::temp_directory_path() /
+        fs::unique_path("osquery.append_only_file_tests.%%%%-%%%%");
+    ASSERT_TRUE(fs::create_directory(directory_));
+    path_ = (directory_ / "history").string();
+  }
+
+  void TearDown() override {
+    fs::remove_all(directory_);
+  }
+
+  void writeFile(const std::string& content,
+                 std::ios::openmode mode = std::ios::trunc) {
+    std::ofstream stream(path_, std::ios::out | std::ios::binary | mode);
+    stream << content;
+  }
+
+  /// Read from where the previous read stopped, then keep the state reached.
+  AppendedLines readAppended() {
+    AppendedLines lines;
+    EXPECT_TRUE(readAppendedLines(path_, state_, lines).ok());
+    state_ = lines.state;
+    return lines;
+  }
+
+ protected:
+  fs::path directory_;
+  std::string path_;
+  AppendOnlyFileState state_;
+};
+
+TEST_F(AppendOnlyFileTests, test_read_appended) {
+  writeFile("first\nsecond\n");
+
+  auto lines = readAppended();
+  EXPECT_FALSE(lines.resumed);
+  EXPECT_EQ(lines.content, "first\nsecond\n");
+  EXPECT_TRUE(lines.tail.empty());
+  EXPECT_EQ(lines.state.offset, 13U);
+
+  // Only appended lines are read, a partial line is not consumed.
+  writeFile("third\nfour", std::ios::app);
+  lines = readAppended();
+  EXPECT_TRUE(lines.resumed);
+  EXPECT_EQ(lines.content, "third\n");
+  EXPECT_EQ(lines.tail, "four");
+
+  writeFile("th\n", std::ios::app);
+  lines = readAppended();
+  EXPECT_TRUE(lines.resumed);
+  EXPECT_EQ(lines.content, "fourth\n");
+  EXPECT_TRUE(lines.tail.empty());
+
+  // Nothing was appended.
+  lines = readAppended();
+  EXPECT_TRUE(lines.resumed);
+  EXPECT_TRUE(lines.content.empty());
+}
+
+TEST_F(AppendOnlyFileTests, test_read_truncated) {
+  writeFile("first\nsecond\n");
+  readAppended();
+
+  writeFile("new\n");
+  auto lines = readAppended();
+  EXPECT_FALSE(lines.resumed);
+  EXPECT_EQ(lines.content, "new\n");
+}
+
+TEST_F(AppendOnlyFileTests, test_read_rewritten) {
+  writeFile("first\nsecond\n");
+  readAppended();
+
+  // The file is rewritten in place with different, longer, content.
+  writeFile("FIRST\nsecond\nthird\n");
+  auto lines = readAppended();
+  EXPECT_FALSE(lines.resumed);
+  EXPECT_EQ(lines.content, "FIRST\nsecond\nthird\n");
+}
+
+TEST_F(AppendOnlyFileTests, test_read_rotated) {
+  writeFile("first\nsecond\n");
+  readAppended();
+
+  // A new file with the same content replaces the file.
+  auto rotated = (directory_ / "history.new").string();
+  {
+    std::ofstream stream(rotated, std::ios::out | std::ios::binary);
+    stream << "first\nsecond\nthird\n";
+  }
+  fs::rename(rotated, path_);
+
+  auto lines = readAppended();
+  EXPECT_FALSE(lines.resumed);
+  EXPECT_EQ(lines.content, "first\nsecond\nthird\n");
+}
+
+TEST_F(AppendOnlyFileTests, test_read_missing) {
+  writeFile("first\n");
+  auto state = readAppended().state;
+
+  AppendedLines lines;
+  EXPECT_FALSE(
+      readAppendedLines((directory_ / "missing").string(), state, lines).ok());
+}
+
+} // namespace tables
+} // namespace osquery
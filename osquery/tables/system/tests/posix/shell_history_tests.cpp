@@ -153,5 +153,54 @@ TEST_F(ShellHistoryTests, bash_sessions_empty_ts) {
   fs::remove_all(directory);
 }
 
+TEST_F(ShellHistoryTests, appended_lines) {
+  std::vector<DynamicTableRowHolder> results;
+  auto predicate = [&results](DynamicTableRowHolder& r) {
+    results.push_back(std::move(r));
+  };
+
+  auto directory =
+      fs::temp_directory_path() /
+      fs::unique_path("osquery.shell_history_tests.appended_lines.%%%%-%%%%");
+  ASSERT_TRUE(fs::create_directory(directory));
+  auto filepath = directory / fs::path(".bash_history");
+  auto append = [&filepath](const std::string& content) {
+    auto fout = std::ofstream(filepath.native(),
+                              std::ios::out | std::ios::binary | std::ios::app);
+    fout << content;
+  };
+
+  auto const uid = std::to_string(geteuid());
+  auto const gid = std::to_string(getegid());
+  append("#1479082319\nls\n#1479082320\n");
+  genShellHistoryForUser(uid, gid, directory.native(), predicate);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0]["time"], "1479082319");
+  EXPECT_EQ(results[0]["command"], "ls");
+
+  // A timestamp and its command may be appended separately.
+  results.clear();
+  append("pwd\nunterminated");
+  genShellHistoryForUser(uid, gid, directory.native(), predicate);
+  ASSERT_EQ(results.size(), 3u);
+  EXPECT_EQ(results[0]["command"], "ls");
+  EXPECT_EQ(results[1]["time"], "1479082320");
+  EXPECT_EQ(results[1]["command"], "pwd");
+  EXPECT_EQ(results[2]["time"], "0");
+  EXPECT_EQ(results[2]["command"], "unterminated");
+
+  // A rewritten history replaces every row.
+  results.clear();
+  {
+    auto fout =
+        std::ofstream(filepath.native(), std::ios::out | std::ios::binary);
+    fout << "whoami\n";
+  }
+  genShellHistoryForUser(uid, gid, directory.native(), predicate);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0]["command"], "whoami");
+  fs::remove_all(directory);
+}
+
 } // namespace tables
 } // namespace osquery
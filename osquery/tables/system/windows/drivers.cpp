@@ -238,77 +238,82 @@ QueryData genDrivers(QueryContext& context) {
   }
   const auto& wmi_results = wmiSignedDriverReq->results();
 
-  auto dev_info_set = setupDevInfoSet(DIGCF_ALLCLASSES | DIGCF_PRESENT);
-  if (dev_info_set == nullptr) {
-    win32LogWARNING("Error getting device handle");
-    return results;
-  }
-
+  // The SetupAPI pass reads the registry for every present device.
+  bool with_device = context.isColumnGroupUsed("device");
   std::map<std::wstring, Row> api_devices;
-  std::vector<SP_DEVINFO_DATA> devices;
-  auto ret = getDeviceList(dev_info_set, devices);
-  if (!ret.ok()) {
-    win32LogWARNING(ret.getMessage(), ret.getCode());
-    return results;
-  }
-
-  // Then, leverage the Windows APIs to get whatever remains
-  for (auto& device : devices) {
-    WCHAR devId[MAX_DEVICE_ID_LEN] = {0};
-    if (CM_Get_Device_ID(device.DevInst, devId, MAX_DEVICE_ID_LEN, 0) !=
-        CR_SUCCESS) {
-      win32LogWARNING("Failed to get device ID");
-      continue;
+  if (with_device) {
+    auto dev_info_set = setupDevInfoSet(DIGCF_ALLCLASSES | DIGCF_PRESENT);
+    if (dev_info_set == nullptr) {
+      win32LogWARNING("Error getting device handle");
+      return results;
     }
 
-    Row r;
-    for (const auto& elem : kAdditionalDeviceProps) {
-      std::string val;
-      ret = getDeviceProperty(dev_info_set, device, elem.second, val);
-      if (!ret.ok()) {
-        VLOG(1) << "Failed to get element type " << elem.first
-                << " with error code: " << ret.getCode();
-      } else {
-        r[elem.first] = std::move(val);
-      }
+    std::vector<SP_DEVINFO_DATA> devices;
+    auto ret = getDeviceList(dev_info_set, devices);
+    if (!ret.ok()) {
+      win32LogWARNING(ret.getMessage(), ret.getCode());
+      return results;
     }
 
-    if (r.count("driver_key") > 0 && !r.at("driver_key").empty()) {
-      r["driver_key"].insert(0, kDriverKeyPath);
-      auto res = registrySubKeyExists(HKEY_LOCAL_MACHINE, r["driver_key"]);
-      if (!res.ok()) {
-        VLOG(1) << "The following registry key for device id "
-                << wstringToString(devId) << " could not be found within path: "
-                << kHkeyLocalMachinePrefix + r["driver_key"];
-        r["driver_key"].clear();
-      } else {
-        r["driver_key"].insert(0, kHkeyLocalMachinePrefix);
+    // Then, leverage the Windows APIs to get whatever remains
+    for (auto& device : devices) {
+      WCHAR devId[MAX_DEVICE_ID_LEN] = {0};
+      if (CM_Get_Device_ID(device.DevInst, devId, MAX_DEVICE_ID_LEN, 0) !=
+          CR_SUCCESS) {
+        win32LogWARNING("Failed to get device ID");
+        continue;
       }
-    }
 
-    if (r.count("service") > 0 && !r.at("service").empty()) {
-      std::string svc_key = kServiceKeyPath + r["service"];
-      std::string full_svc_key = kHkeyLocalMachinePrefix + svc_key;
-      auto res = registrySubKeyExists(HKEY_LOCAL_MACHINE, svc_key);
-      if (!res.ok()) {
-        VLOG(1) << "The following registry key for service name "
-                << r["service"]
-                << " could not be found within path: " << full_svc_key;
-      } else {
-        r["service_key"] = std::move(full_svc_key);
-        std::string path;
-        auto ret = getDriverImagePath(r["service"], path);
+      Row r;
+      for (const auto& elem : kAdditionalDeviceProps) {
+        std::string val;
+        ret = getDeviceProperty(dev_info_set, device, elem.second, val);
         if (!ret.ok()) {
-          VLOG(1) << "Failed to get driver image path for device id: "
+          VLOG(1) << "Failed to get element type " << elem.first
+                  << " with error code: " << ret.getCode();
+        } else {
+          r[elem.first] = std::move(val);
+        }
+      }
+
+      if (r.count("driver_key") > 0 && !r.at("driver_key").empty()) {
+        r["driver_key"].insert(0, kDriverKeyPath);
+        auto res = registrySubKeyExists(HKEY_LOCAL_MACHINE, r["driver_key"]);
+        if (!res.ok()) {
+          VLOG(1) << "The following registry key for device id "
                   << wstringToString(devId)
-                  << " ,error code: " << ret.getCode();
+                  << " could not be found within path: "
+                  << kHkeyLocalMachinePrefix + r["driver_key"];
+          r["driver_key"].clear();
         } else {
-          r["image"] = std::move(path);
+          r["driver_key"].insert(0, kHkeyLocalMachinePrefix);
+        }
+      }
+
+      if (r.count("service") > 0 && !r.at("service").empty()) {
+        std::string svc_key = kServiceKeyPath + r["service"];
+        std::string full_svc_key = kHkeyLocalMachinePrefix + svc_key;
+        auto res = registrySubKeyExists(HKEY_LOCAL_MACHINE, svc_key);
+        if (!res.ok()) {
+          VLOG(1) << "The following registry key for service name "
+                  << r["service"]
+                  << " could not be found within path: " << full_svc_key;
+        } else {
+          r["service_key"] = std::move(full_svc_key);
+          std::string path;
+          auto ret = getDriverImagePath(r["service"], path);
+          if (!ret.ok()) {
+            VLOG(1) << "Failed to get driver image path for device id: "
+                    << wstringToString(devId)
+                    << " ,error code: " << ret.getCode();
+          } else {
+            r["image"] = std::move(path);
+          }
         }
       }
-    }
 
-    api_devices[devId] = r;
+      api_devices[devId] = r;
+    }
   }
 
   /*
@@ -339,37 +344,40 @@ QueryData genDrivers(QueryContext& context) {
       r["signed"] = "-1";
     }
 
-    std::wstring inf_name;
-    ret = row.GetString(L"InfName", inf_name);
-    if (!ret.ok()) {
-      VLOG(1) << "Failed to retrieve Inf name for " << r["device_name"]
-              << " with " << ret.getMessage();
-    } else {
-      std::vector<WCHAR> inf(MAX_PATH, 0x0);
-      unsigned long inf_len = 0;
-      auto sdi_ret =
-          SetupGetInfDriverStoreLocation(inf_name.c_str(),
-                                         nullptr,
-                                         nullptr,
-                                         inf.data(),
-                                         static_cast<unsigned long>(inf.size()),
-                                         &inf_len);
-      if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
-        inf.resize(inf_len);
-        sdi_ret = SetupGetInfDriverStoreLocation(
+    // The INF path is resolved through the driver store.
+    if (context.isColumnGroupUsed("inf")) {
+      std::wstring inf_name;
+      ret = row.GetString(L"InfName", inf_name);
+      if (!ret.ok()) {
+        VLOG(1) << "Failed to retrieve Inf name for " << r["device_name"]
+                << " with " << ret.getMessage();
+      } else {
+        std::vector<WCHAR> inf(MAX_PATH, 0x0);
+        unsigned long inf_len = 0;
+        auto sdi_ret = SetupGetInfDriverStoreLocation(
             inf_name.c_str(),
             nullptr,
             nullptr,
             inf.data(),
             static_cast<unsigned long>(inf.size()),
             &inf_len);
-      }
-      if (sdi_ret != TRUE) {
-        VLOG(1) << "Failed to derive full driver INF path for "
-                << r["device_name"] << " with " << GetLastError();
-        r["inf"] = wstringToString(inf_name);
-      } else {
-        r["inf"] = wstringToString(inf.data());
+        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+          inf.resize(inf_len);
+          sdi_ret = SetupGetInfDriverStoreLocation(
+              inf_name.c_str(),
+              nullptr,
+              nullptr,
+              inf.data(),
+              static_cast<unsigned long>(inf.size()),
+              &inf_len);
+        }
+        if (sdi_ret != TRUE) {
+          VLOG(1) << "Failed to derive full driver INF path for "
+                  << r["device_name"] << " with " << GetLastError();
+          r["inf"] = wstringToString(inf_name);
+        } else {
+          r["inf"] = wstringToString(inf.data());
+        }
       }
     }
 
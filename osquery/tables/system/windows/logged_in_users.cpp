@@ -92,57 +92,67 @@ QueryData genLoggedInUsers(QueryContext& context) {
     }
     r["time"] = BIGINT(unixTime);
 
-    LPWSTR clientInfo = nullptr;
-    bytesRet = 0;
-    res = WTSQuerySessionInformationW(WTS_CURRENT_SERVER_HANDLE,
-                                      pSessionInfo[i].SessionId,
-                                      WTSClientInfo,
-                                      &clientInfo,
-                                      &bytesRet);
-    if (res == 0 || clientInfo == nullptr) {
-      VLOG(1) << "Error querying WTS session information (" << GetLastError()
-              << ")";
-      results.push_back(r);
-      WTSFreeMemory(sessionInfo);
-      continue;
-    }
+    r["pid"] = INTEGER(-1);
 
-    auto wtsClient = reinterpret_cast<WTSCLIENTA*>(clientInfo);
-    if (wtsClient->ClientAddressFamily == AF_INET) {
-      r["host"] = std::to_string(wtsClient->ClientAddress[0]) + "." +
-                  std::to_string(wtsClient->ClientAddress[1]) + "." +
-                  std::to_string(wtsClient->ClientAddress[2]) + "." +
-                  std::to_string(wtsClient->ClientAddress[3]);
-    } else if (wtsClient->ClientAddressFamily == AF_INET6) {
-      // TODO: IPv6 addresses are given as an array of byte values.
-      auto addr = reinterpret_cast<const char*>(wtsClient->ClientAddress);
-      r["host"] = std::string(addr, CLIENTADDRESS_LENGTH);
-    } else if (wtsClient->ClientAddressFamily == AF_UNSPEC) {
-      LPWSTR clientName = nullptr;
+    // The client address is queried from the terminal services.
+    if (context.isColumnGroupUsed("client")) {
+      LPWSTR clientInfo = nullptr;
+      bytesRet = 0;
       res = WTSQuerySessionInformationW(WTS_CURRENT_SERVER_HANDLE,
                                         pSessionInfo[i].SessionId,
-                                        WTSClientName,
-                                        &clientName,
+                                        WTSClientInfo,
+                                        &clientInfo,
                                         &bytesRet);
+      if (res == 0 || clientInfo == nullptr) {
+        VLOG(1) << "Error querying WTS session information (" << GetLastError()
+                << ")";
+        results.push_back(r);
+        WTSFreeMemory(sessionInfo);
+        continue;
+      }
 
-      if (res == 0 || clientName == nullptr) {
-        VLOG(1) << "Error querying WTS clientName information ("
-                << GetLastError() << ")";
-      } else {
-        r["host"] = wstringToString(clientName);
+      auto wtsClient = reinterpret_cast<WTSCLIENTA*>(clientInfo);
+      if (wtsClient->ClientAddressFamily == AF_INET) {
+        r["host"] = std::to_string(wtsClient->ClientAddress[0]) + "." +
+                    std::to_string(wtsClient->ClientAddress[1]) + "." +
+                    std::to_string(wtsClient->ClientAddress[2]) + "." +
+                    std::to_string(wtsClient->ClientAddress[3]);
+      } else if (wtsClient->ClientAddressFamily == AF_INET6) {
+        // TODO: IPv6 addresses are given as an array of byte values.
+        auto addr = reinterpret_cast<const char*>(wtsClient->ClientAddress);
+        r["host"] = std::string(addr, CLIENTADDRESS_LENGTH);
+      } else if (wtsClient->ClientAddressFamily == AF_UNSPEC) {
+        LPWSTR clientName = nullptr;
+        res = WTSQuerySessionInformationW(WTS_CURRENT_SERVER_HANDLE,
+                                          pSessionInfo[i].SessionId,
+                                          WTSClientName,
+                                          &clientName,
+                                          &bytesRet);
+
+        if (res == 0 || clientName == nullptr) {
+          VLOG(1) << "Error querying WTS clientName information ("
+                  << GetLastError() << ")";
+        } else {
+          r["host"] = wstringToString(clientName);
+        }
+
+        if (clientName != nullptr) {
+          WTSFreeMemory(clientName);
+        }
       }
 
-      if (clientName != nullptr) {
-        WTSFreeMemory(clientName);
+      if (clientInfo != nullptr) {
+        WTSFreeMemory(clientInfo);
+        clientInfo = nullptr;
+        wtsClient = nullptr;
       }
     }
 
-    r["pid"] = INTEGER(-1);
-
-    if (clientInfo != nullptr) {
-      WTSFreeMemory(clientInfo);
-      clientInfo = nullptr;
-      wtsClient = nullptr;
+    // Resolving the account may query a domain controller.
+    if (!context.isColumnGroupUsed("sid")) {
+      WTSFreeMemory(sessionInfo);
+      results.push_back(r);
+      continue;
     }
 
     const auto sidBuf = getSidFromAccountName(wtsSession->UserName);
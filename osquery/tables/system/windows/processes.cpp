@@ -676,16 +676,16 @@ TableRows genProcesses(QueryContext& context) {
       }
     }
 
-    if (context.isAnyColumnUsed({"path", "on_disk"})) {
+    if (context.isColumnGroupUsed("exe")) {
       getProcessPathInfo(proc_handle, pid, r);
     }
 
-    if (context.isAnyColumnUsed({"cwd", "root"}) && !isProtectedProcess &&
+    if (context.isColumnGroupUsed("links") && !isProtectedProcess &&
         !isSecureProcess && !isVirtualProcess) {
       getProcessCurrentDirectoryInfo(proc_handle, pid, r);
     }
 
-    if (context.isColumnUsed("cmdline") && !isSecureProcess &&
+    if (context.isColumnGroupUsed("cmdline") && !isSecureProcess &&
         !isVirtualProcess) {
       std::string cmd{""};
       auto s = getProcessCommandLine(
@@ -714,7 +714,7 @@ TableRows genProcesses(QueryContext& context) {
       genProcRssInfo(proc_handle, r);
     }
 
-    if (context.isAnyColumnUsed({"disk_bytes_read", "disk_bytes_written"})) {
+    if (context.isColumnGroupUsed("io")) {
       IO_COUNTERS io_ctrs;
       ret = GetProcessIoCounters(proc_handle, &io_ctrs);
       r["disk_bytes_read"] =
@@ -62,19 +62,21 @@ const std::map<int, std::string> kServiceType = {
     {0x00000110, "OWN_PROCESS(Interactive)"},
     {0x00000120, "SHARE_PROCESS(Interactive)"}};
 
-static inline Status getService(const SC_HANDLE& scmHandle,
-                                const ENUM_SERVICE_STATUS_PROCESS& svc,
-                                QueryData& results) {
-  Row r;
-  svc_handle_t svcHandle(
-      OpenService(scmHandle, svc.lpServiceName, SERVICE_QUERY_CONFIG),
-      closeServiceHandle);
-  if (svcHandle == nullptr) {
-    return Status(GetLastError(), "Failed to open service handle");
-  }
+/// The optional lookups made for each service.
+struct ServiceLookups {
+  /// Query the service configuration, this opens the service.
+  bool config{true};
+
+  /// Query the service description, this opens the service.
+  bool description{true};
 
+  /// Read the ServiceDll from the service parameters in the registry.
+  bool registry{true};
+};
+
+static inline Status getServiceConfig(SC_HANDLE svcHandle, Row& r) {
   DWORD cbBufSize;
-  (void)QueryServiceConfig(svcHandle.get(), nullptr, 0, &cbBufSize);
+  (void)QueryServiceConfig(svcHandle, nullptr, 0, &cbBufSize);
   auto err = GetLastError();
   if (ERROR_INSUFFICIENT_BUFFER != err) {
     return Status(err, "Failed to query size of service config buffer");
@@ -86,27 +88,41 @@ static inline Status getService(const SC_HANDLE& scmHandle,
     return Status(1, "Failed to malloc service config buffer");
   }
 
-  auto ret =
-      QueryServiceConfig(svcHandle.get(), lpsc.get(), cbBufSize, &cbBufSize);
+  auto ret = QueryServiceConfig(svcHandle, lpsc.get(), cbBufSize, &cbBufSize);
   if (ret == 0) {
     return Status(GetLastError(), "Failed to query service config");
   }
 
+  r["start_type"] = SQL_TEXT(kSvcStartType[lpsc->dwStartType]);
+  r["path"] = SQL_TEXT(wstringToString(lpsc->lpBinaryPathName));
+  r["user_account"] = SQL_TEXT(wstringToString(lpsc->lpServiceStartName));
+
+  if (kServiceType.count(lpsc->dwServiceType) > 0) {
+    r["service_type"] = SQL_TEXT(kServiceType.at(lpsc->dwServiceType));
+  } else {
+    r["service_type"] = SQL_TEXT("UNKNOWN");
+  }
+  return Status::success();
+}
+
+static inline void getServiceDescription(
+    SC_HANDLE svcHandle, const ENUM_SERVICE_STATUS_PROCESS& svc, Row& r) {
   try {
+    DWORD cbBufSize;
     (void)QueryServiceConfig2(
-        svcHandle.get(), SERVICE_CONFIG_DESCRIPTION, nullptr, 0, &cbBufSize);
-    err = GetLastError();
+        svcHandle, SERVICE_CONFIG_DESCRIPTION, nullptr, 0, &cbBufSize);
+    auto err = GetLastError();
     if (ERROR_INSUFFICIENT_BUFFER == err) {
       svc_descr_t lpsd(static_cast<LPSERVICE_DESCRIPTION>(malloc(cbBufSize)),
                        freePtr);
       if (lpsd == nullptr) {
         throw std::runtime_error("failed to malloc service description buffer");
       }
-      ret = QueryServiceConfig2(svcHandle.get(),
-                                SERVICE_CONFIG_DESCRIPTION,
-                                (LPBYTE)lpsd.get(),
-                                cbBufSize,
-                                &cbBufSize);
+      auto ret = QueryServiceConfig2(svcHandle,
+                                     SERVICE_CONFIG_DESCRIPTION,
+                                     (LPBYTE)lpsd.get(),
+                                     cbBufSize,
+                                     &cbBufSize);
       if (ret == 0) {
         std::stringstream ss;
         ss << "failed to query size of service description buffer, error: "
@@ -123,6 +139,32 @@ static inline Status getService(const SC_HANDLE& scmHandle,
   } catch (const std::runtime_error& e) {
     LOG(WARNING) << svc.lpServiceName << ": " << e.what();
   }
+}
+
+static inline Status getService(const SC_HANDLE& scmHandle,
+                                const ENUM_SERVICE_STATUS_PROCESS& svc,
+                                const ServiceLookups& lookups,
+                                QueryData& results) {
+  Row r;
+  if (lookups.config || lookups.description) {
+    svc_handle_t svcHandle(
+        OpenService(scmHandle, svc.lpServiceName, SERVICE_QUERY_CONFIG),
+        closeServiceHandle);
+    if (svcHandle == nullptr) {
+      return Status(GetLastError(), "Failed to open service handle");
+    }
+
+    if (lookups.config) {
+      auto status = getServiceConfig(svcHandle.get(), r);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
+    if (lookups.description) {
+      getServiceDescription(svcHandle.get(), svc, r);
+    }
+  }
 
   r["name"] = SQL_TEXT(wstringToString(svc.lpServiceName));
   r["display_name"] = SQL_TEXT(wstringToString(svc.lpDisplayName));
@@ -131,28 +173,21 @@ static inline Status getService(const SC_HANDLE& scmHandle,
   r["win32_exit_code"] = INTEGER(svc.ServiceStatusProcess.dwWin32ExitCode);
   r["service_exit_code"] =
       INTEGER(svc.ServiceStatusProcess.dwServiceSpecificExitCode);
-  r["start_type"] = SQL_TEXT(kSvcStartType[lpsc->dwStartType]);
-  r["path"] = SQL_TEXT(wstringToString(lpsc->lpBinaryPathName));
-  r["user_account"] = SQL_TEXT(wstringToString(lpsc->lpServiceStartName));
 
-  if (kServiceType.count(lpsc->dwServiceType) > 0) {
-    r["service_type"] = SQL_TEXT(kServiceType.at(lpsc->dwServiceType));
-  } else {
-    r["service_type"] = SQL_TEXT("UNKNOWN");
-  }
+  if (lookups.registry) {
+    QueryData regResults;
+    queryKey("HKEY_LOCAL_MACHINE\\SYSTEM\\CurrentControlSet\\Services\\" +
+                 r["name"] + "\\Parameters",
+             regResults);
+    for (const auto& aKey : regResults) {
+      if (aKey.at("name") == "ServiceDll") {
+        auto module_path = aKey.at("data");
+        if (const auto expanded_path = expandEnvString(module_path)) {
+          module_path = *expanded_path;
+        }
 
-  QueryData regResults;
-  queryKey("HKEY_LOCAL_MACHINE\\SYSTEM\\CurrentControlSet\\Services\\" +
-               r["name"] + "\\Parameters",
-           regResults);
-  for (const auto& aKey : regResults) {
-    if (aKey.at("name") == "ServiceDll") {
-      auto module_path = aKey.at("data");
-      if (const auto expanded_path = expandEnvString(module_path)) {
-        module_path = *expanded_path;
+        r["module_path"] = SQL_TEXT(module_path);
       }
-
-      r["module_path"] = SQL_TEXT(module_path);
     }
   }
 
@@ -160,7 +195,8 @@ static inline Status getService(const SC_HANDLE& scmHandle,
   return Status::success();
 }
 
-static inline Status getServices(QueryData& results) {
+static inline Status getServices(const ServiceLookups& lookups,
+                                 QueryData& results) {
   svc_handle_t scmHandle(OpenSCManager(nullptr, nullptr, GENERIC_READ),
                          closeServiceHandle);
   if (scmHandle == nullptr) {
@@ -206,7 +242,7 @@ static inline Status getServices(QueryData& results) {
   }
 
   for (size_t i = 0; i < serviceCount; i++) {
-    auto s = getService(scmHandle.get(), lpSvcBuf[i], results);
+    auto s = getService(scmHandle.get(), lpSvcBuf[i], lookups, results);
     if (!s.ok()) {
       LOG(WARNING) << s.getMessage();
     }
@@ -217,7 +253,14 @@ static inline Status getServices(QueryData& results) {
 
 QueryData genServices(QueryContext& context) {
   QueryData results;
-  auto status = getServices(results);
+
+  // Opening every service is the most expensive part of the table.
+  ServiceLookups lookups;
+  lookups.config = context.isColumnGroupUsed("config");
+  lookups.description = context.isColumnGroupUsed("description");
+  lookups.registry = context.isColumnGroupUsed("registry");
+
+  auto status = getServices(lookups, results);
   if (!status.ok()) {
     LOG(WARNING) << status.getMessage();
     results = QueryData();
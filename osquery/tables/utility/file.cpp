@@ -8,6 +8,7 @@
  */
 
 #if !defined(WIN32)
+#include <fcntl.h>
 #include <sys/stat.h>
 #else
 #include <shobjidl.h>
@@ -22,6 +23,9 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/fileops.h>
 #include <osquery/filesystem/filesystem.h>
+#if !defined(WIN32)
+#include <osquery/filesystem/posix/file_metadata.h>
+#endif
 #include <osquery/logger/logger.h>
 #include <osquery/utils/scope_guard.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
@@ -188,17 +192,46 @@ boost::optional<LnkData> parseLnkData(const fs::path& link) {
   return link_data;
 }
 #else
-const std::map<fs::file_type, std::string> kTypeNames{
-    {fs::regular_file, "regular"},
-    {fs::directory_file, "directory"},
-    {fs::symlink_file, "symlink"},
-    {fs::block_file, "block"},
-    {fs::character_file, "character"},
-    {fs::fifo_file, "fifo"},
-    {fs::socket_file, "socket"},
-    {fs::type_unknown, "unknown"},
-    {fs::status_error, "error"},
+const std::map<std::uint32_t, std::string> kTypeNames{
+    {S_IFREG, "regular"},
+    {S_IFDIR, "directory"},
+    {S_IFLNK, "symlink"},
+    {S_IFBLK, "block"},
+    {S_IFCHR, "character"},
+    {S_IFIFO, "fifo"},
+    {S_IFSOCK, "socket"},
+};
+
+/// The metadata fields needed by each status column.
+const std::vector<std::pair<std::string, std::uint32_t>> kColumnFields{
+    {"inode", kFileMetadataInode},
+    {"uid", kFileMetadataUid},
+    {"gid", kFileMetadataGid},
+    {"mode", kFileMetadataMode | kFileMetadataType},
+    {"size", kFileMetadataSize},
+    {"atime", kFileMetadataAtime},
+    {"mtime", kFileMetadataMtime},
+    {"ctime", kFileMetadataCtime},
+    {"btime", kFileMetadataBtime},
+    {"hard_links", kFileMetadataHardLinks},
+    {"type", kFileMetadataType},
 };
+
+/// Only ask the filesystem for the fields of the used columns.
+std::uint32_t getFileMetadataMask(const QueryContext& context) {
+  if (!context.isColumnGroupUsed("status")) {
+    return 0;
+  }
+
+  // The device and block size are always returned, bsd_flags needs a lookup.
+  std::uint32_t mask = kFileMetadataType;
+  for (const auto& column : kColumnFields) {
+    if (context.isColumnUsed(column.first)) {
+      mask |= column.second;
+    }
+  }
+  return mask;
+}
 #endif
 
 std::set<std::string> getPathsFromConstraints(const QueryContext& context) {
@@ -324,12 +357,7 @@ QueryData genFileWindows(QueryContext& context, Logger& logger) {
   auto paths = getPathsFromConstraints(context);
 
   // Only get shortcut data if actually requested
-  bool get_shortcut_data = context.isAnyColumnUsed({"shortcut_target_path",
-                                                    "shortcut_target_type",
-                                                    "shortcut_target_location",
-                                                    "shortcut_start_in",
-                                                    "shortcut_run",
-                                                    "shortcut_comment"});
+  bool get_shortcut_data = context.isColumnGroupUsed("shortcut");
 
   // Iterate through each of the resolved/supplied paths.
   for (const auto& path_string : paths) {
@@ -363,9 +391,11 @@ QueryData genFileWindows(QueryContext& context, Logger& logger) {
 
 #else
 
-void genFileInfoPosix(const fs::path& path,
+void genFileInfoPosix(int dirfd,
+                      const std::string& name,
+                      const fs::path& path,
                       const fs::path& parent,
-                      const std::string& pattern,
+                      std::uint32_t mask,
                       QueryData& results) {
   // Must provide the path, filename, directory separate from boost path->string
   // helpers to match any explicit (query-parsed) predicate constraints.
@@ -375,55 +405,67 @@ void genFileInfoPosix(const fs::path& path,
   r["directory"] = parent.string();
   r["symlink"] = "0";
 
-  struct stat file_stat;
-
   // On POSIX systems, first check the link state.
-  struct stat link_stat;
-  if (lstat(path.string().c_str(), &link_stat) < 0) {
+  FileMetadata link_metadata;
+  if (!getFileMetadata(
+           dirfd, name, mask | kFileMetadataType, false, link_metadata)
+           .ok()) {
     // Path was not real, had too may links, or could not be accessed.
     return;
   }
-  if (S_ISLNK(link_stat.st_mode)) {
+  bool is_link = (fileMetadataType(link_metadata) == S_IFLNK);
+  if (is_link) {
     r["symlink"] = "1";
   }
 
-  if (stat(path.string().c_str(), &file_stat)) {
-    file_stat = link_stat;
+#if defined(__linux__)
+  r["pid_with_namespace"] = "0";
+#endif
+
+  if (mask == 0) {
+    // Only the path and link state were requested.
+    results.push_back(r);
+    return;
   }
 
-  r["inode"] = BIGINT(file_stat.st_ino);
-  r["uid"] = BIGINT(file_stat.st_uid);
-  r["gid"] = BIGINT(file_stat.st_gid);
-  r["mode"] = lsperms(file_stat.st_mode);
-  r["device"] = BIGINT(file_stat.st_rdev);
-  r["size"] = BIGINT(file_stat.st_size);
-  r["block_size"] = INTEGER(file_stat.st_blksize);
-  r["hard_links"] = INTEGER(file_stat.st_nlink);
+  // The status of a symlink is the status of its target, when it exists.
+  FileMetadata metadata;
+  bool target_found = true;
+  if (!is_link) {
+    metadata = link_metadata;
+  } else if (!getFileMetadata(dirfd, name, mask, true, metadata).ok()) {
+    metadata = link_metadata;
+    target_found = false;
+  }
 
-  r["atime"] = BIGINT(file_stat.st_atime);
-  r["mtime"] = BIGINT(file_stat.st_mtime);
-  r["ctime"] = BIGINT(file_stat.st_ctime);
+  r["inode"] = BIGINT(metadata.inode);
+  r["uid"] = BIGINT(metadata.uid);
+  r["gid"] = BIGINT(metadata.gid);
+  r["mode"] = lsperms(metadata.mode);
+  r["device"] = BIGINT(metadata.device);
+  r["size"] = BIGINT(metadata.size);
+  r["block_size"] = INTEGER(metadata.block_size);
+  r["hard_links"] = INTEGER(metadata.hard_links);
 
-#if defined(__linux__)
-  // No 'birth' or create time in Linux or Windows.
-  r["btime"] = "0";
-  r["pid_with_namespace"] = "0";
-#else
-  r["btime"] = BIGINT(file_stat.st_birthtimespec.tv_sec);
-#endif
+  r["atime"] = BIGINT(metadata.atime);
+  r["mtime"] = BIGINT(metadata.mtime);
+  r["ctime"] = BIGINT(metadata.ctime);
+
+  // Linux only reports a birth time through statx, on some filesystems.
+  r["btime"] = BIGINT(
+      (metadata.mask & kFileMetadataBtime) ? metadata.btime : 0);
 
   // Type booleans
-  boost::system::error_code ec;
-  auto status = fs::status(path, ec);
-  if (kTypeNames.count(status.type())) {
-    r["type"] = kTypeNames.at(status.type());
+  auto type = kTypeNames.find(fileMetadataType(metadata));
+  if (target_found && type != kTypeNames.end()) {
+    r["type"] = type->second;
   } else {
     r["type"] = "unknown";
   }
 
 #if defined(__APPLE__)
   std::string bsd_file_flags_description;
-  if (!describeBSDFileFlags(bsd_file_flags_description, file_stat.st_flags)) {
+  if (!describeBSDFileFlags(bsd_file_flags_description, metadata.flags)) {
     VLOG(1)
         << "The following file had undocumented BSD file flags (chflags) set: "
         << path;
@@ -438,13 +480,17 @@ void genFileInfoPosix(const fs::path& path,
 QueryData genFilePosix(QueryContext& context, Logger& logger) {
   QueryData results;
 
+  // The metadata lookups are limited to the fields of the used columns.
+  auto mask = getFileMetadataMask(context);
+
   // Resolve file paths for EQUALS and LIKE operations.
   auto paths = getPathsFromConstraints(context);
 
   // Iterate through each of the resolved/supplied paths.
   for (const auto& path_string : paths) {
     fs::path path = path_string;
-    genFileInfoPosix(path, path.parent_path(), "", results);
+    genFileInfoPosix(
+        AT_FDCWD, path_string, path, path.parent_path(), mask, results);
   }
 
   // Resolve directories for EQUALS and LIKE operations.
@@ -452,18 +498,20 @@ QueryData genFilePosix(QueryContext& context, Logger& logger) {
 
   // Now loop through constraints using the directory column constraint.
   for (const auto& directory_string : directories) {
-    if (!isReadable(directory_string) || !isDirectory(directory_string)) {
+    std::unique_ptr<DirectoryReader> reader;
+    if (!DirectoryReader::open(AT_FDCWD, directory_string, reader).ok()) {
       continue;
     }
 
-    try {
-      // Iterate over the directory and generate info for each regular file.
-      fs::directory_iterator begin(directory_string), end;
-      for (; begin != end; ++begin) {
-        genFileInfoPosix(begin->path(), directory_string, "", results);
-      }
-    } catch (const fs::filesystem_error& /* e */) {
-      continue;
+    // Entries are looked up relative to the directory, not by path.
+    DirectoryEntry entry;
+    while (reader->next(entry)) {
+      genFileInfoPosix(reader->fd(),
+                       entry.name,
+                       joinDirectoryEntry(directory_string, entry.name),
+                       directory_string,
+                       mask,
+                       results);
     }
   }
 
@@ -253,6 +253,8 @@ QueryData genOsquerySchedule(QueryContext& context) {
         r["last_system_time"] = "0";
         r["average_memory"] = "0";
         r["last_memory"] = "0";
+        r["generate_time_ms"] = "0";
+        r["last_generate_time_ms"] = "0";
         r["last_executed"] = "0";
 
         // Report optional performance information.
@@ -270,6 +272,8 @@ QueryData genOsquerySchedule(QueryContext& context) {
               r["last_system_time"] = BIGINT(perf.last_system_time);
               r["average_memory"] = BIGINT(perf.average_memory);
               r["last_memory"] = BIGINT(perf.last_memory);
+              r["generate_time_ms"] = BIGINT(perf.generate_time_ms);
+              r["last_generate_time_ms"] = BIGINT(perf.last_generate_time_ms);
             });
 
         results.push_back(r);
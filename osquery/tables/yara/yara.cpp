@@ -15,6 +15,10 @@
 #include <regex>
 #include <thread>
 
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+
 #ifdef LINUX
 #include <malloc.h>
 #endif
@@ -22,6 +26,9 @@
 #include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#ifndef WIN32
+#include <osquery/filesystem/posix/file_metadata.h>
+#endif
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
 #include <osquery/remote/uri.h>
@@ -358,14 +365,29 @@ QueryData genYaraImpl(QueryContext& context, Logger& logger) {
             resolveFilePattern(pattern, patterns, GLOB_FILES | GLOB_NO_CANON);
         if (status.ok()) {
           for (const auto& resolved : patterns) {
+#ifndef WIN32
+            // Only the file type and mode are needed to skip special files.
+            FileMetadata metadata;
+            if (!getFileMetadata(AT_FDCWD,
+                                 resolved,
+                                 kFileMetadataType | kFileMetadataMode,
+                                 true,
+                                 metadata)
+                     .ok()) {
+              continue; // failed to stat the file
+            }
+            auto st_mode = static_cast<mode_t>(metadata.mode);
+#else
             struct stat sb;
             if (0 != stat(resolved.c_str(), &sb)) {
               continue; // failed to stat the file
             }
+            auto st_mode = sb.st_mode;
+#endif
 
             // Check that each resolved path is readable.
             if (isReadable(resolved) &&
-                !yaraShouldSkipFile(resolved, sb.st_mode)) {
+                !yaraShouldSkipFile(resolved, st_mode)) {
               paths.insert(resolved);
             }
           }
@@ -57,6 +57,10 @@ class YARAEventSubscriber : public FileEventSubscriber {
 
   void configure() override;
 
+  std::set<std::string> configParsers() const override {
+    return {"file_paths", "yara"};
+  }
+
  private:
   /**
    * @brief This exports a single Callback for FSEventsEventPublisher events.
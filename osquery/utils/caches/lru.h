@@ -94,6 +94,14 @@ class LRU {
     return map_.find(key) != map_.end();
   }
 
+  /**
+   * @brief Remove every element from the cache.
+   */
+  void clear() noexcept {
+    map_.clear();
+    queue_.clear();
+  }
+
  private:
   void evict() {
     map_.erase(queue_.back());
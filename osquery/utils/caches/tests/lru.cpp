@@ -115,6 +115,19 @@ TEST_F(LruCacheTests, has_does_not_change_the_place_in_queue) {
   EXPECT_TRUE(cache.has(3));
 }
 
+TEST_F(LruCacheTests, clear) {
+  auto cache = caches::LRU<int, int>(2);
+  cache.insert(1, 212);
+  cache.insert(2, 212);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0U);
+  EXPECT_FALSE(cache.has(1));
+  cache.insert(3, 212);
+  cache.insert(4, 212);
+  EXPECT_TRUE(cache.has(3));
+  EXPECT_TRUE(cache.has(4));
+}
+
 TEST_F(LruCacheTests, pointer_validity_after_insertions) {
   auto cache = caches::LRU<int, std::string>(16);
   auto ptr_1 = cache.insert(1, "Arctic");
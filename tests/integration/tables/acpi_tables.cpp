@@ -41,5 +41,11 @@ TEST_F(acpiTables, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+#ifdef OSQUERY_LINUX
+TEST_F(acpiTables, test_column_pruning) {
+  validate_column_pruning("acpi_tables");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
@@ -47,5 +47,11 @@ TEST_F(blockDevices, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+#ifdef OSQUERY_LINUX
+TEST_F(blockDevices, test_column_pruning) {
+  validate_column_pruning("block_devices");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
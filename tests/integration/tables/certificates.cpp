@@ -82,5 +82,11 @@ TEST_F(certificates, test_certificate_common_name) {
   ASSERT_FALSE(value.empty());
 }
 
+#ifdef OSQUERY_LINUX
+TEST_F(certificates, test_column_pruning) {
+  validate_column_pruning("certificates");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
@@ -62,5 +62,9 @@ TEST_F(dockerContainers, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+TEST_F(dockerContainers, test_column_pruning) {
+  validate_column_pruning("docker_containers");
+}
+
 } // namespace table_tests
 } // namespace osquery
@@ -52,5 +52,9 @@ TEST_F(drivers, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+TEST_F(drivers, test_column_pruning) {
+  validate_column_pruning("drivers");
+}
+
 } // namespace table_tests
 } // namespace osquery
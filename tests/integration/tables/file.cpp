@@ -229,5 +229,16 @@ TEST_F(FileTests, test_sanity) {
   }
 }
 
+TEST_F(FileTests, test_column_pruning) {
+#ifdef WIN32
+  auto link_path = directory / boost::filesystem::path(kFileNameList.front());
+  link_path.replace_extension(".lnk");
+  validate_column_pruning("file", {{"path", link_path.string()}}, {"shortcut"});
+#else
+  validate_column_pruning(
+      "file", {{"directory", directory.string()}}, {"status"});
+#endif
+}
+
 } // namespace table_tests
 } // namespace osquery
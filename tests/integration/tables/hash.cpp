@@ -69,5 +69,9 @@ TEST_F(Hash, test_sanity) {
   }
 }
 
+TEST_F(Hash, test_column_pruning) {
+  validate_column_pruning("hash", {{"path", path.string()}});
+}
+
 } // namespace table_tests
 } // namespace osquery
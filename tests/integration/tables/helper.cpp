@@ -10,6 +10,7 @@
 #include <osquery/tests/integration/tables/helper.h>
 
 #include <osquery/core/system.h>
+#include <osquery/core/tables.h>
 #include <osquery/database/database.h>
 #include <osquery/registry/registry.h>
 
@@ -316,6 +317,74 @@ void validate_container_rows(const std::string& table_name,
   validate_rows(rows, validation_map);
 }
 
+void validate_column_pruning(
+    const std::string& table_name,
+    const std::map<std::string, std::string>& constraints,
+    const std::set<std::string>& groups) {
+  auto plugin = Registry::get().plugin("table", table_name);
+  auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
+  ASSERT_NE(table, nullptr);
+
+  auto column_groups = table->columnGroups();
+  ASSERT_FALSE(column_groups.empty());
+
+  auto columns = table->columns();
+  for (const auto& group : column_groups) {
+    if (!groups.empty() && groups.count(group.first) == 0) {
+      continue;
+    }
+
+    // Use every column outside of the group, as SQLite would.
+    QueryContext context;
+    UsedColumns used;
+    UsedColumnsBitset used_bitset;
+    std::vector<std::string> pruned;
+    for (size_t i = 0; i < columns.size(); ++i) {
+      const auto& name = std::get<0>(columns[i]);
+      auto bit = std::min(i, used_bitset.size() - 1);
+      if (group.second.test(bit)) {
+        pruned.push_back(name);
+      } else {
+        used.insert(name);
+        used_bitset.set(bit);
+      }
+    }
+    context.colsUsed = used;
+    context.colsUsedBitset = used_bitset;
+    for (const auto& constraint : constraints) {
+      context.constraints[constraint.first].add(
+          Constraint(EQUALS, constraint.second));
+    }
+
+    std::vector<Row> rows;
+    if (table->usesGenerator()) {
+      RowGenerator::pull_type generator(
+          [&table, &context](RowYield& yield) {
+            table->generator(yield, context);
+          });
+      for (const auto& row : generator) {
+        rows.push_back(static_cast<Row>(*row));
+      }
+    } else {
+      for (const auto& row : table->generate(context)) {
+        rows.push_back(static_cast<Row>(*row));
+      }
+    }
+
+    EXPECT_FALSE(context.isColumnGroupUsed(group.first))
+        << table_name << " did not provide the group " << group.first;
+    for (const auto& row : rows) {
+      for (const auto& name : pruned) {
+        auto value = row.find(name);
+        EXPECT_TRUE(value == row.end() || value->second.empty() ||
+                    value->second == "-1")
+            << table_name << "." << name << " was generated without the "
+            << group.first << " group being used: " << value->second;
+      }
+    }
+  }
+}
+
 void setUpEnvironment() {
   platformSetup();
   registryAndPluginInit();
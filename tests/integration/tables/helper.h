@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <map>
+#include <set>
 #include <unordered_set>
 
 #include <boost/variant.hpp>
@@ -96,6 +98,21 @@ void validate_container_rows(
     const std::string& sql_constraints = std::string());
 bool is_valid_hex(const std::string& value);
 
+/**
+ * @brief Check that a table honors the column groups of its spec.
+ *
+ * For each column group the table is generated with every other column
+ * used, the group's columns must then be absent, empty, or -1.
+ *
+ * @param table_name The table, which must declare column groups.
+ * @param constraints Equality constraints, for tables that require them.
+ * @param groups The groups to check, all groups if empty.
+ */
+void validate_column_pruning(
+    const std::string& table_name,
+    const std::map<std::string, std::string>& constraints = {},
+    const std::set<std::string>& groups = {});
+
 void setUpEnvironment();
 
 } // namespace table_tests
@@ -117,5 +117,9 @@ TEST_F(InterfaceDetailsTest, test_sanity) {
   validate_rows(rows, row_map);
 }
 
+TEST_F(InterfaceDetailsTest, test_column_pruning) {
+  validate_column_pruning("interface_details");
+}
+
 } // namespace table_tests
 } // namespace osquery
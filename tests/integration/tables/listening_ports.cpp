@@ -47,5 +47,9 @@ TEST_F(listeningPorts, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+TEST_F(listeningPorts, test_column_pruning) {
+  validate_column_pruning("listening_ports");
+}
+
 } // namespace table_tests
 } // namespace osquery
@@ -39,5 +39,11 @@ TEST_F(LoggedInUsersTest, test_sanity) {
   validate_rows(rows, row_map);
 }
 
+#ifdef OSQUERY_WINDOWS
+TEST_F(LoggedInUsersTest, test_column_pruning) {
+  validate_column_pruning("logged_in_users");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
@@ -42,5 +42,9 @@ TEST_F(mounts, test_sanity) {
   validate_rows(data, row_map);
 }
 
+TEST_F(mounts, test_column_pruning) {
+  validate_column_pruning("mounts");
+}
+
 } // namespace table_tests
 } // namespace osquery
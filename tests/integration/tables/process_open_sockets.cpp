@@ -47,5 +47,11 @@ TEST_F(processOpenSockets, test_sanity) {
   validate_rows(data, row_map);
 }
 
+#ifdef OSQUERY_LINUX
+TEST_F(processOpenSockets, test_column_pruning) {
+  validate_column_pruning("process_open_sockets");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
@@ -113,5 +113,11 @@ TEST_F(ProcessesTest, test_sanity) {
   validate_rows(data, row_map);
 }
 
+#if defined(OSQUERY_LINUX) || defined(OSQUERY_WINDOWS)
+TEST_F(ProcessesTest, test_column_pruning) {
+  validate_column_pruning("processes");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
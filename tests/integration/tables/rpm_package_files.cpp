@@ -45,5 +45,9 @@ TEST_F(rpmPackageFiles, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+TEST_F(rpmPackageFiles, test_column_pruning) {
+  validate_column_pruning("rpm_package_files");
+}
+
 } // namespace table_tests
 } // namespace osquery
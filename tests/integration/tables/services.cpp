@@ -50,5 +50,9 @@ TEST_F(services, test_sanity) {
   // validate_rows(data, row_map);
 }
 
+TEST_F(services, test_column_pruning) {
+  validate_column_pruning("services");
+}
+
 } // namespace table_tests
 } // namespace osquery
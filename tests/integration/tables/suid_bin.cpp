@@ -40,5 +40,9 @@ TEST_F(suidBin, test_sanity) {
   validate_rows(data_newgrp, row_map);
 }
 
+TEST_F(suidBin, test_column_pruning) {
+  validate_column_pruning("suid_bin");
+}
+
 } // namespace table_tests
 } // namespace osquery
@@ -48,5 +48,11 @@ TEST_F(SystemInfo, test_sanity) {
   validate_rows(data, row_map);
 }
 
+#ifdef OSQUERY_LINUX
+TEST_F(SystemInfo, test_column_pruning) {
+  validate_column_pruning("system_info");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
@@ -83,5 +83,11 @@ TEST_F(UsersTest, test_sanity) {
   validate_rows(rows_one, row_map);
 }
 
+#ifdef OSQUERY_DARWIN
+TEST_F(UsersTest, test_column_pruning) {
+  validate_column_pruning("users");
+}
+#endif
+
 } // namespace table_tests
 } // namespace osquery
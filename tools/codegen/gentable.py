@@ -101,6 +101,7 @@ TABLE_ATTRIBUTES = {
     "cacheable": "CACHEABLE",
     "utility": "UTILITY",
     "kernel_required": "KERNEL_REQUIRED", # Deprecated
+    "limit_pushdown": "LIMIT_PUSHDOWN",
 }
 
 WINDOWS = ['windows', 'win32', 'cygwin']
@@ -209,6 +210,7 @@ class TableState(Singleton):
         self.has_column_aliases = False
         self.strongly_typed_rows = False
         self.generator = False
+        self.cost = {}
 
     def columns(self):
         return [i for i in self.schema if isinstance(i, Column)]
@@ -225,6 +227,9 @@ class TableState(Singleton):
         for column in self.columns():
             column_options = []
             for option in column.options:
+                if option in ["cost", "group"]:
+                    # Column costs and groups are not column options.
+                    continue
                 # Only allow explicitly-defined options.
                 if option in COLUMN_OPTIONS:
                     if option == "collate":
@@ -250,6 +255,8 @@ class TableState(Singleton):
             self.has_options = True
         if "event_subscriber" in self.attributes:
             self.generator = True
+            # Events are generated from a time-ordered index, honoring a LIMIT.
+            self.attributes["limit_pushdown"] = True
         if "strongly_typed_rows" in self.attributes:
             self.strongly_typed_rows = True
         if "cacheable" in self.attributes:
@@ -261,6 +268,30 @@ class TableState(Singleton):
             print(lightred("Invalid table spec: %s" % (path)))
             exit(1)
 
+        # Check the planner cost hints
+        column_costs = {}
+        for column in self.columns():
+            if "cost" in column.options:
+                column_costs[column.name] = column.options["cost"]
+        for name, value in list(self.cost.items()) + list(column_costs.items()):
+            if not isinstance(value, int) or value < 0:
+                print(lightred("Table %s has an invalid cost for %s: %s" % (
+                    self.table_name, name, value)))
+                exit(1)
+
+        # Collect the column groups as masks of used columns, columns past
+        # the 64th share the last bit, as in the SQLite colUsed mask.
+        column_groups = {}
+        for i, column in enumerate(self.columns()):
+            if "group" not in column.options:
+                continue
+            group = column.options["group"]
+            if not isinstance(group, str) or not group.isidentifier():
+                print(lightred("Table %s column %s has an invalid group: %s" % (
+                    self.table_name, column.name, group)))
+                exit(1)
+            column_groups[group] = column_groups.get(group, 0) | (1 << min(i, 63))
+
         # Check for reserved column names
         for column in self.columns():
             if column.name in RESERVED:
@@ -298,6 +329,9 @@ class TableState(Singleton):
             generator=self.generator,
             strongly_typed_rows=self.strongly_typed_rows,
             attribute_set=[TABLE_ATTRIBUTES[attr] for attr in self.attributes if attr in TABLE_ATTRIBUTES],
+            table_cost=self.cost,
+            column_costs=column_costs,
+            column_groups=column_groups,
         )
 
         with open(path, "w+") as file_h:
@@ -351,6 +385,7 @@ def table_name(name, aliases=[]):
     table.examples = []
     table.notes = ""
     table.aliases = aliases
+    table.cost = {}
 
 
 def schema(schema_list):
@@ -405,6 +440,15 @@ def attributes(**kwargs):
         table.attributes[attr] = kwargs[attr]
 
 
+def cost(rows=0, row_cost=0):
+    """
+    define planner hints: the expected number of rows of a scan, and the
+    additional cost of generating each row relative to a row in memory.
+    Expensive columns may also set a cost=N hint.
+    """
+    table.cost = {"rows": rows, "row_cost": row_cost}
+
+
 def fuzz_paths(paths):
     table.fuzz_paths = paths
 